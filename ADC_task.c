@@ -1,67 +1,70 @@
 #include <stdbool.h>
 #include <stdint.h>
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "driverlib/gpio.h"
-#include "driverlib/rom.h"
 #include "utils/uartstdio.h"
 #include "priorities.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include "semphr.h"
-#include "lcd_i2c.h"
 #include "sensors.h"
+#include "timestamp.h"
+#include "trace_recorder.h"
+#include "calib.h"
+#include "ADC_task.h"
+
+static tThrottleRequest g_psThrottleRequests[ADC_TASK_TOPIC_SLOTS];
+tSensorBusTopic g_sThrottleTopic;
+extern xSemaphoreHandle g_pADCSemaphore;
+
+// filter state of the throttle request, kept between periods
+static int32_t g_i32ADCFiltered;
 
-//*****************************************************************************
-//
-// The stack size for the LED toggle task.
-//
-//*****************************************************************************
-#define ADCTASKSTACKSIZE				128				 // Stack size in words
 
 //*****************************************************************************
 //
-// The item size and queue size for the LED message queue.
+// Turns a throttle reading into the torque request: scaled to pedal
+// position, smoothed, then mapped. *pi32Filtered is the filter state kept
+// between periods. The trace replay runs it on recorded readings.
 //
 //*****************************************************************************
-#define ADC_ITEM_SIZE					 sizeof(uint32_t)*1				// change to four sensors reading in the future
-#define ADC_QUEUE_SIZE				 1
+uint32_t ADCTaskThrottleRequest(uint32_t ui32Raw, int32_t *pi32Filtered)
+{
+	int32_t i32Scaled, i32Request;
 
+	i32Scaled = CalibScale(ADC_CH_THROTTLE, ui32Raw);
+	*pi32Filtered += (int32_t)(((int64_t)(i32Scaled - *pi32Filtered) *
+	                            g_psCalib->sTuning.ui32FilterAlpha) >> 16);
+	i32Request = CalibThrottleMap(*pi32Filtered);
 
-xQueueHandle g_pADCQueue;
-extern xSemaphoreHandle g_pADCSemaphore;
-
+	return (i32Request > 0) ? (uint32_t)i32Request : 0;
+}
 
 //*****************************************************************************
 //
-// This task toggles the user selected LED at a user selected frequency. User
-// can make the selections by pressing the left and right buttons.
+// Reads the throttle and publishes the request. Runs in the 5ms rate group,
+// which releases it strictly periodically and watches its deadline.
 //
 //*****************************************************************************
-static void ADCTask(void *pvParameters)
+void ADCTaskRun(void)
 {
-
 	uint32_t ThrottleValue;
-	
-	while(1)
-		{
-			
-			xSemaphoreTake(g_pADCSemaphore, portMAX_DELAY);
-			ThrottleValue = ThrottleSensorGetValue();
-			xSemaphoreGive(g_pADCSemaphore);
-			
-			xQueueSend( g_pADCQueue, &ThrottleValue, 0);
-			
-			// this task runs every 5ms
-			vTaskDelay(5);
-			
-		}
+	tThrottleRequest *psRequest;
+
+	xSemaphoreTake(g_pADCSemaphore, portMAX_DELAY);
+	ThrottleValue = ThrottleSensorGetValue();
+	xSemaphoreGive(g_pADCSemaphore);
+
+	ThrottleValue = ADCTaskThrottleRequest(ThrottleValue, &g_i32ADCFiltered);
+
+	psRequest = (tThrottleRequest *)SensorBusPublishBegin(&g_sThrottleTopic);
+	psRequest->ui32Time = TimestampGet();
+	psRequest->ui32Request = ThrottleValue;
+	SensorBusPublishEnd(&g_sThrottleTopic);
 }
 
 //*****************************************************************************
 //
-// Initializes the LCD task.
+// Initializes the throttle sensor and the topic of the requests, the 5ms
+// rate group runs ADCTaskRun().
 //
 //*****************************************************************************
 uint32_t ADCTaskInit(void)
@@ -73,19 +76,9 @@ uint32_t ADCTaskInit(void)
 		//
 		UARTprintf("\nADC task running!!");
 		
-		//
-		// Create a queue for sending messages to the LCD task.
-		//
-		g_pADCQueue = xQueueCreate(ADC_QUEUE_SIZE, ADC_ITEM_SIZE);
-
-		//
-		// Create the LED task.
-		//
-		if(xTaskCreate(ADCTask, (const portCHAR *)"ADC", ADCTASKSTACKSIZE, NULL,
-									 tskIDLE_PRIORITY + PRIORITY_ADC_TASK, NULL) != pdTRUE)
-		{
-				return(1);
-		}
+		SensorBusTopicRegister(&g_sThrottleTopic, "throttle",
+		                       g_psThrottleRequests, sizeof(tThrottleRequest),
+		                       ADC_TASK_TOPIC_SLOTS);
 
 		//
 		// Success.
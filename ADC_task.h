@@ -1,7 +1,31 @@
 #ifndef ADC_TASK_H
 #define ADC_TASK_H
 
+#include "rate_group.h"
+#include "sensor_bus.h"
+
+// period of the throttle request, the rate group it runs in
+#define ADC_TASK_PERIOD_MS			 RATE_GROUP_PERIOD_MS(RATE_GROUP_5MS)
+
+//*****************************************************************************
+//
+// The throttle request of every period, published on the "throttle" topic of
+// the sensor bus.
+//
+//*****************************************************************************
+#define ADC_TASK_TOPIC_SLOTS		 4
+
+typedef struct
+{
+	uint32_t ui32Time;							// DWT timestamp of the request
+	uint32_t ui32Request;
+}
+tThrottleRequest;
+
+extern tSensorBusTopic g_sThrottleTopic;
 
 uint32_t ADCTaskInit(void);
+void ADCTaskRun(void);
+uint32_t ADCTaskThrottleRequest(uint32_t ui32Raw, int32_t *pi32Filtered);
 
 #endif
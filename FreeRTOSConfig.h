@@ -66,13 +66,17 @@
  * See http://www.freertos.org/a00110.html.
  *----------------------------------------------------------*/
 
+#include "ram_budget.h"
+
 #define configUSE_PREEMPTION                1
 #define configUSE_IDLE_HOOK                 0
 #define configUSE_TICK_HOOK                 0
 #define configCPU_CLOCK_HZ                  ( ( unsigned long ) 80000000 )
 #define configTICK_RATE_HZ                  ( ( portTickType ) 1000 )
 #define configMINIMAL_STACK_SIZE            ( ( unsigned short ) 200 )
-#define configTOTAL_HEAP_SIZE               ( ( size_t ) ( 30000 ) )
+/* The heap only holds task stacks, queues and semaphores, its size is the
+line of the RAM budget, see ram_budget.h. */
+#define configTOTAL_HEAP_SIZE               ( ( size_t ) ( RAM_BUDGET_HEAP ) )
 #define configMAX_TASK_NAME_LEN             ( 12 )
 #define configUSE_TRACE_FACILITY            1
 #define configUSE_16_BIT_TICKS              0
@@ -86,6 +90,10 @@
 #define configMAX_CO_ROUTINE_PRIORITIES     ( 2 )
 #define configQUEUE_REGISTRY_SIZE           10
 
+/* Record scheduler, queue and interrupt events into the RAM trace buffer, see
+trace_recorder.h. */
+#define configUSE_TRACE_RECORDER            1
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 
@@ -104,4 +112,8 @@ to exclude the API function. */
 #define configKERNEL_INTERRUPT_PRIORITY         ( 7 << 5 )    /* Priority 7, or 0xE0 as only the top three bits are implemented.  This is the lowest priority. */
 #define configMAX_SYSCALL_INTERRUPT_PRIORITY     ( 5 << 5 )  /* Priority 5, or 0xA0 as only the top three bits are implemented. */
 
+#if configUSE_TRACE_RECORDER == 1
+#include "trace_recorder.h"
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -4,30 +4,76 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "inc/hw_adc.h"
-#include "inc/hw_ints.h"
-#include "inc/hw_gpio.h"
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "inc/hw_udma.h"
-
-#include "driverlib/adc.h"
-#include "driverlib/gpio.h"
-#include "driverlib/interrupt.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/pwm.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/udma.h"
-#include "driverlib/timer.h"
-#include "driverlib/rom.h"
-#include "driverlib/rom_map.h"
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "timestamp.h"
+#include "trace_recorder.h"
+#include "sensor_bus.h"
+#include "adc_api.h"
+#include "can_events.h"
+#include "sensor_diag.h"
+#include "stats.h"
+#include "freeze_frame.h"
+#include "event_log.h"
 
 void ADC0IntHandler(void);
+void ADCSuspensionIntHandler(void);
 
 static volatile uint32_t g_ui32ADC0Reading = 0;
 
 uint32_t ADCData[4];
 
+//*****************************************************************************
+//
+// Ring of the most recent frames, the slots of the "adc" topic of the sensor
+// bus, published by ADC0IntHandler(). freeze_frame.c moves the topic to
+// slots of its own while it holds a snapshot in this ring.
+//
+//*****************************************************************************
+static tADCFrame g_psADCFrames[ADC_FRAME_RING_SIZE];
+tSensorBusTopic g_sADCTopic;
+
+typedef char tADCFrameRingSize[((ADC_FRAME_RING_SIZE &
+                                 (ADC_FRAME_RING_SIZE - 1)) == 0) ? 1 : -1];
+
+//*****************************************************************************
+//
+// The sequencers of the extended acquisition, see ADCExtendedInit(), and the
+// slots of their topics.
+//
+//*****************************************************************************
+#define ADC_SUSPENSION_SEQ				0
+#define ADC_SLOW_SEQ					2
+
+// the slow channels fit the 4 steps of sequencer 2
+typedef char tADCSlowFits[(ADC_SLOW_CHANNELS <= 4) ? 1 : -1];
+
+static tADCSuspensionFrame g_psADCSuspensionFrames[ADC_SUSPENSION_RING_SIZE];
+tSensorBusTopic g_sADCSuspensionTopic;
+static tADCSlowFrame g_psADCSlowFrames[ADC_SLOW_TOPIC_SLOTS];
+tSensorBusTopic g_sADCSlowTopic;
+
+typedef char tADCExtendedBudget[(sizeof(g_psADCSuspensionFrames) +
+                                 sizeof(g_psADCSlowFrames) <=
+                                 RAM_BUDGET_ADC_EXTENDED) ? 1 : -1];
+
+// time of the slow conversion started by the last ADCSlowRun()
+static uint32_t g_ui32ADCSlowTrigger;
+static bool g_bADCSlowPending = false;
+
+// sensor fault bits of the last frame, new faults go to the event log. The
+// CAN event faults are in the low byte, the diagnostic DTCs above.
+#define ADC_FAULT_DTC_SHIFT				8
+static uint32_t g_ui32ADCFaults = 0;
+
+// cycles per stage of ADC0IntHandler(), see ADCStageReport()
+static tADCStageStats g_sADCStages;
+
+static const char * const g_ppcADCStageNames[ADC_NUM_STAGES] =
+{
+	"read", "events", "diag", "stats", "record"
+};
+
 //*****************************************************************************
 //
 //! \addtogroup adc_examples_list
@@ -47,60 +93,17 @@ uint32_t ADCData[4];
 
 void ADCInit(void)
 {
-		// The ADC0 peripheral must be enabled for use.
-		//
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-
-		//
-		// For this example ADC0 is used with AIN0 on port E7.
-		// The actual port and pins used may be different on your part, consult
-		// the data sheet for more information.	GPIO port E needs to be enabled
-		// so these pins can be used.
-		// TODO: change this to whichever GPIO port you are using.
-		//
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
-	
-		//
-		// Select the analog ADC function for these pins.
-		// Consult the data sheet to see which functions are allocated per pin.
-		// TODO: change this to select the port/pin you are using.
-		//
-		MAP_GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_3 | GPIO_PIN_1 );
-		MAP_GPIOPinTypeADC(GPIO_PORTD_BASE, GPIO_PIN_1);
-		//
-		// Enable sample sequence 3 with a processor signal trigger.	Sequence 3
-		// will do a single sample when the processor sends a signal to start the
-		// conversion.	Each ADC module has 4 programmable sequences, sequence 0
-		// to sequence 3.	This example is arbitrarily using sequence 3.
-		//
-		MAP_ADCSequenceConfigure(ADC0_BASE, 1, ADC_TRIGGER_PROCESSOR, 0);
-
-		//
-		// Configure step 0 on sequence 3.	Sample channel 0 (ADC_CTL_CH0) in
-		// single-ended mode (default) and configure the interrupt flag
-		// (ADC_CTL_IE) to be set when the sample is done.	Tell the ADC logic
-		// that this is the last conversion on sequence 3 (ADC_CTL_END).	Sequence
-		// 3 has only one programmable step.	Sequence 1 and 2 have 4 steps, and
-		// sequence 0 has 8 programmable steps.	Since we are only doing a single
-		// conversion using sequence 3 we will only configure step 0.	For more
-		// information on the ADC sequences and steps, reference the datasheet.
-		//
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 0, ADC_CTL_CH0 );
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 1, ADC_CTL_CH2 );		
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 2, ADC_CTL_CH6 );
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 3, ADC_CTL_CH6 | ADC_CTL_IE | ADC_CTL_END);
-		
-		//
-		// Since sample sequence 3 is now configured, it must be enabled.
-		//
-		MAP_ADCSequenceEnable(ADC0_BASE, 1);
+		// AIN0, AIN2 and AIN6, the last one twice
+		static const uint8_t pui8Channels[4] = { 0, 2, 6, 6 };
 
 		//
-		// Clear the interrupt status flag.	This is done to make sure the
-		// interrupt flag is cleared before we sample.
+		// Sequence 1 converts its 4 steps when the processor sends a signal to
+		// start the conversion. Each ADC module has 4 programmable sequences,
+		// sequence 0 to sequence 3. The last step interrupts and ends the
+		// sequence, the pins of the channels are set to their analog function.
 		//
-		MAP_ADCIntClear(ADC0_BASE, 1);
+		HalADCInit(1);
+		HalADCSequenceInit(1, HAL_ADC_TRIGGER_PROCESSOR, pui8Channels, 4);
 		
 }
 
@@ -119,24 +122,24 @@ void ADCGetValue(uint32_t* ADCValues)
 		//
 		// Trigger the ADC conversion.
 		//
-		MAP_ADCProcessorTrigger(ADC0_BASE, 1);
+		HalADCProcessorTrigger(1);
 
 		//
 		// Wait for conversion to be completed.
 		//
-		while(!MAP_ADCIntStatus(ADC0_BASE, 1, false))
+		while(!HalADCIntStatus(1))
 		{
 		}
 
 		//
 		// Clear the ADC interrupt flag.
 		//
-		MAP_ADCIntClear(ADC0_BASE, 1);
+		HalADCIntClear(1);
 
 		//
 		// Read ADC Value.
 		//
-		MAP_ADCSequenceDataGet(ADC0_BASE, 1, pui32ADC0Value);
+		HalADCDataGet(1, pui32ADC0Value);
 		
 }
 
@@ -147,101 +150,371 @@ NOTE PE1 IS BAD DO NOT USE
 *******************************************************************************/
 void ADCTimerTriggeredInit(void)
 {
+		// PE3-> AIN0, PE2-> AIN1 - NOTE PE1 IS BAD DO NOT USE, PD1-> AIN6,
+		// PB4-> AIN10 rotary sensor of the throttle pedal
+		static const uint8_t pui8Channels[4] = { 0, 1, 6, 10 };
 	
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
-		MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
-	
-		MAP_GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_3 | GPIO_PIN_2 );
-		MAP_GPIOPinTypeADC(GPIO_PORTD_BASE, GPIO_PIN_1);
+		SensorBusTopicRegister(&g_sADCTopic, "adc", g_psADCFrames,
+		                       sizeof(tADCFrame), ADC_FRAME_RING_SIZE);
+		SensorDiagInit();
+		StatsInit();
+		ADCStageStatsReset();
 	
 		// Apply averaging hardware to get more precise reading
 		// Take the average of 8 sampled vales, throughput is reduced by a factor of 8
-		MAP_ADCHardwareOversampleConfigure(ADC0_BASE,8);
-		
-		// Set reference voltage to internal
-    MAP_ADCReferenceSet(ADC0_BASE,ADC_REF_INT);
-
-	
-		//
-		// Enable sample sequence 1 with a processor signal trigger.	Sequence 1
-		// will do 4 sample when the timer sends a signal to start the
-		// conversion.	Each ADC module has 4 programmable sequences, sequence 0
-		// to sequence 3.
-		//
-		MAP_ADCSequenceConfigure(ADC0_BASE, 1, ADC_TRIGGER_TIMER, 0);
-
-	
-		// We are using Sequencer No. 1 which will gather 4 samples.
-		// the following code sets up the configuration fro each sample
-		
-		// AIN0 AIN1 AIN6 will be used as single ended -> pins PE3, PE2, PD1 respectively
-		// if sensors turn out to be differential then the succesive AIN can be used
-		
-		// PE3-> AIN0 - first element in the array
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 0, ADC_CTL_CH0 );
-		
-		// PE2-> AIN1 - second element in the array - NOTE PE1 IS BAD DO NOT USE
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 1, ADC_CTL_CH1 );
-		
-		// PD1-> AIN6 - third element in the array		
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 2, ADC_CTL_CH6 );
-		MAP_ADCSequenceStepConfigure(ADC0_BASE, 1, 3, ADC_CTL_CH6 | ADC_CTL_IE | ADC_CTL_END);
-		
-		//
-		// Since sample sequence 1 is now configured, it must be enabled.
-		//
-		MAP_ADCSequenceEnable(ADC0_BASE, 1);
+		HalADCInit(8);
 
 		//
-		// Clear the interrupt status flag.	This is done to make sure the
-		// interrupt flag is cleared before we sample.
+		// Sequencer 1 gathers 4 samples when the timer sends a signal to start
+		// the conversion, in the order of pui8Channels, the elements of the
+		// frame. Each ADC module has 4 programmable sequences, sequence 0 to
+		// sequence 3.
 		//
-		MAP_ADCIntClear(ADC0_BASE, 1);
-	
-	  // Enable the Timer peripheral
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
+		HalADCSequenceInit(1, HAL_ADC_TRIGGER_TIMER, pui8Channels, 4);
 
-    // Timer should run periodically
-    MAP_TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC);
+		// Timer 0 runs periodically and triggers the ADC at the 8000Hz
+		// sampling rate
+		HalTimerPeriodicInit(0, ADC_SAMPLE_RATE_HZ);
+		HalTimerADCTriggerEnable(0);
 
-    // Set the value that is loaded into the timer everytime it finishes
-    // it's the number of clock cycles it takes till the timer triggers the ADC
-		// frequency set to 8000Hz sampling rate set by the timer
-    #define F_SAMPLE    8000
-	
-    MAP_TimerLoadSet(TIMER0_BASE, TIMER_A, ((SysCtlClockGet()/F_SAMPLE)-1));
+		// Enable processor interrupts.
+		HalIntMasterEnable();
+		HalADCIntRegister(1, ADC0IntHandler);
 
-    // Enable triggering
-    MAP_TimerControlTrigger(TIMER0_BASE, TIMER_A, true);
+		// Enable the timer
+		HalTimerEnable(0);
 
-    // Enable processor interrupts.
-    MAP_IntMasterEnable();
-		ADCIntRegister(ADC0_BASE, 1, ADC0IntHandler);
-    MAP_ADCIntEnable(ADC0_BASE, 1);
+}
 
-    // Enable the timer
-    MAP_TimerEnable(TIMER0_BASE, TIMER_A);
+//*****************************************************************************
+//
+// Adds the cycles since *pui32Mark to a stage and moves the mark on.
+//
+//*****************************************************************************
+static inline void ADCStageAccount(uint32_t ui32Stage, uint32_t *pui32Mark)
+{
+    uint32_t ui32Now = TimestampGet(), ui32Cycles = ui32Now - *pui32Mark;
 
+    g_sADCStages.pui64Cycles[ui32Stage] += ui32Cycles;
+    if(ui32Cycles > g_sADCStages.pui32MaxCycles[ui32Stage])
+    {
+        g_sADCStages.pui32MaxCycles[ui32Stage] = ui32Cycles;
+    }
+    *pui32Mark = ui32Now;
 }
 
 void ADC0IntHandler(void) {
 	
+    tADCFrame *psFrame;
+    uint32_t ui32Seq = SensorBusSeqGet(&g_sADCTopic), ui32Faults;
+    uint32_t ui32Start = TimestampGet(), ui32Mark = ui32Start;
+
+    TRACE_ISR_ENTER(TRACE_ISR_ADC0);
+
     // Clear the interrupt status flag.
-    MAP_ADCIntClear(ADC0_BASE, 1);
+    HalADCIntClear(1);
 	  // Read ADC Data
-    MAP_ADCSequenceDataGet(ADC0_BASE, 1, ADCData);
+    HalADCDataGet(1, ADCData);
+    // A conversion was lost while the FIFO was full
+    if(HalADCOverflow(1))
+    {
+        g_sADCStages.ui32Overruns++;
+    }
+
+    // Publish the readings as the next frame
+    psFrame = (tADCFrame *)SensorBusPublishBegin(&g_sADCTopic);
+    psFrame->ui32Seq = ui32Seq;
+    psFrame->ui32Time = TimestampGet();
+    psFrame->pui16Data[0] = (uint16_t)ADCData[0];
+    psFrame->pui16Data[1] = (uint16_t)ADCData[1];
+    psFrame->pui16Data[2] = (uint16_t)ADCData[2];
+    psFrame->pui16Data[3] = (uint16_t)ADCData[3];
+    SensorBusPublishEnd(&g_sADCTopic);
+    ADCStageAccount(ADC_STAGE_READ, &ui32Mark);
+
+    // Safety relevant changes go out on CAN right away
+    CANEventsProcess(psFrame);
+    ADCStageAccount(ADC_STAGE_CAN_EVENTS, &ui32Mark);
+    // Wiring and sensor checks, constant cost per frame
+    SensorDiagProcess(psFrame);
+    ADCStageAccount(ADC_STAGE_DIAG, &ui32Mark);
+    // Channel statistics, one block of frames at a time from the ring. The
+    // freeze frame moves the topic on block boundaries only, so the block
+    // is in one piece.
+    if((ui32Seq & (STATS_BLOCK_FRAMES - 1)) == (STATS_BLOCK_FRAMES - 1))
+    {
+        StatsProcessFrames(SensorBusSlotGet(&g_sADCTopic,
+                                            ui32Seq + 1 - STATS_BLOCK_FRAMES),
+                           STATS_BLOCK_FRAMES);
+    }
+    ADCStageAccount(ADC_STAGE_STATS, &ui32Mark);
+    // Keep the frame for the fault snapshot, record new faults
+    ui32Faults = CANEventsFaults() |
+                 (SensorDiagActive() << ADC_FAULT_DTC_SHIFT);
+    FreezeFrameRecord(psFrame, ui32Faults);
+    if(ui32Faults & ~g_ui32ADCFaults)
+    {
+        EventLogWrite(EVENTLOG_SENSOR_FAULT, ui32Faults & ~g_ui32ADCFaults,
+                      ui32Faults, ui32Seq);
+    }
+    g_ui32ADCFaults = ui32Faults;
+    ADCStageAccount(ADC_STAGE_RECORD, &ui32Mark);
+    g_sADCStages.ui32Frames++;
+    if((ui32Mark - ui32Start) < g_sADCStages.ui32MinCycles)
+    {
+        g_sADCStages.ui32MinCycles = ui32Mark - ui32Start;
+    }
+    if((ui32Mark - ui32Start) > g_sADCStages.ui32MaxCycles)
+    {
+        g_sADCStages.ui32MaxCycles = ui32Mark - ui32Start;
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_ADC0);
 	
 }
 
+/******************************************************************************
+Description: the frame above converts all of its channels at 8kHz, the rate
+the throttle and brake need. The dampers need more than 1kHz and the
+temperature a few Hz, so they get sequencers of their own. The timer
+trigger is shared by all the timers of the ADC, a second timer rate is not
+possible, so sequencer 0 starts on the PWM trigger at ADC_SUSPENSION_RATE_HZ
+and its handler only publishes the frame. Sequencer 2 starts on the
+processor from ADCSlowRun() and is read by the next run, without an
+interrupt. The averaging of HalADCInit() applies to every sequencer.
+
+The steering stays in the 8kHz frame: the stuck and noise checks of
+sensor_diag.c, the freeze frame and the CAN messages read it there. The
+fourth step, which converted the steering a second time, now reads the
+rotary sensor of the throttle pedal, a second throttle signal running the
+other way. Call after ADCTimerTriggeredInit().
+******************************************************************************/
+uint32_t ADCExtendedInit(void)
+{
+	// PE0-> AIN3 front left, PD3-> AIN4 front right
+	static const uint8_t pui8Suspension[ADC_SUSPENSION_CHANNELS] = { 3, 4 };
+	// PD2-> AIN5 temperature
+	static const uint8_t pui8Slow[ADC_SLOW_CHANNELS] = { 5 };
+
+	SensorBusTopicRegister(&g_sADCSuspensionTopic, "suspension",
+	                       g_psADCSuspensionFrames, sizeof(tADCSuspensionFrame),
+	                       ADC_SUSPENSION_RING_SIZE);
+	SensorBusTopicRegister(&g_sADCSlowTopic, "slow", g_psADCSlowFrames,
+	                       sizeof(tADCSlowFrame), ADC_SLOW_TOPIC_SLOTS);
+
+	HalADCSequenceInit(ADC_SLOW_SEQ, HAL_ADC_TRIGGER_PROCESSOR, pui8Slow,
+	                   ADC_SLOW_CHANNELS);
+	g_bADCSlowPending = false;
+
+	HalADCSequenceInit(ADC_SUSPENSION_SEQ, HAL_ADC_TRIGGER_PWM,
+	                   pui8Suspension, ADC_SUSPENSION_CHANNELS);
+	HalADCIntRegister(ADC_SUSPENSION_SEQ, ADCSuspensionIntHandler);
+	HalADCPWMTriggerInit(ADC_SUSPENSION_RATE_HZ);
+
+	return(0);
+}
+
+void ADCSuspensionIntHandler(void)
+{
+	tADCSuspensionFrame *psFrame;
+	uint32_t pui32Data[ADC_SUSPENSION_CHANNELS], ui32Ch;
+
+	TRACE_ISR_ENTER(TRACE_ISR_ADC0SS0);
+
+	HalADCIntClear(ADC_SUSPENSION_SEQ);
+	HalADCDataGet(ADC_SUSPENSION_SEQ, pui32Data);
+	if(HalADCOverflow(ADC_SUSPENSION_SEQ))
+	{
+		g_sADCStages.ui32SuspensionOverruns++;
+	}
+
+	psFrame = (tADCSuspensionFrame *)
+	          SensorBusPublishBegin(&g_sADCSuspensionTopic);
+	psFrame->ui32Seq = SensorBusSeqGet(&g_sADCSuspensionTopic);
+	psFrame->ui32Time = TimestampGet();
+	for(ui32Ch = 0; ui32Ch < ADC_SUSPENSION_CHANNELS; ui32Ch++)
+	{
+		psFrame->pui16Data[ui32Ch] = (uint16_t)pui32Data[ui32Ch];
+	}
+	SensorBusPublishEnd(&g_sADCSuspensionTopic);
+	g_sADCStages.ui32SuspensionFrames++;
+
+	TRACE_ISR_EXIT(TRACE_ISR_ADC0SS0);
+}
+
+/******************************************************************************
+Publishes the slow conversion started by the last run and starts the next.
+A conversion takes microseconds, one still not done after 100ms is counted
+and left to the next run. Runs in the 100ms rate group.
+******************************************************************************/
+void ADCSlowRun(void)
+{
+	tADCSlowFrame *psFrame;
+	uint32_t pui32Data[4], ui32Ch;
+
+	if(g_bADCSlowPending)
+	{
+		if(!HalADCIntStatus(ADC_SLOW_SEQ))
+		{
+			g_sADCStages.ui32SlowMisses++;
+			return;
+		}
+
+		HalADCIntClear(ADC_SLOW_SEQ);
+		HalADCDataGet(ADC_SLOW_SEQ, pui32Data);
+
+		psFrame = (tADCSlowFrame *)SensorBusPublishBegin(&g_sADCSlowTopic);
+		psFrame->ui32Seq = SensorBusSeqGet(&g_sADCSlowTopic);
+		psFrame->ui32Time = g_ui32ADCSlowTrigger;
+		for(ui32Ch = 0; ui32Ch < ADC_SLOW_CHANNELS; ui32Ch++)
+		{
+			psFrame->pui16Data[ui32Ch] = (uint16_t)pui32Data[ui32Ch];
+		}
+		SensorBusPublishEnd(&g_sADCSlowTopic);
+		g_sADCStages.ui32SlowFrames++;
+	}
+
+	g_ui32ADCSlowTrigger = TimestampGet();
+	g_bADCSlowPending = true;
+	HalADCProcessorTrigger(ADC_SLOW_SEQ);
+}
+
 uint32_t ADCGetSensor1() {
-	return ADCData[0];
+	return ADCData[ADC_CH_THROTTLE];
 }
 
 uint32_t ADCGetSensor2() {
-	return ADCData[1];
+	return ADCData[ADC_CH_BRAKE];
 }
 
 uint32_t ADCGetSensor3() {
-	return ADCData[2];
+	return ADCData[ADC_CH_STEERING];
+}
+
+/******************************************************************************
+Returns the sequence number of the next frame, i.e. the position a new reader
+should start reading from.
+******************************************************************************/
+uint32_t ADCFrameSeqGet(void)
+{
+	return SensorBusSeqGet(&g_sADCTopic);
+}
+
+/******************************************************************************
+Copies the frame with sequence number *pui32Seq and advances the reader. If the
+reader fell behind by more than the ring size it skips forward to the oldest
+frame still available, the gap shows in the frame sequence numbers. Returns
+false when there is no new frame yet. A reader of its own on the sensor bus,
+see SensorBusRead().
+******************************************************************************/
+bool ADCFrameRead(uint32_t *pui32Seq, tADCFrame *psFrame)
+{
+	tSensorBusSub sSub = { "", &g_sADCTopic, *pui32Seq, 0, 0, 0 };
+	bool bRead;
+
+	bRead = SensorBusRead(&sSub, psFrame);
+	*pui32Seq = sSub.ui32Seq;
+
+	return bRead;
+}
+
+/******************************************************************************
+Copies the newest frame. Used by interrupt handlers that only need the current
+readings and do not follow the stream. Returns false before the first frame.
+******************************************************************************/
+bool ADCFrameLatest(tADCFrame *psFrame)
+{
+	return SensorBusLatestRead(&g_sADCTopic, psFrame);
+}
+
+/******************************************************************************
+Copy the newest frame of the dampers and of the slow channels. Return false
+before the first.
+******************************************************************************/
+bool ADCSuspensionLatest(tADCSuspensionFrame *psFrame)
+{
+	return SensorBusLatestRead(&g_sADCSuspensionTopic, psFrame);
+}
+
+bool ADCSlowLatest(tADCSlowFrame *psFrame)
+{
+	return SensorBusLatestRead(&g_sADCSlowTopic, psFrame);
+}
+
+/******************************************************************************
+Copies the stage cycle counts. The handler may run in between two stages, so
+the copy is taken with interrupts masked.
+******************************************************************************/
+void ADCStageStatsGet(tADCStageStats *psStats)
+{
+	uint32_t ui32Masked = HalIntMasterDisable();
+
+	*psStats = g_sADCStages;
+
+	if(!ui32Masked)
+	{
+		HalIntMasterEnable();
+	}
+}
+
+void ADCStageStatsReset(void)
+{
+	uint32_t ui32Masked = HalIntMasterDisable();
+	uint32_t ui32Stage;
+
+	g_sADCStages.ui32Frames = 0;
+	g_sADCStages.ui32MinCycles = 0xFFFFFFFF;
+	g_sADCStages.ui32MaxCycles = 0;
+	g_sADCStages.ui32Overruns = 0;
+	g_sADCStages.ui32SuspensionFrames = 0;
+	g_sADCStages.ui32SuspensionOverruns = 0;
+	g_sADCStages.ui32SlowFrames = 0;
+	g_sADCStages.ui32SlowMisses = 0;
+	for(ui32Stage = 0; ui32Stage < ADC_NUM_STAGES; ui32Stage++)
+	{
+		g_sADCStages.pui64Cycles[ui32Stage] = 0;
+		g_sADCStages.pui32MaxCycles[ui32Stage] = 0;
+	}
+
+	if(!ui32Masked)
+	{
+		HalIntMasterEnable();
+	}
+}
+
+/******************************************************************************
+Prints the average and longest cycles of every stage per frame and the share
+of the CPU the handler takes at the sample rate.
+******************************************************************************/
+void ADCStageReport(void)
+{
+	tADCStageStats sStats;
+	uint32_t ui32Stage, ui32Avg, ui32Total = 0, ui32Load;
+
+	ADCStageStatsGet(&sStats);
+	if(sStats.ui32Frames == 0)
+	{
+		UARTprintf("ADC: no frames\n");
+		return;
+	}
+
+	UARTprintf("ADC: %u frames, cycles per frame avg max\n", sStats.ui32Frames);
+	for(ui32Stage = 0; ui32Stage < ADC_NUM_STAGES; ui32Stage++)
+	{
+		ui32Avg = (uint32_t)(sStats.pui64Cycles[ui32Stage] / sStats.ui32Frames);
+		ui32Total += ui32Avg;
+		UARTprintf("  %s\t%u\t%u\n", g_ppcADCStageNames[ui32Stage], ui32Avg,
+		           sStats.pui32MaxCycles[ui32Stage]);
+	}
+	// share of the CPU in 0.01 %
+	ui32Load = (uint32_t)(((uint64_t)ui32Total * ADC_SAMPLE_RATE_HZ * 10000) /
+	                      HAL_SYS_CLOCK_HZ);
+	UARTprintf("  total\t%u, %u.%02u%% CPU at %uHz\n", ui32Total,
+	           ui32Load / 100, ui32Load % 100, ADC_SAMPLE_RATE_HZ);
+	UARTprintf("  overruns\t%u\n", sStats.ui32Overruns);
+	UARTprintf("  suspension\t%u frames at %uHz, %u overruns\n",
+	           sStats.ui32SuspensionFrames, ADC_SUSPENSION_RATE_HZ,
+	           sStats.ui32SuspensionOverruns);
+	UARTprintf("  slow\t%u frames, %u late\n", sStats.ui32SlowFrames,
+	           sStats.ui32SlowMisses);
 }
@@ -1,7 +1,100 @@
 #ifndef ADC_SG_H
 #define ADC_SG_H
 
+#include "ram_budget.h"
 
+//*****************************************************************************
+//
+// Every timer triggered conversion of the sequencer produces one frame. The
+// frames are published on the "adc" topic of the sensor bus, so several
+// readers can follow the stream at their own pace. The ring of the topic
+// takes the whole RAM budget of the frames, it is the history of the freeze
+// frame too.
+//
+//*****************************************************************************
+#define ADC_NUM_CHANNELS				4
+#define ADC_SAMPLE_RATE_HZ				8000
+
+// channels of the frame, in the order of the steps of sequencer 1
+#define ADC_CH_THROTTLE					0		// AIN0, PE3
+#define ADC_CH_BRAKE					1		// AIN1, PE2
+#define ADC_CH_STEERING					2		// AIN6, PD1
+#define ADC_CH_THROTTLE_ROTARY			3		// AIN10, PB4, falls as pressed
+
+typedef struct
+{
+	uint32_t ui32Seq;							// frame sequence number
+	uint32_t ui32Time;							// DWT timestamp of the conversion
+	uint16_t pui16Data[ADC_NUM_CHANNELS];		// 12-bit readings
+}
+tADCFrame;
+
+// must be power of two
+#define ADC_FRAME_RING_SIZE				(RAM_BUDGET_ADC_FRAMES / sizeof(tADCFrame))
+
+//*****************************************************************************
+//
+// Extended acquisition, the channels that need a rate of their own instead
+// of the one of the frame. Sequencer 0 converts the front damper
+// potentiometers at ADC_SUSPENSION_RATE_HZ on the PWM trigger and publishes
+// them on the "suspension" topic. Sequencer 2 converts the temperature once
+// every run of the 100ms rate group and publishes it on "slow", one run
+// after the conversion started.
+//
+//*****************************************************************************
+#define ADC_SUSPENSION_CHANNELS			2
+#define ADC_SUSPENSION_FRONT_LEFT		0		// AIN3, PE0
+#define ADC_SUSPENSION_FRONT_RIGHT		1		// AIN4, PD3
+#define ADC_SUSPENSION_RING_SIZE		64		// must be power of two
+#define ADC_SUSPENSION_RATE_HZ			2000
+
+#define ADC_SLOW_CHANNELS				1
+#define ADC_SLOW_TEMPERATURE			0		// AIN5, PD2
+#define ADC_SLOW_TOPIC_SLOTS			8		// must be power of two
+
+typedef struct
+{
+	uint32_t ui32Seq;							// frame sequence number
+	uint32_t ui32Time;							// DWT timestamp of the conversion
+	uint16_t pui16Data[ADC_SUSPENSION_CHANNELS];	// 12-bit readings
+}
+tADCSuspensionFrame;
+
+typedef struct
+{
+	uint32_t ui32Seq;							// frame sequence number
+	uint32_t ui32Time;							// DWT timestamp of the trigger
+	uint16_t pui16Data[ADC_SLOW_CHANNELS];		// 12-bit readings
+}
+tADCSlowFrame;
+
+//*****************************************************************************
+//
+// Cycles spent in the stages of ADC0IntHandler(), counted with the DWT
+// timestamp around every stage of every frame.
+//
+//*****************************************************************************
+#define ADC_STAGE_READ					0		// FIFO read, frame published
+#define ADC_STAGE_CAN_EVENTS			1
+#define ADC_STAGE_DIAG					2
+#define ADC_STAGE_STATS					3		// every STATS_BLOCK_FRAMES
+#define ADC_STAGE_RECORD				4		// freeze frame, event log
+#define ADC_NUM_STAGES					5
+
+typedef struct
+{
+	uint32_t ui32Frames;
+	uint64_t pui64Cycles[ADC_NUM_STAGES];		// sum over all frames
+	uint32_t pui32MaxCycles[ADC_NUM_STAGES];	// longest single frame
+	uint32_t ui32MinCycles;						// whole handler
+	uint32_t ui32MaxCycles;
+	uint32_t ui32Overruns;						// FIFO overflows seen
+	uint32_t ui32SuspensionFrames;
+	uint32_t ui32SuspensionOverruns;
+	uint32_t ui32SlowFrames;
+	uint32_t ui32SlowMisses;					// conversions not done in 100ms
+}
+tADCStageStats;
 
 
 void AdcSgInit(void);
@@ -15,6 +108,23 @@ uint32_t ADCGetSensor1(void);
 uint32_t ADCGetSensor2(void);
 uint32_t ADCGetSensor3(void);
 
+uint32_t ADCExtendedInit(void);
+void ADCSlowRun(void);
+
+extern struct tSensorBusTopic g_sADCTopic;
+extern struct tSensorBusTopic g_sADCSuspensionTopic;
+extern struct tSensorBusTopic g_sADCSlowTopic;
+
+uint32_t ADCFrameSeqGet(void);
+bool ADCFrameRead(uint32_t *pui32Seq, tADCFrame *psFrame);
+bool ADCFrameLatest(tADCFrame *psFrame);
+bool ADCSuspensionLatest(tADCSuspensionFrame *psFrame);
+bool ADCSlowLatest(tADCSlowFrame *psFrame);
+
+void ADCStageStatsGet(tADCStageStats *psStats);
+void ADCStageStatsReset(void);
+void ADCStageReport(void);
+
 
 
 #endif
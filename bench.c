@@ -0,0 +1,442 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Micro benchmarks of the firmware hot paths
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/uartstdio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timestamp.h"
+#include "adc_api.h"
+#include "ADC_task.h"
+#include "sensors.h"
+#include "calib.h"
+#include "stats.h"
+#include "compress.h"
+#include "lcd_i2c.h"
+#include "lcd_task.h"
+#include "i2cDriver.h"
+#include "delay.h"
+#include "block_pool.h"
+#include "ram_budget.h"
+#include "bench.h"
+
+#if !defined(ECU_BENCH)
+#error "bench.c is part of the bench build only, see ram_budget.h"
+#endif
+
+/******************************************************************************
+Description: the computing kernels run on a fixed set of synthetic frames
+with state of their own, so a benchmark on the board does not disturb the
+sampling: the calibration is only read, the filter, statistics and
+compression state belong to the benchmark. The LCD and I2C cases hold the LCD
+mutex and write commands that leave the display as it is. The ADC interrupt
+handler is not called from here, its case resets the stage counts of
+adc_api.c and reads them after BENCH_ADC_FRAMES live frames.
+******************************************************************************/
+
+#define BENCH_RUNS                      100
+#define BENCH_IO_RUNS                   10
+
+#define BENCH_FRAMES                    STATS_BLOCK_FRAMES
+#define BENCH_SAMPLES                   64
+#define BENCH_ITOA_CALLS                16
+#define BENCH_QUEUE_ITEMS               16
+#define BENCH_POOL_BLOCKS               16
+#define BENCH_ADC_FRAMES                400
+#define BENCH_ADC_TIMEOUT_MS            1000
+
+// the LCD backpack of lcd_task.c
+#define BENCH_LCD_ADDR                  0x3F
+
+#define BENCH_FRAME_STRIDE              (sizeof(tADCFrame) / sizeof(uint16_t))
+
+extern xSemaphoreHandle g_pLCDSemaphore;
+
+static tADCFrame g_psBenchFrames[BENCH_FRAMES];
+static uint16_t g_pui16BenchSamples[BENCH_SAMPLES];
+static bool g_bBenchReady = false;
+
+static tStatsAccum g_sBenchAccum;
+static tCompressBlock g_sBenchBlock;
+static uint8_t g_pui8BenchPacked[COMPRESS_BLOCK_MAX(BENCH_FRAMES,
+                                                   ADC_NUM_CHANNELS)];
+static uint32_t g_ui32BenchPacked;
+static int32_t g_i32BenchFiltered;
+static xQueueHandle g_pBenchQueue;
+static tBlockPool g_sBenchPool;
+static void *g_ppvBenchBlocks[BENCH_POOL_BLOCKS];
+BLOCK_POOL_STORAGE(g_ppvBenchPoolStorage, sizeof(tADCFrame), BENCH_POOL_BLOCKS);
+
+typedef char tBenchBudget[(sizeof(g_psBenchFrames) +
+                           sizeof(g_pui16BenchSamples) +
+                           sizeof(g_sBenchAccum) + sizeof(g_sBenchBlock) +
+                           sizeof(g_pui8BenchPacked) +
+                           sizeof(g_ppvBenchBlocks) +
+                           sizeof(g_ppvBenchPoolStorage) <=
+                           RAM_BUDGET_BENCH) ? 1 : -1];
+
+// results go here so the compiler keeps the work
+static volatile int32_t g_i32BenchSink;
+
+//*****************************************************************************
+//
+// Builds the input frames and the queue, once. Throttle ramp with a few
+// counts of noise, steady brake, steering moving.
+//
+//*****************************************************************************
+void BenchInit(void)
+{
+    uint32_t ui32Idx, ui32Noise = 1;
+
+    if(g_bBenchReady)
+    {
+        return;
+    }
+
+    for(ui32Idx = 0; ui32Idx < BENCH_FRAMES; ui32Idx++)
+    {
+        ui32Noise = (ui32Noise * 1103515245) + 12345;
+        g_psBenchFrames[ui32Idx].ui32Seq = ui32Idx;
+        g_psBenchFrames[ui32Idx].ui32Time =
+            ui32Idx * (TIMESTAMP_CYCLES_PER_US * 1000000 / ADC_SAMPLE_RATE_HZ);
+        g_psBenchFrames[ui32Idx].pui16Data[ADC_CH_THROTTLE] =
+            (uint16_t)(400 + (ui32Idx * 100) + ((ui32Noise >> 16) & 7));
+        g_psBenchFrames[ui32Idx].pui16Data[ADC_CH_BRAKE] =
+            (uint16_t)(300 + ((ui32Noise >> 20) & 3));
+        g_psBenchFrames[ui32Idx].pui16Data[ADC_CH_STEERING] =
+            (uint16_t)(2048 + (ui32Idx * 37) - ((ui32Noise >> 24) & 15));
+        g_psBenchFrames[ui32Idx].pui16Data[ADC_CH_THROTTLE_ROTARY] =
+            (uint16_t)(4095 -
+                       g_psBenchFrames[ui32Idx].pui16Data[ADC_CH_THROTTLE]);
+    }
+
+    for(ui32Idx = 0; ui32Idx < BENCH_SAMPLES; ui32Idx++)
+    {
+        g_pui16BenchSamples[ui32Idx] = (uint16_t)((ui32Idx * 4095) /
+                                                  (BENCH_SAMPLES - 1));
+    }
+
+    g_pBenchQueue = xQueueCreate(1, sizeof(uint32_t));
+    BlockPoolInit(&g_sBenchPool, "bench", g_ppvBenchPoolStorage,
+                  sizeof(tADCFrame), BENCH_POOL_BLOCKS);
+    g_bBenchReady = true;
+}
+
+//*****************************************************************************
+//
+// Times ui32Runs calls of the body.
+//
+//*****************************************************************************
+static void BenchTime(void (*pfnBody)(void), uint32_t ui32Runs,
+                      uint32_t ui32Items, tBenchResult *psResult)
+{
+    uint32_t ui32Run, ui32Start, ui32Cycles;
+    uint64_t ui64Sum = 0;
+
+    psResult->ui32Runs = ui32Runs;
+    psResult->ui32MinCycles = 0xFFFFFFFF;
+    psResult->ui32MaxCycles = 0;
+    psResult->ui32Items = ui32Items;
+    psResult->ui32Bytes = 0;
+
+    for(ui32Run = 0; ui32Run < ui32Runs; ui32Run++)
+    {
+        ui32Start = TimestampGet();
+        pfnBody();
+        ui32Cycles = TimestampGet() - ui32Start;
+
+        ui64Sum += ui32Cycles;
+        if(ui32Cycles < psResult->ui32MinCycles)
+        {
+            psResult->ui32MinCycles = ui32Cycles;
+        }
+        if(ui32Cycles > psResult->ui32MaxCycles)
+        {
+            psResult->ui32MaxCycles = ui32Cycles;
+        }
+    }
+
+    psResult->ui32AvgCycles = (uint32_t)(ui64Sum / ui32Runs);
+}
+
+//*****************************************************************************
+//
+// The benchmark bodies.
+//
+//*****************************************************************************
+static void BenchCalibScaleBody(void)
+{
+    uint32_t ui32Idx;
+    int32_t i32Sum = 0;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_SAMPLES; ui32Idx++)
+    {
+        i32Sum += CalibScale(ADC_CH_THROTTLE, g_pui16BenchSamples[ui32Idx]);
+    }
+    g_i32BenchSink = i32Sum;
+}
+
+static void BenchThrottleBody(void)
+{
+    uint32_t ui32Idx;
+    int32_t i32Sum = 0;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_SAMPLES; ui32Idx++)
+    {
+        i32Sum += ADCTaskThrottleRequest(g_pui16BenchSamples[ui32Idx],
+                                         &g_i32BenchFiltered);
+    }
+    g_i32BenchSink = i32Sum;
+}
+
+static void BenchStatsBody(void)
+{
+    uint32_t ui32Ch;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        StatsAccumReset(&g_sBenchAccum);
+        StatsBlockUpdate(&g_sBenchAccum, &g_psBenchFrames[0].pui16Data[ui32Ch],
+                         BENCH_FRAME_STRIDE, BENCH_FRAMES);
+    }
+    g_i32BenchSink = (int32_t)g_sBenchAccum.ui64SumSq;
+}
+
+static void BenchCompressBody(void)
+{
+    uint32_t ui32Idx;
+
+    CompressBlockInit(&g_sBenchBlock, ADC_NUM_CHANNELS);
+    for(ui32Idx = 0; ui32Idx < BENCH_FRAMES; ui32Idx++)
+    {
+        CompressBlockAdd(&g_sBenchBlock, g_psBenchFrames[ui32Idx].ui32Seq,
+                         g_psBenchFrames[ui32Idx].ui32Time,
+                         g_psBenchFrames[ui32Idx].pui16Data);
+    }
+    g_ui32BenchPacked = CompressBlockFinish(&g_sBenchBlock, g_pui8BenchPacked);
+}
+
+static void BenchItoasciiBody(void)
+{
+    char pcBuffer[6];
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_ITOA_CALLS; ui32Idx++)
+    {
+        itoascii(g_pui16BenchSamples[ui32Idx * 4] * 10, pcBuffer);
+    }
+    g_i32BenchSink = pcBuffer[4];
+}
+
+static void BenchLCDBody(void)
+{
+    lcdI2cSetCursor(0, 0);
+}
+
+static void BenchI2CBody(void)
+{
+    i2cDriverWrite(BENCH_LCD_ADDR, LCD_BACKLIGHT);
+}
+
+static void BenchQueueBody(void)
+{
+    uint32_t ui32Idx, ui32Item = 0;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_QUEUE_ITEMS; ui32Idx++)
+    {
+        xQueueSend(g_pBenchQueue, &ui32Idx, 0);
+        xQueueReceive(g_pBenchQueue, &ui32Item, 0);
+    }
+    g_i32BenchSink = (int32_t)ui32Item;
+}
+
+static void BenchPoolBody(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_POOL_BLOCKS; ui32Idx++)
+    {
+        g_ppvBenchBlocks[ui32Idx] = BlockPoolAlloc(&g_sBenchPool);
+    }
+    for(ui32Idx = 0; ui32Idx < BENCH_POOL_BLOCKS; ui32Idx++)
+    {
+        BlockPoolFree(&g_sBenchPool, g_ppvBenchBlocks[ui32Idx]);
+    }
+}
+
+static void BenchDelay1Body(void)
+{
+    delay_us(1);
+}
+
+static void BenchDelay100Body(void)
+{
+    delay_us(100);
+}
+
+//*****************************************************************************
+//
+// The cases.
+//
+//*****************************************************************************
+static void BenchADCHandler(tBenchResult *psResult)
+{
+    tADCStageStats sStats;
+    uint32_t ui32Stage, ui32Waited = 0;
+    uint64_t ui64Sum = 0;
+
+    ADCStageStatsReset();
+    do
+    {
+        vTaskDelay(1);
+        ADCStageStatsGet(&sStats);
+    }
+    while((sStats.ui32Frames < BENCH_ADC_FRAMES) &&
+          (++ui32Waited < BENCH_ADC_TIMEOUT_MS));
+
+    for(ui32Stage = 0; ui32Stage < ADC_NUM_STAGES; ui32Stage++)
+    {
+        ui64Sum += sStats.pui64Cycles[ui32Stage];
+    }
+
+    psResult->ui32Runs = sStats.ui32Frames;
+    psResult->ui32MinCycles = sStats.ui32Frames ? sStats.ui32MinCycles : 0;
+    psResult->ui32AvgCycles = sStats.ui32Frames ?
+                              (uint32_t)(ui64Sum / sStats.ui32Frames) : 0;
+    psResult->ui32MaxCycles = sStats.ui32MaxCycles;
+    psResult->ui32Items = 1;
+    psResult->ui32Bytes = 0;
+}
+
+static void BenchCalibScale(tBenchResult *psResult)
+{
+    BenchTime(BenchCalibScaleBody, BENCH_RUNS, BENCH_SAMPLES, psResult);
+}
+
+static void BenchThrottle(tBenchResult *psResult)
+{
+    g_i32BenchFiltered = 0;
+    BenchTime(BenchThrottleBody, BENCH_RUNS, BENCH_SAMPLES, psResult);
+}
+
+static void BenchStats(tBenchResult *psResult)
+{
+    BenchTime(BenchStatsBody, BENCH_RUNS, BENCH_FRAMES * ADC_NUM_CHANNELS,
+              psResult);
+}
+
+static void BenchCompress(tBenchResult *psResult)
+{
+    BenchTime(BenchCompressBody, BENCH_RUNS, BENCH_FRAMES, psResult);
+    psResult->ui32Bytes = g_ui32BenchPacked;
+}
+
+static void BenchItoascii(tBenchResult *psResult)
+{
+    BenchTime(BenchItoasciiBody, BENCH_RUNS, BENCH_ITOA_CALLS, psResult);
+}
+
+static void BenchLCD(tBenchResult *psResult)
+{
+    xSemaphoreTake(g_pLCDSemaphore, portMAX_DELAY);
+    BenchTime(BenchLCDBody, BENCH_IO_RUNS, 1, psResult);
+    xSemaphoreGive(g_pLCDSemaphore);
+}
+
+static void BenchI2C(tBenchResult *psResult)
+{
+    xSemaphoreTake(g_pLCDSemaphore, portMAX_DELAY);
+    BenchTime(BenchI2CBody, BENCH_IO_RUNS, 1, psResult);
+    xSemaphoreGive(g_pLCDSemaphore);
+}
+
+static void BenchQueue(tBenchResult *psResult)
+{
+    BenchTime(BenchQueueBody, BENCH_RUNS, BENCH_QUEUE_ITEMS, psResult);
+}
+
+static void BenchPool(tBenchResult *psResult)
+{
+    BenchTime(BenchPoolBody, BENCH_RUNS, BENCH_POOL_BLOCKS, psResult);
+}
+
+static void BenchDelay1(tBenchResult *psResult)
+{
+    BenchTime(BenchDelay1Body, BENCH_IO_RUNS, 1, psResult);
+}
+
+static void BenchDelay100(tBenchResult *psResult)
+{
+    BenchTime(BenchDelay100Body, BENCH_IO_RUNS, 100, psResult);
+}
+
+const tBenchCase g_psBenchCases[] =
+{
+    { "adc_isr",          "frame",   BenchADCHandler },
+    { "calib_scale",      "sample",  BenchCalibScale },
+    { "throttle_request", "sample",  BenchThrottle },
+    { "stats_block",      "sample",  BenchStats },
+    { "compress_block",   "frame",   BenchCompress },
+    { "itoascii",         "call",    BenchItoascii },
+    { "lcd_send",         "command", BenchLCD },
+    { "i2c_write",        "byte",    BenchI2C },
+    { "queue_send_recv",  "item",    BenchQueue },
+    { "pool_alloc_free",  "block",   BenchPool },
+    { "delay_us_1",       "us",      BenchDelay1 },
+    { "delay_us_100",     "us",      BenchDelay100 },
+};
+
+const uint32_t g_ui32BenchNumCases = sizeof(g_psBenchCases) /
+                                     sizeof(g_psBenchCases[0]);
+
+void BenchPrintHeader(void)
+{
+    UARTprintf("bench,name,runs,min_cycles,avg_cycles,max_cycles,items,item,"
+               "bytes\n");
+}
+
+void BenchPrint(const tBenchCase *psCase, const tBenchResult *psResult)
+{
+    UARTprintf("bench,%s,%u,%u,%u,%u,%u,%s,%u\n", psCase->pcName,
+               psResult->ui32Runs, psResult->ui32MinCycles,
+               psResult->ui32AvgCycles, psResult->ui32MaxCycles,
+               psResult->ui32Items, psCase->pcItem, psResult->ui32Bytes);
+}
+
+//*****************************************************************************
+//
+// Runs all cases, or the one named, and prints their lines. Must be called
+// from a task. Returns false if no case has the name.
+//
+//*****************************************************************************
+bool BenchRun(const char *pcName)
+{
+    tBenchResult sResult;
+    uint32_t ui32Idx;
+    bool bFound = false;
+
+    BenchInit();
+
+    for(ui32Idx = 0; ui32Idx < g_ui32BenchNumCases; ui32Idx++)
+    {
+        if(pcName && strcmp(pcName, g_psBenchCases[ui32Idx].pcName))
+        {
+            continue;
+        }
+
+        if(!bFound)
+        {
+            BenchPrintHeader();
+            bFound = true;
+        }
+        g_psBenchCases[ui32Idx].pfnRun(&sResult);
+        BenchPrint(&g_psBenchCases[ui32Idx], &sResult);
+    }
+
+    return bFound;
+}
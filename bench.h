@@ -0,0 +1,49 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Micro benchmarks of the firmware hot paths. Every case runs its code a
+// number of times and times each run with the DWT cycle counter. The same
+// cases run on the board from the console ("bench") of a bench build, see
+// ram_budget.h, and on the host in tools/bench/ecu_bench.c, both print one
+// line per case:
+//
+//   bench,name,runs,min_cycles,avg_cycles,max_cycles,items,item,bytes
+//
+// Cycles are per run, a run handles "items" of "item" (samples, frames,
+// calls) and produces "bytes" of output where that matters, 0 otherwise.
+// Interrupts stay enabled, so compare the minimum between builds.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Runs;
+    uint32_t ui32MinCycles;
+    uint32_t ui32AvgCycles;
+    uint32_t ui32MaxCycles;
+    uint32_t ui32Items;
+    uint32_t ui32Bytes;
+}
+tBenchResult;
+
+typedef struct
+{
+    const char *pcName;
+    const char *pcItem;
+    void (*pfnRun)(tBenchResult *psResult);
+}
+tBenchCase;
+
+extern const tBenchCase g_psBenchCases[];
+extern const uint32_t g_ui32BenchNumCases;
+
+void BenchInit(void);
+void BenchPrintHeader(void);
+void BenchPrint(const tBenchCase *psCase, const tBenchResult *psResult);
+bool BenchRun(const char *pcName);
+
+#endif
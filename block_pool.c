@@ -0,0 +1,226 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Fixed size block pools, constant time and safe from interrupt handlers
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "block_pool.h"
+
+/******************************************************************************
+Description: the free blocks of a pool form a singly linked list through
+their first word, so taking a block is popping the head of the list and
+freeing one is pushing it, a few loads and stores with interrupts masked
+like LOGn() and EventLogWrite(). No search, no splitting or merging, no
+fragmentation: a pool that had a free block at its low water mark never
+fails, and the statistics show how close each pool came.
+
+A free checks that the pointer is the start of a block of the pool and
+counts it instead of corrupting the list otherwise. Freeing the same block
+twice is not caught.
+******************************************************************************/
+
+static tBlockPool *g_psBlockPools = NULL;
+
+//*****************************************************************************
+//
+// Links the blocks of the storage into the free list and adds the pool to
+// the list of "pool". Call before the pool is used by tasks or interrupts.
+//
+//*****************************************************************************
+void BlockPoolInit(tBlockPool *psPool, const char *pcName, void *pvStorage,
+                   uint32_t ui32BlockSize, uint32_t ui32NumBlocks)
+{
+    uint8_t *pui8Block;
+    uint32_t ui32Idx;
+
+    psPool->pcName = pcName;
+    psPool->ui32BlockSize = BLOCK_POOL_BLOCK_SIZE(ui32BlockSize);
+    psPool->ui32NumBlocks = ui32NumBlocks;
+    psPool->pui8Start = (uint8_t *)pvStorage;
+    psPool->pui8End = psPool->pui8Start +
+                      (psPool->ui32BlockSize * ui32NumBlocks);
+
+    psPool->pvFree = NULL;
+    for(ui32Idx = ui32NumBlocks; ui32Idx > 0; ui32Idx--)
+    {
+        pui8Block = psPool->pui8Start +
+                    ((ui32Idx - 1) * psPool->ui32BlockSize);
+        *(void **)pui8Block = psPool->pvFree;
+        psPool->pvFree = pui8Block;
+    }
+
+    psPool->ui32Free = ui32NumBlocks;
+    psPool->ui32MinFree = ui32NumBlocks;
+    psPool->ui32Allocs = 0;
+    psPool->ui32Fails = 0;
+    psPool->ui32BadFrees = 0;
+
+    psPool->psNext = g_psBlockPools;
+    g_psBlockPools = psPool;
+}
+
+//*****************************************************************************
+//
+// Takes a block. Returns NULL when the pool is empty, never waits.
+//
+//*****************************************************************************
+void *BlockPoolAlloc(tBlockPool *psPool)
+{
+    void *pvBlock;
+    uint32_t ui32Masked;
+
+    ui32Masked = HalIntMasterDisable();
+
+    pvBlock = psPool->pvFree;
+    if(pvBlock)
+    {
+        psPool->pvFree = *(void **)pvBlock;
+        psPool->ui32Allocs++;
+        if(--psPool->ui32Free < psPool->ui32MinFree)
+        {
+            psPool->ui32MinFree = psPool->ui32Free;
+        }
+    }
+    else
+    {
+        psPool->ui32Fails++;
+    }
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+
+    return pvBlock;
+}
+
+//*****************************************************************************
+//
+// Gives a block back to its pool.
+//
+//*****************************************************************************
+void BlockPoolFree(tBlockPool *psPool, void *pvBlock)
+{
+    uint8_t *pui8Block = (uint8_t *)pvBlock;
+    uint32_t ui32Masked;
+
+    ui32Masked = HalIntMasterDisable();
+
+    if((pui8Block < psPool->pui8Start) || (pui8Block >= psPool->pui8End) ||
+       (((uint32_t)(pui8Block - psPool->pui8Start) %
+         psPool->ui32BlockSize) != 0))
+    {
+        psPool->ui32BadFrees++;
+    }
+    else
+    {
+        *(void **)pui8Block = psPool->pvFree;
+        psPool->pvFree = pui8Block;
+        psPool->ui32Free++;
+    }
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Copies the statistics of a pool, consistent with each other.
+//
+//*****************************************************************************
+void BlockPoolStatsGet(tBlockPool *psPool, tBlockPoolStats *psStats)
+{
+    uint32_t ui32Masked;
+
+    ui32Masked = HalIntMasterDisable();
+
+    psStats->ui32Blocks = psPool->ui32NumBlocks;
+    psStats->ui32Free = psPool->ui32Free;
+    psStats->ui32MinFree = psPool->ui32MinFree;
+    psStats->ui32Allocs = psPool->ui32Allocs;
+    psStats->ui32Fails = psPool->ui32Fails;
+    psStats->ui32BadFrees = psPool->ui32BadFrees;
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Restarts the counters and the low water mark from the current state.
+//
+//*****************************************************************************
+void BlockPoolStatsReset(tBlockPool *psPool)
+{
+    uint32_t ui32Masked;
+
+    ui32Masked = HalIntMasterDisable();
+
+    psPool->ui32MinFree = psPool->ui32Free;
+    psPool->ui32Allocs = 0;
+    psPool->ui32Fails = 0;
+    psPool->ui32BadFrees = 0;
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// The pools, linked by psNext.
+//
+//*****************************************************************************
+tBlockPool *BlockPools(void)
+{
+    return g_psBlockPools;
+}
+
+//*****************************************************************************
+//
+// Returns the pool with the given name, or NULL.
+//
+//*****************************************************************************
+tBlockPool *BlockPoolFind(const char *pcName)
+{
+    tBlockPool *psPool;
+
+    for(psPool = g_psBlockPools; psPool != NULL; psPool = psPool->psNext)
+    {
+        if(strcmp(psPool->pcName, pcName) == 0)
+        {
+            break;
+        }
+    }
+
+    return psPool;
+}
+
+//*****************************************************************************
+//
+// Prints the statistics of every pool. The caller must own the UART.
+//
+//*****************************************************************************
+void BlockPoolReport(void)
+{
+    tBlockPoolStats sStats;
+    tBlockPool *psPool;
+
+    UARTprintf("\npool       size  blocks  free  min free  allocs  fails  bad\n");
+    for(psPool = g_psBlockPools; psPool != NULL; psPool = psPool->psNext)
+    {
+        BlockPoolStatsGet(psPool, &sStats);
+        UARTprintf("%-9s  %4u  %6u  %4u  %8u  %6u  %5u  %3u\n",
+                   psPool->pcName, psPool->ui32BlockSize, sStats.ui32Blocks,
+                   sStats.ui32Free, sStats.ui32MinFree, sStats.ui32Allocs,
+                   sStats.ui32Fails, sStats.ui32BadFrees);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Fixed size block pools. A pool hands out blocks of one size from a static
+// array, in constant time and from tasks and interrupt handlers alike, so
+// sample blocks and messages can be passed on by pointer (through a queue of
+// pointers, to the uDMA) instead of being copied. Whoever holds the block
+// last frees it, again from a task or an interrupt handler. Blocks are
+// rounded up to whole pointers, word aligned for the uDMA.
+//
+//*****************************************************************************
+#define BLOCK_POOL_BLOCK_SIZE(size)                                           \
+    ((((size) + sizeof(void *) - 1) / sizeof(void *)) * sizeof(void *))
+
+// static storage for count blocks of size bytes
+#define BLOCK_POOL_STORAGE(name, size, count)                                 \
+    static void *name[(BLOCK_POOL_BLOCK_SIZE(size) / sizeof(void *)) *        \
+                      (count)]
+
+typedef struct tBlockPool
+{
+    const char *pcName;
+    uint8_t *pui8Start;
+    uint8_t *pui8End;
+    uint32_t ui32BlockSize;
+    uint32_t ui32NumBlocks;
+
+    void *pvFree;                       // free list, linked by the first word
+    uint32_t ui32Free;
+    uint32_t ui32MinFree;               // low water mark
+    uint32_t ui32Allocs;
+    uint32_t ui32Fails;                 // allocations with the pool empty
+    uint32_t ui32BadFrees;              // pointers not of this pool
+
+    struct tBlockPool *psNext;
+}
+tBlockPool;
+
+typedef struct
+{
+    uint32_t ui32Blocks;
+    uint32_t ui32Free;
+    uint32_t ui32MinFree;
+    uint32_t ui32Allocs;
+    uint32_t ui32Fails;
+    uint32_t ui32BadFrees;
+}
+tBlockPoolStats;
+
+void BlockPoolInit(tBlockPool *psPool, const char *pcName, void *pvStorage,
+                   uint32_t ui32BlockSize, uint32_t ui32NumBlocks);
+void *BlockPoolAlloc(tBlockPool *psPool);
+void BlockPoolFree(tBlockPool *psPool, void *pvBlock);
+void BlockPoolStatsGet(tBlockPool *psPool, tBlockPoolStats *psStats);
+void BlockPoolStatsReset(tBlockPool *psPool);
+tBlockPool *BlockPools(void);
+tBlockPool *BlockPoolFind(const char *pcName);
+void BlockPoolReport(void);
+
+#endif
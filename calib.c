@@ -0,0 +1,485 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Calibration parameter store in the internal EEPROM
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "hal.h"
+#include "utils/uartstdio.h"
+#include "crc16.h"
+#include "event_log.h"
+#include "ram_budget.h"
+#include "uart_log.h"
+#include "calib.h"
+
+/******************************************************************************
+Description: the sensor calibration and tuning values live in two RAM copies
+of tCalibSet. g_psCalib points at the one in use; the hot path reads it
+directly, there is no search or parsing per sample. Each copy holds a
+uniform index table per channel (lut.h) built from the lookup table points
+or the offset and gain when the set is made current, so a conversion costs
+the same whatever the calibration. A change from the
+console is made in the other copy, checked, and then g_psCalib is switched
+over in one store, so a reader always sees a complete and consistent set.
+
+The EEPROM holds two banks behind the event log, each with a header and the
+raw image of tCalibParams:
+
+    word 0      CALIB_MAGIC
+    word 1      CALIB_VERSION (bits 31:16), image size in words (bits 15:0)
+    word 2      generation, incremented with every save
+    word 3      CRC-16/CCITT-FALSE of word 2 and the image
+    word 4..    tCalibParams
+
+A save goes to the bank not holding the current set and programs the header
+last, so the previous set survives a power loss during the save. At boot the
+valid bank with the newer generation is loaded, if neither is valid the
+compiled in defaults are used until the next save.
+******************************************************************************/
+
+#define CALIB_EEPROM_BASE               (EVENTLOG_EEPROM_BASE + \
+                                         EVENTLOG_EEPROM_SIZE)
+#define CALIB_BANK_SIZE                 0x200
+#define CALIB_MAGIC                     0x41435346      // "FSCA"
+#define CALIB_HDR_WORDS                 4
+#define CALIB_IMAGE_WORDS               (sizeof(tCalibParams) / 4)
+
+// fails to compile if the image does not fit its EEPROM bank
+typedef char tCalibBankCheck[((CALIB_HDR_WORDS * 4) + sizeof(tCalibParams) <=
+                              CALIB_BANK_SIZE) ? 1 : -1];
+
+static tCalibSet g_psCalibCopies[2];
+
+typedef char tCalibBudget[(sizeof(g_psCalibCopies) <= RAM_BUDGET_CALIB) ?
+                          1 : -1];
+const tCalibParams * volatile g_psCalib = &g_psCalibCopies[0].sParams;
+
+static uint32_t g_ui32CalibBank = 1;            // bank of the current set
+static uint32_t g_ui32CalibGeneration = 0;
+static bool g_bCalibStored = false;             // current set is in EEPROM
+
+//*****************************************************************************
+//
+// Starts a change: returns the copy not in use, holding the current set.
+//
+//*****************************************************************************
+static tCalibParams *CalibEditBegin(void)
+{
+    tCalibParams *psEdit = (g_psCalib == &g_psCalibCopies[0].sParams) ?
+                           &g_psCalibCopies[1].sParams :
+                           &g_psCalibCopies[0].sParams;
+
+    *psEdit = *g_psCalib;
+
+    return psEdit;
+}
+
+//*****************************************************************************
+//
+// Builds the conversion tables of a copy from its parameters.
+//
+//*****************************************************************************
+static void CalibBuild(tCalibParams *psParams)
+{
+    tCalibSet *psSet = (tCalibSet *)psParams;
+    const tCalibSensor *psSensor;
+    uint32_t ui32Ch;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        psSensor = &psParams->psSensors[ui32Ch];
+
+        if(psSensor->ui32LutPoints)
+        {
+            LutBuild(&psSet->psLut[ui32Ch], psSensor->pi32LutRaw,
+                     psSensor->pi32LutValue, psSensor->ui32LutPoints);
+        }
+        else
+        {
+            LutBuildLinear(&psSet->psLut[ui32Ch], psSensor->i32Offset,
+                           psSensor->i32Gain);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Checks a set before it is used.
+//
+//*****************************************************************************
+static bool CalibValid(const tCalibParams *psParams)
+{
+    const tCalibSensor *psSensor;
+    uint32_t ui32Ch, ui32Point;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        psSensor = &psParams->psSensors[ui32Ch];
+
+        if((psSensor->i32Gain == 0) ||
+           (psSensor->i32RawMin >= psSensor->i32RawMax) ||
+           (psSensor->ui32LutPoints == 1) ||
+           (psSensor->ui32LutPoints > CALIB_LUT_POINTS))
+        {
+            return false;
+        }
+
+        for(ui32Point = 1; ui32Point < psSensor->ui32LutPoints; ui32Point++)
+        {
+            if(psSensor->pi32LutRaw[ui32Point] <=
+               psSensor->pi32LutRaw[ui32Point - 1])
+            {
+                return false;
+            }
+        }
+    }
+
+    if((psParams->sTuning.ui32FilterAlpha == 0) ||
+       (psParams->sTuning.ui32FilterAlpha > 65536) ||
+       (psParams->sTuning.ui32TelemetryDecimation == 0) ||
+       (psParams->sTuning.ui32ThrottleMap >= LUT_NUM_MAPS))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Ends a change: switches the readers over if the set is valid.
+//
+//*****************************************************************************
+static int32_t CalibEditCommit(tCalibParams *psEdit)
+{
+    if(!CalibValid(psEdit))
+    {
+        return -1;
+    }
+
+    CalibBuild(psEdit);
+    g_psCalib = psEdit;
+    g_bCalibStored = false;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Compiled in defaults: raw counts with no scaling, no filtering.
+//
+//*****************************************************************************
+static void CalibDefaultSet(tCalibParams *psParams)
+{
+    uint32_t ui32Ch;
+
+    memset(psParams, 0, sizeof(*psParams));
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        psParams->psSensors[ui32Ch].i32Offset = 0;
+        psParams->psSensors[ui32Ch].i32Gain = 1 << 16;
+        psParams->psSensors[ui32Ch].i32RawMin = 0;
+        psParams->psSensors[ui32Ch].i32RawMax = 4095;
+    }
+
+    psParams->sTuning.ui32FilterAlpha = 65536;
+    psParams->sTuning.ui32TelemetryDecimation = 1;
+    psParams->sTuning.ui32ThrottleMap = LUT_MAP_NONE;
+}
+
+void CalibDefaults(void)
+{
+    tCalibParams *psEdit = CalibEditBegin();
+
+    CalibDefaultSet(psEdit);
+    CalibEditCommit(psEdit);
+}
+
+//*****************************************************************************
+//
+// Changes one value of a channel: offset, gain, min or max.
+//
+//*****************************************************************************
+int32_t CalibSensorSet(uint32_t ui32Ch, const char *pcField, int32_t i32Value)
+{
+    tCalibParams *psEdit;
+    tCalibSensor *psSensor;
+
+    if(ui32Ch >= ADC_NUM_CHANNELS)
+    {
+        return -1;
+    }
+
+    psEdit = CalibEditBegin();
+    psSensor = &psEdit->psSensors[ui32Ch];
+
+    if(strcmp(pcField, "offset") == 0)
+    {
+        psSensor->i32Offset = i32Value;
+    }
+    else if(strcmp(pcField, "gain") == 0)
+    {
+        psSensor->i32Gain = i32Value;
+    }
+    else if(strcmp(pcField, "min") == 0)
+    {
+        psSensor->i32RawMin = i32Value;
+    }
+    else if(strcmp(pcField, "max") == 0)
+    {
+        psSensor->i32RawMax = i32Value;
+    }
+    else if(strcmp(pcField, "points") == 0)
+    {
+        psSensor->ui32LutPoints = (uint32_t)i32Value;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return CalibEditCommit(psEdit);
+}
+
+//*****************************************************************************
+//
+// Changes one point of the lookup table of a channel. Points at or above the
+// number of points in use are not checked, so a new table is entered point
+// by point and enabled with the "points" field.
+//
+//*****************************************************************************
+int32_t CalibLutSet(uint32_t ui32Ch, uint32_t ui32Point, int32_t i32Raw,
+                    int32_t i32Value)
+{
+    tCalibParams *psEdit;
+
+    if((ui32Ch >= ADC_NUM_CHANNELS) || (ui32Point >= CALIB_LUT_POINTS))
+    {
+        return -1;
+    }
+
+    psEdit = CalibEditBegin();
+    psEdit->psSensors[ui32Ch].pi32LutRaw[ui32Point] = i32Raw;
+    psEdit->psSensors[ui32Ch].pi32LutValue[ui32Point] = i32Value;
+
+    return CalibEditCommit(psEdit);
+}
+
+//*****************************************************************************
+//
+// Changes a tuning value: alpha, decimation or map.
+//
+//*****************************************************************************
+int32_t CalibTuningSet(const char *pcField, int32_t i32Value)
+{
+    tCalibParams *psEdit = CalibEditBegin();
+
+    if(strcmp(pcField, "alpha") == 0)
+    {
+        psEdit->sTuning.ui32FilterAlpha = (uint32_t)i32Value;
+    }
+    else if(strcmp(pcField, "decimation") == 0)
+    {
+        psEdit->sTuning.ui32TelemetryDecimation = (uint32_t)i32Value;
+    }
+    else if(strcmp(pcField, "map") == 0)
+    {
+        psEdit->sTuning.ui32ThrottleMap = (uint32_t)i32Value;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return CalibEditCommit(psEdit);
+}
+
+//*****************************************************************************
+//
+// Reads one bank into a RAM copy. Returns true if it holds a valid set.
+//
+//*****************************************************************************
+static bool CalibBankRead(uint32_t ui32Bank, tCalibParams *psParams,
+                          uint32_t *pui32Generation)
+{
+    uint32_t pui32Hdr[CALIB_HDR_WORDS];
+    uint32_t ui32Addr = CALIB_EEPROM_BASE + (ui32Bank * CALIB_BANK_SIZE);
+    uint16_t ui16Crc;
+
+    HalEEPROMRead(pui32Hdr, ui32Addr, sizeof(pui32Hdr));
+    if((pui32Hdr[0] != CALIB_MAGIC) ||
+       (pui32Hdr[1] != ((CALIB_VERSION << 16) | CALIB_IMAGE_WORDS)))
+    {
+        return false;
+    }
+
+    HalEEPROMRead((uint32_t *)psParams, ui32Addr + sizeof(pui32Hdr),
+                  sizeof(tCalibParams));
+
+    ui16Crc = Crc16Ccitt(CRC16_CCITT_INIT, (const uint8_t *)&pui32Hdr[2], 4);
+    ui16Crc = Crc16Ccitt(ui16Crc, (const uint8_t *)psParams,
+                         sizeof(tCalibParams));
+    if((pui32Hdr[3] != ui16Crc) || !CalibValid(psParams))
+    {
+        return false;
+    }
+
+    *pui32Generation = pui32Hdr[2];
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Loads the newest valid set from the EEPROM. Returns -1 and leaves the
+// current set if there is none.
+//
+//*****************************************************************************
+int32_t CalibLoad(void)
+{
+    tCalibParams *psEdit;
+    uint32_t ui32Gen0 = 0, ui32Gen1 = 0, ui32Bank;
+    bool bValid0, bValid1;
+
+    if(!EventLogEEPROMTake())
+    {
+        return -1;
+    }
+
+    //
+    // Check bank 0 in the spare copy, then read the one to use again.
+    //
+    psEdit = CalibEditBegin();
+    bValid0 = CalibBankRead(0, psEdit, &ui32Gen0);
+    bValid1 = CalibBankRead(1, psEdit, &ui32Gen1);
+    if(!bValid0 && !bValid1)
+    {
+        EventLogEEPROMGive();
+        return -1;
+    }
+
+    ui32Bank = (bValid1 && (!bValid0 || ((int32_t)(ui32Gen1 - ui32Gen0) > 0))) ?
+               1 : 0;
+    if(ui32Bank == 0)
+    {
+        CalibBankRead(0, psEdit, &ui32Gen0);
+    }
+
+    EventLogEEPROMGive();
+
+    CalibBuild(psEdit);
+    g_psCalib = psEdit;
+    g_ui32CalibBank = ui32Bank;
+    g_ui32CalibGeneration = ui32Bank ? ui32Gen1 : ui32Gen0;
+    g_bCalibStored = true;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Stores the current set in the other bank. Blocks the caller for a few
+// milliseconds of EEPROM programming.
+//
+//*****************************************************************************
+int32_t CalibSave(void)
+{
+    const tCalibParams *psParams = g_psCalib;
+    uint32_t pui32Hdr[CALIB_HDR_WORDS];
+    uint32_t ui32Bank = g_ui32CalibBank ^ 1, ui32Addr, ui32Erased = 0;
+    uint16_t ui16Crc;
+
+    if(!EventLogEEPROMTake())
+    {
+        return -1;
+    }
+
+    ui32Addr = CALIB_EEPROM_BASE + (ui32Bank * CALIB_BANK_SIZE);
+
+    pui32Hdr[0] = CALIB_MAGIC;
+    pui32Hdr[1] = (CALIB_VERSION << 16) | CALIB_IMAGE_WORDS;
+    pui32Hdr[2] = g_ui32CalibGeneration + 1;
+    ui16Crc = Crc16Ccitt(CRC16_CCITT_INIT, (const uint8_t *)&pui32Hdr[2], 4);
+    pui32Hdr[3] = Crc16Ccitt(ui16Crc, (const uint8_t *)psParams,
+                             sizeof(tCalibParams));
+
+    //
+    // Invalidate the bank first, then the image and the rest of the header,
+    // the magic word commits it.
+    //
+    if((HalEEPROMProgram(&ui32Erased, ui32Addr, 4) == 0) &&
+       (HalEEPROMProgram((uint32_t *)psParams, ui32Addr + sizeof(pui32Hdr),
+                         sizeof(tCalibParams)) == 0) &&
+       (HalEEPROMProgram(&pui32Hdr[1], ui32Addr + 4,
+                         sizeof(pui32Hdr) - 4) == 0) &&
+       (HalEEPROMProgram(pui32Hdr, ui32Addr, 4) == 0))
+    {
+        g_ui32CalibBank = ui32Bank;
+        g_ui32CalibGeneration = pui32Hdr[2];
+        g_bCalibStored = true;
+        EventLogEEPROMGive();
+        return 0;
+    }
+
+    EventLogEEPROMGive();
+
+    return -1;
+}
+
+//*****************************************************************************
+//
+// Prints the parameters in use. The caller must own the UART.
+//
+//*****************************************************************************
+void CalibReport(void)
+{
+    const tCalibParams *psParams = g_psCalib;
+    const tCalibSensor *psSensor;
+    uint32_t ui32Ch, ui32Point;
+
+    UARTprintf("calibration v%u, generation %u%s\n", CALIB_VERSION,
+               g_ui32CalibGeneration, g_bCalibStored ? "" : ", not saved");
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        psSensor = &psParams->psSensors[ui32Ch];
+        UARTprintf("ch%u offset %d gain %d min %d max %d points %u\n", ui32Ch,
+                   psSensor->i32Offset, psSensor->i32Gain,
+                   psSensor->i32RawMin, psSensor->i32RawMax,
+                   psSensor->ui32LutPoints);
+        for(ui32Point = 0; ui32Point < psSensor->ui32LutPoints; ui32Point++)
+        {
+            UARTprintf("  %u: %d -> %d\n", ui32Point,
+                       psSensor->pi32LutRaw[ui32Point],
+                       psSensor->pi32LutValue[ui32Point]);
+        }
+    }
+
+    UARTprintf("alpha %u decimation %u map %s\n",
+               psParams->sTuning.ui32FilterAlpha,
+               psParams->sTuning.ui32TelemetryDecimation,
+               g_ppcLutThrottleMapNames[psParams->sTuning.ui32ThrottleMap]);
+}
+
+//*****************************************************************************
+//
+// Loads the stored set at boot, after EventLogTaskInit() opened the EEPROM.
+//
+//*****************************************************************************
+void CalibInit(void)
+{
+    CalibDefaultSet(&g_psCalibCopies[0].sParams);
+    CalibBuild(&g_psCalibCopies[0].sParams);
+    g_psCalib = &g_psCalibCopies[0].sParams;
+
+    if(CalibLoad() == 0)
+    {
+        LOG2(LOG_CALIB_LOADED, g_ui32CalibGeneration, g_ui32CalibBank);
+    }
+    else
+    {
+        LOG0(LOG_CALIB_DEFAULTS);
+    }
+}
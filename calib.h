@@ -0,0 +1,100 @@
+#ifndef CALIB_H
+#define CALIB_H
+
+#include "adc_api.h"
+#include "lut.h"
+
+//*****************************************************************************
+//
+// Calibration and tuning parameters. Any change of these structures must bump
+// CALIB_VERSION, a stored set of another version is not loaded. Every member
+// is a 32-bit word so the image is the same on the target and the host.
+//
+//*****************************************************************************
+#define CALIB_VERSION                   2
+#define CALIB_LUT_POINTS                8
+
+typedef struct
+{
+    int32_t i32Offset;                  // raw counts at zero
+    int32_t i32Gain;                    // units per count, Q16
+    int32_t i32RawMin;                  // plausible raw range, outside is
+    int32_t i32RawMax;                  // an open or shorted sensor
+    uint32_t ui32LutPoints;             // 0 for linear offset and gain only
+    int32_t pi32LutRaw[CALIB_LUT_POINTS];     // ascending raw counts
+    int32_t pi32LutValue[CALIB_LUT_POINTS];   // units at each point
+}
+tCalibSensor;
+
+typedef struct
+{
+    uint32_t ui32FilterAlpha;           // display filter coefficient, Q16
+    uint32_t ui32TelemetryDecimation;   // default of "telem on"
+    uint32_t ui32ThrottleMap;           // LUT_MAP_x of the torque request
+}
+tCalibTuning;
+
+typedef struct
+{
+    tCalibSensor psSensors[ADC_NUM_CHANNELS];
+    tCalibTuning sTuning;
+}
+tCalibParams;
+
+//*****************************************************************************
+//
+// The parameters in use. Readers load the pointer once per sample and must
+// not keep it, an update switches it to the other RAM copy.
+//
+//*****************************************************************************
+extern const tCalibParams * volatile g_psCalib;
+
+//*****************************************************************************
+//
+// A parameter set with the conversion tables built from it. The tables are
+// part of the RAM copy, not of the stored image, and are rebuilt whenever
+// the parameters change. g_psCalib points at the first member.
+//
+//*****************************************************************************
+typedef struct
+{
+    tCalibParams sParams;
+    tLutTable psLut[ADC_NUM_CHANNELS];
+}
+tCalibSet;
+
+//*****************************************************************************
+//
+// Converts a raw reading to engineering units with the table of its
+// channel, the lookup table if points are set, else offset and gain.
+//
+//*****************************************************************************
+static inline int32_t CalibScale(uint32_t ui32Ch, uint32_t ui32Raw)
+{
+    const tCalibSet *psSet = (const tCalibSet *)g_psCalib;
+
+    return LutApply(&psSet->psLut[ui32Ch], (int32_t)ui32Raw);
+}
+
+//*****************************************************************************
+//
+// Converts a pedal position in 0.1 % to the torque request of the selected
+// throttle map.
+//
+//*****************************************************************************
+static inline int32_t CalibThrottleMap(int32_t i32Pedal)
+{
+    return LutThrottleMap(g_psCalib->sTuning.ui32ThrottleMap, i32Pedal);
+}
+
+void CalibInit(void);
+int32_t CalibSensorSet(uint32_t ui32Ch, const char *pcField, int32_t i32Value);
+int32_t CalibLutSet(uint32_t ui32Ch, uint32_t ui32Point, int32_t i32Raw,
+                    int32_t i32Value);
+int32_t CalibTuningSet(const char *pcField, int32_t i32Value);
+int32_t CalibSave(void);
+int32_t CalibLoad(void);
+void CalibDefaults(void);
+void CalibReport(void);
+
+#endif
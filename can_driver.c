@@ -0,0 +1,215 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// CAN0 controller and the 1 kHz scheduler tick
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_can.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/can.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/uartstdio.h"
+#include "trace_recorder.h"
+#include "adc_api.h"
+#include "can_scheduler.h"
+#include "can_events.h"
+#include "can_driver.h"
+
+/******************************************************************************
+Description: CAN0 on PE4 (RX) and PE5 (TX) at CAN_DRIVER_BITRATE. Timer 2A
+interrupts at CAN_SCHEDULER_TICK_HZ and runs the message scheduler with the
+newest ADC frame, the scheduler loads due frames into the message objects and
+the controller sends them on its own. The CAN0 interrupt reports completed
+objects back to the scheduler and keeps track of bus errors.
+
+The ADC interrupt runs the event triggers of can_events.c with every frame
+and loads the event message itself. The ADC, CAN and tick interrupts run at
+the same priority: the scheduler and the event code are never entered twice
+and the message object interface registers are never used by two handlers
+at once. None of them call into FreeRTOS.
+******************************************************************************/
+
+#define CAN_DRIVER_INT_PRIORITY         0x40
+
+static volatile uint32_t g_ui32CANErrors = 0;
+static volatile uint32_t g_ui32CANBusOff = 0;
+static volatile uint32_t g_ui32CANLastStatus = 0;
+
+static void CANDriverObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame);
+
+const tCANPort g_sCANDriverPort =
+{
+    CANDriverObjectLoad
+};
+
+//*****************************************************************************
+//
+// Loads a frame into a transmit message object. The controller starts the
+// transmission as soon as the bus is free.
+//
+//*****************************************************************************
+static void CANDriverObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame)
+{
+    tCANMsgObject sMsg;
+
+    sMsg.ui32MsgID = psFrame->ui32Id;
+    sMsg.ui32MsgIDMask = 0;
+    sMsg.ui32Flags = MSG_OBJ_TX_INT_ENABLE;
+    sMsg.ui32MsgLen = psFrame->ui8Len;
+    sMsg.pui8MsgData = (uint8_t *)psFrame->pui8Data;
+
+    MAP_CANMessageSet(CAN0_BASE, ui32Obj, &sMsg, MSG_OBJ_TYPE_TX);
+}
+
+//*****************************************************************************
+//
+// CAN0 interrupt: transmit complete and error status.
+//
+//*****************************************************************************
+void CAN0IntHandler(void)
+{
+    uint32_t ui32Cause, ui32Status;
+
+    TRACE_ISR_ENTER(TRACE_ISR_CAN0);
+
+    while((ui32Cause = MAP_CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE)) != 0)
+    {
+        if(ui32Cause == CAN_INT_INTID_STATUS)
+        {
+            //
+            // Reading the status clears the interrupt.
+            //
+            ui32Status = MAP_CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
+            g_ui32CANLastStatus = ui32Status;
+
+            if((ui32Status & CAN_STATUS_LEC_MSK) != CAN_STATUS_LEC_NONE)
+            {
+                g_ui32CANErrors++;
+            }
+
+            //
+            // The controller stops after bus off, enabling it again starts
+            // the recovery sequence of 128 x 11 recessive bits.
+            //
+            if(ui32Status & CAN_STATUS_BUS_OFF)
+            {
+                g_ui32CANBusOff++;
+                MAP_CANEnable(CAN0_BASE);
+            }
+        }
+        else
+        {
+            MAP_CANIntClear(CAN0_BASE, ui32Cause);
+            CANSchedulerTxDone(ui32Cause);
+            CANEventsTxDone(ui32Cause);
+        }
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_CAN0);
+}
+
+//*****************************************************************************
+//
+// Timer 2A interrupt: one scheduler tick.
+//
+//*****************************************************************************
+void CANTickIntHandler(void)
+{
+    tADCFrame sFrame;
+
+    TRACE_ISR_ENTER(TRACE_ISR_TIMER2A);
+
+    MAP_TimerIntClear(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+
+    //
+    // Nothing to send until the ADC has produced its first frame.
+    //
+    if(ADCFrameLatest(&sFrame))
+    {
+        CANSchedulerTick(&sFrame);
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_TIMER2A);
+}
+
+//*****************************************************************************
+//
+// Sets up CAN0, the message scheduler and the tick timer.
+//
+//*****************************************************************************
+void CANDriverInit(void)
+{
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_CAN0);
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+
+    MAP_GPIOPinConfigure(GPIO_PE4_CAN0RX);
+    MAP_GPIOPinConfigure(GPIO_PE5_CAN0TX);
+    MAP_GPIOPinTypeCAN(GPIO_PORTE_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+
+    MAP_CANInit(CAN0_BASE);
+    MAP_CANBitRateSet(CAN0_BASE, MAP_SysCtlClockGet(), CAN_DRIVER_BITRATE);
+
+    CANSchedulerInit(&g_sCANDriverPort);
+    CANEventsInit(&g_sCANDriverPort);
+    MAP_IntPrioritySet(INT_ADC0SS1, CAN_DRIVER_INT_PRIORITY);
+
+    CANIntRegister(CAN0_BASE, CAN0IntHandler);
+    MAP_CANIntEnable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR |
+                                CAN_INT_STATUS);
+    MAP_IntPrioritySet(INT_CAN0, CAN_DRIVER_INT_PRIORITY);
+    MAP_IntEnable(INT_CAN0);
+    MAP_CANEnable(CAN0_BASE);
+
+    MAP_TimerConfigure(TIMER2_BASE, TIMER_CFG_PERIODIC);
+    MAP_TimerLoadSet(TIMER2_BASE, TIMER_A,
+                     (MAP_SysCtlClockGet() / CAN_SCHEDULER_TICK_HZ) - 1);
+    TimerIntRegister(TIMER2_BASE, TIMER_A, CANTickIntHandler);
+    MAP_IntPrioritySet(INT_TIMER2A, CAN_DRIVER_INT_PRIORITY);
+    MAP_TimerIntEnable(TIMER2_BASE, TIMER_TIMA_TIMEOUT);
+    MAP_TimerEnable(TIMER2_BASE, TIMER_A);
+}
+
+//*****************************************************************************
+//
+// Prints the message counters and the bus error state. The caller must hold
+// the UART.
+//
+//*****************************************************************************
+void CANDriverReport(void)
+{
+    const tCANMessageStats *psStats;
+    const tCANEventStats *psEvents = CANEventsStats();
+    uint32_t ui32Idx, ui32Rx, ui32Tx;
+
+    MAP_CANErrCntrGet(CAN0_BASE, &ui32Rx, &ui32Tx);
+
+    UARTprintf("CAN %u bit/s, status 0x%02x, tec %u rec %u, errors %u, "
+               "bus off %u\n", CAN_DRIVER_BITRATE, g_ui32CANLastStatus,
+               ui32Tx, ui32Rx, g_ui32CANErrors, g_ui32CANBusOff);
+
+    for(ui32Idx = 0; ui32Idx < g_ui32CANNumMessages; ui32Idx++)
+    {
+        psStats = CANSchedulerStats(ui32Idx);
+        UARTprintf("  %s 0x%03x %u ms: sent %u done %u overwritten %u\n",
+                   g_psCANMessages[ui32Idx].pcName,
+                   g_psCANMessages[ui32Idx].ui32Id,
+                   g_psCANMessages[ui32Idx].ui16PeriodMs, psStats->ui32Sent,
+                   psStats->ui32Done, psStats->ui32Overwritten);
+    }
+
+    UARTprintf("  FS_Event 0x%03x: sent %u done %u merged %u deferred %u\n",
+               CAN_EVENT_ID, psEvents->ui32Sent, psEvents->ui32Done,
+               psEvents->ui32Merged, psEvents->ui32Deferred);
+    UARTprintf("    brake on %u off %u pedal step %u fault %u\n",
+               psEvents->pui32Causes[0], psEvents->pui32Causes[1],
+               psEvents->pui32Causes[2], psEvents->pui32Causes[3]);
+}
@@ -0,0 +1,16 @@
+#ifndef CAN_DRIVER_H
+#define CAN_DRIVER_H
+
+#include "can_port.h"
+
+#define CAN_DRIVER_BITRATE              500000
+
+extern const tCANPort g_sCANDriverPort;
+
+void CANDriverInit(void);
+void CANDriverReport(void);
+
+void CAN0IntHandler(void);
+void CANTickIntHandler(void);
+
+#endif
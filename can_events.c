@@ -0,0 +1,332 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Event triggered CAN message for safety relevant sensor changes
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "timestamp.h"
+#include "can_events.h"
+
+/******************************************************************************
+Description: the periodic messages add up to one period of delay to a brake
+or throttle cut. CANEventsProcess() is called from the ADC interrupt with
+every new frame and looks for
+
+ - the brake pressure crossing CAN_EVENT_BRAKE_ON / CAN_EVENT_BRAKE_OFF
+ - the throttle moving by CAN_EVENT_PEDAL_STEP since the last event
+ - a fault bit changing: sensor out of range or brake/throttle implausible,
+   debounced over CAN_EVENT_FAULT_FRAMES frames
+
+and loads the event message into its own message object right away, so the
+frame is on the wire one arbitration later.
+
+Rate limiting: loading the object takes a token from a bucket of
+CAN_EVENT_BURST that refills every CAN_EVENT_REFILL_US, measured with the
+frame timestamps. An event that finds the bucket empty is held and its cause
+bits are merged into the next frame. An event that finds the previous frame
+still waiting for the bus replaces it with a frame carrying both causes.
+
+Event message layout (little endian, see tools/can/fsae_sensors.dbc):
+ bits  0..7   cause bits of this frame
+ bits  8..15  active fault bits
+ bits 16..27  throttle
+ bits 28..39  brake pressure
+ bits 40..55  timestamp of the triggering ADC frame, us modulo 65536
+ bits 60..63  rolling counter
+
+CANEventsProcess() and CANEventsTxDone() must not preempt each other and must
+not preempt the CAN scheduler, on the target the ADC, CAN and tick interrupts
+share one priority.
+******************************************************************************/
+
+#define CAN_EVENT_REFILL_CYCLES         TimestampUsToCycles(CAN_EVENT_REFILL_US)
+
+static const tCANPort *g_psEventPort = NULL;
+static bool g_bEventStarted;
+
+static bool g_bEventBrakeOn;
+static uint16_t g_ui16EventThrottleRef;
+static uint8_t g_ui8EventFaults;
+static uint8_t g_pui8EventFaultCount[3];
+
+static uint8_t g_ui8EventHeld;          // causes waiting for a token
+static uint8_t g_ui8EventLoaded;        // causes of the frame in the object
+static volatile bool g_bEventObjPending;
+static uint8_t g_ui8EventCounter;
+
+static uint32_t g_ui32EventTokens;
+static uint32_t g_ui32EventRefillTime;
+
+static tCANEventStats g_sEventStats;
+
+//*****************************************************************************
+//
+// Binds the event message to a CAN port and resets the trigger state. The
+// first frame after this only sets the references.
+//
+//*****************************************************************************
+void CANEventsInit(const tCANPort *psPort)
+{
+    uint32_t ui32Idx;
+
+    g_bEventStarted = false;
+    g_ui8EventFaults = 0;
+    g_ui8EventHeld = 0;
+    g_ui8EventLoaded = 0;
+    g_bEventObjPending = false;
+    g_ui8EventCounter = 0;
+
+    for(ui32Idx = 0; ui32Idx < sizeof(g_pui8EventFaultCount); ui32Idx++)
+    {
+        g_pui8EventFaultCount[ui32Idx] = 0;
+    }
+
+    g_sEventStats.ui32Sent = 0;
+    g_sEventStats.ui32Done = 0;
+    g_sEventStats.ui32Merged = 0;
+    g_sEventStats.ui32Deferred = 0;
+    for(ui32Idx = 0; ui32Idx < CAN_EVENT_NUM_CAUSES; ui32Idx++)
+    {
+        g_sEventStats.pui32Causes[ui32Idx] = 0;
+    }
+
+    g_psEventPort = psPort;
+}
+
+//*****************************************************************************
+//
+// Debounces one fault bit, returns true when it changed.
+//
+//*****************************************************************************
+static bool CANEventsFaultUpdate(uint32_t ui32Idx, uint8_t ui8Bit,
+                                 bool bCondition)
+{
+    if(bCondition == ((g_ui8EventFaults & ui8Bit) != 0))
+    {
+        g_pui8EventFaultCount[ui32Idx] = 0;
+        return false;
+    }
+
+    if(++g_pui8EventFaultCount[ui32Idx] < CAN_EVENT_FAULT_FRAMES)
+    {
+        return false;
+    }
+
+    g_pui8EventFaultCount[ui32Idx] = 0;
+    g_ui8EventFaults ^= ui8Bit;
+    return true;
+}
+
+//*****************************************************************************
+//
+// Packs and loads the event message.
+//
+//*****************************************************************************
+static void CANEventsLoad(const tADCFrame *psFrame, uint8_t ui8Causes)
+{
+    tCANFrame sCANFrame;
+    uint64_t ui64Data;
+    uint32_t ui32Idx;
+
+    ui64Data = (uint64_t)ui8Causes |
+               ((uint64_t)g_ui8EventFaults << 8) |
+               ((uint64_t)(psFrame->pui16Data[ADC_CH_THROTTLE] & 0xFFF)
+                << 16) |
+               ((uint64_t)(psFrame->pui16Data[ADC_CH_BRAKE] & 0xFFF)
+                << 28) |
+               ((uint64_t)(TimestampCyclesToUs(psFrame->ui32Time) & 0xFFFF)
+                << 40) |
+               ((uint64_t)(g_ui8EventCounter & 0xF) << 60);
+
+    sCANFrame.ui32Id = CAN_EVENT_ID;
+    sCANFrame.ui8Len = CAN_EVENT_LEN;
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        sCANFrame.pui8Data[ui32Idx] = (uint8_t)(ui64Data >> (8 * ui32Idx));
+    }
+
+    g_bEventObjPending = true;
+    g_psEventPort->pfnObjectLoad(CAN_EVENT_MSG_OBJ, &sCANFrame);
+}
+
+//*****************************************************************************
+//
+// Checks a new ADC frame for events and sends the event message when needed.
+//
+//*****************************************************************************
+void CANEventsProcess(const tADCFrame *psFrame)
+{
+    uint32_t ui32Throttle, ui32Brake, ui32Step, ui32Add, ui32Idx;
+    uint8_t ui8Causes = 0;
+    bool bBPP;
+
+    if(g_psEventPort == NULL)
+    {
+        return;
+    }
+
+    ui32Throttle = psFrame->pui16Data[ADC_CH_THROTTLE];
+    ui32Brake = psFrame->pui16Data[ADC_CH_BRAKE];
+
+    if(!g_bEventStarted)
+    {
+        g_bEventBrakeOn = (ui32Brake > CAN_EVENT_BRAKE_ON);
+        g_ui16EventThrottleRef = (uint16_t)ui32Throttle;
+        g_ui32EventTokens = CAN_EVENT_BURST;
+        g_ui32EventRefillTime = psFrame->ui32Time;
+        g_bEventStarted = true;
+        return;
+    }
+
+    //
+    // Brake threshold with hysteresis.
+    //
+    if(!g_bEventBrakeOn && (ui32Brake > CAN_EVENT_BRAKE_ON))
+    {
+        g_bEventBrakeOn = true;
+        ui8Causes |= CAN_EVENT_CAUSE_BRAKE_ON;
+    }
+    else if(g_bEventBrakeOn && (ui32Brake < CAN_EVENT_BRAKE_OFF))
+    {
+        g_bEventBrakeOn = false;
+        ui8Causes |= CAN_EVENT_CAUSE_BRAKE_OFF;
+    }
+
+    //
+    // Pedal step relative to the throttle of the last step event.
+    //
+    ui32Step = (ui32Throttle > g_ui16EventThrottleRef) ?
+               (ui32Throttle - g_ui16EventThrottleRef) :
+               (g_ui16EventThrottleRef - ui32Throttle);
+    if(ui32Step >= CAN_EVENT_PEDAL_STEP)
+    {
+        g_ui16EventThrottleRef = (uint16_t)ui32Throttle;
+        ui8Causes |= CAN_EVENT_CAUSE_PEDAL_STEP;
+    }
+
+    //
+    // Faults. Brake/throttle plausibility latches until the throttle is
+    // released below CAN_EVENT_BPP_CLEAR.
+    //
+    if(g_ui8EventFaults & CAN_EVENT_FAULT_BPP)
+    {
+        bBPP = (ui32Throttle >= CAN_EVENT_BPP_CLEAR);
+    }
+    else
+    {
+        bBPP = g_bEventBrakeOn && (ui32Throttle > CAN_EVENT_BPP_SET);
+    }
+
+    if(CANEventsFaultUpdate(0, CAN_EVENT_FAULT_THROTTLE_RANGE,
+                            (ui32Throttle < CAN_EVENT_RANGE_MIN) ||
+                            (ui32Throttle > CAN_EVENT_RANGE_MAX)) |
+       CANEventsFaultUpdate(1, CAN_EVENT_FAULT_BRAKE_RANGE,
+                            (ui32Brake < CAN_EVENT_RANGE_MIN) ||
+                            (ui32Brake > CAN_EVENT_RANGE_MAX)) |
+       CANEventsFaultUpdate(2, CAN_EVENT_FAULT_BPP, bBPP))
+    {
+        ui8Causes |= CAN_EVENT_CAUSE_FAULT;
+    }
+
+    for(ui32Idx = 0; ui32Idx < CAN_EVENT_NUM_CAUSES; ui32Idx++)
+    {
+        if(ui8Causes & (1 << ui32Idx))
+        {
+            g_sEventStats.pui32Causes[ui32Idx]++;
+        }
+    }
+
+    //
+    // Refill the bucket.
+    //
+    if(g_ui32EventTokens >= CAN_EVENT_BURST)
+    {
+        g_ui32EventRefillTime = psFrame->ui32Time;
+    }
+    else
+    {
+        ui32Add = (psFrame->ui32Time - g_ui32EventRefillTime) /
+                  CAN_EVENT_REFILL_CYCLES;
+        if(ui32Add != 0)
+        {
+            g_ui32EventRefillTime += ui32Add * CAN_EVENT_REFILL_CYCLES;
+            g_ui32EventTokens += ui32Add;
+            if(g_ui32EventTokens > CAN_EVENT_BURST)
+            {
+                g_ui32EventTokens = CAN_EVENT_BURST;
+            }
+        }
+    }
+
+    g_ui8EventHeld |= ui8Causes;
+    if(g_ui8EventHeld == 0)
+    {
+        return;
+    }
+
+    if(g_ui32EventTokens == 0)
+    {
+        if(ui8Causes != 0)
+        {
+            g_sEventStats.ui32Deferred++;
+        }
+        return;
+    }
+
+    //
+    // Every load takes a token, also when it replaces a frame that is still
+    // pending: the controller may already be sending it and then sends the
+    // object again.
+    //
+    g_ui32EventTokens--;
+    if(g_bEventObjPending)
+    {
+        g_ui8EventLoaded |= g_ui8EventHeld;
+        g_sEventStats.ui32Merged++;
+    }
+    else
+    {
+        g_ui8EventCounter++;
+        g_ui8EventLoaded = g_ui8EventHeld;
+        g_sEventStats.ui32Sent++;
+    }
+    g_ui8EventHeld = 0;
+    CANEventsLoad(psFrame, g_ui8EventLoaded);
+}
+
+//*****************************************************************************
+//
+// Called by the port when a message object has been sent.
+//
+//*****************************************************************************
+void CANEventsTxDone(uint32_t ui32Obj)
+{
+    if(ui32Obj == CAN_EVENT_MSG_OBJ)
+    {
+        g_bEventObjPending = false;
+        g_sEventStats.ui32Done++;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the event counters.
+//
+//*****************************************************************************
+const tCANEventStats *CANEventsStats(void)
+{
+    return &g_sEventStats;
+}
+
+//*****************************************************************************
+//
+// Returns the debounced CAN_EVENT_FAULT_xxx bits.
+//
+//*****************************************************************************
+uint32_t CANEventsFaults(void)
+{
+    return g_ui8EventFaults;
+}
@@ -0,0 +1,81 @@
+#ifndef CAN_EVENTS_H
+#define CAN_EVENTS_H
+
+#include "adc_api.h"
+#include "can_port.h"
+
+//*****************************************************************************
+//
+// The event message. Object 1 wins internal arbitration against the periodic
+// messages and the id wins on the bus.
+//
+//*****************************************************************************
+#define CAN_EVENT_ID                    0x080
+#define CAN_EVENT_MSG_OBJ               1
+#define CAN_EVENT_LEN                   8
+
+//*****************************************************************************
+//
+// Triggers, in raw ADC counts (4095 = 3.3V), on the ADC_CH_THROTTLE and
+// ADC_CH_BRAKE channels of the frame.
+//
+//*****************************************************************************
+#define CAN_EVENT_BRAKE_ON              800     // brake pressed above
+#define CAN_EVENT_BRAKE_OFF             700     // released below
+#define CAN_EVENT_PEDAL_STEP            400     // ~10% since the last event
+
+#define CAN_EVENT_RANGE_MIN             100     // below: open circuit
+#define CAN_EVENT_RANGE_MAX             3995    // above: short to supply
+#define CAN_EVENT_FAULT_FRAMES          4       // debounce, 0.5ms at 8kHz
+
+// brake and throttle plausibility, 25% to set and 5% to clear
+#define CAN_EVENT_BPP_SET               1024
+#define CAN_EVENT_BPP_CLEAR             205
+
+//*****************************************************************************
+//
+// Rate limit: a token bucket of CAN_EVENT_BURST frames refilled every
+// CAN_EVENT_REFILL_US. Events that find the bucket empty are merged and sent
+// with the next token.
+//
+//*****************************************************************************
+#define CAN_EVENT_BURST                 4
+#define CAN_EVENT_REFILL_US             2000
+
+//*****************************************************************************
+//
+// Cause bits, byte 0 of the event message.
+//
+//*****************************************************************************
+#define CAN_EVENT_CAUSE_BRAKE_ON        0x01
+#define CAN_EVENT_CAUSE_BRAKE_OFF       0x02
+#define CAN_EVENT_CAUSE_PEDAL_STEP      0x04
+#define CAN_EVENT_CAUSE_FAULT           0x08    // fault bits changed
+#define CAN_EVENT_NUM_CAUSES            4
+
+//*****************************************************************************
+//
+// Fault bits, byte 1 of the event message.
+//
+//*****************************************************************************
+#define CAN_EVENT_FAULT_THROTTLE_RANGE  0x01
+#define CAN_EVENT_FAULT_BRAKE_RANGE     0x02
+#define CAN_EVENT_FAULT_BPP             0x04    // brake pressed with throttle
+
+typedef struct
+{
+    uint32_t ui32Sent;                  // frames handed to the controller
+    uint32_t ui32Done;                  // frames confirmed on the wire
+    uint32_t ui32Merged;                // event added to a frame not yet sent
+    uint32_t ui32Deferred;              // bucket empty, waited for a token
+    uint32_t pui32Causes[CAN_EVENT_NUM_CAUSES];
+}
+tCANEventStats;
+
+void CANEventsInit(const tCANPort *psPort);
+void CANEventsProcess(const tADCFrame *psFrame);
+void CANEventsTxDone(uint32_t ui32Obj);
+const tCANEventStats *CANEventsStats(void);
+uint32_t CANEventsFaults(void);
+
+#endif
@@ -0,0 +1,180 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// In-process CAN controller and bus stand-in for host builds
+//
+// Host only, not part of the Keil project.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "can_port.h"
+#include "can_loopback.h"
+#include "can_scheduler.h"
+#include "can_events.h"
+
+/******************************************************************************
+Description: models the 32 transmit message objects of the TM4C CAN
+controller on a bus with no other senders. Loaded objects wait until the bus
+is free, the lowest pending object number is sent first like in the real
+controller. A frame occupies the bus for its worst case bit stuffed length at
+the configured bit rate, when its last bit is out the receive callback,
+CANSchedulerTxDone() and CANEventsTxDone() are called.
+
+Time only moves in CANLoopbackRun(). The caller runs the bus up to the current
+simulation time before loading objects, so a load is stamped with that time.
+******************************************************************************/
+
+#define CAN_LOOPBACK_NUM_OBJECTS        33
+
+static bool g_pbLoopbackPending[CAN_LOOPBACK_NUM_OBJECTS];
+static tCANFrame g_psLoopbackObjects[CAN_LOOPBACK_NUM_OBJECTS];
+
+static uint32_t g_ui32LoopbackBitrate;
+static tCANLoopbackRx g_pfnLoopbackRx;
+static void *g_pvLoopbackContext;
+
+static uint64_t g_ui64LoopbackNow;
+static uint64_t g_ui64LoopbackBusyUntil;
+static uint64_t g_ui64LoopbackBusyTime;
+static uint32_t g_ui32LoopbackInFlight;
+static tCANFrame g_sLoopbackWire;
+
+static void CANLoopbackObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame);
+
+const tCANPort g_sCANLoopbackPort =
+{
+    CANLoopbackObjectLoad
+};
+
+//*****************************************************************************
+//
+// Resets the simulated controller and bus.
+//
+//*****************************************************************************
+void CANLoopbackInit(uint32_t ui32Bitrate, tCANLoopbackRx pfnRx,
+                     void *pvContext)
+{
+    uint32_t ui32Obj;
+
+    for(ui32Obj = 0; ui32Obj < CAN_LOOPBACK_NUM_OBJECTS; ui32Obj++)
+    {
+        g_pbLoopbackPending[ui32Obj] = false;
+    }
+
+    g_ui32LoopbackBitrate = ui32Bitrate;
+    g_pfnLoopbackRx = pfnRx;
+    g_pvLoopbackContext = pvContext;
+    g_ui64LoopbackNow = 0;
+    g_ui64LoopbackBusyUntil = 0;
+    g_ui64LoopbackBusyTime = 0;
+    g_ui32LoopbackInFlight = 0;
+}
+
+//*****************************************************************************
+//
+// Worst case length of a standard data frame on the wire in nanoseconds:
+// 47 fixed bits including interframe space, the data bits and one stuff bit
+// for every four bits of the stuffed region.
+//
+//*****************************************************************************
+static uint64_t CANLoopbackFrameTime(const tCANFrame *psFrame)
+{
+    uint32_t ui32Bits = 47 + (8 * psFrame->ui8Len) +
+                        ((34 + (8 * psFrame->ui8Len) - 1) / 4);
+
+    return ((uint64_t)ui32Bits * 1000000000ULL) / g_ui32LoopbackBitrate;
+}
+
+static void CANLoopbackObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame)
+{
+    if((ui32Obj == 0) || (ui32Obj >= CAN_LOOPBACK_NUM_OBJECTS))
+    {
+        return;
+    }
+
+    g_psLoopbackObjects[ui32Obj] = *psFrame;
+    g_pbLoopbackPending[ui32Obj] = true;
+}
+
+//*****************************************************************************
+//
+// Runs the bus until the given time.
+//
+//*****************************************************************************
+void CANLoopbackRun(uint64_t ui64UntilNs)
+{
+    uint32_t ui32Obj, ui32Done;
+
+    while(1)
+    {
+        //
+        // Finish the frame on the wire.
+        //
+        if(g_ui32LoopbackInFlight != 0)
+        {
+            if(g_ui64LoopbackBusyUntil > ui64UntilNs)
+            {
+                break;
+            }
+
+            g_ui64LoopbackNow = g_ui64LoopbackBusyUntil;
+            ui32Done = g_ui32LoopbackInFlight;
+            g_ui32LoopbackInFlight = 0;
+
+            if(g_pfnLoopbackRx)
+            {
+                g_pfnLoopbackRx(&g_sLoopbackWire, g_ui64LoopbackNow,
+                                g_pvLoopbackContext);
+            }
+            CANSchedulerTxDone(ui32Done);
+            CANEventsTxDone(ui32Done);
+        }
+
+        //
+        // Start the next pending object, lowest number first.
+        //
+        for(ui32Obj = 1; ui32Obj < CAN_LOOPBACK_NUM_OBJECTS; ui32Obj++)
+        {
+            if(g_pbLoopbackPending[ui32Obj])
+            {
+                break;
+            }
+        }
+        if(ui32Obj == CAN_LOOPBACK_NUM_OBJECTS)
+        {
+            break;
+        }
+
+        g_pbLoopbackPending[ui32Obj] = false;
+        g_sLoopbackWire = g_psLoopbackObjects[ui32Obj];
+        g_ui32LoopbackInFlight = ui32Obj;
+        g_ui64LoopbackBusyUntil = g_ui64LoopbackNow +
+                                  CANLoopbackFrameTime(&g_sLoopbackWire);
+        g_ui64LoopbackBusyTime += g_ui64LoopbackBusyUntil - g_ui64LoopbackNow;
+    }
+
+    if(ui64UntilNs > g_ui64LoopbackNow)
+    {
+        g_ui64LoopbackNow = ui64UntilNs;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the current simulation time.
+//
+//*****************************************************************************
+uint64_t CANLoopbackTime(void)
+{
+    return g_ui64LoopbackNow;
+}
+
+//*****************************************************************************
+//
+// Returns the total time the bus has been busy, for bus load figures.
+//
+//*****************************************************************************
+uint64_t CANLoopbackBusyTime(void)
+{
+    return g_ui64LoopbackBusyTime;
+}
@@ -0,0 +1,23 @@
+#ifndef CAN_LOOPBACK_H
+#define CAN_LOOPBACK_H
+
+#include "can_port.h"
+
+//*****************************************************************************
+//
+// Called for every frame that completes on the simulated bus, with the time
+// its last bit was sent.
+//
+//*****************************************************************************
+typedef void (*tCANLoopbackRx)(const tCANFrame *psFrame, uint64_t ui64TimeNs,
+                               void *pvContext);
+
+extern const tCANPort g_sCANLoopbackPort;
+
+void CANLoopbackInit(uint32_t ui32Bitrate, tCANLoopbackRx pfnRx,
+                     void *pvContext);
+void CANLoopbackRun(uint64_t ui64UntilNs);
+uint64_t CANLoopbackTime(void);
+uint64_t CANLoopbackBusyTime(void);
+
+#endif
@@ -0,0 +1,43 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Periodic CAN messages of the front sensors ECU
+//
+// Keep this table in sync with tools/can/fsae_sensors.dbc.
+
+#include <stdint.h>
+#include "can_messages.h"
+
+/******************************************************************************
+Sensor 1: throttle hall sensor   ADC channel 0
+Sensor 2: brake pressure sensor  ADC channel 1
+Sensor 3: steering potentiometer ADC channel 2
+******************************************************************************/
+
+static const tCANSignal g_psPedalSignals[] =
+{
+    { CAN_SRC_ADC0,     0,  12 },       // throttle raw
+    { CAN_SRC_ADC1,     16, 12 },       // brake pressure raw
+    { CAN_SRC_COUNTER,  60, 4 },
+};
+
+static const tCANSignal g_psSteeringSignals[] =
+{
+    { CAN_SRC_ADC2,     0,  12 },       // steering raw
+    { CAN_SRC_COUNTER,  28, 4 },
+};
+
+//*****************************************************************************
+//
+// The periodic messages. Message objects 2..32 may be used here, lower
+// numbers are sent first when several are pending. Object 1 belongs to the
+// event message of can_events.c.
+//
+//*****************************************************************************
+const tCANMessage g_psCANMessages[] =
+{
+    { "FS_Pedals",   0x100, 8, 2, 1,  3, g_psPedalSignals },
+    { "FS_Steering", 0x101, 4, 3, 10, 2, g_psSteeringSignals },
+};
+
+const uint32_t g_ui32CANNumMessages =
+    sizeof(g_psCANMessages) / sizeof(g_psCANMessages[0]);
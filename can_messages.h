@@ -0,0 +1,45 @@
+#ifndef CAN_MESSAGES_H
+#define CAN_MESSAGES_H
+
+//*****************************************************************************
+//
+// Signal sources. ADC channels are sent as raw 12-bit counts, the scaling is
+// documented in tools/can/fsae_sensors.dbc.
+//
+//*****************************************************************************
+#define CAN_SRC_ADC0                    0
+#define CAN_SRC_ADC1                    1
+#define CAN_SRC_ADC2                    2
+#define CAN_SRC_ADC3                    3
+#define CAN_SRC_COUNTER                 16      // rolling message counter
+
+//*****************************************************************************
+//
+// DBC style description of a periodic message. Signals are little endian
+// (Intel) with the start bit counted from bit 0 of byte 0.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Source;
+    uint8_t ui8StartBit;
+    uint8_t ui8Length;
+}
+tCANSignal;
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Id;
+    uint8_t ui8Len;
+    uint8_t ui8MsgObj;                  // 2..32, one per message
+    uint16_t ui16PeriodMs;
+    uint8_t ui8NumSignals;
+    const tCANSignal *psSignals;
+}
+tCANMessage;
+
+extern const tCANMessage g_psCANMessages[];
+extern const uint32_t g_ui32CANNumMessages;
+
+#endif
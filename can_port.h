@@ -0,0 +1,35 @@
+#ifndef CAN_PORT_H
+#define CAN_PORT_H
+
+//*****************************************************************************
+//
+// A CAN data frame with a standard 11-bit identifier.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Id;
+    uint8_t ui8Len;
+    uint8_t pui8Data[8];
+}
+tCANFrame;
+
+//*****************************************************************************
+//
+// Transmit side of a CAN controller as seen by the message scheduler. A frame
+// is loaded into a transmit message object and the controller sends it on
+// its own, lower object numbers win internal arbitration. When the frame is
+// on the wire the port calls CANSchedulerTxDone() and CANEventsTxDone() with
+// the object number, each ignores objects it does not own.
+//
+// can_driver.c implements this for the TM4C CAN0 controller and
+// can_loopback.c for the host simulation.
+//
+//*****************************************************************************
+typedef struct
+{
+    void (*pfnObjectLoad)(uint32_t ui32Obj, const tCANFrame *psFrame);
+}
+tCANPort;
+
+#endif
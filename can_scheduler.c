@@ -0,0 +1,174 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Table driven periodic CAN transmit scheduler
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "can_scheduler.h"
+
+/******************************************************************************
+Description: every message of g_psCANMessages owns one transmit message object
+of the CAN controller. CANSchedulerTick() is called at CAN_SCHEDULER_TICK_HZ
+from a timer interrupt with the latest ADC frame. When a message is due its
+signals are packed and the frame is loaded into its message object, the
+controller sends it without further CPU involvement. Due times of the
+messages are staggered so that they do not all fall on the same tick.
+
+If the previous frame of a message is still waiting for the bus when the next
+one is due, the object is overwritten with the newer data and the overwrite
+is counted.
+
+CANSchedulerTick() and CANSchedulerTxDone() must not preempt each other, on
+the target both interrupts run at the same priority.
+******************************************************************************/
+
+static const tCANPort *g_psCANPort = NULL;
+static uint16_t g_pui16CANCountdown[CAN_SCHEDULER_MAX_MESSAGES];
+static uint8_t g_pui8CANCounter[CAN_SCHEDULER_MAX_MESSAGES];
+static volatile bool g_pbCANPending[CAN_SCHEDULER_MAX_MESSAGES];
+static tCANMessageStats g_psCANStats[CAN_SCHEDULER_MAX_MESSAGES];
+
+// message index of every message object, 0xFF if unused
+static uint8_t g_pui8CANObjToMsg[33];
+
+//*****************************************************************************
+//
+// Binds the scheduler to a CAN port and resets all message timers.
+//
+//*****************************************************************************
+void CANSchedulerInit(const tCANPort *psPort)
+{
+    uint32_t ui32Idx;
+
+    g_psCANPort = psPort;
+
+    for(ui32Idx = 0; ui32Idx < sizeof(g_pui8CANObjToMsg); ui32Idx++)
+    {
+        g_pui8CANObjToMsg[ui32Idx] = 0xFF;
+    }
+
+    for(ui32Idx = 0; (ui32Idx < g_ui32CANNumMessages) &&
+                     (ui32Idx < CAN_SCHEDULER_MAX_MESSAGES); ui32Idx++)
+    {
+        g_pui16CANCountdown[ui32Idx] =
+            (ui32Idx % g_psCANMessages[ui32Idx].ui16PeriodMs) + 1;
+        g_pui8CANCounter[ui32Idx] = 0;
+        g_pbCANPending[ui32Idx] = false;
+        g_psCANStats[ui32Idx].ui32Sent = 0;
+        g_psCANStats[ui32Idx].ui32Done = 0;
+        g_psCANStats[ui32Idx].ui32Overwritten = 0;
+        g_pui8CANObjToMsg[g_psCANMessages[ui32Idx].ui8MsgObj] =
+            (uint8_t)ui32Idx;
+    }
+}
+
+//*****************************************************************************
+//
+// Packs the signals of a message into a CAN frame.
+//
+//*****************************************************************************
+void CANSchedulerPack(const tCANMessage *psMsg, const tADCFrame *psFrame,
+                      uint32_t ui32Counter, tCANFrame *psCANFrame)
+{
+    const tCANSignal *psSignal = psMsg->psSignals;
+    uint64_t ui64Data = 0;
+    uint32_t ui32Idx, ui32Value;
+
+    for(ui32Idx = 0; ui32Idx < psMsg->ui8NumSignals; ui32Idx++, psSignal++)
+    {
+        if(psSignal->ui8Source == CAN_SRC_COUNTER)
+        {
+            ui32Value = ui32Counter;
+        }
+        else
+        {
+            ui32Value = psFrame->pui16Data[psSignal->ui8Source];
+        }
+
+        ui32Value &= (1UL << psSignal->ui8Length) - 1;
+        ui64Data |= (uint64_t)ui32Value << psSignal->ui8StartBit;
+    }
+
+    psCANFrame->ui32Id = psMsg->ui32Id;
+    psCANFrame->ui8Len = psMsg->ui8Len;
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        psCANFrame->pui8Data[ui32Idx] = (uint8_t)(ui64Data >> (8 * ui32Idx));
+    }
+}
+
+//*****************************************************************************
+//
+// Advances the message timers by one tick and loads every due message.
+//
+//*****************************************************************************
+void CANSchedulerTick(const tADCFrame *psFrame)
+{
+    const tCANMessage *psMsg;
+    tCANFrame sCANFrame;
+    uint32_t ui32Idx;
+
+    if(g_psCANPort == NULL)
+    {
+        return;
+    }
+
+    for(ui32Idx = 0; (ui32Idx < g_ui32CANNumMessages) &&
+                     (ui32Idx < CAN_SCHEDULER_MAX_MESSAGES); ui32Idx++)
+    {
+        if(--g_pui16CANCountdown[ui32Idx] != 0)
+        {
+            continue;
+        }
+
+        psMsg = &g_psCANMessages[ui32Idx];
+        g_pui16CANCountdown[ui32Idx] = psMsg->ui16PeriodMs;
+
+        CANSchedulerPack(psMsg, psFrame, g_pui8CANCounter[ui32Idx]++,
+                         &sCANFrame);
+
+        if(g_pbCANPending[ui32Idx])
+        {
+            g_psCANStats[ui32Idx].ui32Overwritten++;
+        }
+        g_pbCANPending[ui32Idx] = true;
+        g_psCANStats[ui32Idx].ui32Sent++;
+
+        g_psCANPort->pfnObjectLoad(psMsg->ui8MsgObj, &sCANFrame);
+    }
+}
+
+//*****************************************************************************
+//
+// Called by the port when the frame of a message object has been sent.
+//
+//*****************************************************************************
+void CANSchedulerTxDone(uint32_t ui32Obj)
+{
+    uint32_t ui32Idx;
+
+    if(ui32Obj >= sizeof(g_pui8CANObjToMsg))
+    {
+        return;
+    }
+
+    ui32Idx = g_pui8CANObjToMsg[ui32Obj];
+    if(ui32Idx != 0xFF)
+    {
+        g_pbCANPending[ui32Idx] = false;
+        g_psCANStats[ui32Idx].ui32Done++;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the counters of a message, indexed like g_psCANMessages.
+//
+//*****************************************************************************
+const tCANMessageStats *CANSchedulerStats(uint32_t ui32Msg)
+{
+    return &g_psCANStats[ui32Msg];
+}
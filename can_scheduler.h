@@ -0,0 +1,26 @@
+#ifndef CAN_SCHEDULER_H
+#define CAN_SCHEDULER_H
+
+#include "adc_api.h"
+#include "can_port.h"
+#include "can_messages.h"
+
+#define CAN_SCHEDULER_TICK_HZ           1000
+#define CAN_SCHEDULER_MAX_MESSAGES      16
+
+typedef struct
+{
+    uint32_t ui32Sent;                  // frames handed to the controller
+    uint32_t ui32Done;                  // frames confirmed on the wire
+    uint32_t ui32Overwritten;           // previous frame was still pending
+}
+tCANMessageStats;
+
+void CANSchedulerInit(const tCANPort *psPort);
+void CANSchedulerTick(const tADCFrame *psFrame);
+void CANSchedulerTxDone(uint32_t ui32Obj);
+void CANSchedulerPack(const tCANMessage *psMsg, const tADCFrame *psFrame,
+                      uint32_t ui32Counter, tCANFrame *psCANFrame);
+const tCANMessageStats *CANSchedulerStats(uint32_t ui32Msg);
+
+#endif
@@ -0,0 +1,89 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Consistent Overhead Byte Stuffing
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdint.h>
+#include "cobs.h"
+
+//*****************************************************************************
+//
+// Encodes a buffer so that it contains no zero bytes. The output needs room
+// for ui32Len + ui32Len / 254 + 1 bytes and does not include the trailing
+// zero delimiter. Returns the encoded length.
+//
+//*****************************************************************************
+uint32_t CobsEncode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out)
+{
+    uint32_t ui32Code = 0, ui32Out = 1;
+    uint8_t ui8Run = 1;
+
+    while(ui32Len--)
+    {
+        if(*pui8In != 0)
+        {
+            pui8Out[ui32Out++] = *pui8In;
+            ui8Run++;
+        }
+
+        if((*pui8In == 0) || (ui8Run == 0xFF))
+        {
+            pui8Out[ui32Code] = ui8Run;
+            ui32Code = ui32Out++;
+            ui8Run = 1;
+
+            //
+            // A full run that ends the input does not need another block.
+            //
+            if((*pui8In != 0) && (ui32Len == 0))
+            {
+                return ui32Code;
+            }
+        }
+
+        pui8In++;
+    }
+
+    pui8Out[ui32Code] = ui8Run;
+
+    return ui32Out;
+}
+
+//*****************************************************************************
+//
+// Decodes one COBS block, without the zero delimiter. The output may be the
+// same buffer as the input. Returns the decoded length or -1 if the input is
+// not valid COBS.
+//
+//*****************************************************************************
+int32_t CobsDecode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out)
+{
+    uint32_t ui32In = 0, ui32Out = 0, ui32Idx;
+    uint8_t ui8Code;
+
+    while(ui32In < ui32Len)
+    {
+        ui8Code = pui8In[ui32In++];
+        if((ui8Code == 0) || ((ui32In + ui8Code - 1) > ui32Len))
+        {
+            return -1;
+        }
+
+        for(ui32Idx = 1; ui32Idx < ui8Code; ui32Idx++)
+        {
+            if(pui8In[ui32In] == 0)
+            {
+                return -1;
+            }
+            pui8Out[ui32Out++] = pui8In[ui32In++];
+        }
+
+        if((ui8Code != 0xFF) && (ui32In < ui32Len))
+        {
+            pui8Out[ui32Out++] = 0;
+        }
+    }
+
+    return (int32_t)ui32Out;
+}
@@ -0,0 +1,7 @@
+#ifndef COBS_H
+#define COBS_H
+
+uint32_t CobsEncode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out);
+int32_t CobsDecode(const uint8_t *pui8In, uint32_t ui32Len, uint8_t *pui8Out);
+
+#endif
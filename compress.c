@@ -0,0 +1,399 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Delta and bit packing compression of sample blocks
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdint.h>
+#include "compress.h"
+
+//*****************************************************************************
+//
+// Number of bits needed for a value, 0 for 0.
+//
+//*****************************************************************************
+#if defined(__ARMCC_VERSION)
+#define CompressBitLength(x)    ((x) ? (32 - __clz(x)) : 0)
+#elif defined(__GNUC__)
+#define CompressBitLength(x)    ((x) ? (32 - __builtin_clz(x)) : 0)
+#else
+static uint32_t CompressBitLength(uint32_t ui32Value)
+{
+    uint32_t ui32Bits = 0;
+
+    while(ui32Value)
+    {
+        ui32Bits++;
+        ui32Value >>= 1;
+    }
+
+    return ui32Bits;
+}
+#endif
+
+//*****************************************************************************
+//
+// Zig-zag encoding of a two's complement difference given as unsigned value,
+// small negative and positive differences both become small numbers.
+//
+//*****************************************************************************
+#define CompressZigZag16(u)     ((uint16_t)(((u) << 1) ^ (0 - ((u) >> 15))))
+#define CompressZigZag32(u)     ((uint32_t)(((u) << 1) ^ (0 - ((u) >> 31))))
+
+//*****************************************************************************
+//
+// Bit stream writer and reader, least significant bit first. Fields of up to
+// 16 bits are moved at a time so a 32-bit accumulator is enough.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Out;
+    uint32_t ui32Acc;
+    uint32_t ui32Bits;
+}
+tBitWriter;
+
+typedef struct
+{
+    const uint8_t *pui8In;
+    const uint8_t *pui8End;
+    uint32_t ui32Acc;
+    uint32_t ui32Bits;
+    uint32_t bOverrun;
+}
+tBitReader;
+
+static inline void BitPut(tBitWriter *psWriter, uint32_t ui32Value,
+                          uint32_t ui32Bits)
+{
+    psWriter->ui32Acc |= ui32Value << psWriter->ui32Bits;
+    psWriter->ui32Bits += ui32Bits;
+
+    while(psWriter->ui32Bits >= 8)
+    {
+        *psWriter->pui8Out++ = (uint8_t)psWriter->ui32Acc;
+        psWriter->ui32Acc >>= 8;
+        psWriter->ui32Bits -= 8;
+    }
+}
+
+static void BitPut32(tBitWriter *psWriter, uint32_t ui32Value,
+                     uint32_t ui32Bits)
+{
+    if(ui32Bits > 16)
+    {
+        BitPut(psWriter, ui32Value & 0xFFFF, 16);
+        BitPut(psWriter, ui32Value >> 16, ui32Bits - 16);
+    }
+    else
+    {
+        BitPut(psWriter, ui32Value, ui32Bits);
+    }
+}
+
+static inline uint32_t BitGet(tBitReader *psReader, uint32_t ui32Bits)
+{
+    uint32_t ui32Value;
+
+    while(psReader->ui32Bits < ui32Bits)
+    {
+        if(psReader->pui8In == psReader->pui8End)
+        {
+            psReader->bOverrun = 1;
+            return 0;
+        }
+        psReader->ui32Acc |= (uint32_t)*psReader->pui8In++ <<
+                             psReader->ui32Bits;
+        psReader->ui32Bits += 8;
+    }
+
+    ui32Value = psReader->ui32Acc & ((1UL << ui32Bits) - 1);
+    psReader->ui32Acc >>= ui32Bits;
+    psReader->ui32Bits -= ui32Bits;
+
+    return ui32Value;
+}
+
+static uint32_t BitGet32(tBitReader *psReader, uint32_t ui32Bits)
+{
+    uint32_t ui32Value;
+
+    if(ui32Bits > 16)
+    {
+        ui32Value = BitGet(psReader, 16);
+        return ui32Value | (BitGet(psReader, ui32Bits - 16) << 16);
+    }
+
+    return BitGet(psReader, ui32Bits);
+}
+
+//*****************************************************************************
+//
+// Starts an empty block.
+//
+//*****************************************************************************
+void CompressBlockInit(tCompressBlock *psBlock, uint32_t ui32Channels)
+{
+    uint32_t ui32Ch;
+
+    if(ui32Channels > COMPRESS_MAX_CHANNELS)
+    {
+        ui32Channels = COMPRESS_MAX_CHANNELS;
+    }
+
+    psBlock->ui32Channels = ui32Channels;
+    psBlock->ui32Count = 0;
+    psBlock->ui32TimeBits = 0;
+    for(ui32Ch = 0; ui32Ch < ui32Channels; ui32Ch++)
+    {
+        psBlock->pui16Bits[ui32Ch] = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Adds a frame to the block. Returns the number of frames in the block, or 0
+// if the block is full or the frame does not continue its sequence; finish
+// the block and add the frame again then.
+//
+//*****************************************************************************
+uint32_t CompressBlockAdd(tCompressBlock *psBlock, uint32_t ui32Seq,
+                          uint32_t ui32Time, const uint16_t *pui16Data)
+{
+    uint32_t ui32Ch, ui32Idx = psBlock->ui32Count, ui32Period;
+    uint16_t ui16Delta;
+
+    if(ui32Idx == 0)
+    {
+        psBlock->ui32Seq = ui32Seq;
+        psBlock->ui32Step = 0;
+        psBlock->ui32Time = ui32Time;
+        for(ui32Ch = 0; ui32Ch < psBlock->ui32Channels; ui32Ch++)
+        {
+            psBlock->pui16First[ui32Ch] = pui16Data[ui32Ch];
+            psBlock->pui16Last[ui32Ch] = pui16Data[ui32Ch];
+        }
+    }
+    else
+    {
+        if(ui32Idx == COMPRESS_MAX_FRAMES)
+        {
+            return 0;
+        }
+
+        //
+        // The sequence must advance by the same step, at most 16 bits.
+        //
+        if(ui32Idx == 1)
+        {
+            psBlock->ui32Step = ui32Seq - psBlock->ui32Seq;
+            if((psBlock->ui32Step == 0) || (psBlock->ui32Step > 0xFFFF))
+            {
+                return 0;
+            }
+        }
+        else if(ui32Seq != (psBlock->ui32Seq + (ui32Idx * psBlock->ui32Step)))
+        {
+            return 0;
+        }
+
+        //
+        // Timestamps: the first difference is stored as the period, the
+        // later ones as their change against the previous difference.
+        //
+        ui32Period = ui32Time - psBlock->ui32LastTime;
+        if(ui32Idx == 1)
+        {
+            psBlock->ui32Period = ui32Period;
+        }
+        else
+        {
+            psBlock->pui32TimeDelta[ui32Idx] =
+                CompressZigZag32(ui32Period - psBlock->ui32LastPeriod);
+            psBlock->ui32TimeBits |= psBlock->pui32TimeDelta[ui32Idx];
+        }
+        psBlock->ui32LastPeriod = ui32Period;
+
+        for(ui32Ch = 0; ui32Ch < psBlock->ui32Channels; ui32Ch++)
+        {
+            ui16Delta = (uint16_t)(pui16Data[ui32Ch] -
+                                   psBlock->pui16Last[ui32Ch]);
+            psBlock->pui16Last[ui32Ch] = pui16Data[ui32Ch];
+            psBlock->pui16Delta[ui32Ch][ui32Idx] = CompressZigZag16(ui16Delta);
+            psBlock->pui16Bits[ui32Ch] |= psBlock->pui16Delta[ui32Ch][ui32Idx];
+        }
+    }
+
+    psBlock->ui32LastTime = ui32Time;
+    psBlock->ui32Count = ui32Idx + 1;
+
+    return psBlock->ui32Count;
+}
+
+//*****************************************************************************
+//
+// Returns the size in bytes CompressBlockFinish() will write for the frames
+// added so far.
+//
+//*****************************************************************************
+uint32_t CompressBlockSize(const tCompressBlock *psBlock)
+{
+    uint32_t ui32Ch, ui32Bits = 8 + 8 + 32 + 16 + 32;
+    uint32_t ui32Count = psBlock->ui32Count;
+
+    if(ui32Count > 1)
+    {
+        ui32Bits += 32 + 6;
+        if(ui32Count > 2)
+        {
+            ui32Bits += (ui32Count - 2) *
+                        CompressBitLength(psBlock->ui32TimeBits);
+        }
+    }
+
+    for(ui32Ch = 0; ui32Ch < psBlock->ui32Channels; ui32Ch++)
+    {
+        ui32Bits += 16 + 5 + ((ui32Count - 1) *
+                    CompressBitLength((uint32_t)psBlock->pui16Bits[ui32Ch]));
+    }
+
+    return (ui32Bits + 7) / 8;
+}
+
+//*****************************************************************************
+//
+// Packs the block into pui8Out, which needs room for COMPRESS_BLOCK_MAX()
+// bytes, and empties it. Returns the packed size in bytes.
+//
+//*****************************************************************************
+uint32_t CompressBlockFinish(tCompressBlock *psBlock, uint8_t *pui8Out)
+{
+    tBitWriter sWriter;
+    uint32_t ui32Ch, ui32Idx, ui32Bits, ui32Count = psBlock->ui32Count;
+    const uint16_t *pui16Delta;
+
+    sWriter.pui8Out = pui8Out;
+    sWriter.ui32Acc = 0;
+    sWriter.ui32Bits = 0;
+
+    BitPut(&sWriter, ui32Count, 8);
+    BitPut(&sWriter, psBlock->ui32Channels, 8);
+    BitPut32(&sWriter, psBlock->ui32Seq, 32);
+    BitPut(&sWriter, psBlock->ui32Step, 16);
+    BitPut32(&sWriter, psBlock->ui32Time, 32);
+
+    if(ui32Count > 1)
+    {
+        BitPut32(&sWriter, psBlock->ui32Period, 32);
+        ui32Bits = CompressBitLength(psBlock->ui32TimeBits);
+        BitPut(&sWriter, ui32Bits, 6);
+        for(ui32Idx = 2; ui32Idx < ui32Count; ui32Idx++)
+        {
+            BitPut32(&sWriter, psBlock->pui32TimeDelta[ui32Idx], ui32Bits);
+        }
+    }
+
+    for(ui32Ch = 0; ui32Ch < psBlock->ui32Channels; ui32Ch++)
+    {
+        BitPut(&sWriter, psBlock->pui16First[ui32Ch], 16);
+        ui32Bits = CompressBitLength((uint32_t)psBlock->pui16Bits[ui32Ch]);
+        BitPut(&sWriter, ui32Bits, 5);
+
+        pui16Delta = psBlock->pui16Delta[ui32Ch];
+        for(ui32Idx = 1; ui32Idx < ui32Count; ui32Idx++)
+        {
+            BitPut(&sWriter, pui16Delta[ui32Idx], ui32Bits);
+        }
+    }
+
+    if(sWriter.ui32Bits != 0)
+    {
+        BitPut(&sWriter, 0, 8 - sWriter.ui32Bits);
+    }
+
+    CompressBlockInit(psBlock, psBlock->ui32Channels);
+
+    return (uint32_t)(sWriter.pui8Out - pui8Out);
+}
+
+//*****************************************************************************
+//
+// Unpacks a block. pui32Time receives n timestamps and pui16Data n * ch
+// samples, frame by frame; both must hold COMPRESS_MAX_FRAMES frames of
+// COMPRESS_MAX_CHANNELS. Returns the number of bytes used or -1 if the block
+// is malformed.
+//
+//*****************************************************************************
+int32_t CompressBlockDecode(const uint8_t *pui8In, uint32_t ui32Len,
+                            tCompressHeader *psHeader, uint32_t *pui32Time,
+                            uint16_t *pui16Data)
+{
+    tBitReader sReader;
+    uint32_t ui32Ch, ui32Idx, ui32Bits, ui32Count, ui32Channels;
+    uint32_t ui32Period, ui32Value;
+    uint16_t ui16Sample;
+
+    sReader.pui8In = pui8In;
+    sReader.pui8End = pui8In + ui32Len;
+    sReader.ui32Acc = 0;
+    sReader.ui32Bits = 0;
+    sReader.bOverrun = 0;
+
+    ui32Count = BitGet(&sReader, 8);
+    ui32Channels = BitGet(&sReader, 8);
+    if((ui32Count == 0) || (ui32Count > COMPRESS_MAX_FRAMES) ||
+       (ui32Channels > COMPRESS_MAX_CHANNELS))
+    {
+        return -1;
+    }
+
+    psHeader->ui32Count = ui32Count;
+    psHeader->ui32Channels = ui32Channels;
+    psHeader->ui32Seq = BitGet32(&sReader, 32);
+    psHeader->ui32Step = BitGet(&sReader, 16);
+
+    pui32Time[0] = BitGet32(&sReader, 32);
+    if(ui32Count > 1)
+    {
+        ui32Period = BitGet32(&sReader, 32);
+        pui32Time[1] = pui32Time[0] + ui32Period;
+
+        ui32Bits = BitGet(&sReader, 6);
+        if(ui32Bits > 32)
+        {
+            return -1;
+        }
+        for(ui32Idx = 2; ui32Idx < ui32Count; ui32Idx++)
+        {
+            ui32Value = BitGet32(&sReader, ui32Bits);
+            ui32Period += (ui32Value >> 1) ^ (0 - (ui32Value & 1));
+            pui32Time[ui32Idx] = pui32Time[ui32Idx - 1] + ui32Period;
+        }
+    }
+
+    for(ui32Ch = 0; ui32Ch < ui32Channels; ui32Ch++)
+    {
+        ui16Sample = (uint16_t)BitGet(&sReader, 16);
+        pui16Data[ui32Ch] = ui16Sample;
+
+        ui32Bits = BitGet(&sReader, 5);
+        if(ui32Bits > 16)
+        {
+            return -1;
+        }
+        for(ui32Idx = 1; ui32Idx < ui32Count; ui32Idx++)
+        {
+            ui32Value = BitGet(&sReader, ui32Bits);
+            ui16Sample += (uint16_t)((ui32Value >> 1) ^ (0 - (ui32Value & 1)));
+            pui16Data[(ui32Idx * ui32Channels) + ui32Ch] = ui16Sample;
+        }
+    }
+
+    if(sReader.bOverrun)
+    {
+        return -1;
+    }
+
+    return (int32_t)(sReader.pui8In - pui8In);
+}
@@ -0,0 +1,96 @@
+//*****************************************************************************
+//
+// compress.h - Delta and bit packing compression of sample blocks.
+//
+// Shared by the firmware and the host tools, so it must only depend on
+// stdint.h. A block holds up to COMPRESS_MAX_FRAMES frames of up to
+// COMPRESS_MAX_CHANNELS 16-bit samples each, with the frame sequence numbers
+// and timestamps. Frames are added one at a time so the work is spread over
+// the stream, CompressBlockFinish() packs the block.
+//
+// Every stream of the block is stored as its first value followed by
+// zig-zag encoded differences, all differences of a stream with the width of
+// the largest one. A bit stream, least significant bit first:
+//
+//     bits  field
+//     8     frames in the block, n
+//     8     channels, ch
+//     32    sequence number of the first frame
+//     16    sequence step (decimation), frames are evenly spaced
+//     32    timestamp of the first frame
+//   if n > 1:
+//     32    t1 - t0
+//     6     width w of the time stream
+//     w     (n - 2) times: zig-zag of (t[i] - t[i-1]) - (t[i-1] - t[i-2])
+//   ch times:
+//     16    first sample
+//     5     width w of the channel
+//     w     (n - 1) times: zig-zag of the 16-bit difference to the previous
+//           sample
+//
+// The block is padded to a whole byte with zero bits. Differences wrap
+// modulo 2^16 (samples) and 2^32 (timestamps), so any input is lossless.
+//
+//*****************************************************************************
+
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdint.h>
+
+#define COMPRESS_MAX_FRAMES             32
+#define COMPRESS_MAX_CHANNELS           8
+
+// worst case size of a packed block in bytes
+#define COMPRESS_BLOCK_MAX(n, ch)                                             \
+    ((128 + 6 + (32 * (n)) + ((ch) * (21 + (16 * (n))))) / 8 + 1)
+
+//*****************************************************************************
+//
+// Block under construction. Only the zig-zag differences are kept, the width
+// of every stream is tracked as an OR of its values while frames come in.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Channels;
+    uint32_t ui32Count;
+    uint32_t ui32Seq;
+    uint32_t ui32Step;
+    uint32_t ui32Time;
+    uint32_t ui32Period;
+    uint32_t ui32LastTime;
+    uint32_t ui32LastPeriod;
+    uint32_t ui32TimeBits;
+    uint32_t pui32TimeDelta[COMPRESS_MAX_FRAMES];
+    uint16_t pui16First[COMPRESS_MAX_CHANNELS];
+    uint16_t pui16Last[COMPRESS_MAX_CHANNELS];
+    uint16_t pui16Bits[COMPRESS_MAX_CHANNELS];
+    uint16_t pui16Delta[COMPRESS_MAX_CHANNELS][COMPRESS_MAX_FRAMES];
+}
+tCompressBlock;
+
+//*****************************************************************************
+//
+// Decoded block header.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Channels;
+    uint32_t ui32Seq;
+    uint32_t ui32Step;
+}
+tCompressHeader;
+
+void CompressBlockInit(tCompressBlock *psBlock, uint32_t ui32Channels);
+uint32_t CompressBlockAdd(tCompressBlock *psBlock, uint32_t ui32Seq,
+                          uint32_t ui32Time, const uint16_t *pui16Data);
+uint32_t CompressBlockSize(const tCompressBlock *psBlock);
+uint32_t CompressBlockFinish(tCompressBlock *psBlock, uint8_t *pui8Out);
+int32_t CompressBlockDecode(const uint8_t *pui8In, uint32_t ui32Len,
+                            tCompressHeader *psHeader, uint32_t *pui32Time,
+                            uint16_t *pui16Data);
+
+#endif
@@ -0,0 +1,621 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/cmdline.h"
+#include "utils/uartstdio.h"
+#include "utils/ustdlib.h"
+#include "hal.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "trace_recorder.h"
+#include "deadline_monitor.h"
+#include "uart_log.h"
+#include "telemetry.h"
+#include "can_driver.h"
+#include "sdlog_task.h"
+#include "freeze_frame.h"
+#include "event_log.h"
+#include "calib.h"
+#include "sensor_diag.h"
+#include "stats.h"
+#include "adc_api.h"
+#if defined(ECU_BENCH)
+#include "bench.h"
+#endif
+#include "rate_group.h"
+#include "sensor_bus.h"
+#include "block_pool.h"
+#include "wheel_speed.h"
+
+//*****************************************************************************
+//
+// The stack size for the console task.
+//
+//*****************************************************************************
+#define CONSOLETASKSTACKSIZE            256             // Stack size in words
+
+//*****************************************************************************
+//
+// The console polls the UART receive FIFO instead of blocking in UARTgets()
+// so it never spins while waiting for input.
+//
+//*****************************************************************************
+#define CONSOLE_POLL_MS                 20
+#define CONSOLE_LINE_SIZE               64
+
+extern xSemaphoreHandle g_pUARTSemaphore;
+
+static int CmdHelp(int argc, char *argv[]);
+static int CmdTrace(int argc, char *argv[]);
+static int CmdDeadline(int argc, char *argv[]);
+static int CmdLog(int argc, char *argv[]);
+static int CmdTelemetry(int argc, char *argv[]);
+static int CmdCAN(int argc, char *argv[]);
+static int CmdSDLog(int argc, char *argv[]);
+static int CmdFreeze(int argc, char *argv[]);
+static int CmdEventLog(int argc, char *argv[]);
+static int CmdCalib(int argc, char *argv[]);
+static int CmdDiag(int argc, char *argv[]);
+static int CmdStats(int argc, char *argv[]);
+static int CmdADC(int argc, char *argv[]);
+#if defined(ECU_BENCH)
+static int CmdBench(int argc, char *argv[]);
+#endif
+static int CmdRateGroup(int argc, char *argv[]);
+static int CmdSensorBus(int argc, char *argv[]);
+static int CmdBlockPool(int argc, char *argv[]);
+static int CmdWheelSpeed(int argc, char *argv[]);
+
+//*****************************************************************************
+//
+// The table of commands supported by the console. Handlers are called with
+// the UART mutex held.
+//
+//*****************************************************************************
+tCmdLineEntry g_psCmdTable[] =
+{
+    { "help",     CmdHelp,     "      : Display list of commands" },
+    { "trace",    CmdTrace,    "     : trace dump|start|stop|clear" },
+    { "deadline", CmdDeadline, "  : Print task deadline statistics" },
+    { "log",      CmdLog,      "       : log text|bin|stats" },
+    { "telem",    CmdTelemetry, "     : telem on|zon [decimation] [baud]|off|stats" },
+    { "can",      CmdCAN,      "       : Print CAN message statistics" },
+    { "sdlog",    CmdSDLog,    "     : sdlog start|stop|stats" },
+    { "freeze",   CmdFreeze,   "    : freeze dump|arm|trigger" },
+    { "evlog",    CmdEventLog, "     : evlog [clear], EEPROM fault log" },
+    { "cal",      CmdCalib,    "       : cal [set|lut|tune|save|load|default]" },
+    { "diag",     CmdDiag,     "      : diag [clear], sensor trouble codes" },
+    { "stats",    CmdStats,    "     : stats [window <ms>|reset], channel statistics" },
+    { "adc",      CmdADC,      "       : adc [reset], ADC interrupt cycles per stage" },
+#if defined(ECU_BENCH)
+    { "bench",    CmdBench,    "     : bench [name], cycles of the hot paths as CSV" },
+#endif
+    { "rate",     CmdRateGroup, "      : Print rate group overruns and runnable times" },
+    { "bus",      CmdSensorBus, "       : Print sensor bus topics and their readers" },
+    { "pool",     CmdBlockPool, "      : pool [reset], block pool usage" },
+    { "wheels",   CmdWheelSpeed, "    : Print front wheel speeds and edge counts" },
+    { 0, 0, 0 }
+};
+
+static int CmdHelp(int argc, char *argv[])
+{
+    tCmdLineEntry *psEntry;
+
+    UARTprintf("\nAvailable commands\n------------------\n");
+    for(psEntry = g_psCmdTable; psEntry->pcCmd; psEntry++)
+    {
+        UARTprintf("%s%s\n", psEntry->pcCmd, psEntry->pcHelp);
+    }
+
+    return(0);
+}
+
+static int CmdTrace(int argc, char *argv[])
+{
+    if((argc < 2) || (strcmp(argv[1], "dump") == 0))
+    {
+        TraceRecorderDump();
+    }
+    else if(strcmp(argv[1], "start") == 0)
+    {
+        TraceRecorderStart();
+    }
+    else if(strcmp(argv[1], "stop") == 0)
+    {
+        TraceRecorderStop();
+    }
+    else if(strcmp(argv[1], "clear") == 0)
+    {
+        TraceRecorderClear();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdDeadline(int argc, char *argv[])
+{
+    DeadlineMonitorReport();
+
+    return(0);
+}
+
+static int CmdRateGroup(int argc, char *argv[])
+{
+    RateGroupReport();
+
+    return(0);
+}
+
+static int CmdSensorBus(int argc, char *argv[])
+{
+    tSensorBusTopic *psTopic;
+    tSensorBusSub *psSub;
+
+    UARTprintf("\ntopic      slots  size  published\n");
+    for(psTopic = SensorBusTopics(); psTopic; psTopic = psTopic->psNext)
+    {
+        UARTprintf("%-9s  %5u  %4u  %u\n", psTopic->pcName,
+                   psTopic->ui32Mask + 1, psTopic->ui32SlotSize,
+                   SensorBusSeqGet(psTopic));
+        for(psSub = psTopic->psSubs; psSub; psSub = psSub->psNext)
+        {
+            UARTprintf("  %-9s reads %u lost %u\n", psSub->pcName,
+                       psSub->ui32Reads, psSub->ui32Lost);
+        }
+    }
+
+    return(0);
+}
+
+static int CmdBlockPool(int argc, char *argv[])
+{
+    tBlockPool *psPool;
+
+    if(argc < 2)
+    {
+        BlockPoolReport();
+    }
+    else if(strcmp(argv[1], "reset") == 0)
+    {
+        for(psPool = BlockPools(); psPool; psPool = psPool->psNext)
+        {
+            BlockPoolStatsReset(psPool);
+        }
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdWheelSpeed(int argc, char *argv[])
+{
+    WheelSpeedReport();
+
+    return(0);
+}
+
+static int CmdLog(int argc, char *argv[])
+{
+    if((argc < 2) || (strcmp(argv[1], "stats") == 0))
+    {
+        UARTLogReport();
+    }
+    else if(strcmp(argv[1], "text") == 0)
+    {
+        UARTLogModeSet(LOG_MODE_TEXT);
+    }
+    else if(strcmp(argv[1], "bin") == 0)
+    {
+        UARTLogModeSet(LOG_MODE_BINARY);
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdTelemetry(int argc, char *argv[])
+{
+    uint32_t ui32Decimation = g_psCalib->sTuning.ui32TelemetryDecimation;
+    uint32_t ui32Baud = TELEMETRY_DEFAULT_BAUD;
+
+    if((argc < 2) || (strcmp(argv[1], "stats") == 0))
+    {
+        TelemetryReport();
+    }
+    else if((strcmp(argv[1], "on") == 0) || (strcmp(argv[1], "zon") == 0))
+    {
+        if(argc > 2)
+        {
+            ui32Decimation = ustrtoul(argv[2], NULL, 0);
+        }
+        if(argc > 3)
+        {
+            ui32Baud = ustrtoul(argv[3], NULL, 0);
+        }
+        TelemetryStart(ui32Decimation, ui32Baud, argv[1][0] == 'z');
+    }
+    else if(strcmp(argv[1], "off") == 0)
+    {
+        TelemetryStop();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdCAN(int argc, char *argv[])
+{
+    CANDriverReport();
+
+    return(0);
+}
+
+static int CmdSDLog(int argc, char *argv[])
+{
+    if((argc < 2) || (strcmp(argv[1], "stats") == 0))
+    {
+        SDLogTaskReport();
+    }
+    else if(strcmp(argv[1], "start") == 0)
+    {
+        SDLogTaskStart();
+    }
+    else if(strcmp(argv[1], "stop") == 0)
+    {
+        SDLogTaskStop();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdFreeze(int argc, char *argv[])
+{
+    if((argc < 2) || (strcmp(argv[1], "dump") == 0))
+    {
+        FreezeFrameDump();
+    }
+    else if(strcmp(argv[1], "arm") == 0)
+    {
+        FreezeFrameArm();
+    }
+    else if(strcmp(argv[1], "trigger") == 0)
+    {
+        FreezeFrameTrigger();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdEventLog(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        EventLogDump();
+    }
+    else if(strcmp(argv[1], "clear") == 0)
+    {
+        EventLogClear();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// ustrtoul() with an optional minus sign.
+//
+//*****************************************************************************
+static int32_t ConsoleStrToInt(const char *pcStr)
+{
+    if(pcStr[0] == '-')
+    {
+        return -(int32_t)ustrtoul(pcStr + 1, NULL, 0);
+    }
+
+    return (int32_t)ustrtoul(pcStr, NULL, 0);
+}
+
+static int CmdCalib(int argc, char *argv[])
+{
+    int32_t i32Status;
+
+    if(argc < 2)
+    {
+        CalibReport();
+        return(0);
+    }
+
+    if((strcmp(argv[1], "set") == 0) && (argc == 5))
+    {
+        i32Status = CalibSensorSet(ustrtoul(argv[2], NULL, 0), argv[3],
+                                   ConsoleStrToInt(argv[4]));
+    }
+    else if((strcmp(argv[1], "lut") == 0) && (argc == 6))
+    {
+        i32Status = CalibLutSet(ustrtoul(argv[2], NULL, 0),
+                                ustrtoul(argv[3], NULL, 0),
+                                ConsoleStrToInt(argv[4]),
+                                ConsoleStrToInt(argv[5]));
+    }
+    else if((strcmp(argv[1], "tune") == 0) && (argc == 4))
+    {
+        i32Status = CalibTuningSet(argv[2], ConsoleStrToInt(argv[3]));
+    }
+    else if(strcmp(argv[1], "save") == 0)
+    {
+        i32Status = CalibSave();
+    }
+    else if(strcmp(argv[1], "load") == 0)
+    {
+        i32Status = CalibLoad();
+    }
+    else if(strcmp(argv[1], "default") == 0)
+    {
+        CalibDefaults();
+        i32Status = 0;
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    if(i32Status != 0)
+    {
+        UARTprintf("cal: rejected\n");
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Prints the trouble codes of the sensor diagnostics: active now, or set
+// since the last clear with how often and at which frames.
+//
+//*****************************************************************************
+static int CmdDiag(int argc, char *argv[])
+{
+    const tSensorDiagRecord *psRecord;
+    uint32_t ui32Active, ui32History, ui32Ch, ui32Type, ui32Bit;
+
+    if((argc > 1) && (strcmp(argv[1], "clear") == 0))
+    {
+        SensorDiagClear();
+        return(0);
+    }
+    else if(argc > 1)
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    ui32Active = SensorDiagActive();
+    ui32History = SensorDiagHistory();
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        UARTprintf("ch%u noise %u counts^2\n", ui32Ch,
+                   SensorDiagNoise(ui32Ch));
+        for(ui32Type = 0; ui32Type < SENSOR_DIAG_NUM_TYPES; ui32Type++)
+        {
+            ui32Bit = SENSOR_DIAG_DTC(ui32Ch, ui32Type);
+            if(!((ui32Active | ui32History) & ui32Bit))
+            {
+                continue;
+            }
+
+            psRecord = SensorDiagRecord(ui32Ch, ui32Type);
+            UARTprintf("  %s %s, %u times, frames %u..%u\n",
+                       g_ppcSensorDiagNames[ui32Type],
+                       (ui32Active & ui32Bit) ? "ACTIVE" : "stored",
+                       psRecord->ui32Count, psRecord->ui32FirstSeq,
+                       psRecord->ui32LastSeq);
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Prints count, range, mean and deviation of every channel over the rolling
+// window and since the last reset.
+//
+//*****************************************************************************
+static void ConsoleStatsLine(uint32_t ui32Ch, const char *pcName,
+                             bool bWindow)
+{
+    tStatsResult sResult;
+    uint32_t ui32Std;
+
+    if(!StatsGet(ui32Ch, bWindow, &sResult))
+    {
+        UARTprintf("ch%u %s no samples\n", ui32Ch, pcName);
+        return;
+    }
+
+    ui32Std = StatsStdQ8(sResult.ui32VarQ8);
+    UARTprintf("ch%u %s n %u min %u max %u mean %d.%02d std %u.%02u\n",
+               ui32Ch, pcName, sResult.ui32Count, sResult.ui32Min,
+               sResult.ui32Max, sResult.i32MeanQ8 >> 8,
+               ((sResult.i32MeanQ8 & 0xFF) * 100) >> 8, ui32Std >> 8,
+               ((ui32Std & 0xFF) * 100) >> 8);
+}
+
+static int CmdStats(int argc, char *argv[])
+{
+    uint32_t ui32Ch;
+
+    if(argc < 2)
+    {
+        UARTprintf("window %ums\n", StatsWindowGet());
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            ConsoleStatsLine(ui32Ch, "window", true);
+            ConsoleStatsLine(ui32Ch, "total ", false);
+        }
+    }
+    else if((strcmp(argv[1], "window") == 0) && (argc == 3))
+    {
+        StatsWindowSet(ustrtoul(argv[2], NULL, 0));
+    }
+    else if(strcmp(argv[1], "reset") == 0)
+    {
+        StatsReset();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+static int CmdADC(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        ADCStageReport();
+    }
+    else if(strcmp(argv[1], "reset") == 0)
+    {
+        ADCStageStatsReset();
+    }
+    else
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+#if defined(ECU_BENCH)
+static int CmdBench(int argc, char *argv[])
+{
+    if(!BenchRun((argc > 1) ? argv[1] : NULL))
+    {
+        return(CMDLINE_INVALID_ARG);
+    }
+
+    return(0);
+}
+#endif
+
+//*****************************************************************************
+//
+// Runs one command line and reports parser errors.
+//
+//*****************************************************************************
+static void ConsoleProcessLine(char *pcLine)
+{
+    int iStatus = CmdLineProcess(pcLine);
+
+    if(iStatus == CMDLINE_BAD_CMD)
+    {
+        UARTprintf("Bad command!\n");
+    }
+    else if(iStatus == CMDLINE_TOO_MANY_ARGS)
+    {
+        UARTprintf("Too many arguments for command processor!\n");
+    }
+    else if(iStatus == CMDLINE_INVALID_ARG)
+    {
+        UARTprintf("Invalid argument!\n");
+    }
+
+    UARTprintf("> ");
+}
+
+//*****************************************************************************
+//
+// This task collects characters from UART0 into a line and hands complete
+// lines to the command line processor.
+//
+//*****************************************************************************
+static void ConsoleTask(void *pvParameters)
+{
+    static char pcLine[CONSOLE_LINE_SIZE];
+    uint32_t ui32Len = 0;
+    int32_t i32Char;
+
+    while(1)
+    {
+        i32Char = HalUARTCharGetNonBlocking(0);
+        if(i32Char < 0)
+        {
+            vTaskDelay(CONSOLE_POLL_MS);
+            continue;
+        }
+
+        xSemaphoreTake(g_pUARTSemaphore, portMAX_DELAY);
+
+        if((i32Char == '\r') || (i32Char == '\n'))
+        {
+            if(ui32Len != 0)
+            {
+                pcLine[ui32Len] = '\0';
+                ui32Len = 0;
+                UARTprintf("\n");
+                ConsoleProcessLine(pcLine);
+            }
+        }
+        else if((i32Char == '\b') || (i32Char == 0x7F))
+        {
+            if(ui32Len != 0)
+            {
+                ui32Len--;
+                UARTprintf("\b \b");
+            }
+        }
+        else if(ui32Len < (CONSOLE_LINE_SIZE - 1))
+        {
+            pcLine[ui32Len++] = (char)i32Char;
+            UARTprintf("%c", i32Char);
+        }
+
+        xSemaphoreGive(g_pUARTSemaphore);
+    }
+}
+
+//*****************************************************************************
+//
+// Initializes the console task.
+//
+//*****************************************************************************
+uint32_t ConsoleTaskInit(void)
+{
+    if(xTaskCreate(ConsoleTask, (const portCHAR *)"CON", CONSOLETASKSTACKSIZE,
+                   NULL, tskIDLE_PRIORITY + PRIORITY_CONSOLE_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
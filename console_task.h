@@ -0,0 +1,11 @@
+#ifndef __CONSOLE_TASK_H__
+#define __CONSOLE_TASK_H__
+
+//*****************************************************************************
+//
+// Prototypes for the UART console task.
+//
+//*****************************************************************************
+extern uint32_t ConsoleTaskInit(void);
+
+#endif // __CONSOLE_TASK_H__
@@ -0,0 +1,9 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#define CRC16_CCITT_INIT                0xFFFF
+
+uint16_t Crc16Ccitt(uint16_t ui16Crc, const uint8_t *pui8Data,
+                    uint32_t ui32Len);
+
+#endif
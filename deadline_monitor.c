@@ -0,0 +1,292 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Period/deadline monitor for the periodic FreeRTOS tasks
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/uartstdio.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timestamp.h"
+#include "deadline_monitor.h"
+#include "uart_log.h"
+
+/******************************************************************************
+Description: every periodic task calls DeadlineMonitorStart() when it is
+released and DeadlineMonitorFinish() before it blocks again. The monitor keeps
+the expected release time of the next activation, so the time from release to
+start (scheduling latency) and from start to finish (execution time) can be
+binned into fixed width histograms. An activation that finishes after its
+deadline is counted as a miss.
+
+The tasks are expected to use vTaskDelayUntil() so that releases are strictly
+periodic. The first activation defines the release phase. A task released by
+an interrupt that drops releases while the task is still busy, like the rate
+groups, gets the time of every release from DeadlineMonitorRelease()
+instead, otherwise the monitor would stay a period behind after each drop.
+******************************************************************************/
+
+//*****************************************************************************
+//
+// The stack size and reporting period of the monitor report task.
+//
+//*****************************************************************************
+#define MONITORTASKSTACKSIZE            128             // Stack size in words
+#define MONITOR_REPORT_PERIOD_MS        5000
+
+extern xSemaphoreHandle g_pUARTSemaphore;
+
+static tDeadlineMonitor *g_psMonitors = NULL;
+
+//*****************************************************************************
+//
+// Returns the histogram bucket for a duration given in cycles.
+//
+//*****************************************************************************
+static uint32_t DeadlineMonitorBucket(tDeadlineMonitor *psMonitor,
+                                      uint32_t ui32Cycles)
+{
+    uint32_t ui32Bucket = ui32Cycles >> psMonitor->ui32BucketShift;
+
+    if(ui32Bucket >= DEADLINE_HIST_BUCKETS)
+    {
+        ui32Bucket = DEADLINE_HIST_BUCKETS - 1;
+    }
+
+    return ui32Bucket;
+}
+
+//*****************************************************************************
+//
+// Initializes a monitor and adds it to the list printed by the report task.
+// The bucket width is rounded up to a power of two number of cycles so that
+// binning a sample is a single shift.
+//
+//*****************************************************************************
+void DeadlineMonitorRegister(tDeadlineMonitor *psMonitor, const char *pcName,
+                             uint32_t ui32PeriodUs, uint32_t ui32DeadlineUs,
+                             uint32_t ui32BucketUs)
+{
+    uint32_t ui32BucketCycles = TimestampUsToCycles(ui32BucketUs);
+
+    psMonitor->pcName = pcName;
+    psMonitor->ui32Period = TimestampUsToCycles(ui32PeriodUs);
+    psMonitor->ui32Deadline = TimestampUsToCycles(ui32DeadlineUs);
+    psMonitor->bReleaseGiven = false;
+
+    psMonitor->ui32BucketShift = 0;
+    while((1UL << psMonitor->ui32BucketShift) < ui32BucketCycles)
+    {
+        psMonitor->ui32BucketShift++;
+    }
+
+    DeadlineMonitorReset(psMonitor);
+
+    taskENTER_CRITICAL();
+    psMonitor->psNext = g_psMonitors;
+    g_psMonitors = psMonitor;
+    taskEXIT_CRITICAL();
+}
+
+//*****************************************************************************
+//
+// Clears the statistics of a monitor. The next activation defines a new
+// release phase.
+//
+//*****************************************************************************
+void DeadlineMonitorReset(tDeadlineMonitor *psMonitor)
+{
+    uint32_t ui32Idx;
+
+    psMonitor->bRunning = false;
+    psMonitor->ui32Activations = 0;
+    psMonitor->ui32Misses = 0;
+    psMonitor->ui32MaxLatency = 0;
+    psMonitor->ui32MaxExec = 0;
+
+    for(ui32Idx = 0; ui32Idx < DEADLINE_HIST_BUCKETS; ui32Idx++)
+    {
+        psMonitor->pui32Latency[ui32Idx] = 0;
+        psMonitor->pui32Exec[ui32Idx] = 0;
+    }
+}
+
+//*****************************************************************************
+//
+// Sets the release time of the next activation. Called by the interrupt
+// handler that releases the task, while the task waits for it.
+//
+//*****************************************************************************
+void DeadlineMonitorRelease(tDeadlineMonitor *psMonitor, uint32_t ui32Time)
+{
+    psMonitor->ui32NextRelease = ui32Time;
+    psMonitor->bReleaseGiven = true;
+}
+
+//*****************************************************************************
+//
+// Marks the start of an activation.
+//
+//*****************************************************************************
+void DeadlineMonitorStart(tDeadlineMonitor *psMonitor)
+{
+    uint32_t ui32Now = TimestampGet();
+    uint32_t ui32Latency;
+
+    if(!psMonitor->bRunning)
+    {
+        if(!psMonitor->bReleaseGiven)
+        {
+            psMonitor->ui32NextRelease = ui32Now;
+        }
+        psMonitor->bRunning = true;
+    }
+
+    //
+    // The tick and the cycle counter are driven by the same clock, but the
+    // first activation may have started slightly late. Treat an early start
+    // as zero latency rather than a wrapped huge one.
+    //
+    ui32Latency = ui32Now - psMonitor->ui32NextRelease;
+    if((int32_t)ui32Latency < 0)
+    {
+        ui32Latency = 0;
+    }
+
+    psMonitor->ui32Start = ui32Now;
+    psMonitor->pui32Latency[DeadlineMonitorBucket(psMonitor, ui32Latency)]++;
+    if(ui32Latency > psMonitor->ui32MaxLatency)
+    {
+        psMonitor->ui32MaxLatency = ui32Latency;
+    }
+}
+
+//*****************************************************************************
+//
+// Marks the end of an activation and checks it against the deadline.
+//
+//*****************************************************************************
+void DeadlineMonitorFinish(tDeadlineMonitor *psMonitor)
+{
+    uint32_t ui32Now = TimestampGet();
+    uint32_t ui32Exec = ui32Now - psMonitor->ui32Start;
+    int32_t i32Response = (int32_t)(ui32Now - psMonitor->ui32NextRelease);
+
+    psMonitor->pui32Exec[DeadlineMonitorBucket(psMonitor, ui32Exec)]++;
+    if(ui32Exec > psMonitor->ui32MaxExec)
+    {
+        psMonitor->ui32MaxExec = ui32Exec;
+    }
+
+    if(i32Response > (int32_t)psMonitor->ui32Deadline)
+    {
+        psMonitor->ui32Misses++;
+        LOG2(LOG_DEADLINE_MISS, TimestampCyclesToUs(psMonitor->ui32Period),
+             TimestampCyclesToUs((uint32_t)i32Response));
+    }
+
+    psMonitor->ui32Activations++;
+    if(!psMonitor->bReleaseGiven)
+    {
+        psMonitor->ui32NextRelease += psMonitor->ui32Period;
+    }
+}
+
+//*****************************************************************************
+//
+// Prints one histogram as a list of bucket counts.
+//
+//*****************************************************************************
+static void DeadlineMonitorPrintHist(const char *pcLabel, uint32_t *pui32Hist)
+{
+    uint32_t ui32Idx;
+
+    UARTprintf("  %s:", pcLabel);
+    for(ui32Idx = 0; ui32Idx < DEADLINE_HIST_BUCKETS; ui32Idx++)
+    {
+        UARTprintf(" %u", pui32Hist[ui32Idx]);
+    }
+    UARTprintf("\n");
+}
+
+//*****************************************************************************
+//
+// Returns the monitor registered with the given name, or NULL.
+//
+//*****************************************************************************
+tDeadlineMonitor *DeadlineMonitorFind(const char *pcName)
+{
+    tDeadlineMonitor *psMonitor;
+
+    for(psMonitor = g_psMonitors; psMonitor != NULL;
+        psMonitor = psMonitor->psNext)
+    {
+        if(strcmp(psMonitor->pcName, pcName) == 0)
+        {
+            break;
+        }
+    }
+
+    return psMonitor;
+}
+
+//*****************************************************************************
+//
+// Prints the statistics of every registered monitor. The caller must own the
+// UART.
+//
+//*****************************************************************************
+void DeadlineMonitorReport(void)
+{
+    tDeadlineMonitor *psMonitor;
+
+    for(psMonitor = g_psMonitors; psMonitor != NULL;
+        psMonitor = psMonitor->psNext)
+    {
+        UARTprintf("\n%s: act %u miss %u max lat %uus max exec %uus "
+                   "bucket %uus\n", psMonitor->pcName,
+                   psMonitor->ui32Activations, psMonitor->ui32Misses,
+                   TimestampCyclesToUs(psMonitor->ui32MaxLatency),
+                   TimestampCyclesToUs(psMonitor->ui32MaxExec),
+                   TimestampCyclesToUs(1UL << psMonitor->ui32BucketShift));
+        DeadlineMonitorPrintHist("lat ", psMonitor->pui32Latency);
+        DeadlineMonitorPrintHist("exec", psMonitor->pui32Exec);
+    }
+}
+
+//*****************************************************************************
+//
+// This task periodically prints the monitor statistics over the UART.
+//
+//*****************************************************************************
+static void MonitorTask(void *pvParameters)
+{
+    while(1)
+    {
+        vTaskDelay(MONITOR_REPORT_PERIOD_MS);
+
+        xSemaphoreTake(g_pUARTSemaphore, portMAX_DELAY);
+        DeadlineMonitorReport();
+        xSemaphoreGive(g_pUARTSemaphore);
+    }
+}
+
+//*****************************************************************************
+//
+// Initializes the monitor report task.
+//
+//*****************************************************************************
+uint32_t DeadlineMonitorTaskInit(void)
+{
+    if(xTaskCreate(MonitorTask, (const portCHAR *)"MON", MONITORTASKSTACKSIZE,
+                   NULL, tskIDLE_PRIORITY + PRIORITY_MONITOR_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
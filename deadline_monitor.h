@@ -0,0 +1,53 @@
+#ifndef DEADLINE_MONITOR_H
+#define DEADLINE_MONITOR_H
+
+//*****************************************************************************
+//
+// Number of histogram buckets kept per monitor. The last bucket collects
+// everything that does not fit in the others.
+//
+//*****************************************************************************
+#define DEADLINE_HIST_BUCKETS           16
+
+//*****************************************************************************
+//
+// Timing record of one periodic task. All times are in DWT cycles.
+//
+//*****************************************************************************
+typedef struct tDeadlineMonitor
+{
+    const char *pcName;
+    uint32_t ui32Period;
+    uint32_t ui32Deadline;
+    uint32_t ui32BucketShift;
+
+    uint32_t ui32NextRelease;
+    uint32_t ui32Start;
+    bool bRunning;
+    bool bReleaseGiven;                 // set by DeadlineMonitorRelease()
+
+    uint32_t ui32Activations;
+    uint32_t ui32Misses;
+    uint32_t ui32MaxLatency;
+    uint32_t ui32MaxExec;
+
+    // release-to-start and start-to-finish histograms
+    uint32_t pui32Latency[DEADLINE_HIST_BUCKETS];
+    uint32_t pui32Exec[DEADLINE_HIST_BUCKETS];
+
+    struct tDeadlineMonitor *psNext;
+}
+tDeadlineMonitor;
+
+void DeadlineMonitorRegister(tDeadlineMonitor *psMonitor, const char *pcName,
+                             uint32_t ui32PeriodUs, uint32_t ui32DeadlineUs,
+                             uint32_t ui32BucketUs);
+void DeadlineMonitorRelease(tDeadlineMonitor *psMonitor, uint32_t ui32Time);
+void DeadlineMonitorStart(tDeadlineMonitor *psMonitor);
+void DeadlineMonitorFinish(tDeadlineMonitor *psMonitor);
+void DeadlineMonitorReset(tDeadlineMonitor *psMonitor);
+tDeadlineMonitor *DeadlineMonitorFind(const char *pcName);
+void DeadlineMonitorReport(void);
+uint32_t DeadlineMonitorTaskInit(void);
+
+#endif
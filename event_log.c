@@ -0,0 +1,517 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Persistent fault and event log in the internal EEPROM
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "hal.h"
+#include "utils/uartstdio.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "crc16.h"
+#include "timestamp.h"
+#include "event_log.h"
+
+/******************************************************************************
+Description: an append-only ring of fixed size records in the EEPROM that
+survives power cycles. Record layout, 32-bit words:
+
+    word 0      sequence number (bits 31:16), CRC-16/CCITT-FALSE of the
+                sequence number and words 1 to 7 (bits 15:0)
+    word 1      event id (bits 31:24), boot number (bits 15:0)
+    word 2      milliseconds since that boot
+    word 3..7   arguments
+
+Record n always goes to slot n % EVENTLOG_SLOTS, so the writes walk through
+all slots evenly and every EEPROM word sees the same wear. Word 0 is
+programmed last and commits the record, a record torn by a power loss fails
+its CRC and is skipped. At boot the newest valid record gives the next
+sequence number and the boot number, one pass over 1kB.
+
+EventLogWrite() only queues the event in RAM with interrupts masked for a
+few stores, like LOGn(), and is safe from any interrupt. The low priority
+EVL task programs the queued records one word at a time with the non
+blocking EEPROM call and sleeps while the EEPROM is busy, and waits
+EVENTLOG_WRITE_MS between records so a chattering fault cannot wear the
+EEPROM out. Nothing in the sampling path ever waits for the EEPROM.
+
+Crash records are written directly and blocking from the stack overflow hook
+and the hard fault handler, the scheduler is not usable there anymore.
+******************************************************************************/
+
+#define EVENTLOGTASKSTACKSIZE           128             // Stack size in words
+#define EVENTLOG_QUEUE_SIZE             8               // must be power of two
+#define EVENTLOG_POLL_MS                50
+#define EVENTLOG_WRITE_MS               100
+
+typedef struct
+{
+    uint32_t ui32Id;
+    uint32_t ui32Time;                  // DWT timestamp
+    uint32_t pui32Args[3];
+}
+tEventLogEntry;
+
+static tEventLogEntry g_psEventLogQueue[EVENTLOG_QUEUE_SIZE];
+static volatile uint32_t g_ui32EventLogHead = 0;
+static volatile uint32_t g_ui32EventLogTail = 0;
+static volatile uint32_t g_ui32EventLogDropped = 0;
+
+static bool g_bEventLogReady = false;
+static volatile bool g_bEventLogRunning = false;
+static volatile uint32_t g_ui32EventLogSeq = 0;     // next record
+static uint32_t g_ui32EventLogBoot = 0;
+static xSemaphoreHandle g_pEventLogMutex;
+
+static const char * const g_ppcEventLogNames[] =
+{
+    "?", "boot", "sensor fault", "stack overflow", "hard fault"
+};
+
+//*****************************************************************************
+//
+// Builds and checks the stored form of a record.
+//
+//*****************************************************************************
+static uint16_t EventLogCrc(uint32_t ui32Seq, const uint32_t *pui32Words)
+{
+    uint8_t pui8Seq[2];
+
+    pui8Seq[0] = (uint8_t)ui32Seq;
+    pui8Seq[1] = (uint8_t)(ui32Seq >> 8);
+
+    return Crc16Ccitt(Crc16Ccitt(CRC16_CCITT_INIT, pui8Seq, 2),
+                      (const uint8_t *)pui32Words,
+                      (EVENTLOG_RECORD_WORDS - 1) * 4);
+}
+
+static void EventLogEncode(uint32_t *pui32Rec, const tEventLogRecord *psRec)
+{
+    uint32_t ui32Idx;
+
+    pui32Rec[1] = (psRec->ui32Id << 24) | (psRec->ui32Boot & 0xFFFF);
+    pui32Rec[2] = psRec->ui32TimeMs;
+    for(ui32Idx = 0; ui32Idx < EVENTLOG_MAX_ARGS; ui32Idx++)
+    {
+        pui32Rec[3 + ui32Idx] = psRec->pui32Args[ui32Idx];
+    }
+    pui32Rec[0] = ((psRec->ui32Seq & 0xFFFF) << 16) |
+                  EventLogCrc(psRec->ui32Seq & 0xFFFF, pui32Rec + 1);
+}
+
+static bool EventLogDecode(const uint32_t *pui32Rec, tEventLogRecord *psRec)
+{
+    uint32_t ui32Idx;
+
+    psRec->ui32Seq = pui32Rec[0] >> 16;
+    if((pui32Rec[0] & 0xFFFF) != EventLogCrc(psRec->ui32Seq, pui32Rec + 1))
+    {
+        return false;
+    }
+
+    psRec->ui32Id = pui32Rec[1] >> 24;
+    psRec->ui32Boot = pui32Rec[1] & 0xFFFF;
+    psRec->ui32TimeMs = pui32Rec[2];
+    for(ui32Idx = 0; ui32Idx < EVENTLOG_MAX_ARGS; ui32Idx++)
+    {
+        psRec->pui32Args[ui32Idx] = pui32Rec[3 + ui32Idx];
+    }
+
+    return true;
+}
+
+static uint32_t EventLogAddress(uint32_t ui32Seq)
+{
+    return EVENTLOG_EEPROM_BASE +
+           ((ui32Seq % EVENTLOG_SLOTS) * EVENTLOG_RECORD_SIZE);
+}
+
+//*****************************************************************************
+//
+// Finds the newest record. All valid records are within EVENTLOG_SLOTS
+// sequence numbers of each other, so a 16 bit signed difference orders them.
+//
+//*****************************************************************************
+static void EventLogRecover(void)
+{
+    uint32_t pui32Rec[EVENTLOG_RECORD_WORDS];
+    tEventLogRecord sRec;
+    uint32_t ui32Slot;
+    bool bFound = false;
+    uint32_t ui32NewestSeq = 0, ui32NewestBoot = 0;
+
+    for(ui32Slot = 0; ui32Slot < EVENTLOG_SLOTS; ui32Slot++)
+    {
+        HalEEPROMRead(pui32Rec, EVENTLOG_EEPROM_BASE +
+                      (ui32Slot * EVENTLOG_RECORD_SIZE), EVENTLOG_RECORD_SIZE);
+        if(!EventLogDecode(pui32Rec, &sRec) ||
+           ((sRec.ui32Seq % EVENTLOG_SLOTS) != ui32Slot))
+        {
+            continue;
+        }
+
+        if(!bFound || ((int16_t)(sRec.ui32Seq - ui32NewestSeq) > 0))
+        {
+            ui32NewestSeq = sRec.ui32Seq;
+            ui32NewestBoot = sRec.ui32Boot;
+            bFound = true;
+        }
+    }
+
+    g_ui32EventLogSeq = bFound ? ((ui32NewestSeq + 1) & 0xFFFF) : 0;
+    g_ui32EventLogBoot = (ui32NewestBoot + 1) & 0xFFFF;
+}
+
+//*****************************************************************************
+//
+// Queues an event. Safe from tasks and any interrupt handler, never blocks.
+//
+//*****************************************************************************
+void EventLogWrite(uint32_t ui32Id, uint32_t ui32Arg0, uint32_t ui32Arg1,
+                   uint32_t ui32Arg2)
+{
+    tEventLogEntry *psEntry;
+    uint32_t ui32Masked;
+
+    if(!g_bEventLogReady)
+    {
+        return;
+    }
+
+    ui32Masked = HalIntMasterDisable();
+
+    if((g_ui32EventLogHead - g_ui32EventLogTail) >= EVENTLOG_QUEUE_SIZE)
+    {
+        g_ui32EventLogDropped++;
+    }
+    else
+    {
+        psEntry = &g_psEventLogQueue[g_ui32EventLogHead &
+                                     (EVENTLOG_QUEUE_SIZE - 1)];
+        psEntry->ui32Id = ui32Id;
+        psEntry->ui32Time = TimestampGet();
+        psEntry->pui32Args[0] = ui32Arg0;
+        psEntry->pui32Args[1] = ui32Arg1;
+        psEntry->pui32Args[2] = ui32Arg2;
+        g_ui32EventLogHead++;
+    }
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Writes a crash record, blocking. Only for the fault handlers: waits for a
+// write of the EVL task to finish and takes the next slot, the record the
+// task was working on is left torn.
+//
+//*****************************************************************************
+void EventLogCrash(uint32_t ui32Id, uint32_t ui32PC, uint32_t ui32LR,
+                   uint32_t ui32Status, const char *pcTaskName)
+{
+    uint32_t pui32Rec[EVENTLOG_RECORD_WORDS];
+    tEventLogRecord sRec;
+    uint32_t ui32Addr, ui32Idx;
+    char *pcName;
+
+    if(!g_bEventLogReady)
+    {
+        return;
+    }
+
+    memset(&sRec, 0, sizeof(sRec));
+    sRec.ui32Seq = g_ui32EventLogSeq;
+    g_ui32EventLogSeq = (sRec.ui32Seq + 1) & 0xFFFF;
+    sRec.ui32Id = ui32Id;
+    sRec.ui32Boot = g_ui32EventLogBoot;
+    sRec.ui32TimeMs = g_bEventLogRunning ?
+                      (xTaskGetTickCount() * portTICK_PERIOD_MS) : 0;
+    sRec.pui32Args[0] = ui32PC;
+    sRec.pui32Args[1] = ui32LR;
+    sRec.pui32Args[2] = ui32Status;
+    if(pcTaskName != NULL)
+    {
+        // up to 8 characters, not terminated at 8
+        pcName = (char *)&sRec.pui32Args[3];
+        for(ui32Idx = 0; (ui32Idx < 8) && (pcTaskName[ui32Idx] != '\0');
+            ui32Idx++)
+        {
+            pcName[ui32Idx] = pcTaskName[ui32Idx];
+        }
+    }
+    EventLogEncode(pui32Rec, &sRec);
+
+    ui32Addr = EventLogAddress(sRec.ui32Seq);
+    while(HalEEPROMBusy())
+    {
+    }
+    HalEEPROMProgram(pui32Rec + 1, ui32Addr + 4, EVENTLOG_RECORD_SIZE - 4);
+    HalEEPROMProgram(pui32Rec, ui32Addr, 4);
+}
+
+//*****************************************************************************
+//
+// Called by FaultISR with the exception frame of the faulting code: r0-r3,
+// r12, lr, pc, xpsr.
+//
+//*****************************************************************************
+void EventLogHardFault(uint32_t *pui32Frame)
+{
+    EventLogCrash(EVENTLOG_HARD_FAULT, pui32Frame[6], pui32Frame[5],
+                  HalSysFaultStatusGet(),
+                  g_bEventLogRunning ? pcTaskGetName(NULL) : NULL);
+
+    //
+    // Keep the state for the debugger.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+// Called from vApplicationStackOverflowHook(). The hook runs in the context
+// switch after the task was saved, so its pc and lr are in the exception
+// frame on its stack: pxTopOfStack, the first member of the task control
+// block, points at r4-r11 and EXC_RETURN pushed by the RVDS ARM_CM4F port,
+// preceded by s16-s31 if the task used the FPU.
+//
+//*****************************************************************************
+void EventLogStackOverflow(void *pvTask, const char *pcTaskName)
+{
+    uint32_t *pui32Top = *(uint32_t **)pvTask;
+    uint32_t *pui32Frame;
+
+    if(pui32Top[8] & 0x10)
+    {
+        pui32Frame = pui32Top + 9;
+    }
+    else
+    {
+        pui32Frame = pui32Top + 16 + 9;
+    }
+
+    EventLogCrash(EVENTLOG_STACK_OVERFLOW, pui32Frame[6], pui32Frame[5], 0,
+                  pcTaskName);
+}
+
+//*****************************************************************************
+//
+// Programs one record word by word, sleeping while the EEPROM is busy.
+//
+//*****************************************************************************
+static void EventLogProgram(const tEventLogEntry *psEntry)
+{
+    uint32_t pui32Rec[EVENTLOG_RECORD_WORDS];
+    tEventLogRecord sRec;
+    uint32_t ui32Addr, ui32Idx, ui32Age, ui32Now;
+
+    ui32Age = TimestampCyclesToUs(TimestampGet() - psEntry->ui32Time) / 1000;
+    ui32Now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    memset(&sRec, 0, sizeof(sRec));
+    sRec.ui32Id = psEntry->ui32Id;
+    sRec.ui32Boot = g_ui32EventLogBoot;
+    sRec.ui32TimeMs = (ui32Age < ui32Now) ? (ui32Now - ui32Age) : 0;
+    sRec.pui32Args[0] = psEntry->pui32Args[0];
+    sRec.pui32Args[1] = psEntry->pui32Args[1];
+    sRec.pui32Args[2] = psEntry->pui32Args[2];
+
+    xSemaphoreTake(g_pEventLogMutex, portMAX_DELAY);
+
+    sRec.ui32Seq = g_ui32EventLogSeq;
+    g_ui32EventLogSeq = (sRec.ui32Seq + 1) & 0xFFFF;
+    EventLogEncode(pui32Rec, &sRec);
+    ui32Addr = EventLogAddress(sRec.ui32Seq);
+
+    //
+    // Word 0 commits the record, so it goes last.
+    //
+    for(ui32Idx = 1; ui32Idx <= EVENTLOG_RECORD_WORDS; ui32Idx++)
+    {
+        HalEEPROMProgramWord(
+            pui32Rec[ui32Idx % EVENTLOG_RECORD_WORDS],
+            ui32Addr + ((ui32Idx % EVENTLOG_RECORD_WORDS) * 4));
+        while(HalEEPROMBusy())
+        {
+            vTaskDelay(1);
+        }
+    }
+
+    xSemaphoreGive(g_pEventLogMutex);
+}
+
+//*****************************************************************************
+//
+// Prints the records oldest first. The caller must own the UART.
+//
+//*****************************************************************************
+void EventLogDump(void)
+{
+    uint32_t pui32Rec[EVENTLOG_RECORD_WORDS];
+    tEventLogRecord sRec;
+    uint32_t ui32Seq, ui32Count;
+    char pcName[9];
+
+    if(!g_bEventLogReady)
+    {
+        UARTprintf("evlog: no EEPROM\n");
+        return;
+    }
+
+    UARTprintf("evlog: boot %u, %u queued, %u dropped\n", g_ui32EventLogBoot,
+               g_ui32EventLogHead - g_ui32EventLogTail,
+               g_ui32EventLogDropped);
+
+    xSemaphoreTake(g_pEventLogMutex, portMAX_DELAY);
+
+    ui32Seq = g_ui32EventLogSeq;
+    for(ui32Count = 0; ui32Count < EVENTLOG_SLOTS; ui32Count++, ui32Seq++)
+    {
+        HalEEPROMRead(pui32Rec, EventLogAddress(ui32Seq),
+                      EVENTLOG_RECORD_SIZE);
+        if(!EventLogDecode(pui32Rec, &sRec) ||
+           (((ui32Seq - sRec.ui32Seq) % EVENTLOG_SLOTS) != 0))
+        {
+            continue;
+        }
+
+        UARTprintf("%5u boot %u %u.%03u s %s",
+                   sRec.ui32Seq, sRec.ui32Boot, sRec.ui32TimeMs / 1000,
+                   sRec.ui32TimeMs % 1000,
+                   g_ppcEventLogNames[(sRec.ui32Id <= EVENTLOG_HARD_FAULT) ?
+                                      sRec.ui32Id : 0]);
+
+        if((sRec.ui32Id == EVENTLOG_STACK_OVERFLOW) ||
+           (sRec.ui32Id == EVENTLOG_HARD_FAULT))
+        {
+            memcpy(pcName, &sRec.pui32Args[3], 8);
+            pcName[8] = '\0';
+            UARTprintf(": task %s pc %08x lr %08x status %08x\n", pcName,
+                       sRec.pui32Args[0], sRec.pui32Args[1],
+                       sRec.pui32Args[2]);
+        }
+        else
+        {
+            UARTprintf(": %08x %08x %08x\n", sRec.pui32Args[0],
+                       sRec.pui32Args[1], sRec.pui32Args[2]);
+        }
+    }
+
+    xSemaphoreGive(g_pEventLogMutex);
+}
+
+//*****************************************************************************
+//
+// The EEPROM does one operation at a time. Other users take it with these
+// around their accesses, EventLogEEPROMTake() fails if there is no EEPROM.
+// Only for tasks.
+//
+//*****************************************************************************
+bool EventLogEEPROMTake(void)
+{
+    if(!g_bEventLogReady)
+    {
+        return false;
+    }
+
+    xSemaphoreTake(g_pEventLogMutex, portMAX_DELAY);
+
+    return true;
+}
+
+void EventLogEEPROMGive(void)
+{
+    xSemaphoreGive(g_pEventLogMutex);
+}
+
+//*****************************************************************************
+//
+// Invalidates all records. Only the commit words are overwritten, the rest
+// of the EEPROM is left alone.
+//
+//*****************************************************************************
+void EventLogClear(void)
+{
+    uint32_t ui32Slot, ui32Erased = 0xFFFFFFFF;
+
+    if(!g_bEventLogReady)
+    {
+        return;
+    }
+
+    xSemaphoreTake(g_pEventLogMutex, portMAX_DELAY);
+    for(ui32Slot = 0; ui32Slot < EVENTLOG_SLOTS; ui32Slot++)
+    {
+        HalEEPROMProgram(&ui32Erased, EVENTLOG_EEPROM_BASE +
+                         (ui32Slot * EVENTLOG_RECORD_SIZE), 4);
+    }
+    xSemaphoreGive(g_pEventLogMutex);
+}
+
+//*****************************************************************************
+//
+// EVL task: moves the queued events to the EEPROM.
+//
+//*****************************************************************************
+static void EventLogTask(void *pvParameters)
+{
+    g_bEventLogRunning = true;
+
+    while(1)
+    {
+        if(g_ui32EventLogTail == g_ui32EventLogHead)
+        {
+            vTaskDelay(EVENTLOG_POLL_MS);
+            continue;
+        }
+
+        EventLogProgram(&g_psEventLogQueue[g_ui32EventLogTail &
+                                           (EVENTLOG_QUEUE_SIZE - 1)]);
+        g_ui32EventLogTail++;
+
+        vTaskDelay(EVENTLOG_WRITE_MS);
+    }
+}
+
+//*****************************************************************************
+//
+// Mounts the EEPROM, finds the end of the log and records the boot. Call
+// before the other tasks are created so their faults are caught.
+//
+//*****************************************************************************
+uint32_t EventLogTaskInit(void)
+{
+    uint32_t ui32Cause;
+
+    g_pEventLogMutex = xSemaphoreCreateMutex();
+
+    //
+    // Without a working EEPROM the ECU still runs, just without the log.
+    //
+    if(HalEEPROMInit())
+    {
+        EventLogRecover();
+        g_bEventLogReady = true;
+
+        ui32Cause = HalSysResetCauseGet();
+        EventLogWrite(EVENTLOG_BOOT, ui32Cause, 0, 0);
+    }
+
+    if(xTaskCreate(EventLogTask, (const portCHAR *)"EVL",
+                   EVENTLOGTASKSTACKSIZE, NULL,
+                   tskIDLE_PRIORITY + PRIORITY_EVENTLOG_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
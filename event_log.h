@@ -0,0 +1,51 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+//*****************************************************************************
+//
+// Layout in the internal EEPROM (2kB). The event log takes the first
+// EVENTLOG_SLOTS records of EVENTLOG_RECORD_WORDS words, the rest is free
+// for the calibration data.
+//
+//*****************************************************************************
+#define EVENTLOG_EEPROM_BASE            0x000
+#define EVENTLOG_SLOTS                  32      // must divide 65536
+#define EVENTLOG_RECORD_WORDS           8
+#define EVENTLOG_RECORD_SIZE            (EVENTLOG_RECORD_WORDS * 4)
+#define EVENTLOG_EEPROM_SIZE            (EVENTLOG_SLOTS * EVENTLOG_RECORD_SIZE)
+
+#define EVENTLOG_MAX_ARGS               5
+
+//*****************************************************************************
+//
+// Event ids and their arguments.
+//
+//*****************************************************************************
+#define EVENTLOG_BOOT                   1       // reset cause
+#define EVENTLOG_SENSOR_FAULT           2       // faults set, all faults, frame
+#define EVENTLOG_STACK_OVERFLOW         3       // PC, LR, 0, task name
+#define EVENTLOG_HARD_FAULT             4       // PC, LR, CFSR, task name
+
+typedef struct
+{
+    uint32_t ui32Seq;
+    uint32_t ui32Id;
+    uint32_t ui32Boot;                  // power cycle the event happened in
+    uint32_t ui32TimeMs;                // since that boot
+    uint32_t pui32Args[EVENTLOG_MAX_ARGS];
+}
+tEventLogRecord;
+
+void EventLogWrite(uint32_t ui32Id, uint32_t ui32Arg0, uint32_t ui32Arg1,
+                   uint32_t ui32Arg2);
+void EventLogCrash(uint32_t ui32Id, uint32_t ui32PC, uint32_t ui32LR,
+                   uint32_t ui32Status, const char *pcTaskName);
+void EventLogHardFault(uint32_t *pui32Frame);
+void EventLogStackOverflow(void *pvTask, const char *pcTaskName);
+void EventLogDump(void);
+bool EventLogEEPROMTake(void);
+void EventLogEEPROMGive(void);
+void EventLogClear(void);
+uint32_t EventLogTaskInit(void);
+
+#endif
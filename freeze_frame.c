@@ -0,0 +1,233 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Pre-trigger capture of the ADC frames around a sensor fault
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "uart_log.h"
+#include "sensor_bus.h"
+#include "stats.h"
+#include "freeze_frame.h"
+
+/******************************************************************************
+Description: ADC0IntHandler() passes every frame and the current fault bits of
+can_events.c to FreezeFrameRecord() after publishing the frame on the "adc"
+topic. The ring of the topic always holds the most recent
+ADC_FRAME_RING_SIZE frames, the freeze frame keeps no copy. When a fault bit
+sets, the topic goes on for FREEZE_POST_FRAMES more frames, then the freeze
+frame moves it to the spare slots here with SensorBusTopicSwap(): the ring
+stops where it is and is the snapshot. Nothing is copied, the trigger only
+costs the swap. FreezeFrameArm() moves the topic back into the ring and
+recording starts over.
+
+The topic is moved on stats block boundaries only, where ADC0IntHandler()
+has just passed the last block to StatsProcessFrames(), so that a block
+never spans the ring and the spare slots.
+
+All capture state is written by the interrupt only. Requests from tasks are
+counters the task increments and the interrupt acknowledges by catching up,
+so no locking is needed on either side.
+******************************************************************************/
+
+static tADCFrame g_psFreezeSpare[FREEZE_SPARE_FRAMES];
+
+typedef char tFreezeSpareSize[((FREEZE_SPARE_FRAMES % STATS_BLOCK_FRAMES) ==
+                               0) ? 1 : -1];
+
+static volatile uint32_t g_ui32FreezeState = FREEZE_ARMED;
+static uint32_t g_ui32FreezeArmSeq = 0;         // first frame since arming
+static uint32_t g_ui32FreezePost;
+static uint32_t g_ui32FreezeLastFaults = 0;
+static const tADCFrame *g_psFreezeRing;         // the ring while frozen
+static tFreezeSnapshot g_sFreezeSnapshot;
+
+typedef char tFreezeBudget[(sizeof(g_psFreezeSpare) +
+                            sizeof(g_sFreezeSnapshot) <=
+                            RAM_BUDGET_FREEZE) ? 1 : -1];
+
+static volatile uint32_t g_ui32FreezeArmReq = 0;
+static uint32_t g_ui32FreezeArmAck = 0;
+static volatile uint32_t g_ui32FreezeTrigReq = 0;
+static uint32_t g_ui32FreezeTrigAck = 0;
+
+//*****************************************************************************
+//
+// Called from ADC0IntHandler() for every frame. Costs the fault check, the
+// end of the post window and the arming additionally move the topic.
+//
+//*****************************************************************************
+void FreezeFrameRecord(const tADCFrame *psFrame, uint32_t ui32Faults)
+{
+    uint32_t ui32Cause, ui32Frames;
+    bool bBlockEnd;
+
+    bBlockEnd = ((psFrame->ui32Seq + 1) & (STATS_BLOCK_FRAMES - 1)) == 0;
+
+    //
+    // Arming is only pending while a snapshot is held, a request before
+    // that would release the next snapshot right after it is taken.
+    //
+    if(g_ui32FreezeState != FREEZE_FROZEN)
+    {
+        g_ui32FreezeArmAck = g_ui32FreezeArmReq;
+    }
+
+    if(g_ui32FreezeState == FREEZE_ARMED)
+    {
+        ui32Cause = ui32Faults & ~g_ui32FreezeLastFaults;
+        if(g_ui32FreezeTrigReq != g_ui32FreezeTrigAck)
+        {
+            g_ui32FreezeTrigAck = g_ui32FreezeTrigReq;
+            ui32Cause |= FREEZE_CAUSE_MANUAL;
+        }
+
+        if(ui32Cause != 0)
+        {
+            g_sFreezeSnapshot.ui32Cause = ui32Cause;
+            g_sFreezeSnapshot.ui32Faults = ui32Faults;
+            g_sFreezeSnapshot.ui32TriggerSeq = psFrame->ui32Seq;
+            g_sFreezeSnapshot.ui32TriggerTime = psFrame->ui32Time;
+            g_ui32FreezePost = FREEZE_POST_FRAMES;
+            g_ui32FreezeState = FREEZE_TRIGGERED;
+            LOG2(LOG_FREEZE_TRIGGER, ui32Cause, psFrame->ui32Seq);
+        }
+    }
+    else if(g_ui32FreezeState == FREEZE_TRIGGERED)
+    {
+        if(g_ui32FreezePost != 0)
+        {
+            g_ui32FreezePost--;
+        }
+        else if(bBlockEnd)
+        {
+            g_psFreezeRing = SensorBusTopicSwap(&g_sADCTopic, g_psFreezeSpare,
+                                                FREEZE_SPARE_FRAMES);
+
+            ui32Frames = psFrame->ui32Seq + 1 - g_ui32FreezeArmSeq;
+            if(ui32Frames > ADC_FRAME_RING_SIZE)
+            {
+                ui32Frames = ADC_FRAME_RING_SIZE;
+            }
+            g_sFreezeSnapshot.ui32Frames = ui32Frames;
+            g_sFreezeSnapshot.ui32FirstSeq = psFrame->ui32Seq + 1 - ui32Frames;
+            g_ui32FreezeState = FREEZE_FROZEN;
+            LOG1(LOG_FREEZE_DONE, ui32Frames);
+        }
+    }
+    else if((g_ui32FreezeArmReq != g_ui32FreezeArmAck) && bBlockEnd)
+    {
+        SensorBusTopicSwap(&g_sADCTopic, (void *)g_psFreezeRing,
+                           ADC_FRAME_RING_SIZE);
+        g_ui32FreezeArmAck = g_ui32FreezeArmReq;
+        g_ui32FreezeTrigAck = g_ui32FreezeTrigReq;
+        g_ui32FreezeArmSeq = psFrame->ui32Seq + 1;
+        g_ui32FreezeState = FREEZE_ARMED;
+    }
+
+    g_ui32FreezeLastFaults = ui32Faults;
+}
+
+//*****************************************************************************
+//
+// Triggers a capture by hand. Ignored unless armed.
+//
+//*****************************************************************************
+void FreezeFrameTrigger(void)
+{
+    g_ui32FreezeTrigReq++;
+}
+
+//*****************************************************************************
+//
+// Releases the snapshot and starts recording for the next fault. Ignored
+// unless frozen.
+//
+//*****************************************************************************
+void FreezeFrameArm(void)
+{
+    g_ui32FreezeArmReq++;
+}
+
+uint32_t FreezeFrameState(void)
+{
+    return g_ui32FreezeState;
+}
+
+//*****************************************************************************
+//
+// Copies the snapshot header. Returns false if there is no snapshot.
+//
+//*****************************************************************************
+bool FreezeFrameSnapshot(tFreezeSnapshot *psSnapshot)
+{
+    if(g_ui32FreezeState != FREEZE_FROZEN)
+    {
+        return false;
+    }
+
+    *psSnapshot = g_sFreezeSnapshot;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// One frame of the snapshot, in place in the ring. NULL if there is no
+// snapshot or the frame is not in it.
+//
+//*****************************************************************************
+const tADCFrame *FreezeFrameGet(uint32_t ui32Seq)
+{
+    if((g_ui32FreezeState != FREEZE_FROZEN) ||
+       ((ui32Seq - g_sFreezeSnapshot.ui32FirstSeq) >=
+        g_sFreezeSnapshot.ui32Frames))
+    {
+        return NULL;
+    }
+
+    return &g_psFreezeRing[ui32Seq & (ADC_FRAME_RING_SIZE - 1)];
+}
+
+//*****************************************************************************
+//
+// Prints the snapshot as CSV with the time relative to the trigger frame.
+// The caller must own the UART.
+//
+//*****************************************************************************
+void FreezeFrameDump(void)
+{
+    static const char * const ppcStates[] =
+    {
+        "armed", "triggered", "frozen"
+    };
+    tFreezeSnapshot sSnap;
+    const tADCFrame *psFrame;
+    uint32_t ui32Idx, ui32Seq;
+    int32_t i32Us;
+
+    if(!FreezeFrameSnapshot(&sSnap))
+    {
+        UARTprintf("freeze: %s\n", ppcStates[g_ui32FreezeState]);
+        return;
+    }
+
+    UARTprintf("\nFREEZE BEGIN cause %02x faults %02x trigger %u frames %u\n",
+               sSnap.ui32Cause, sSnap.ui32Faults, sSnap.ui32TriggerSeq,
+               sSnap.ui32Frames);
+    UARTprintf("seq,time_us,ch0,ch1,ch2,ch3\n");
+
+    for(ui32Idx = 0; ui32Idx < sSnap.ui32Frames; ui32Idx++)
+    {
+        ui32Seq = sSnap.ui32FirstSeq + ui32Idx;
+        psFrame = FreezeFrameGet(ui32Seq);
+        i32Us = ((int32_t)(ui32Seq - sSnap.ui32TriggerSeq) * 1000000) /
+                ADC_SAMPLE_RATE_HZ;
+        UARTprintf("%u,%d,%u,%u,%u,%u\n", ui32Seq, i32Us,
+                   psFrame->pui16Data[0], psFrame->pui16Data[1],
+                   psFrame->pui16Data[2], psFrame->pui16Data[3]);
+    }
+
+    UARTprintf("FREEZE END\n");
+}
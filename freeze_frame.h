@@ -0,0 +1,50 @@
+#ifndef FREEZE_FRAME_H
+#define FREEZE_FRAME_H
+
+#include "adc_api.h"
+
+//*****************************************************************************
+//
+// Capture window. The snapshot is the ring of the "adc" topic,
+// ADC_FRAME_RING_SIZE frames, of which FREEZE_POST_FRAMES or up to a stats
+// block more are taken after the trigger. With the flight RAM budget that is
+// 14 to 16ms before and 16 to 18ms after a fault at 8kHz. While a snapshot
+// is held the topic runs on FREEZE_SPARE_FRAMES slots of the freeze frame,
+// 8ms.
+//
+//*****************************************************************************
+#define FREEZE_POST_FRAMES              (ADC_FRAME_RING_SIZE / 2)
+#define FREEZE_SPARE_FRAMES             64      // must be power of two
+
+//*****************************************************************************
+//
+// Capture states.
+//
+//*****************************************************************************
+#define FREEZE_ARMED                    0       // recording, waiting for fault
+#define FREEZE_TRIGGERED                1       // recording the post window
+#define FREEZE_FROZEN                   2       // snapshot held, not recording
+
+// cause of a trigger from the console, the other bits are CAN_EVENT_FAULT_xxx
+#define FREEZE_CAUSE_MANUAL             0x80
+
+typedef struct
+{
+    uint32_t ui32Cause;                 // fault bits that set at the trigger
+    uint32_t ui32Faults;                // all fault bits at the trigger
+    uint32_t ui32TriggerSeq;            // frame sequence number
+    uint32_t ui32TriggerTime;           // DWT timestamp of the trigger frame
+    uint32_t ui32FirstSeq;              // oldest frame in the snapshot
+    uint32_t ui32Frames;
+}
+tFreezeSnapshot;
+
+void FreezeFrameRecord(const tADCFrame *psFrame, uint32_t ui32Faults);
+void FreezeFrameTrigger(void);
+void FreezeFrameArm(void);
+uint32_t FreezeFrameState(void);
+bool FreezeFrameSnapshot(tFreezeSnapshot *psSnapshot);
+const tADCFrame *FreezeFrameGet(uint32_t ui32Seq);
+void FreezeFrameDump(void);
+
+#endif
@@ -0,0 +1,206 @@
+//*****************************************************************************
+//
+// hal.h - Hardware abstraction of the peripherals used by the sensor drivers.
+//
+// A thin layer under adc_api.c, i2cDriver.c, delay.c and the tasks, so that
+// the same sources build for the board and for the Linux simulation. The
+// calls map one to one onto the TivaWare driverlib, the backends only know
+// the pins and the peripheral instances:
+//
+//   hal_tm4c.c             TM4C123GH6PM with MAP_ driverlib calls
+//   tools/sim/hal_sim.c    Linux, peripherals simulated on host threads,
+//                          built with HAL_SIM defined
+//
+// Interrupt handlers registered here run in handler mode on the target and
+// on a host thread of the simulation, with the other handlers and the
+// interrupt masking sections of the tasks held off.
+//
+// This header is included from FreeRTOSConfig.h through trace_recorder.h so
+// it must only depend on the C standard and TivaWare headers.
+//
+//*****************************************************************************
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Processor interrupt masking. HalIntMasterDisable() returns true if
+// interrupts were already masked, the caller only unmasks them again if it
+// masked them:
+//
+//     ui32Masked = HalIntMasterDisable();
+//     ...
+//     if(!ui32Masked)
+//     {
+//         HalIntMasterEnable();
+//     }
+//
+// HalBusyWait() goes into every pass of a loop that waits on a variable
+// only an interrupt handler changes. It is empty on the board, the loop
+// stays a plain busy-wait; the simulation waits there for the next
+// interrupt, so that virtual time moves on.
+//
+//*****************************************************************************
+#ifdef HAL_SIM
+uint32_t HalIntMasterDisable(void);
+void HalIntMasterEnable(void);
+void HalBusyWait(void);
+#else
+#include "driverlib/cpu.h"
+#define HalIntMasterDisable()           CPUcpsid()
+#define HalIntMasterEnable()            CPUcpsie()
+#define HalBusyWait()
+#endif
+
+//*****************************************************************************
+//
+// System clock, reset and fault status.
+//
+//*****************************************************************************
+#define HAL_SYS_CLOCK_HZ                80000000
+
+void HalSysClockInit(void);
+uint32_t HalSysClockGet(void);
+uint32_t HalSysResetCauseGet(void);
+uint32_t HalSysFaultStatusGet(void);
+
+//*****************************************************************************
+//
+// ADC0. A sample sequencer converts ui32Steps channels, AINn is channel n,
+// and interrupts after the last step. The pins of the channels are set up
+// by HalADCSequenceInit(). The sequencer holds up to HAL_ADC_MAX_STEPS
+// steps, sequencer 0 has 8, 1 and 2 have 4 and 3 has 1. A conversion that
+// finds the FIFO still full is lost, HalADCOverflow() tells and clears it.
+//
+// A sequencer starts on the processor, on any timer with the ADC trigger
+// enabled or on the PWM trigger. All timer triggers are one and the same
+// trigger of the ADC, so a sequencer that needs a rate of its own uses the
+// PWM trigger: HalADCPWMTriggerInit() starts PWM0 generator 0 at that rate,
+// 153Hz and up, without driving a pin. Sequencer n has priority n when two
+// start at once.
+//
+//*****************************************************************************
+#define HAL_ADC_MAX_STEPS               8
+#define HAL_ADC_NUM_CHANNELS            12
+
+#define HAL_ADC_TRIGGER_PROCESSOR       0
+#define HAL_ADC_TRIGGER_TIMER           1
+#define HAL_ADC_TRIGGER_PWM             2
+
+void HalADCInit(uint32_t ui32Oversample);
+void HalADCSequenceInit(uint32_t ui32Seq, uint32_t ui32Trigger,
+                        const uint8_t *pui8Channels, uint32_t ui32Steps);
+void HalADCIntRegister(uint32_t ui32Seq, void (*pfnHandler)(void));
+void HalADCIntClear(uint32_t ui32Seq);
+bool HalADCIntStatus(uint32_t ui32Seq);
+uint32_t HalADCDataGet(uint32_t ui32Seq, uint32_t *pui32Buffer);
+void HalADCProcessorTrigger(uint32_t ui32Seq);
+bool HalADCOverflow(uint32_t ui32Seq);
+void HalADCPWMTriggerInit(uint32_t ui32Hz);
+
+//*****************************************************************************
+//
+// General purpose timers, 32-bit periodic down counters. Timer n is TIMERn
+// timer A. A timer can trigger the ADC sequencers set to
+// HAL_ADC_TRIGGER_TIMER and interrupt on every timeout. A handler that
+// calls the FreeRTOS FromISR API needs a priority at or below
+// configMAX_SYSCALL_INTERRUPT_PRIORITY, set with HalTimerIntPrioritySet() in
+// the NVIC encoding, 0x00 highest to 0xE0 lowest.
+//
+//*****************************************************************************
+#define HAL_NUM_TIMERS                  6
+
+void HalTimerPeriodicInit(uint32_t ui32Timer, uint32_t ui32Hz);
+void HalTimerADCTriggerEnable(uint32_t ui32Timer);
+void HalTimerIntRegister(uint32_t ui32Timer, void (*pfnHandler)(void));
+void HalTimerIntPrioritySet(uint32_t ui32Timer, uint32_t ui32Priority);
+void HalTimerIntClear(uint32_t ui32Timer);
+void HalTimerEnable(uint32_t ui32Timer);
+void HalTimerDisable(uint32_t ui32Timer);
+
+//*****************************************************************************
+//
+// Edge capture on the wide timers, WTIMERn for input n, without interrupts.
+// The signal of an input goes to both capture pins of its timer: timer A
+// counts the rising edges, timer B takes the time of the last one, both in
+// hardware. HalCaptureRead() returns the two of the same edge, the time in
+// TimestampGet() cycles. Input 0 is on PC4 and PC5, input 1 on PC6 and PC7.
+//
+//*****************************************************************************
+#define HAL_NUM_CAPTURES                2
+
+void HalCaptureInit(uint32_t ui32Input);
+void HalCaptureRead(uint32_t ui32Input, uint32_t *pui32Edges,
+                    uint32_t *pui32Time);
+
+//*****************************************************************************
+//
+// I2C masters. I2C0 is on PB2/PB3, I2C1 on PA6/PA7. A write blocks until the
+// bytes are out and returns HAL_I2C_OK or the error of the transfer. A bus
+// held low by a slave ends the write with HAL_I2C_ERR_TIMEOUT after
+// HAL_I2C_TIMEOUT_US of any one byte.
+//
+//*****************************************************************************
+#define HAL_I2C_OK                      0
+#define HAL_I2C_ERR_ADDR_NACK           1
+#define HAL_I2C_ERR_DATA_NACK           2
+#define HAL_I2C_ERR_ARB_LOST            3
+#define HAL_I2C_ERR_TIMEOUT             4
+
+#define HAL_I2C_TIMEOUT_US              1000
+
+void HalI2CMasterInit(uint32_t ui32Port, bool bFast);
+uint32_t HalI2CMasterWrite(uint32_t ui32Port, uint8_t ui8Addr,
+                           const uint8_t *pui8Data, uint32_t ui32Count);
+
+//*****************************************************************************
+//
+// UARTs. UART0 on PA0/PA1 is the console, HalUARTInit() of port 0 also
+// attaches it to UARTprintf() of utils/uartstdio. HalUARTBaudSet() waits
+// until the transmitter is idle before it changes the rate.
+//
+//*****************************************************************************
+void HalUARTInit(uint32_t ui32Port, uint32_t ui32Baud);
+void HalUARTBaudSet(uint32_t ui32Port, uint32_t ui32Baud);
+void HalUARTWrite(uint32_t ui32Port, const uint8_t *pui8Data,
+                  uint32_t ui32Count);
+int32_t HalUARTCharGetNonBlocking(uint32_t ui32Port);
+
+//*****************************************************************************
+//
+// GPIO ports A to F, pins as a bit mask.
+//
+//*****************************************************************************
+#define HAL_GPIO_PORTA                  0
+#define HAL_GPIO_PORTB                  1
+#define HAL_GPIO_PORTC                  2
+#define HAL_GPIO_PORTD                  3
+#define HAL_GPIO_PORTE                  4
+#define HAL_GPIO_PORTF                  5
+#define HAL_GPIO_NUM_PORTS              6
+
+void HalGPIOOutputInit(uint32_t ui32Port, uint8_t ui8Pins);
+void HalGPIOInputInit(uint32_t ui32Port, uint8_t ui8Pins);
+void HalGPIOWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Value);
+uint8_t HalGPIORead(uint32_t ui32Port, uint8_t ui8Pins);
+
+//*****************************************************************************
+//
+// Internal EEPROM, 2kB of 32-bit words. Addresses and lengths are in bytes
+// and multiples of 4. HalEEPROMProgram() returns 0 on success.
+//
+//*****************************************************************************
+#define HAL_EEPROM_SIZE                 2048
+
+bool HalEEPROMInit(void);
+void HalEEPROMRead(uint32_t *pui32Data, uint32_t ui32Addr, uint32_t ui32Count);
+uint32_t HalEEPROMProgram(uint32_t *pui32Data, uint32_t ui32Addr,
+                          uint32_t ui32Count);
+void HalEEPROMProgramWord(uint32_t ui32Data, uint32_t ui32Addr);
+bool HalEEPROMBusy(void);
+
+#endif
@@ -0,0 +1,599 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Hardware abstraction layer, TM4C123GH6PM backend
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+#include "driverlib/adc.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/pwm.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "timestamp.h"
+
+/******************************************************************************
+Description: maps the calls of hal.h onto the driverlib. The tables below hold
+the peripheral instances and pins of the front sensor unit board, a call only
+looks up its instance and makes the same driverlib calls the drivers made
+before they went through the HAL.
+******************************************************************************/
+
+typedef struct
+{
+    uint32_t ui32Periph;
+    uint32_t ui32Base;
+}
+tHalPort;
+
+static const tHalPort g_psHalGPIOPorts[HAL_GPIO_NUM_PORTS] =
+{
+    { SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE },
+    { SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE },
+    { SYSCTL_PERIPH_GPIOC, GPIO_PORTC_BASE },
+    { SYSCTL_PERIPH_GPIOD, GPIO_PORTD_BASE },
+    { SYSCTL_PERIPH_GPIOE, GPIO_PORTE_BASE },
+    { SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE },
+};
+
+// ADC trigger of HAL_ADC_TRIGGER_n, the PWM one is PWM0 generator 0
+static const uint32_t g_pui32HalADCTriggers[] =
+{
+    ADC_TRIGGER_PROCESSOR, ADC_TRIGGER_TIMER,
+    ADC_TRIGGER_PWM0 | ADC_TRIGGER_PWM_MOD0,
+};
+
+// pin of AINn, as GPIO port and pin mask
+static const uint8_t g_ppui8HalADCPins[HAL_ADC_NUM_CHANNELS][2] =
+{
+    { HAL_GPIO_PORTE, GPIO_PIN_3 },
+    { HAL_GPIO_PORTE, GPIO_PIN_2 },
+    { HAL_GPIO_PORTE, GPIO_PIN_1 },
+    { HAL_GPIO_PORTE, GPIO_PIN_0 },
+    { HAL_GPIO_PORTD, GPIO_PIN_3 },
+    { HAL_GPIO_PORTD, GPIO_PIN_2 },
+    { HAL_GPIO_PORTD, GPIO_PIN_1 },
+    { HAL_GPIO_PORTD, GPIO_PIN_0 },
+    { HAL_GPIO_PORTE, GPIO_PIN_5 },
+    { HAL_GPIO_PORTE, GPIO_PIN_4 },
+    { HAL_GPIO_PORTB, GPIO_PIN_4 },
+    { HAL_GPIO_PORTB, GPIO_PIN_5 },
+};
+
+static const tHalPort g_psHalTimers[HAL_NUM_TIMERS] =
+{
+    { SYSCTL_PERIPH_TIMER0, TIMER0_BASE },
+    { SYSCTL_PERIPH_TIMER1, TIMER1_BASE },
+    { SYSCTL_PERIPH_TIMER2, TIMER2_BASE },
+    { SYSCTL_PERIPH_TIMER3, TIMER3_BASE },
+    { SYSCTL_PERIPH_TIMER4, TIMER4_BASE },
+    { SYSCTL_PERIPH_TIMER5, TIMER5_BASE },
+};
+
+// the timer A interrupts of the timers above
+static const uint32_t g_pui32HalTimerInts[HAL_NUM_TIMERS] =
+{
+    INT_TIMER0A, INT_TIMER1A, INT_TIMER2A, INT_TIMER3A, INT_TIMER4A,
+    INT_TIMER5A,
+};
+
+typedef struct
+{
+    uint32_t ui32Periph;
+    uint32_t ui32Base;
+    uint32_t ui32Port;
+    uint32_t ui32SCLConfig;
+    uint32_t ui32SDAConfig;
+    uint8_t ui8SCLPin;
+    uint8_t ui8SDAPin;
+}
+tHalI2C;
+
+static const tHalI2C g_psHalI2C[] =
+{
+    { SYSCTL_PERIPH_I2C0, I2C0_BASE, HAL_GPIO_PORTB, GPIO_PB2_I2C0SCL,
+      GPIO_PB3_I2C0SDA, GPIO_PIN_2, GPIO_PIN_3 },
+    { SYSCTL_PERIPH_I2C1, I2C1_BASE, HAL_GPIO_PORTA, GPIO_PA6_I2C1SCL,
+      GPIO_PA7_I2C1SDA, GPIO_PIN_6, GPIO_PIN_7 },
+};
+
+#define HAL_NUM_I2C     (sizeof(g_psHalI2C) / sizeof(g_psHalI2C[0]))
+
+// the wide timers of the capture inputs, both capture pins on one port
+typedef struct
+{
+    uint32_t ui32Periph;
+    uint32_t ui32Base;
+    uint32_t ui32Port;
+    uint32_t ui32CountConfig;
+    uint32_t ui32TimeConfig;
+    uint8_t ui8Pins;
+}
+tHalCapture;
+
+static const tHalCapture g_psHalCaptures[HAL_NUM_CAPTURES] =
+{
+    { SYSCTL_PERIPH_WTIMER0, WTIMER0_BASE, HAL_GPIO_PORTC, GPIO_PC4_WT0CCP0,
+      GPIO_PC5_WT0CCP1, GPIO_PIN_4 | GPIO_PIN_5 },
+    { SYSCTL_PERIPH_WTIMER1, WTIMER1_BASE, HAL_GPIO_PORTC, GPIO_PC6_WT1CCP0,
+      GPIO_PC7_WT1CCP1, GPIO_PIN_6 | GPIO_PIN_7 },
+};
+
+//*****************************************************************************
+//
+// System clock, reset cause and fault status.
+//
+//*****************************************************************************
+void HalSysClockInit(void)
+{
+    // 400MHz PLL / 2 / 2.5 from the 16MHz crystal
+    MAP_SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN |
+                       SYSCTL_XTAL_16MHZ);
+}
+
+uint32_t HalSysClockGet(void)
+{
+    return MAP_SysCtlClockGet();
+}
+
+uint32_t HalSysResetCauseGet(void)
+{
+    uint32_t ui32Cause = MAP_SysCtlResetCauseGet();
+
+    MAP_SysCtlResetCauseClear(ui32Cause);
+
+    return ui32Cause;
+}
+
+uint32_t HalSysFaultStatusGet(void)
+{
+    return HWREG(NVIC_FAULT_STAT);
+}
+
+//*****************************************************************************
+//
+// ADC0.
+//
+//*****************************************************************************
+void HalADCInit(uint32_t ui32Oversample)
+{
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+
+    // Average ui32Oversample conversions per step, throughput is reduced by
+    // the same factor
+    MAP_ADCHardwareOversampleConfigure(ADC0_BASE, ui32Oversample);
+
+    // Set reference voltage to internal
+    MAP_ADCReferenceSet(ADC0_BASE, ADC_REF_INT);
+}
+
+void HalADCSequenceInit(uint32_t ui32Seq, uint32_t ui32Trigger,
+                        const uint8_t *pui8Channels, uint32_t ui32Steps)
+{
+    const tHalPort *psPort;
+    uint32_t ui32Step, ui32Ch, ui32Config;
+
+    MAP_ADCSequenceDisable(ADC0_BASE, ui32Seq);
+    MAP_ADCSequenceConfigure(ADC0_BASE, ui32Seq,
+                             g_pui32HalADCTriggers[ui32Trigger], ui32Seq);
+
+    for(ui32Step = 0; ui32Step < ui32Steps; ui32Step++)
+    {
+        // Select the analog function of the pin
+        ui32Ch = pui8Channels[ui32Step];
+        psPort = &g_psHalGPIOPorts[g_ppui8HalADCPins[ui32Ch][0]];
+        MAP_SysCtlPeripheralEnable(psPort->ui32Periph);
+        MAP_GPIOPinTypeADC(psPort->ui32Base, g_ppui8HalADCPins[ui32Ch][1]);
+
+        // The last step interrupts and ends the sequence
+        ui32Config = ui32Ch;
+        if(ui32Step == (ui32Steps - 1))
+        {
+            ui32Config |= ADC_CTL_IE | ADC_CTL_END;
+        }
+        MAP_ADCSequenceStepConfigure(ADC0_BASE, ui32Seq, ui32Step, ui32Config);
+    }
+
+    MAP_ADCSequenceEnable(ADC0_BASE, ui32Seq);
+
+    // Make sure the interrupt flag is cleared before we sample
+    MAP_ADCIntClear(ADC0_BASE, ui32Seq);
+}
+
+void HalADCIntRegister(uint32_t ui32Seq, void (*pfnHandler)(void))
+{
+    ADCIntRegister(ADC0_BASE, ui32Seq, pfnHandler);
+    MAP_ADCIntEnable(ADC0_BASE, ui32Seq);
+}
+
+void HalADCIntClear(uint32_t ui32Seq)
+{
+    MAP_ADCIntClear(ADC0_BASE, ui32Seq);
+}
+
+bool HalADCIntStatus(uint32_t ui32Seq)
+{
+    return MAP_ADCIntStatus(ADC0_BASE, ui32Seq, false) != 0;
+}
+
+uint32_t HalADCDataGet(uint32_t ui32Seq, uint32_t *pui32Buffer)
+{
+    return MAP_ADCSequenceDataGet(ADC0_BASE, ui32Seq, pui32Buffer);
+}
+
+void HalADCProcessorTrigger(uint32_t ui32Seq)
+{
+    MAP_ADCProcessorTrigger(ADC0_BASE, ui32Seq);
+}
+
+bool HalADCOverflow(uint32_t ui32Seq)
+{
+    if(MAP_ADCSequenceOverflow(ADC0_BASE, ui32Seq) == 0)
+    {
+        return false;
+    }
+
+    MAP_ADCSequenceOverflowClear(ADC0_BASE, ui32Seq);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// PWM0 generator 0 counts down from its load at the system clock / 8 and
+// triggers the ADC every time it reloads. The generator drives no pin.
+//
+//*****************************************************************************
+void HalADCPWMTriggerInit(uint32_t ui32Hz)
+{
+    MAP_SysCtlPWMClockSet(SYSCTL_PWMDIV_8);
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_PWM0);
+
+    MAP_PWMGenConfigure(PWM0_BASE, PWM_GEN_0,
+                        PWM_GEN_MODE_DOWN | PWM_GEN_MODE_NO_SYNC);
+    MAP_PWMGenPeriodSet(PWM0_BASE, PWM_GEN_0,
+                        (MAP_SysCtlClockGet() / 8) / ui32Hz);
+    MAP_PWMGenIntTrigEnable(PWM0_BASE, PWM_GEN_0, PWM_TR_CNT_LOAD);
+    MAP_PWMGenEnable(PWM0_BASE, PWM_GEN_0);
+}
+
+//*****************************************************************************
+//
+// Timers.
+//
+//*****************************************************************************
+void HalTimerPeriodicInit(uint32_t ui32Timer, uint32_t ui32Hz)
+{
+    const tHalPort *psTimer = &g_psHalTimers[ui32Timer];
+
+    MAP_SysCtlPeripheralEnable(psTimer->ui32Periph);
+    MAP_TimerDisable(psTimer->ui32Base, TIMER_A);
+    MAP_TimerConfigure(psTimer->ui32Base, TIMER_CFG_PERIODIC);
+    MAP_TimerLoadSet(psTimer->ui32Base, TIMER_A,
+                     (MAP_SysCtlClockGet() / ui32Hz) - 1);
+}
+
+void HalTimerADCTriggerEnable(uint32_t ui32Timer)
+{
+    MAP_TimerControlTrigger(g_psHalTimers[ui32Timer].ui32Base, TIMER_A, true);
+}
+
+void HalTimerIntRegister(uint32_t ui32Timer, void (*pfnHandler)(void))
+{
+    uint32_t ui32Base = g_psHalTimers[ui32Timer].ui32Base;
+
+    TimerIntRegister(ui32Base, TIMER_A, pfnHandler);
+    MAP_TimerIntClear(ui32Base, TIMER_TIMA_TIMEOUT);
+    MAP_TimerIntEnable(ui32Base, TIMER_TIMA_TIMEOUT);
+}
+
+void HalTimerIntPrioritySet(uint32_t ui32Timer, uint32_t ui32Priority)
+{
+    MAP_IntPrioritySet(g_pui32HalTimerInts[ui32Timer], ui32Priority);
+}
+
+void HalTimerIntClear(uint32_t ui32Timer)
+{
+    MAP_TimerIntClear(g_psHalTimers[ui32Timer].ui32Base, TIMER_TIMA_TIMEOUT);
+}
+
+void HalTimerEnable(uint32_t ui32Timer)
+{
+    MAP_TimerEnable(g_psHalTimers[ui32Timer].ui32Base, TIMER_A);
+}
+
+void HalTimerDisable(uint32_t ui32Timer)
+{
+    MAP_TimerDisable(g_psHalTimers[ui32Timer].ui32Base, TIMER_A);
+}
+
+//*****************************************************************************
+//
+// Edge capture.
+//
+//*****************************************************************************
+void HalCaptureInit(uint32_t ui32Input)
+{
+    const tHalCapture *psCapture = &g_psHalCaptures[ui32Input];
+    const tHalPort *psPins = &g_psHalGPIOPorts[psCapture->ui32Port];
+
+    MAP_SysCtlPeripheralEnable(psCapture->ui32Periph);
+    MAP_SysCtlPeripheralEnable(psPins->ui32Periph);
+
+    MAP_GPIOPinConfigure(psCapture->ui32CountConfig);
+    MAP_GPIOPinConfigure(psCapture->ui32TimeConfig);
+    MAP_GPIOPinTypeTimer(psPins->ui32Base, psCapture->ui8Pins);
+
+    //
+    // The 32-bit halves count up from 0 and wrap, so differences of counts
+    // and of times are right across the wrap. Timer A counts edges up to its
+    // match, which takes months of driving, timer B counts system clocks and
+    // captures its count at every edge.
+    //
+    MAP_TimerDisable(psCapture->ui32Base, TIMER_BOTH);
+    MAP_TimerConfigure(psCapture->ui32Base, TIMER_CFG_SPLIT_PAIR |
+                       TIMER_CFG_A_CAP_COUNT_UP | TIMER_CFG_B_CAP_TIME_UP);
+    MAP_TimerControlEvent(psCapture->ui32Base, TIMER_BOTH,
+                          TIMER_EVENT_POS_EDGE);
+    MAP_TimerLoadSet(psCapture->ui32Base, TIMER_A, 0xFFFFFFFF);
+    MAP_TimerMatchSet(psCapture->ui32Base, TIMER_A, 0xFFFFFFFF);
+    MAP_TimerLoadSet(psCapture->ui32Base, TIMER_B, 0xFFFFFFFF);
+    MAP_TimerEnable(psCapture->ui32Base, TIMER_BOTH);
+}
+
+void HalCaptureRead(uint32_t ui32Input, uint32_t *pui32Edges,
+                    uint32_t *pui32Time)
+{
+    uint32_t ui32Base = g_psHalCaptures[ui32Input].ui32Base;
+    uint32_t ui32Edge, ui32Count, ui32Now, ui32Stamp;
+
+    //
+    // An edge between the reads changes the captured time, read again until
+    // count and time belong to the same edge. The timer runs on the system
+    // clock like the DWT counter, the age of the edge on the timer turns its
+    // time into a timestamp.
+    //
+    do
+    {
+        ui32Edge = HWREG(ui32Base + TIMER_O_TBR);
+        ui32Count = HWREG(ui32Base + TIMER_O_TAR);
+        ui32Now = HWREG(ui32Base + TIMER_O_TBV);
+        ui32Stamp = TimestampGet();
+    }
+    while(HWREG(ui32Base + TIMER_O_TBR) != ui32Edge);
+
+    *pui32Edges = ui32Count;
+    *pui32Time = ui32Stamp - (ui32Now - ui32Edge);
+}
+
+//*****************************************************************************
+//
+// I2C masters.
+//
+//*****************************************************************************
+void HalI2CMasterInit(uint32_t ui32Port, bool bFast)
+{
+    const tHalI2C *psI2C = &g_psHalI2C[ui32Port];
+    const tHalPort *psPins = &g_psHalGPIOPorts[psI2C->ui32Port];
+
+    MAP_SysCtlPeripheralEnable(psI2C->ui32Periph);
+    MAP_SysCtlPeripheralEnable(psPins->ui32Periph);
+
+    // SCL push-pull, SDA open-drain with weak pull-ups
+    MAP_GPIOPinConfigure(psI2C->ui32SCLConfig);
+    MAP_GPIOPinConfigure(psI2C->ui32SDAConfig);
+    MAP_GPIOPinTypeI2CSCL(psPins->ui32Base, psI2C->ui8SCLPin);
+    MAP_GPIOPinTypeI2C(psPins->ui32Base, psI2C->ui8SDAPin);
+
+    // 100kbps, or 400kbps if bFast
+    MAP_I2CMasterInitExpClk(psI2C->ui32Base, MAP_SysCtlClockGet(), bFast);
+}
+
+//*****************************************************************************
+//
+// Waits for the end of a transfer step and returns its error.
+//
+//*****************************************************************************
+static uint32_t HalI2CWait(uint32_t ui32Base)
+{
+    uint32_t ui32Start = TimestampGet();
+    uint32_t ui32Err;
+
+    //
+    // A slave holding SCL or SDA low keeps the master busy for good, give up
+    // and leave the bus to the next transfer.
+    //
+    while(MAP_I2CMasterBusy(ui32Base))
+    {
+        if((TimestampGet() - ui32Start) >
+           TimestampUsToCycles(HAL_I2C_TIMEOUT_US))
+        {
+            return HAL_I2C_ERR_TIMEOUT;
+        }
+    }
+
+    ui32Err = MAP_I2CMasterErr(ui32Base);
+    if(ui32Err & I2C_MASTER_ERR_ARB_LOST)
+    {
+        return HAL_I2C_ERR_ARB_LOST;
+    }
+    else if(ui32Err & I2C_MASTER_ERR_ADDR_ACK)
+    {
+        return HAL_I2C_ERR_ADDR_NACK;
+    }
+    else if(ui32Err & I2C_MASTER_ERR_DATA_ACK)
+    {
+        return HAL_I2C_ERR_DATA_NACK;
+    }
+
+    return HAL_I2C_OK;
+}
+
+uint32_t HalI2CMasterWrite(uint32_t ui32Port, uint8_t ui8Addr,
+                           const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    uint32_t ui32Base = g_psHalI2C[ui32Port].ui32Base;
+    uint32_t ui32Idx, ui32Err;
+
+    MAP_I2CMasterSlaveAddrSet(ui32Base, ui8Addr, false);
+
+    if(ui32Count == 1)
+    {
+        MAP_I2CMasterDataPut(ui32Base, pui8Data[0]);
+        MAP_I2CMasterControl(ui32Base, I2C_MASTER_CMD_SINGLE_SEND);
+        return HalI2CWait(ui32Base);
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        MAP_I2CMasterDataPut(ui32Base, pui8Data[ui32Idx]);
+        MAP_I2CMasterControl(ui32Base,
+                             (ui32Idx == 0) ? I2C_MASTER_CMD_BURST_SEND_START :
+                             (ui32Idx == (ui32Count - 1)) ?
+                             I2C_MASTER_CMD_BURST_SEND_FINISH :
+                             I2C_MASTER_CMD_BURST_SEND_CONT);
+        ui32Err = HalI2CWait(ui32Base);
+        if(ui32Err != HAL_I2C_OK)
+        {
+            if(ui32Err != HAL_I2C_ERR_ARB_LOST)
+            {
+                MAP_I2CMasterControl(ui32Base,
+                                     I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+            }
+            return ui32Err;
+        }
+    }
+
+    return HAL_I2C_OK;
+}
+
+//*****************************************************************************
+//
+// UART0, the console. It runs from the internal 16MHz oscillator up to the
+// console rate, faster rates use the system clock so that the baud divisor
+// stays accurate.
+//
+//*****************************************************************************
+#define HAL_UART_PIOSC_HZ               16000000
+#define HAL_UART_PIOSC_MAX_BAUD         115200
+
+void HalUARTInit(uint32_t ui32Port, uint32_t ui32Baud)
+{
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+
+    MAP_GPIOPinConfigure(GPIO_PA0_U0RX);
+    MAP_GPIOPinConfigure(GPIO_PA1_U0TX);
+    MAP_GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+
+    HalUARTBaudSet(ui32Port, ui32Baud);
+}
+
+void HalUARTBaudSet(uint32_t ui32Port, uint32_t ui32Baud)
+{
+    while(MAP_UARTBusy(UART0_BASE))
+    {
+    }
+
+    if(ui32Baud > HAL_UART_PIOSC_MAX_BAUD)
+    {
+        MAP_UARTClockSourceSet(UART0_BASE, UART_CLOCK_SYSTEM);
+        UARTStdioConfig(ui32Port, ui32Baud, MAP_SysCtlClockGet());
+    }
+    else
+    {
+        MAP_UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC);
+        UARTStdioConfig(ui32Port, ui32Baud, HAL_UART_PIOSC_HZ);
+    }
+}
+
+void HalUARTWrite(uint32_t ui32Port, const uint8_t *pui8Data,
+                  uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        MAP_UARTCharPut(UART0_BASE, *pui8Data++);
+    }
+}
+
+int32_t HalUARTCharGetNonBlocking(uint32_t ui32Port)
+{
+    return MAP_UARTCharGetNonBlocking(UART0_BASE);
+}
+
+//*****************************************************************************
+//
+// GPIO.
+//
+//*****************************************************************************
+void HalGPIOOutputInit(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    MAP_SysCtlPeripheralEnable(g_psHalGPIOPorts[ui32Port].ui32Periph);
+    MAP_GPIOPinTypeGPIOOutput(g_psHalGPIOPorts[ui32Port].ui32Base, ui8Pins);
+}
+
+void HalGPIOInputInit(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    MAP_SysCtlPeripheralEnable(g_psHalGPIOPorts[ui32Port].ui32Periph);
+    MAP_GPIOPinTypeGPIOInput(g_psHalGPIOPorts[ui32Port].ui32Base, ui8Pins);
+}
+
+void HalGPIOWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Value)
+{
+    MAP_GPIOPinWrite(g_psHalGPIOPorts[ui32Port].ui32Base, ui8Pins, ui8Value);
+}
+
+uint8_t HalGPIORead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return (uint8_t)MAP_GPIOPinRead(g_psHalGPIOPorts[ui32Port].ui32Base,
+                                    ui8Pins);
+}
+
+//*****************************************************************************
+//
+// EEPROM.
+//
+//*****************************************************************************
+bool HalEEPROMInit(void)
+{
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while(!MAP_SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0))
+    {
+    }
+
+    return MAP_EEPROMInit() == EEPROM_INIT_OK;
+}
+
+void HalEEPROMRead(uint32_t *pui32Data, uint32_t ui32Addr, uint32_t ui32Count)
+{
+    MAP_EEPROMRead(pui32Data, ui32Addr, ui32Count);
+}
+
+uint32_t HalEEPROMProgram(uint32_t *pui32Data, uint32_t ui32Addr,
+                          uint32_t ui32Count)
+{
+    return MAP_EEPROMProgram(pui32Data, ui32Addr, ui32Count);
+}
+
+void HalEEPROMProgramWord(uint32_t ui32Data, uint32_t ui32Addr)
+{
+    MAP_EEPROMProgramNonBlocking(ui32Data, ui32Addr);
+}
+
+bool HalEEPROMBusy(void)
+{
+    return (MAP_EEPROMStatusGet() & EEPROM_RC_WORKING) != 0;
+}
@@ -24,18 +24,22 @@ SOFTWARE.
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "driverlib/debug.h"
-#include "driverlib/fpu.h"
-#include "driverlib/gpio.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/rom.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/uart.h"
-#include "driverlib/i2c.h"
-#include "utils/uartstdio.h"
-#include "driverlib/rom_map.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "hal.h"
+#include "i2cDriver.h"
+
+// the LCD backpack is on I2C1, pins PA6 (SCL) and PA7 (SDA)
+#define I2C_DRIVER_PORT			1
+
+// after a failed write the bus is left alone this long. A hung bus costs
+// HAL_I2C_TIMEOUT_US per write, the LCD task would spend all its time in
+// timeouts and starve the lower priority tasks.
+#define I2C_DRIVER_BACKOFF_MS	100
+
+static volatile uint32_t g_ui32I2CDriverErrors = 0;
+static bool g_bI2CDriverBackoff = false;
+static TickType_t g_xI2CDriverRetry;
 
 /**************************************************************************
 * @brief  This function Initializes the I2C1 driver in TM4C123GXL using
@@ -46,43 +50,11 @@ void i2cDriverInit(void)
 {	
 
 		//
-    // The I2C1 peripheral must be enabled before use.
-    //
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_I2C1);
-
+    // Enable and initialize the I2C1 master module and its pins. If bFast is
+    // false the data rate is set to 100kbps and if true the data rate will be
+    // set to 400kbps. We will use a data rate of 100kbps.
     //
-    // For this example I2C0 is used with PortB[3:2].  The actual port and
-    // pins used may be different on your part, consult the data sheet for
-    // more information.  GPIO port A needs to be enabled so these pins can
-    // be used.
-    // TODO: change this to whichever GPIO port you are using.
-    //
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-
-    //
-    // Configure the pin muxing for I2C1 functions on port A6 and A7.
-    // This step is not necessary if your part does not support pin muxing.
-    // TODO: change this to select the port/pin you are using.
-    //
-    MAP_GPIOPinConfigure(GPIO_PA6_I2C1SCL);
-    MAP_GPIOPinConfigure(GPIO_PA7_I2C1SDA);
-		
-		//
-    // Select the I2C function for these pins.  This function will also
-    // configure the GPIO pins pins for I2C operation, setting them to
-    // open-drain operation with weak pull-ups.  Consult the data sheet
-    // to see which functions are allocated per pin.
-    // TODO: change this to select the port/pin you are using.
-    //
-    MAP_GPIOPinTypeI2CSCL(GPIO_PORTA_BASE, GPIO_PIN_6);
-    MAP_GPIOPinTypeI2C(GPIO_PORTA_BASE, GPIO_PIN_7);
-		//
-    // Enable and initialize the I2C1 master module.  Use the system clock for
-    // the I2C1 module.  The last parameter sets the I2C data transfer rate.
-    // If false the data rate is set to 100kbps and if true the data rate will
-    // be set to 400kbps.  For this example we will use a data rate of 100kbps.
-    //
-    MAP_I2CMasterInitExpClk(I2C1_BASE, SysCtlClockGet(), false);
+    HalI2CMasterInit(I2C_DRIVER_PORT, false);
 		
 }
 
@@ -91,13 +63,35 @@ void i2cDriverInit(void)
 *	@param	\address is the address of the device to send data to
 * @param  \data is the data to be sent
 * @return none
+* @note   writes after an error are dropped for I2C_DRIVER_BACKOFF_MS,
+*         then the next write tries the bus again
 ***************************************************************************/
 void i2cDriverWrite(uint8_t address, uint8_t data)
 {
+		TickType_t xNow = xTaskGetTickCount();
 
-		MAP_I2CMasterSlaveAddrSet(I2C1_BASE, address, false);
-		MAP_I2CMasterDataPut(I2C1_BASE, data);
-		MAP_I2CMasterControl(I2C1_BASE, I2C_MASTER_CMD_SINGLE_SEND);
-		while(MAP_I2CMasterBusy(I2C1_BASE));	
+		if(g_bI2CDriverBackoff && ((int32_t)(xNow - g_xI2CDriverRetry) < 0))
+		{
+			return;
+		}
 
+		if(HalI2CMasterWrite(I2C_DRIVER_PORT, address, &data, 1) != HAL_I2C_OK)
+		{
+			g_ui32I2CDriverErrors++;
+			g_bI2CDriverBackoff = true;
+			g_xI2CDriverRetry = xNow + pdMS_TO_TICKS(I2C_DRIVER_BACKOFF_MS);
+		}
+		else
+		{
+			g_bI2CDriverBackoff = false;
+		}
+}
+
+/**************************************************************************
+* @brief  Failed writes since power on, no acknowledge or a hung bus
+* @return the number of failed writes
+***************************************************************************/
+uint32_t i2cDriverErrors(void)
+{
+		return g_ui32I2CDriverErrors;
 }
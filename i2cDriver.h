@@ -27,5 +27,6 @@ SOFTWARE.
 
 void i2cDriverInit(void);
 void i2cDriverWrite( uint8_t address, uint8_t data );
+uint32_t i2cDriverErrors(void);
 
 #endif
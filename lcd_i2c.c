@@ -26,14 +26,6 @@ SOFTWARE.
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "driverlib/debug.h"
-#include "driverlib/gpio.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/rom.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/i2c.h"
 #include "lcd_i2c.h"
 #include "delay.h"
 #include "i2cDriver.h"
@@ -195,7 +187,7 @@ void lcdI2cSetCursor(uint8_t col, uint8_t row){
 void lcdI2cPrint(char * str)
 {
 	char * str_tmp = str;
-	while(*str_tmp != NULL)
+	while(*str_tmp != '\0')
 	{
 		write(*str_tmp);
 		str_tmp++;
@@ -1,38 +1,21 @@
 #include <stdbool.h>
 #include <stdint.h>
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "driverlib/gpio.h"
-#include "driverlib/rom.h"
 #include "utils/uartstdio.h"
 #include "priorities.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include "semphr.h"
 #include "lcd_i2c.h"
 #include "throttle_sensor.h"
+#include "ADC_task.h"
 
-//*****************************************************************************
-//
-// The stack size for the LED toggle task.
-//
-//*****************************************************************************
-#define LCDTASKSTACKSIZE				128				 // Stack size in words
-
-//*****************************************************************************
-//
-// The item size and queue size for the LED message queue.
-//
-//*****************************************************************************
-#define LCD_ITEM_SIZE					 sizeof(uint32_t)*1 // change to four sensors reading in the future
-#define LCD_QUEUE_SIZE					1
-
-
-extern xQueueHandle g_pADCQueue;
+extern xSemaphoreHandle g_pLCDSemaphore;
 
+static bool g_bLCDTaskEnabled;
+static bool g_bLCDTaskStarted;
 
-extern xSemaphoreHandle g_pLCDSemaphore;
+// the throttle request on the display, kept while there is no new one
+static uint32_t g_ui32LCDReading;
 
 void itoascii(uint32_t val, char * str)
 {
@@ -52,34 +35,46 @@ void itoascii(uint32_t val, char * str)
 
 //*****************************************************************************
 //
-// This task toggles the user selected LED at a user selected frequency. User
-// can make the selections by pressing the left and right buttons.
+// Shows the latest throttle request. Runs in the 100ms rate group, the first
+// run brings up the display, which takes about 70ms of its delays.
 //
 //*****************************************************************************
-static void LCDTask(void *pvParameters)
+void LCDTaskRun(void)
 {
-	
-	lcdI2cInit(0x3f,16,2,0);
-	int32_t adcReading;
-	char buffer[5];
-	
-	while(1)
+	const tThrottleRequest *psRequest;
+	uint32_t ui32Seq, ui32Request;
+	char buffer[6];
+
+	if(!g_bLCDTaskEnabled)
+	{
+		return;
+	}
+
+	if(!g_bLCDTaskStarted)
+	{
+		lcdI2cInit(0x3f,16,2,0);
+		g_bLCDTaskStarted = true;
+	}
+
+	psRequest = SensorBusLatest(&g_sThrottleTopic, &ui32Seq);
+	if(psRequest)
+	{
+		ui32Request = psRequest->ui32Request;
+		if(SensorBusValid(&g_sThrottleTopic, ui32Seq))
 		{
-			
-			 xQueueReceive( g_pADCQueue, &( adcReading ), ( TickType_t ) 10 );
-			 itoascii(adcReading,buffer);
-			 xSemaphoreTake(g_pLCDSemaphore, portMAX_DELAY);
-			 lcdI2cPrint(buffer);
-			 xSemaphoreGive(g_pLCDSemaphore);
-			 lcdI2cHome();
-			 vTaskDelay(100);
-			
+			g_ui32LCDReading = ui32Request;
 		}
+	}
+	itoascii(g_ui32LCDReading,buffer);
+	xSemaphoreTake(g_pLCDSemaphore, portMAX_DELAY);
+	lcdI2cPrint(buffer);
+	xSemaphoreGive(g_pLCDSemaphore);
+	lcdI2cHome();
 }
 
 //*****************************************************************************
 //
-// Initializes the LCD task.
+// Enables the LCD, the 100ms rate group runs LCDTaskRun().
 //
 //*****************************************************************************
 uint32_t LCDTaskInit(void)
@@ -89,14 +84,7 @@ uint32_t LCDTaskInit(void)
 		//
 		UARTprintf("\nLCD task running!!");
 
-		//
-		// Create the LED task.
-		//
-		if(xTaskCreate(LCDTask, (const portCHAR *)"LCD", LCDTASKSTACKSIZE, NULL,
-									 tskIDLE_PRIORITY + PRIORITY_LCD_TASK, NULL) != pdTRUE)
-		{
-				return(1);
-		}
+		g_bLCDTaskEnabled = true;
 
 		//
 		// Success.
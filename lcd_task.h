@@ -8,5 +8,7 @@
 //
 //*****************************************************************************
 extern uint32_t LCDTaskInit(void);
+extern void LCDTaskRun(void);
+extern void itoascii(uint32_t val, char * str);
 
 #endif // __LED_TASK_H__
@@ -0,0 +1,20 @@
+//*****************************************************************************
+//
+// log_ids.h - Messages of the deferred UART logger.
+//
+// LOG_MSG(id, format) - the position of a message in this list is the id
+// that goes on the wire, so only append new messages at the end. The list is
+// also read by tools/log_decode.py to rebuild the text of binary captures.
+// Formats take up to four 32-bit arguments and support %u %d %x %c.
+//
+//*****************************************************************************
+LOG_MSG(LOG_BOOT,               "FSAE sensors ECU boot\n")
+LOG_MSG(LOG_DROPPED,            "log: %u records dropped\n")
+LOG_MSG(LOG_DEADLINE_MISS,      "deadline miss: period %u us response %u us\n")
+LOG_MSG(LOG_SDLOG_START,        "sdlog: session %u in slot %u\n")
+LOG_MSG(LOG_SDLOG_STOP,         "sdlog: session %u closed, %u frames %u blocks\n")
+LOG_MSG(LOG_SDLOG_CARD_ERROR,   "sdlog: no card or card error\n")
+LOG_MSG(LOG_FREEZE_TRIGGER,     "freeze: cause %x at frame %u\n")
+LOG_MSG(LOG_FREEZE_DONE,        "freeze: snapshot of %u frames ready\n")
+LOG_MSG(LOG_CALIB_LOADED,       "calib: generation %u from bank %u\n")
+LOG_MSG(LOG_CALIB_DEFAULTS,     "calib: no stored set, using defaults\n")
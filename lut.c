@@ -0,0 +1,146 @@
+//*****************************************************************************
+//
+// lut.c - Piecewise linear lookup tables with a uniform index.
+//
+// Plain C without target dependencies, also built into the host tools.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "lut.h"
+
+//*****************************************************************************
+//
+// Throttle response maps, kept in flash. Generated at the 65 table inputs
+// from the curve given with each map, rounded to 0.1 %.
+//
+//*****************************************************************************
+const tLutTable g_psLutThrottleMaps[LUT_NUM_MAPS - 1] =
+{
+    // linear, request equals pedal
+    {{
+        0, 16, 31, 47, 62, 78, 94, 109, 125, 141, 156, 172,
+        188, 203, 219, 234, 250, 266, 281, 297, 312, 328, 344, 359,
+        375, 391, 406, 422, 438, 453, 469, 484, 500, 516, 531, 547,
+        562, 578, 594, 609, 625, 641, 656, 672, 688, 703, 719, 734,
+        750, 766, 781, 797, 812, 828, 844, 859, 875, 891, 906, 922,
+        938, 953, 969, 984, 1000
+    }},
+    // progressive, 0.3x + 0.7x^2, fine control at low pedal
+    {{
+        0, 5, 10, 16, 21, 28, 34, 41, 48, 56, 64, 72,
+        81, 90, 99, 109, 119, 129, 140, 151, 162, 174, 186, 198,
+        211, 224, 237, 251, 265, 280, 294, 310, 325, 341, 357, 373,
+        390, 407, 425, 443, 461, 479, 498, 518, 537, 557, 577, 598,
+        619, 640, 662, 684, 706, 728, 751, 775, 798, 822, 847, 871,
+        896, 922, 948, 974, 1000
+    }},
+    // sport, 1 - (1 - x)^2, early response
+    {{
+        0, 31, 62, 92, 121, 150, 179, 207, 234, 261, 288, 314,
+        340, 365, 390, 414, 438, 461, 483, 506, 527, 549, 569, 590,
+        609, 629, 647, 666, 684, 701, 718, 734, 750, 765, 780, 795,
+        809, 822, 835, 847, 859, 871, 882, 892, 902, 912, 921, 929,
+        938, 945, 952, 959, 965, 970, 976, 980, 984, 988, 991, 994,
+        996, 998, 999, 1000, 1000
+    }},
+    // rain, 60% of the pedal
+    {{
+        0, 9, 19, 28, 38, 47, 56, 66, 75, 84, 94, 103,
+        112, 122, 131, 141, 150, 159, 169, 178, 188, 197, 206, 216,
+        225, 234, 244, 253, 262, 272, 281, 291, 300, 309, 319, 328,
+        337, 347, 356, 366, 375, 384, 394, 403, 412, 422, 431, 441,
+        450, 459, 469, 478, 488, 497, 506, 516, 525, 534, 544, 553,
+        562, 572, 581, 591, 600
+    }}
+};
+
+const char * const g_ppcLutThrottleMapNames[LUT_NUM_MAPS] =
+{
+    "none", "linear", "progressive", "sport", "rain"
+};
+
+//*****************************************************************************
+//
+// Stores a value in the table, saturated to 16 bits.
+//
+//*****************************************************************************
+static int16_t LutSaturate(int64_t i64Value)
+{
+    if(i64Value > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if(i64Value < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t)i64Value;
+}
+
+//*****************************************************************************
+//
+// Builds a table from breakpoints with ascending raw values. Between two
+// breakpoints the value is interpolated, beyond the first and the last it
+// is held. Breakpoints that fall between two table inputs are rounded onto
+// the grid, a knee is smoothed over one segment of 2^LUT_SHIFT counts.
+//
+//*****************************************************************************
+void LutBuild(tLutTable *psTable, const int32_t *pi32Raw,
+              const int32_t *pi32Value, uint32_t ui32Points)
+{
+    int64_t i64Num, i64Den;
+    int32_t i32In;
+    uint32_t ui32Idx, ui32Point = 1;
+
+    for(ui32Idx = 0; ui32Idx <= LUT_SEGMENTS; ui32Idx++)
+    {
+        i32In = (int32_t)(ui32Idx << LUT_SHIFT);
+
+        if(i32In <= pi32Raw[0])
+        {
+            psTable->pi16Value[ui32Idx] = LutSaturate(pi32Value[0]);
+            continue;
+        }
+        if(i32In >= pi32Raw[ui32Points - 1])
+        {
+            psTable->pi16Value[ui32Idx] =
+                LutSaturate(pi32Value[ui32Points - 1]);
+            continue;
+        }
+
+        //
+        // The inputs ascend, so the segment only ever moves forward.
+        //
+        while(i32In > pi32Raw[ui32Point])
+        {
+            ui32Point++;
+        }
+
+        i64Num = (int64_t)(i32In - pi32Raw[ui32Point - 1]) *
+                 (pi32Value[ui32Point] - pi32Value[ui32Point - 1]);
+        i64Den = pi32Raw[ui32Point] - pi32Raw[ui32Point - 1];
+        i64Num += (i64Num < 0) ? -(i64Den / 2) : (i64Den / 2);
+        psTable->pi16Value[ui32Idx] =
+            LutSaturate(pi32Value[ui32Point - 1] + (i64Num / i64Den));
+    }
+}
+
+//*****************************************************************************
+//
+// Builds a table of (raw - offset) * gain, with the gain in Q16.
+//
+//*****************************************************************************
+void LutBuildLinear(tLutTable *psTable, int32_t i32Offset, int32_t i32Gain)
+{
+    uint32_t ui32Idx;
+    int64_t i64Value;
+
+    for(ui32Idx = 0; ui32Idx <= LUT_SEGMENTS; ui32Idx++)
+    {
+        i64Value = (int64_t)((int32_t)(ui32Idx << LUT_SHIFT) - i32Offset) *
+                   i32Gain;
+        psTable->pi16Value[ui32Idx] = LutSaturate((i64Value + 0x8000) >> 16);
+    }
+}
@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+// lut.h - Piecewise linear lookup tables with a uniform index.
+//
+// Shared by the firmware and the host tools, so it must only depend on
+// stdint.h. A table holds LUT_SEGMENTS + 1 values at evenly spaced inputs
+// 0, 2^LUT_SHIFT, 2 * 2^LUT_SHIFT, ... 4096 of a 12-bit domain. A lookup is
+// a shift, a mask and one multiply: the segment is found from the upper
+// bits of the input and the lower bits interpolate in it, there is no search
+// and no division. Tables are built once from breakpoints or from an offset
+// and gain, outside the sample path.
+//
+//*****************************************************************************
+
+#ifndef LUT_H
+#define LUT_H
+
+#include <stdint.h>
+
+#define LUT_INPUT_BITS                  12
+#define LUT_INPUT_FULL                  (1 << LUT_INPUT_BITS)
+#define LUT_SHIFT                       6
+#define LUT_SEGMENTS                    (1 << (LUT_INPUT_BITS - LUT_SHIFT))
+
+typedef struct
+{
+    int16_t pi16Value[LUT_SEGMENTS + 1];
+}
+tLutTable;
+
+//*****************************************************************************
+//
+// Throttle response maps, from the pedal position to the requested torque.
+// Both are in 0.1 % of full travel and full torque. LUT_MAP_NONE passes the
+// pedal position through unchanged, for an uncalibrated throttle channel.
+//
+//*****************************************************************************
+#define LUT_MAP_NONE                    0
+#define LUT_MAP_LINEAR                  1
+#define LUT_MAP_PROGRESSIVE             2
+#define LUT_MAP_SPORT                   3
+#define LUT_MAP_RAIN                    4
+#define LUT_NUM_MAPS                    5
+
+#define LUT_PEDAL_FULL                  1000
+
+extern const tLutTable g_psLutThrottleMaps[LUT_NUM_MAPS - 1];
+extern const char * const g_ppcLutThrottleMapNames[LUT_NUM_MAPS];
+
+//*****************************************************************************
+//
+// Looks up an input of the 12-bit domain, inputs outside it get the value
+// at the nearest end.
+//
+//*****************************************************************************
+static inline int32_t LutApply(const tLutTable *psTable, int32_t i32In)
+{
+    int32_t i32Index, i32Frac, i32Y0;
+
+    if(i32In <= 0)
+    {
+        return psTable->pi16Value[0];
+    }
+    else if(i32In >= LUT_INPUT_FULL)
+    {
+        return psTable->pi16Value[LUT_SEGMENTS];
+    }
+
+    i32Index = i32In >> LUT_SHIFT;
+    i32Frac = i32In & ((1 << LUT_SHIFT) - 1);
+    i32Y0 = psTable->pi16Value[i32Index];
+
+    return i32Y0 + (((psTable->pi16Value[i32Index + 1] - i32Y0) * i32Frac) >>
+                    LUT_SHIFT);
+}
+
+//*****************************************************************************
+//
+// Applies a throttle map to a pedal position in 0.1 %. The position is
+// rescaled to the 12-bit domain with a multiply and shift, 268436 / 2^16 is
+// 4096 / 1000 rounded up so that full travel reaches the last table value.
+//
+//*****************************************************************************
+static inline int32_t LutThrottleMap(uint32_t ui32Map, int32_t i32Pedal)
+{
+    if((ui32Map == LUT_MAP_NONE) || (ui32Map >= LUT_NUM_MAPS))
+    {
+        return i32Pedal;
+    }
+    if(i32Pedal < 0)
+    {
+        i32Pedal = 0;
+    }
+    else if(i32Pedal > LUT_PEDAL_FULL)
+    {
+        i32Pedal = LUT_PEDAL_FULL;
+    }
+
+    return LutApply(&g_psLutThrottleMaps[ui32Map - 1],
+                    (i32Pedal * 268436) >> 16);
+}
+
+void LutBuild(tLutTable *psTable, const int32_t *pi32Raw,
+              const int32_t *pi32Value, uint32_t ui32Points);
+void LutBuildLinear(tLutTable *psTable, int32_t i32Offset, int32_t i32Gain);
+
+#endif
@@ -1,20 +1,27 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "driverlib/gpio.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/rom.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/uart.h"
 #include "utils/uartstdio.h"
+#include "hal.h"
 #include "lcd_task.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
 #include "semphr.h"
+#include "adc_api.h"
 #include "ADC_task.h"
+#include "timestamp.h"
+#include "deadline_monitor.h"
+#include "trace_recorder.h"
+#include "console_task.h"
+#include "uart_log.h"
+#include "telemetry.h"
+#include "can_driver.h"
+#include "sdlog_task.h"
+#include "event_log.h"
+#include "calib.h"
+#include "rate_group.h"
+#include "wheel_speed.h"
 
 
 //*****************************************************************************
@@ -46,6 +53,11 @@ __error__(char *pcFilename, uint32_t ui32Line)
 void
 vApplicationStackOverflowHook(xTaskHandle *pxTask, char *pcTaskName)
 {
+    //
+    // Leave a crash record for the next boot.
+    //
+    EventLogStackOverflow(pxTask, pcTaskName);
+
     //
     // This function can not return, so loop forever.  Interrupts are disabled
     // on entry to this function, so no processor interrupts will interrupt
@@ -65,31 +77,10 @@ void
 ConfigureUART(void)
 {
     //
-    // Enable the GPIO Peripheral used by the UART.
-    //
-    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-
-    //
-    // Enable UART0
-    //
-    ROM_SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-
-    //
-    // Configure GPIO Pins for UART mode.
-    //
-    ROM_GPIOPinConfigure(GPIO_PA0_U0RX);
-    ROM_GPIOPinConfigure(GPIO_PA1_U0TX);
-    ROM_GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-
-    //
-    // Use the internal 16MHz oscillator as the UART clock source.
+    // UART0 on PA0/PA1, clocked from the internal 16MHz oscillator, for
+    // console I/O.
     //
-    UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC);
-
-    //
-    // Initialize the UART for console I/O.
-    //
-    UARTStdioConfig(0, 115200, 16000000);
+    HalUARTInit(0, 115200);
 }
 
 //*****************************************************************************
@@ -101,18 +92,38 @@ int
 main(void)
 {
 		// set clock to 80MHz
-		SysCtlClockSet(SYSCTL_SYSDIV_2_5|SYSCTL_USE_PLL|SYSCTL_OSC_MAIN|SYSCTL_XTAL_16MHZ);
+		HalSysClockInit();
 
     ConfigureUART();
 
+    TimestampInit();
+
     UARTprintf("\n\nTest ADC on FreeRTOS\n");
 
     g_pUARTSemaphore = xSemaphoreCreateMutex();
 		g_pLCDSemaphore = xSemaphoreCreateMutex();
 		g_pADCSemaphore = xSemaphoreCreateMutex();
+		TraceRecorderSetQueueName(g_pUARTSemaphore, "UART");
+		TraceRecorderSetQueueName(g_pLCDSemaphore, "LCD");
+		TraceRecorderSetQueueName(g_pADCSemaphore, "ADC");
+
+    //
+    // Open the EEPROM event log first so it records faults of all tasks.
+    //
+    if(EventLogTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Load the sensor calibration before anything samples.
+    //
+    CalibInit();
 	
     //
-    // Create the LED task.
+    // Enable the LCD, shown by the 100ms rate group.
     //
     if(LCDTaskInit() != 0)
     {
@@ -122,7 +133,7 @@ main(void)
     }
 		
     //
-    // Create the ADC task.
+    // Set up the throttle request, run by the 5ms rate group.
     //
     if(ADCTaskInit() != 0)
     {
@@ -131,6 +142,94 @@ main(void)
 				}
     }
 
+    //
+    // Start the wheel speed inputs, read by the 5ms rate group.
+    //
+    if(WheelSpeedInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Sample the dampers at their own rate and the slow channels from the
+    // 100ms rate group, on the ADC set up for the throttle.
+    //
+    if(ADCExtendedInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Create the rate group tasks and start their release timer.
+    //
+    if(RateGroupInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Start the periodic CAN messages, they send the newest ADC frame.
+    //
+    CANDriverInit();
+
+    //
+    // Create the deadline monitor report task.
+    //
+    if(DeadlineMonitorTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Create the deferred logger task.
+    //
+    if(UARTLogTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    LOG0(LOG_BOOT);
+
+    //
+    // Create the telemetry task.
+    //
+    if(TelemetryTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Create the SD card logger tasks.
+    //
+    if(SDLogTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
+    //
+    // Create the UART console task.
+    //
+    if(ConsoleTaskInit() != 0)
+    {
+        while(1)
+        {
+        }
+    }
+
     vTaskStartScheduler();
 
     while(1)
@@ -32,8 +32,16 @@
 //*****************************************************************************
 
 // higher number indicate higher priority
-#define PRIORITY_ADC_TASK       1
-#define PRIORITY_LCD_TASK       2
+#define PRIORITY_RATE_GROUP_1MS   6   // rate monotonic, see rate_group.c
+#define PRIORITY_RATE_GROUP_5MS   5
+#define PRIORITY_RATE_GROUP_100MS 2
+#define PRIORITY_MONITOR_TASK   0
+#define PRIORITY_CONSOLE_TASK   0
+#define PRIORITY_LOG_TASK       0
+#define PRIORITY_TELEMETRY_TASK 3
+#define PRIORITY_SDLOG_TASK     3
+#define PRIORITY_SDWRITE_TASK   1
+#define PRIORITY_EVENTLOG_TASK  0
 
 
 #endif // __PRIORITIES_H__
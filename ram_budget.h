@@ -0,0 +1,55 @@
+#ifndef RAM_BUDGET_H
+#define RAM_BUDGET_H
+
+//*****************************************************************************
+//
+// The budget of the 32KB of SRAM of the TM4C123GH6PM, in bytes. Every large
+// buffer is sized to its line here and checked against it where it is
+// defined, and the lines must add up to the SRAM, so a buffer that grows
+// past its line or a line that grows past the SRAM fails the build instead
+// of the link of the board image.
+//
+// The heap holds the task stacks, 1768 words today, the task control blocks,
+// the semaphores and the task list of "trace dump", about 9.4KB. The ADC
+// frames are the live ring of the "adc" topic and the history of the freeze
+// frame, 256 frames or 32ms at 8kHz. Everything not listed, the topics,
+// statistics, rate groups, diagnostics, CAN tables, fits into OTHER.
+//
+// bench.c is not part of the flight build. A bench build, ECU_BENCH
+// defined and bench.c added to the project, takes the RAM of its buffers
+// from the ADC frames.
+//
+//*****************************************************************************
+#define RAM_BUDGET_SRAM                 32768
+
+#define RAM_BUDGET_MAIN_STACK           512     // Stack of startup_rvmdk.S
+#define RAM_BUDGET_HEAP                 10240   // configTOTAL_HEAP_SIZE
+#define RAM_BUDGET_UDMA                 1024    // control table, udma_api.c
+#if defined(ECU_BENCH)
+#define RAM_BUDGET_ADC_FRAMES           2048    // adc_api.c
+#define RAM_BUDGET_BENCH                2048    // bench.c
+#else
+#define RAM_BUDGET_ADC_FRAMES           4096
+#define RAM_BUDGET_BENCH                0
+#endif
+#define RAM_BUDGET_ADC_EXTENDED         1024    // adc_api.c, other sequencers
+#define RAM_BUDGET_FREEZE               1152    // freeze_frame.c
+#define RAM_BUDGET_LOG                  1536    // uart_log.c
+#define RAM_BUDGET_TRACE                1024    // trace_recorder.c
+#define RAM_BUDGET_SDLOG                3840    // sdlog.c
+#define RAM_BUDGET_CALIB                1792    // calib.c
+#define RAM_BUDGET_TELEMETRY            1280    // telemetry.c
+#define RAM_BUDGET_OTHER                3584
+
+#define RAM_BUDGET_TOTAL                                                      \
+    (RAM_BUDGET_MAIN_STACK + RAM_BUDGET_HEAP + RAM_BUDGET_UDMA +              \
+     RAM_BUDGET_ADC_FRAMES + RAM_BUDGET_BENCH + RAM_BUDGET_ADC_EXTENDED +     \
+     RAM_BUDGET_FREEZE + RAM_BUDGET_LOG + RAM_BUDGET_TRACE +                  \
+     RAM_BUDGET_SDLOG + RAM_BUDGET_CALIB + RAM_BUDGET_TELEMETRY +             \
+     RAM_BUDGET_OTHER)
+
+#if RAM_BUDGET_TOTAL > RAM_BUDGET_SRAM
+#error "the RAM budget does not fit the SRAM"
+#endif
+
+#endif
@@ -0,0 +1,327 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Rate groups: periodic runnables released by one hardware timer
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timestamp.h"
+#include "deadline_monitor.h"
+#include "trace_recorder.h"
+#include "rate_group.h"
+#include "rate_group_table.h"
+
+/******************************************************************************
+Description: timer 3 interrupts every millisecond and counts down the period
+of every group that has runnables. A group that is due gets its release
+semaphore, unless it has not finished its previous release, which is then
+an overrun. The group task takes the semaphore, runs its runnables one
+after the other and times each of them against its budget. The deadline
+monitor of the group measures release to start and start to finish of the
+whole group, so "deadline" shows the groups instead of the tasks they
+replaced. The interrupt gives the monitor the time of every release it
+makes, a dropped release does not shift the ones after it.
+
+The priorities are rate monotonic, 1ms highest. The 5ms group, the throttle
+request, is above the telemetry and SD logger tasks, the 100ms group is
+below them. With periods that divide each other and a common release, a
+group meets its deadline as long as the interrupts, its own runnables and
+every faster group, released as often as it fits into the period, take no
+longer than the period. The checks below do that sum with the budgets of
+the table and fail the build when a group does not fit into
+RATE_GROUP_LOAD_LIMIT_PCT of its period.
+******************************************************************************/
+
+#define RATE_GROUP_TIMER                3
+#define RATE_GROUP_INT_PRIORITY         0xA0    // may give semaphores
+#define RATEGROUPTASKSTACKSIZE          128     // Stack size in words
+
+//*****************************************************************************
+//
+// The CPU time the interrupt handlers take from the tasks, in us per ms: the
+// ADC handler at 8kHz, the CAN tick and controller and this timer. An upper
+// bound with headroom, "adc" shows the share of the ADC handler.
+//
+//*****************************************************************************
+#define RATE_GROUP_ISR_US_PER_MS        150
+
+// share of every period the groups may take, the rest is for the others
+#define RATE_GROUP_LOAD_LIMIT_PCT       80
+
+//*****************************************************************************
+//
+// The table and the sums over it, all compile time constants.
+//
+//*****************************************************************************
+#define RATE_GROUP_ENTRY(arg, name, fn, group, budget)                        \
+    { name, fn, group, budget },
+#define RATE_GROUP_COUNT(arg, name, fn, group, budget)  + 1
+#define RATE_GROUP_BUDGET_OF(arg, name, fn, group, budget)                    \
+    + (((group) == (arg)) ? (budget) : 0)
+
+#define RATE_GROUP_NUM_RUNNABLES        (0 RATE_GROUP_TABLE(RATE_GROUP_COUNT, 0))
+#define RATE_GROUP_BUDGET_US(group)                                           \
+    (0 RATE_GROUP_TABLE(RATE_GROUP_BUDGET_OF, group))
+
+// time group i takes within the period of group g, if it is as fast or faster
+#define RATE_GROUP_DEMAND_OF_US(g, i)                                         \
+    (((i) <= (g)) ? (RATE_GROUP_BUDGET_US(i) *                                \
+                     (RATE_GROUP_PERIOD_MS(g) / RATE_GROUP_PERIOD_MS(i))) : 0)
+
+#define RATE_GROUP_DEMAND_US(g)                                               \
+    ((RATE_GROUP_ISR_US_PER_MS * RATE_GROUP_PERIOD_MS(g)) +                   \
+     RATE_GROUP_DEMAND_OF_US(g, RATE_GROUP_1MS) +                             \
+     RATE_GROUP_DEMAND_OF_US(g, RATE_GROUP_5MS) +                             \
+     RATE_GROUP_DEMAND_OF_US(g, RATE_GROUP_100MS))
+
+#define RATE_GROUP_FITS(g)                                                    \
+    ((RATE_GROUP_DEMAND_US(g) * 100) <=                                       \
+     (RATE_GROUP_PERIOD_MS(g) * 1000 * RATE_GROUP_LOAD_LIMIT_PCT))
+
+// fail to compile if the periods are not harmonic or a group does not fit
+typedef char tRateGroupHarmonicCheck[
+    ((RATE_GROUP_PERIOD_MS(RATE_GROUP_5MS) %
+      RATE_GROUP_PERIOD_MS(RATE_GROUP_1MS)) == 0) &&
+    ((RATE_GROUP_PERIOD_MS(RATE_GROUP_100MS) %
+      RATE_GROUP_PERIOD_MS(RATE_GROUP_5MS)) == 0) ? 1 : -1];
+typedef char tRateGroup1msCheck[RATE_GROUP_FITS(RATE_GROUP_1MS) ? 1 : -1];
+typedef char tRateGroup5msCheck[RATE_GROUP_FITS(RATE_GROUP_5MS) ? 1 : -1];
+typedef char tRateGroup100msCheck[RATE_GROUP_FITS(RATE_GROUP_100MS) ? 1 : -1];
+
+const tRateGroupRunnable g_psRateGroupRunnables[] =
+{
+    RATE_GROUP_TABLE(RATE_GROUP_ENTRY, 0)
+};
+
+const uint32_t g_ui32RateGroupNumRunnables = RATE_GROUP_NUM_RUNNABLES;
+
+const char * const g_ppcRateGroupNames[RATE_GROUP_NUM] =
+{
+    "1ms", "5ms", "100ms"
+};
+
+static const uint32_t g_pui32RateGroupPriorities[RATE_GROUP_NUM] =
+{
+    PRIORITY_RATE_GROUP_1MS, PRIORITY_RATE_GROUP_5MS, PRIORITY_RATE_GROUP_100MS
+};
+
+typedef struct
+{
+    xSemaphoreHandle pxRelease;
+    uint32_t ui32Countdown;             // timer ticks to the next release
+    volatile bool bBusy;
+    tRateGroupStats sStats;
+    tDeadlineMonitor sMonitor;
+}
+tRateGroup;
+
+static tRateGroup g_psRateGroups[RATE_GROUP_NUM];
+static tRateGroupRunnableStats g_psRateGroupRunnableStats[RATE_GROUP_NUM_RUNNABLES];
+
+//*****************************************************************************
+//
+// Timer 3A interrupt: releases the groups that are due.
+//
+//*****************************************************************************
+static void RateGroupIntHandler(void)
+{
+    BaseType_t xWoken = pdFALSE;
+    tRateGroup *psGroup;
+    uint32_t ui32Group, ui32Now = TimestampGet();
+
+    TRACE_ISR_ENTER(TRACE_ISR_TIMER3A);
+
+    HalTimerIntClear(RATE_GROUP_TIMER);
+
+    for(ui32Group = 0; ui32Group < RATE_GROUP_NUM; ui32Group++)
+    {
+        psGroup = &g_psRateGroups[ui32Group];
+        if(!psGroup->pxRelease || (--psGroup->ui32Countdown != 0))
+        {
+            continue;
+        }
+
+        psGroup->ui32Countdown = RATE_GROUP_PERIOD_MS(ui32Group);
+        if(psGroup->bBusy)
+        {
+            psGroup->sStats.ui32Overruns++;
+            continue;
+        }
+
+        psGroup->bBusy = true;
+        psGroup->sStats.ui32Releases++;
+        DeadlineMonitorRelease(&psGroup->sMonitor, ui32Now);
+        xSemaphoreGiveFromISR(psGroup->pxRelease, &xWoken);
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_TIMER3A);
+
+    portYIELD_FROM_ISR(xWoken);
+}
+
+//*****************************************************************************
+//
+// The task of a group: runs its runnables at every release.
+//
+//*****************************************************************************
+static void RateGroupTask(void *pvParameters)
+{
+    uint32_t ui32Group = (uint32_t)(uintptr_t)pvParameters;
+    tRateGroup *psGroup = &g_psRateGroups[ui32Group];
+    const tRateGroupRunnable *psRunnable;
+    tRateGroupRunnableStats *psStats;
+    uint32_t ui32Idx, ui32Start, ui32Cycles;
+
+    while(1)
+    {
+        xSemaphoreTake(psGroup->pxRelease, portMAX_DELAY);
+        DeadlineMonitorStart(&psGroup->sMonitor);
+
+        for(ui32Idx = 0; ui32Idx < RATE_GROUP_NUM_RUNNABLES; ui32Idx++)
+        {
+            psRunnable = &g_psRateGroupRunnables[ui32Idx];
+            if(psRunnable->ui32Group != ui32Group)
+            {
+                continue;
+            }
+
+            ui32Start = TimestampGet();
+            psRunnable->pfnRun();
+            ui32Cycles = TimestampGet() - ui32Start;
+
+            //
+            // Preemption by faster groups and interrupts counts as well,
+            // the budget is for the response within the group.
+            //
+            psStats = &g_psRateGroupRunnableStats[ui32Idx];
+            if(psStats->ui32Runs++ &&
+               (ui32Cycles > TimestampUsToCycles(psRunnable->ui32BudgetUs)))
+            {
+                psStats->ui32OverBudget++;
+            }
+            if(ui32Cycles > psStats->ui32MaxCycles)
+            {
+                psStats->ui32MaxCycles = ui32Cycles;
+            }
+        }
+
+        DeadlineMonitorFinish(&psGroup->sMonitor);
+        psGroup->bBusy = false;
+    }
+}
+
+//*****************************************************************************
+//
+// Creates the tasks of the groups that have runnables and starts the release
+// timer. Returns 0, or 1 if a task could not be created.
+//
+//*****************************************************************************
+uint32_t RateGroupInit(void)
+{
+    tRateGroup *psGroup;
+    uint32_t ui32Group, ui32PeriodUs;
+
+    for(ui32Group = 0; ui32Group < RATE_GROUP_NUM; ui32Group++)
+    {
+        if(RATE_GROUP_BUDGET_US(ui32Group) == 0)
+        {
+            continue;
+        }
+
+        psGroup = &g_psRateGroups[ui32Group];
+        psGroup->ui32Countdown = RATE_GROUP_PERIOD_MS(ui32Group);
+        psGroup->pxRelease = xSemaphoreCreateBinary();
+        TraceRecorderSetQueueName(psGroup->pxRelease,
+                                  g_ppcRateGroupNames[ui32Group]);
+
+        //
+        // The deadline is the next release, histograms in 1/16 of it.
+        //
+        ui32PeriodUs = RATE_GROUP_PERIOD_MS(ui32Group) * 1000;
+        DeadlineMonitorRegister(&psGroup->sMonitor,
+                                g_ppcRateGroupNames[ui32Group], ui32PeriodUs,
+                                ui32PeriodUs, ui32PeriodUs / 16);
+
+        if(!psGroup->pxRelease ||
+           (xTaskCreate(RateGroupTask,
+                        (const portCHAR *)g_ppcRateGroupNames[ui32Group],
+                        RATEGROUPTASKSTACKSIZE, (void *)(uintptr_t)ui32Group,
+                        tskIDLE_PRIORITY +
+                        g_pui32RateGroupPriorities[ui32Group],
+                        NULL) != pdTRUE))
+        {
+            return(1);
+        }
+    }
+
+    HalTimerPeriodicInit(RATE_GROUP_TIMER, RATE_GROUP_TICK_HZ);
+    HalTimerIntRegister(RATE_GROUP_TIMER, RateGroupIntHandler);
+    HalTimerIntPrioritySet(RATE_GROUP_TIMER, RATE_GROUP_INT_PRIORITY);
+    HalTimerEnable(RATE_GROUP_TIMER);
+
+    return(0);
+}
+
+void RateGroupStatsGet(uint32_t ui32Group, tRateGroupStats *psStats)
+{
+    taskENTER_CRITICAL();
+    *psStats = g_psRateGroups[ui32Group].sStats;
+    taskEXIT_CRITICAL();
+}
+
+void RateGroupRunnableStatsGet(uint32_t ui32Idx,
+                               tRateGroupRunnableStats *psStats)
+{
+    taskENTER_CRITICAL();
+    *psStats = g_psRateGroupRunnableStats[ui32Idx];
+    taskEXIT_CRITICAL();
+}
+
+//*****************************************************************************
+//
+// Prints every group with its releases, overruns and the demand of the
+// schedulability check, then every runnable with its longest run against
+// its budget. The caller must own the UART.
+//
+//*****************************************************************************
+void RateGroupReport(void)
+{
+    static const uint32_t pui32Demand[RATE_GROUP_NUM] =
+    {
+        RATE_GROUP_DEMAND_US(RATE_GROUP_1MS),
+        RATE_GROUP_DEMAND_US(RATE_GROUP_5MS),
+        RATE_GROUP_DEMAND_US(RATE_GROUP_100MS)
+    };
+    tRateGroupStats sStats;
+    tRateGroupRunnableStats sRunnable;
+    const tRateGroupRunnable *psRunnable;
+    uint32_t ui32Group, ui32Idx;
+
+    UARTprintf("\ngroup  pri  releases  overruns  demand us/period\n");
+    for(ui32Group = 0; ui32Group < RATE_GROUP_NUM; ui32Group++)
+    {
+        RateGroupStatsGet(ui32Group, &sStats);
+        UARTprintf("%-5s  %3u  %8u  %8u  %u/%u\n",
+                   g_ppcRateGroupNames[ui32Group],
+                   g_pui32RateGroupPriorities[ui32Group], sStats.ui32Releases,
+                   sStats.ui32Overruns, pui32Demand[ui32Group],
+                   RATE_GROUP_PERIOD_MS(ui32Group) * 1000);
+    }
+
+    UARTprintf("runnable  group      runs  max us  budget  over\n");
+    for(ui32Idx = 0; ui32Idx < RATE_GROUP_NUM_RUNNABLES; ui32Idx++)
+    {
+        psRunnable = &g_psRateGroupRunnables[ui32Idx];
+        RateGroupRunnableStatsGet(ui32Idx, &sRunnable);
+        UARTprintf("%-8s  %-5s  %8u  %6u  %6u  %4u\n", psRunnable->pcName,
+                   g_ppcRateGroupNames[psRunnable->ui32Group],
+                   sRunnable.ui32Runs,
+                   TimestampCyclesToUs(sRunnable.ui32MaxCycles),
+                   psRunnable->ui32BudgetUs, sRunnable.ui32OverBudget);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef RATE_GROUP_H
+#define RATE_GROUP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Rate groups. One 1kHz timer releases every group at its period, all
+// groups together on the multiples of 100ms. Each group is a task that runs
+// its runnables in the order of rate_group_table.h, the shorter the period
+// the higher its priority. A release that finds the group still busy with
+// the previous one is an overrun: it is counted and dropped, never queued.
+//
+//*****************************************************************************
+#define RATE_GROUP_1MS                  0
+#define RATE_GROUP_5MS                  1
+#define RATE_GROUP_100MS                2
+#define RATE_GROUP_NUM                  3
+
+#define RATE_GROUP_TICK_HZ              1000
+
+// period of a group in ticks of the release timer, the periods are harmonic
+#define RATE_GROUP_PERIOD_MS(group)     (((group) == RATE_GROUP_1MS) ? 1 :    \
+                                         ((group) == RATE_GROUP_5MS) ? 5 : 100)
+
+typedef struct
+{
+    const char *pcName;
+    void (*pfnRun)(void);
+    uint32_t ui32Group;
+    uint32_t ui32BudgetUs;              // longest run allowed
+}
+tRateGroupRunnable;
+
+typedef struct
+{
+    uint32_t ui32Runs;
+    uint32_t ui32MaxCycles;
+    uint32_t ui32OverBudget;            // runs longer than the budget
+}
+tRateGroupRunnableStats;
+
+typedef struct
+{
+    uint32_t ui32Releases;
+    uint32_t ui32Overruns;              // releases dropped, group still busy
+}
+tRateGroupStats;
+
+extern const tRateGroupRunnable g_psRateGroupRunnables[];
+extern const uint32_t g_ui32RateGroupNumRunnables;
+extern const char * const g_ppcRateGroupNames[RATE_GROUP_NUM];
+
+uint32_t RateGroupInit(void);
+void RateGroupStatsGet(uint32_t ui32Group, tRateGroupStats *psStats);
+void RateGroupRunnableStatsGet(uint32_t ui32Idx,
+                               tRateGroupRunnableStats *psStats);
+void RateGroupReport(void);
+
+#endif
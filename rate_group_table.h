@@ -0,0 +1,28 @@
+#ifndef RATE_GROUP_TABLE_H
+#define RATE_GROUP_TABLE_H
+
+#include "adc_api.h"
+#include "ADC_task.h"
+#include "lcd_task.h"
+#include "wheel_speed.h"
+
+//*****************************************************************************
+//
+// The runnables of the rate groups, one per line:
+//
+//   X(arg, name, function, group, budget in us)
+//
+// A group runs its runnables in the order of the table. The budget is the
+// longest a run may take, checked on every run and summed up by the
+// schedulability check of rate_group.c, so a runnable added here that does
+// not fit its group fails the build. The first run of a runnable is not
+// held to its budget, it may initialise its hardware.
+//
+//*****************************************************************************
+#define RATE_GROUP_TABLE(X, arg)                                              \
+    X(arg, "throttle", ADCTaskRun,    RATE_GROUP_5MS,     200)                \
+    X(arg, "wheels",   WheelSpeedRun, RATE_GROUP_5MS,      50)                \
+    X(arg, "slow",     ADCSlowRun,    RATE_GROUP_100MS,    50)                \
+    X(arg, "lcd",      LCDTaskRun,    RATE_GROUP_100MS, 12000)
+
+#endif
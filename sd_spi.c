@@ -0,0 +1,554 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// microSD card in SPI mode on SSI0, block writes with uDMA
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_ssi.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/ssi.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "udma_api.h"
+#include "sd_spi.h"
+
+/******************************************************************************
+Description: SD card on SSI0, PA2 SCK, PA3 CS, PA4 MISO and PA5 MOSI.
+Commands and responses are moved byte by byte, the 512 byte data blocks of a
+write go through the SSI0 transmit uDMA channel and the task sleeps until
+the transfer is done. Multi block writes are announced with ACMD23 so the
+card can pre-erase. While the card is busy programming the task polls MISO
+once per tick instead of spinning.
+
+Only called from one task at a time, the data logger writer.
+******************************************************************************/
+
+#define SD_SPI_INIT_HZ                  400000
+#define SD_SPI_CLOCK_HZ                 12500000
+
+// lowest priority, the handler calls into FreeRTOS
+#define SD_DMA_INT_PRIORITY             0xE0
+
+#define SD_CMD_TIMEOUT_MS               500
+#define SD_INIT_TIMEOUT_MS              1000
+#define SD_WRITE_TIMEOUT_MS             500
+
+#define SD_ACMD                         0x80
+#define SD_CMD0                         0       // GO_IDLE_STATE
+#define SD_CMD8                         8       // SEND_IF_COND
+#define SD_CMD9                         9       // SEND_CSD
+#define SD_CMD12                        12      // STOP_TRANSMISSION
+#define SD_CMD16                        16      // SET_BLOCKLEN
+#define SD_CMD17                        17      // READ_SINGLE_BLOCK
+#define SD_CMD24                        24      // WRITE_BLOCK
+#define SD_CMD25                        25      // WRITE_MULTIPLE_BLOCK
+#define SD_CMD55                        55      // APP_CMD
+#define SD_CMD58                        58      // READ_OCR
+#define SD_ACMD23                       (SD_ACMD | 23)  // SET_WR_BLK_ERASE_COUNT
+#define SD_ACMD41                       (SD_ACMD | 41)  // SD_SEND_OP_COND
+
+#define SD_TOKEN_START                  0xFE
+#define SD_TOKEN_START_MULTI            0xFC
+#define SD_TOKEN_STOP_MULTI             0xFD
+#define SD_DATA_ACCEPTED                0x05
+
+static int32_t SDInit(void);
+static uint32_t SDBlockCount(void);
+static int32_t SDRead(uint32_t ui32Block, uint8_t *pui8Data,
+                      uint32_t ui32Count);
+static int32_t SDWrite(uint32_t ui32Block, const uint8_t *pui8Data,
+                       uint32_t ui32Count);
+
+const tStorageDevice g_sSDCardStorage =
+{
+    SDInit,
+    SDBlockCount,
+    SDRead,
+    SDWrite
+};
+
+static xSemaphoreHandle g_pSDDMADone = NULL;
+static volatile bool g_bSDDMABusy = false;
+static bool g_bSDHighCapacity;
+static uint32_t g_ui32SDBlocks = 0;
+
+//*****************************************************************************
+//
+// Byte level SPI access.
+//
+//*****************************************************************************
+static uint8_t SDXfer(uint8_t ui8Out)
+{
+    uint32_t ui32In;
+
+    MAP_SSIDataPut(SSI0_BASE, ui8Out);
+    MAP_SSIDataGet(SSI0_BASE, &ui32In);
+
+    return (uint8_t)ui32In;
+}
+
+static void SDSelect(void)
+{
+    MAP_GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_3, 0);
+}
+
+static void SDDeselect(void)
+{
+    MAP_GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_3, GPIO_PIN_3);
+
+    // the card releases MISO after one more clock byte
+    SDXfer(0xFF);
+}
+
+//*****************************************************************************
+//
+// Waits until the card stops holding MISO low. Returns false on timeout.
+//
+//*****************************************************************************
+static bool SDWaitReady(uint32_t ui32TimeoutMs)
+{
+    TickType_t xStart = xTaskGetTickCount();
+    uint32_t ui32Spin;
+
+    while(1)
+    {
+        for(ui32Spin = 0; ui32Spin < 8; ui32Spin++)
+        {
+            if(SDXfer(0xFF) == 0xFF)
+            {
+                return true;
+            }
+        }
+
+        if((xTaskGetTickCount() - xStart) > pdMS_TO_TICKS(ui32TimeoutMs))
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+}
+
+//*****************************************************************************
+//
+// Sends a command and returns the R1 response, 0xFF on timeout. The card
+// stays selected so the caller can read the rest of the response.
+//
+//*****************************************************************************
+static uint8_t SDCommand(uint32_t ui32Cmd, uint32_t ui32Arg)
+{
+    uint32_t ui32Try;
+    uint8_t ui8R1, ui8Crc = 0x01;
+
+    if(ui32Cmd & SD_ACMD)
+    {
+        ui8R1 = SDCommand(SD_CMD55, 0);
+        if(ui8R1 > 1)
+        {
+            return ui8R1;
+        }
+        ui32Cmd &= ~SD_ACMD;
+    }
+
+    SDDeselect();
+    SDSelect();
+    if((ui32Cmd != SD_CMD0) && !SDWaitReady(SD_CMD_TIMEOUT_MS))
+    {
+        return 0xFF;
+    }
+
+    //
+    // Only CMD0 and CMD8 are checked for a valid CRC in SPI mode.
+    //
+    if(ui32Cmd == SD_CMD0)
+    {
+        ui8Crc = 0x95;
+    }
+    else if(ui32Cmd == SD_CMD8)
+    {
+        ui8Crc = 0x87;
+    }
+
+    SDXfer(0x40 | (uint8_t)ui32Cmd);
+    SDXfer((uint8_t)(ui32Arg >> 24));
+    SDXfer((uint8_t)(ui32Arg >> 16));
+    SDXfer((uint8_t)(ui32Arg >> 8));
+    SDXfer((uint8_t)ui32Arg);
+    SDXfer(ui8Crc);
+
+    if(ui32Cmd == SD_CMD12)
+    {
+        // stuff byte
+        SDXfer(0xFF);
+    }
+
+    for(ui32Try = 0; ui32Try < 10; ui32Try++)
+    {
+        ui8R1 = SDXfer(0xFF);
+        if((ui8R1 & 0x80) == 0)
+        {
+            break;
+        }
+    }
+
+    return ui8R1;
+}
+
+//*****************************************************************************
+//
+// Receives a data block after a read command.
+//
+//*****************************************************************************
+static bool SDReceive(uint8_t *pui8Data, uint32_t ui32Len)
+{
+    TickType_t xStart = xTaskGetTickCount();
+    uint8_t ui8Token;
+
+    while((ui8Token = SDXfer(0xFF)) == 0xFF)
+    {
+        if((xTaskGetTickCount() - xStart) > pdMS_TO_TICKS(SD_CMD_TIMEOUT_MS))
+        {
+            return false;
+        }
+    }
+
+    if(ui8Token != SD_TOKEN_START)
+    {
+        return false;
+    }
+
+    while(ui32Len--)
+    {
+        *pui8Data++ = SDXfer(0xFF);
+    }
+
+    // CRC
+    SDXfer(0xFF);
+    SDXfer(0xFF);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Sends a data block with the uDMA and returns true if the card accepted it.
+//
+//*****************************************************************************
+static bool SDTransmit(uint8_t ui8Token, const uint8_t *pui8Data)
+{
+    uint32_t ui32Dummy;
+
+    SDXfer(ui8Token);
+
+    g_bSDDMABusy = true;
+    MAP_uDMAChannelTransferSet(UDMA_CHANNEL_SSI0TX | UDMA_PRI_SELECT,
+                               UDMA_MODE_BASIC, (void *)pui8Data,
+                               (void *)(SSI0_BASE + SSI_O_DR),
+                               STORAGE_BLOCK_SIZE);
+    MAP_uDMAChannelEnable(UDMA_CHANNEL_SSI0TX);
+    xSemaphoreTake(g_pSDDMADone, portMAX_DELAY);
+    g_bSDDMABusy = false;
+
+    //
+    // The receive FIFO overflowed with the echoed bytes, empty it.
+    //
+    while(MAP_SSIBusy(SSI0_BASE))
+    {
+    }
+    while(MAP_SSIDataGetNonBlocking(SSI0_BASE, &ui32Dummy))
+    {
+    }
+    MAP_SSIIntClear(SSI0_BASE, SSI_RXOR);
+
+    // CRC, not checked in SPI mode
+    SDXfer(0xFF);
+    SDXfer(0xFF);
+
+    return (SDXfer(0xFF) & 0x1F) == SD_DATA_ACCEPTED;
+}
+
+//*****************************************************************************
+//
+// Sets up SSI0 and brings the card into SPI mode. Returns 0 on success.
+//
+//*****************************************************************************
+static int32_t SDInit(void)
+{
+    TickType_t xStart;
+    uint32_t ui32Idx, ui32Arg, ui32CSize, ui32Dummy;
+    uint8_t pui8Reg[16], ui8R1;
+    bool bVersion2;
+
+    if(g_pSDDMADone == NULL)
+    {
+        g_pSDDMADone = xSemaphoreCreateBinary();
+
+        MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_SSI0);
+        MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+
+        MAP_GPIOPinConfigure(GPIO_PA2_SSI0CLK);
+        MAP_GPIOPinConfigure(GPIO_PA4_SSI0RX);
+        MAP_GPIOPinConfigure(GPIO_PA5_SSI0TX);
+        MAP_GPIOPinTypeSSI(GPIO_PORTA_BASE, GPIO_PIN_2 | GPIO_PIN_4 |
+                                            GPIO_PIN_5);
+        MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA,
+                             GPIO_PIN_TYPE_STD_WPU);
+        MAP_GPIOPinTypeGPIOOutput(GPIO_PORTA_BASE, GPIO_PIN_3);
+        MAP_GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_3, GPIO_PIN_3);
+
+        UDMAInit();
+        MAP_uDMAChannelAssign(UDMA_CH11_SSI0TX);
+        MAP_uDMAChannelAttributeDisable(UDMA_CHANNEL_SSI0TX, UDMA_ATTR_ALL);
+        MAP_uDMAChannelControlSet(UDMA_CHANNEL_SSI0TX | UDMA_PRI_SELECT,
+                                  UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                                  UDMA_DST_INC_NONE | UDMA_ARB_4);
+
+        SSIIntRegister(SSI0_BASE, SSI0IntHandler);
+        MAP_IntPrioritySet(INT_SSI0, SD_DMA_INT_PRIORITY);
+        MAP_IntEnable(INT_SSI0);
+    }
+
+    g_ui32SDBlocks = 0;
+
+    MAP_SSIDisable(SSI0_BASE);
+    MAP_SSIDMADisable(SSI0_BASE, SSI_DMA_TX);
+    MAP_SSIConfigSetExpClk(SSI0_BASE, MAP_SysCtlClockGet(),
+                           SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER,
+                           SD_SPI_INIT_HZ, 8);
+    MAP_SSIEnable(SSI0_BASE);
+    while(MAP_SSIDataGetNonBlocking(SSI0_BASE, &ui32Dummy))
+    {
+    }
+
+    //
+    // At least 74 clocks with CS high enter SPI mode.
+    //
+    MAP_GPIOPinWrite(GPIO_PORTA_BASE, GPIO_PIN_3, GPIO_PIN_3);
+    for(ui32Idx = 0; ui32Idx < 10; ui32Idx++)
+    {
+        SDXfer(0xFF);
+    }
+
+    if(SDCommand(SD_CMD0, 0) != 0x01)
+    {
+        SDDeselect();
+        return -1;
+    }
+
+    //
+    // Version 2 cards answer CMD8 and may be high capacity.
+    //
+    bVersion2 = false;
+    if(SDCommand(SD_CMD8, 0x1AA) == 0x01)
+    {
+        for(ui32Idx = 0; ui32Idx < 4; ui32Idx++)
+        {
+            pui8Reg[ui32Idx] = SDXfer(0xFF);
+        }
+        if((pui8Reg[2] != 0x01) || (pui8Reg[3] != 0xAA))
+        {
+            SDDeselect();
+            return -1;
+        }
+        bVersion2 = true;
+    }
+
+    ui32Arg = bVersion2 ? 0x40000000 : 0;
+    xStart = xTaskGetTickCount();
+    while((ui8R1 = SDCommand(SD_ACMD41, ui32Arg)) != 0)
+    {
+        if((ui8R1 > 1) ||
+           ((xTaskGetTickCount() - xStart) > pdMS_TO_TICKS(SD_INIT_TIMEOUT_MS)))
+        {
+            SDDeselect();
+            return -1;
+        }
+        vTaskDelay(1);
+    }
+
+    g_bSDHighCapacity = false;
+    if(bVersion2)
+    {
+        if(SDCommand(SD_CMD58, 0) != 0)
+        {
+            SDDeselect();
+            return -1;
+        }
+        for(ui32Idx = 0; ui32Idx < 4; ui32Idx++)
+        {
+            pui8Reg[ui32Idx] = SDXfer(0xFF);
+        }
+        g_bSDHighCapacity = (pui8Reg[0] & 0x40) != 0;
+    }
+
+    if(!g_bSDHighCapacity && (SDCommand(SD_CMD16, STORAGE_BLOCK_SIZE) != 0))
+    {
+        SDDeselect();
+        return -1;
+    }
+
+    //
+    // Card size from the CSD register.
+    //
+    if((SDCommand(SD_CMD9, 0) != 0) || !SDReceive(pui8Reg, 16))
+    {
+        SDDeselect();
+        return -1;
+    }
+
+    if((pui8Reg[0] >> 6) == 1)
+    {
+        ui32CSize = ((uint32_t)(pui8Reg[7] & 0x3F) << 16) |
+                    ((uint32_t)pui8Reg[8] << 8) | pui8Reg[9];
+        g_ui32SDBlocks = (ui32CSize + 1) << 10;
+    }
+    else
+    {
+        ui32CSize = ((uint32_t)(pui8Reg[6] & 0x03) << 10) |
+                    ((uint32_t)pui8Reg[7] << 2) | (pui8Reg[8] >> 6);
+        g_ui32SDBlocks = (ui32CSize + 1) <<
+                         ((((pui8Reg[9] & 0x03) << 1) | (pui8Reg[10] >> 7)) +
+                          2 + (pui8Reg[5] & 0x0F) - 9);
+    }
+    SDDeselect();
+
+    //
+    // Full speed from here on.
+    //
+    MAP_SSIDisable(SSI0_BASE);
+    MAP_SSIConfigSetExpClk(SSI0_BASE, MAP_SysCtlClockGet(),
+                           SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER,
+                           SD_SPI_CLOCK_HZ, 8);
+    MAP_SSIEnable(SSI0_BASE);
+    MAP_SSIDMAEnable(SSI0_BASE, SSI_DMA_TX);
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Returns the number of 512 byte blocks, 0 if no card was found.
+//
+//*****************************************************************************
+static uint32_t SDBlockCount(void)
+{
+    return g_ui32SDBlocks;
+}
+
+static uint32_t SDAddress(uint32_t ui32Block)
+{
+    return g_bSDHighCapacity ? ui32Block : (ui32Block * STORAGE_BLOCK_SIZE);
+}
+
+//*****************************************************************************
+//
+// Reads blocks one at a time.
+//
+//*****************************************************************************
+static int32_t SDRead(uint32_t ui32Block, uint8_t *pui8Data,
+                      uint32_t ui32Count)
+{
+    int32_t i32Result = 0;
+
+    while(ui32Count--)
+    {
+        if((SDCommand(SD_CMD17, SDAddress(ui32Block++)) != 0) ||
+           !SDReceive(pui8Data, STORAGE_BLOCK_SIZE))
+        {
+            i32Result = -1;
+            break;
+        }
+        pui8Data += STORAGE_BLOCK_SIZE;
+    }
+
+    SDDeselect();
+
+    return i32Result;
+}
+
+//*****************************************************************************
+//
+// Writes consecutive blocks, several of them with one multi block command.
+//
+//*****************************************************************************
+static int32_t SDWrite(uint32_t ui32Block, const uint8_t *pui8Data,
+                       uint32_t ui32Count)
+{
+    int32_t i32Result = 0;
+
+    if(ui32Count == 1)
+    {
+        if((SDCommand(SD_CMD24, SDAddress(ui32Block)) != 0) ||
+           !SDTransmit(SD_TOKEN_START, pui8Data) ||
+           !SDWaitReady(SD_WRITE_TIMEOUT_MS))
+        {
+            i32Result = -1;
+        }
+
+        SDDeselect();
+        return i32Result;
+    }
+
+    if((SDCommand(SD_ACMD23, ui32Count) != 0) ||
+       (SDCommand(SD_CMD25, SDAddress(ui32Block)) != 0))
+    {
+        SDDeselect();
+        return -1;
+    }
+
+    while(ui32Count--)
+    {
+        if(!SDWaitReady(SD_WRITE_TIMEOUT_MS) ||
+           !SDTransmit(SD_TOKEN_START_MULTI, pui8Data))
+        {
+            i32Result = -1;
+            break;
+        }
+        pui8Data += STORAGE_BLOCK_SIZE;
+    }
+
+    //
+    // The stop token also ends a failed transfer.
+    //
+    SDWaitReady(SD_WRITE_TIMEOUT_MS);
+    SDXfer(SD_TOKEN_STOP_MULTI);
+    SDXfer(0xFF);
+    if(!SDWaitReady(SD_WRITE_TIMEOUT_MS))
+    {
+        i32Result = -1;
+    }
+
+    SDDeselect();
+
+    return i32Result;
+}
+
+//*****************************************************************************
+//
+// SSI0 interrupt handler. Signals the end of a uDMA transfer.
+//
+//*****************************************************************************
+void SSI0IntHandler(void)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t ui32Status;
+
+    ui32Status = MAP_SSIIntStatus(SSI0_BASE, true);
+    MAP_SSIIntClear(SSI0_BASE, ui32Status);
+
+    if(g_bSDDMABusy && !MAP_uDMAChannelIsEnabled(UDMA_CHANNEL_SSI0TX))
+    {
+        xSemaphoreGiveFromISR(g_pSDDMADone, &xWoken);
+    }
+
+    portYIELD_FROM_ISR(xWoken);
+}
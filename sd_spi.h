@@ -0,0 +1,10 @@
+#ifndef SD_SPI_H
+#define SD_SPI_H
+
+#include "storage.h"
+
+extern const tStorageDevice g_sSDCardStorage;
+
+void SSI0IntHandler(void);
+
+#endif
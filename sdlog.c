@@ -0,0 +1,529 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Compressed ADC frame logger on a block device
+//
+// Plain C without target dependencies apart from the block pool, also built
+// into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "block_pool.h"
+#include "compress.h"
+#include "crc16.h"
+#include "ram_budget.h"
+#include "sdlog.h"
+
+/******************************************************************************
+Description: records ADC frames into the slots of sdlog_format.h. Two
+contexts use this module:
+
+ - the producer calls SDLogAddFrame() for every frame and SDLogFlush() at the
+   end. Frames are compressed in records of SDLOG_RECORD_FRAMES straight into
+   the current write buffer. A full buffer is queued to the consumer and the
+   next one is taken from the "sdlog" block pool, if it is empty the frames
+   are dropped and counted, the producer never waits for the card.
+ - the consumer calls SDLogWriteNext() to write the queued buffers as multi
+   block writes and gives each buffer back to the pool once it is on the
+   card. It also does the mounting and the superblock updates of
+   SDLogMount(), SDLogSessionStart() and SDLogSessionClose() while the
+   producer is idle.
+
+The buffer queue is a single producer, single consumer ring of buffer
+pointers, the two counters are only written by one side each. It never
+overflows, every entry holds one of the SDLOG_NUM_BUFFERS blocks of the
+pool.
+******************************************************************************/
+
+#if defined(__ARMCC_VERSION)
+#define SDLOG_BARRIER()         __schedule_barrier()
+#elif defined(__GNUC__)
+#define SDLOG_BARRIER()         __sync_synchronize()
+#else
+#define SDLOG_BARRIER()
+#endif
+
+typedef struct
+{
+    uint8_t *pui8Buffer;
+    uint32_t ui32Index;                 // first block in the slot
+    uint32_t ui32Blocks;
+}
+tSDLogQueued;
+
+static tBlockPool g_sSDLogPool;
+BLOCK_POOL_STORAGE(g_ppvSDLogPoolStorage, SDLOG_BUFFER_SIZE, SDLOG_NUM_BUFFERS);
+static tSDLogQueued g_psSDLogQueue[SDLOG_NUM_BUFFERS];
+static volatile uint32_t g_ui32SDLogHead = 0;   // buffers queued
+static volatile uint32_t g_ui32SDLogTail = 0;   // buffers written
+
+static const tStorageDevice *g_psSDLogDevice = NULL;
+static uint32_t g_ui32SDLogFirstBlock;
+static uint32_t g_ui32SDLogSlotBlocks;
+static uint32_t g_ui32SDLogSlotStart;
+
+static volatile bool g_bSDLogActive = false;
+static tCompressBlock g_sSDLogBlock;
+
+typedef char tSDLogBudget[(sizeof(g_ppvSDLogPoolStorage) +
+                           sizeof(g_sSDLogBlock) <= RAM_BUDGET_SDLOG) ? 1 : -1];
+static uint8_t *g_pui8SDLogFill = NULL;
+static uint32_t g_ui32SDLogFillIndex;
+static uint32_t g_ui32SDLogFillBlock;
+static uint32_t g_ui32SDLogFillPos;
+static uint32_t g_ui32SDLogNextIndex;
+
+static tSDLogStats g_sSDLogStats;
+
+//*****************************************************************************
+//
+// Reads the superblock into a buffer of the pool, which the caller frees.
+// Only used while the producer is idle and the queue is empty.
+//
+//*****************************************************************************
+static uint8_t *SDLogSuperblockRead(void)
+{
+    uint8_t *pui8Super = BlockPoolAlloc(&g_sSDLogPool);
+
+    if(pui8Super == NULL)
+    {
+        return NULL;
+    }
+
+    if(g_psSDLogDevice->pfnRead(0, pui8Super, 1) != 0)
+    {
+        BlockPoolFree(&g_sSDLogPool, pui8Super);
+        return NULL;
+    }
+
+    return pui8Super;
+}
+
+//*****************************************************************************
+//
+// Reads the superblock of the device and formats the card if it does not
+// hold a logger layout for its size yet. Returns 0 on success.
+//
+//*****************************************************************************
+int32_t SDLogMount(const tStorageDevice *psDevice)
+{
+    uint8_t *pui8Super;
+    uint32_t ui32Blocks, ui32SlotBlocks;
+    int32_t i32Ret = 0;
+
+    if(g_sSDLogPool.pcName == NULL)
+    {
+        BlockPoolInit(&g_sSDLogPool, "sdlog", g_ppvSDLogPoolStorage,
+                      SDLOG_BUFFER_SIZE, SDLOG_NUM_BUFFERS);
+    }
+
+    g_psSDLogDevice = psDevice;
+    g_bSDLogActive = false;
+
+    if(psDevice->pfnInit() != 0)
+    {
+        return -1;
+    }
+
+    ui32Blocks = psDevice->pfnBlockCount();
+    if(ui32Blocks <= SDLOG_SLOT_ALIGN)
+    {
+        return -1;
+    }
+
+    //
+    // Slots start on an erase group boundary and are a multiple of it when
+    // the card is large enough.
+    //
+    ui32SlotBlocks = (ui32Blocks - SDLOG_SLOT_ALIGN) / SDLOG_NUM_SLOTS;
+    if(ui32SlotBlocks > SDLOG_SLOT_ALIGN)
+    {
+        ui32SlotBlocks -= ui32SlotBlocks % SDLOG_SLOT_ALIGN;
+    }
+
+    pui8Super = SDLogSuperblockRead();
+    if(pui8Super == NULL)
+    {
+        return -1;
+    }
+
+    if((SDLogGet32(pui8Super + SDLOG_SB_MAGIC) != SDLOG_MAGIC) ||
+       (SDLogGet16(pui8Super + SDLOG_SB_VERSION) != SDLOG_VERSION) ||
+       (SDLogGet16(pui8Super + SDLOG_SB_SLOTS) != SDLOG_NUM_SLOTS) ||
+       (SDLogGet32(pui8Super + SDLOG_SB_FIRST_BLOCK) != SDLOG_SLOT_ALIGN) ||
+       (SDLogGet32(pui8Super + SDLOG_SB_SLOT_BLOCKS) != ui32SlotBlocks))
+    {
+        memset(pui8Super, 0, STORAGE_BLOCK_SIZE);
+        SDLogPut32(pui8Super + SDLOG_SB_MAGIC, SDLOG_MAGIC);
+        SDLogPut16(pui8Super + SDLOG_SB_VERSION, SDLOG_VERSION);
+        SDLogPut16(pui8Super + SDLOG_SB_SLOTS, SDLOG_NUM_SLOTS);
+        SDLogPut32(pui8Super + SDLOG_SB_FIRST_BLOCK, SDLOG_SLOT_ALIGN);
+        SDLogPut32(pui8Super + SDLOG_SB_SLOT_BLOCKS, ui32SlotBlocks);
+
+        i32Ret = psDevice->pfnWrite(0, pui8Super, 1);
+    }
+    BlockPoolFree(&g_sSDLogPool, pui8Super);
+
+    if(i32Ret != 0)
+    {
+        return -1;
+    }
+
+    g_ui32SDLogFirstBlock = SDLOG_SLOT_ALIGN;
+    g_ui32SDLogSlotBlocks = ui32SlotBlocks;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Opens the next session in the next slot and enables the producer.
+//
+//*****************************************************************************
+int32_t SDLogSessionStart(void)
+{
+    uint8_t *pui8Super, *pui8Entry;
+    uint32_t ui32Session, ui32Slot;
+    int32_t i32Ret;
+
+    if((g_psSDLogDevice == NULL) || g_bSDLogActive ||
+       (g_ui32SDLogHead != g_ui32SDLogTail))
+    {
+        return -1;
+    }
+
+    pui8Super = SDLogSuperblockRead();
+    if(pui8Super == NULL)
+    {
+        return -1;
+    }
+
+    ui32Session = SDLogGet32(pui8Super + SDLOG_SB_LAST_SESSION) + 1;
+    ui32Slot = ui32Session % SDLOG_NUM_SLOTS;
+
+    pui8Entry = pui8Super + SDLOG_SB_TABLE + (ui32Slot * SDLOG_SB_ENTRY_SIZE);
+    SDLogPut32(pui8Entry + SDLOG_SB_ENTRY_SESSION, ui32Session);
+    SDLogPut32(pui8Entry + SDLOG_SB_ENTRY_BLOCKS, SDLOG_SLOT_OPEN);
+    SDLogPut32(pui8Super + SDLOG_SB_LAST_SESSION, ui32Session);
+
+    i32Ret = g_psSDLogDevice->pfnWrite(0, pui8Super, 1);
+    BlockPoolFree(&g_sSDLogPool, pui8Super);
+    if(i32Ret != 0)
+    {
+        return -1;
+    }
+
+    memset(&g_sSDLogStats, 0, sizeof(g_sSDLogStats));
+    g_sSDLogStats.ui32Session = ui32Session;
+    g_sSDLogStats.ui32Slot = ui32Slot;
+
+    g_ui32SDLogSlotStart = g_ui32SDLogFirstBlock +
+                           (ui32Slot * g_ui32SDLogSlotBlocks);
+    g_ui32SDLogNextIndex = 0;
+    g_pui8SDLogFill = NULL;
+    CompressBlockInit(&g_sSDLogBlock, ADC_NUM_CHANNELS);
+
+    SDLOG_BARRIER();
+    g_bSDLogActive = true;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Records the length of the stopped session in the superblock. Call after
+// SDLogFlush() once SDLogWriteNext() has nothing left to write.
+//
+//*****************************************************************************
+int32_t SDLogSessionClose(void)
+{
+    uint8_t *pui8Super, *pui8Entry;
+    int32_t i32Ret;
+
+    if(g_bSDLogActive || (g_ui32SDLogHead != g_ui32SDLogTail))
+    {
+        return -1;
+    }
+
+    pui8Super = SDLogSuperblockRead();
+    if(pui8Super == NULL)
+    {
+        return -1;
+    }
+
+    pui8Entry = pui8Super + SDLOG_SB_TABLE +
+                (g_sSDLogStats.ui32Slot * SDLOG_SB_ENTRY_SIZE);
+    SDLogPut32(pui8Entry + SDLOG_SB_ENTRY_BLOCKS, g_ui32SDLogNextIndex);
+
+    i32Ret = g_psSDLogDevice->pfnWrite(0, pui8Super, 1);
+    BlockPoolFree(&g_sSDLogPool, pui8Super);
+
+    return i32Ret;
+}
+
+//*****************************************************************************
+//
+// Starts and completes a data block of the current buffer.
+//
+//*****************************************************************************
+static void SDLogBlockOpen(void)
+{
+    uint8_t *pui8Block = g_pui8SDLogFill +
+                         (g_ui32SDLogFillBlock * STORAGE_BLOCK_SIZE);
+
+    SDLogPut16(pui8Block + SDLOG_BLK_MAGIC, SDLOG_BLOCK_MAGIC);
+    pui8Block[SDLOG_BLK_VERSION] = SDLOG_VERSION;
+    pui8Block[SDLOG_BLK_VERSION + 1] = 0;
+    SDLogPut32(pui8Block + SDLOG_BLK_SESSION, g_sSDLogStats.ui32Session);
+    SDLogPut32(pui8Block + SDLOG_BLK_INDEX, g_ui32SDLogNextIndex++);
+    g_ui32SDLogFillPos = SDLOG_BLK_HDR_SIZE;
+}
+
+static void SDLogBlockClose(void)
+{
+    uint8_t *pui8Block = g_pui8SDLogFill +
+                         (g_ui32SDLogFillBlock * STORAGE_BLOCK_SIZE);
+    uint16_t ui16Crc;
+
+    SDLogPut16(pui8Block + SDLOG_BLK_LENGTH,
+               (uint16_t)(g_ui32SDLogFillPos - SDLOG_BLK_HDR_SIZE));
+    memset(pui8Block + g_ui32SDLogFillPos, 0,
+           STORAGE_BLOCK_SIZE - g_ui32SDLogFillPos);
+
+    ui16Crc = Crc16Ccitt(CRC16_CCITT_INIT, pui8Block, SDLOG_BLK_CRC);
+    ui16Crc = Crc16Ccitt(ui16Crc, pui8Block + SDLOG_BLK_HDR_SIZE,
+                         g_ui32SDLogFillPos - SDLOG_BLK_HDR_SIZE);
+    SDLogPut16(pui8Block + SDLOG_BLK_CRC, ui16Crc);
+}
+
+//*****************************************************************************
+//
+// Takes a buffer from the pool. Fails when all buffers are waiting for the
+// card or the slot is full.
+//
+//*****************************************************************************
+static bool SDLogBufferGet(void)
+{
+    if((g_ui32SDLogNextIndex + SDLOG_BUFFER_BLOCKS) > g_ui32SDLogSlotBlocks)
+    {
+        return false;
+    }
+
+    g_pui8SDLogFill = BlockPoolAlloc(&g_sSDLogPool);
+    if(g_pui8SDLogFill == NULL)
+    {
+        return false;
+    }
+
+    g_ui32SDLogFillIndex = g_ui32SDLogNextIndex;
+    g_ui32SDLogFillBlock = 0;
+    SDLogBlockOpen();
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Queues the current buffer for writing.
+//
+//*****************************************************************************
+static void SDLogBufferQueue(void)
+{
+    tSDLogQueued *psQueued;
+
+    SDLogBlockClose();
+    psQueued = &g_psSDLogQueue[g_ui32SDLogHead % SDLOG_NUM_BUFFERS];
+    psQueued->pui8Buffer = g_pui8SDLogFill;
+    psQueued->ui32Index = g_ui32SDLogFillIndex;
+    psQueued->ui32Blocks = g_ui32SDLogFillBlock + 1;
+    g_pui8SDLogFill = NULL;
+
+    SDLOG_BARRIER();
+    g_ui32SDLogHead++;
+}
+
+//*****************************************************************************
+//
+// Packs the pending frames into a record. Returns true if a buffer was
+// queued.
+//
+//*****************************************************************************
+static bool SDLogRecord(void)
+{
+    uint32_t ui32Count = g_sSDLogBlock.ui32Count, ui32Len;
+    uint8_t *pui8Record;
+    bool bQueued = false;
+
+    if(ui32Count == 0)
+    {
+        return false;
+    }
+
+    if((g_pui8SDLogFill == NULL) && !SDLogBufferGet())
+    {
+        g_sSDLogStats.ui32Dropped += ui32Count;
+        CompressBlockInit(&g_sSDLogBlock, ADC_NUM_CHANNELS);
+        return false;
+    }
+
+    //
+    // Records do not span blocks, move on if this one does not fit.
+    //
+    if((g_ui32SDLogFillPos + SDLOG_RECORD_HDR_SIZE +
+        CompressBlockSize(&g_sSDLogBlock)) > STORAGE_BLOCK_SIZE)
+    {
+        if((g_ui32SDLogFillBlock + 1) < SDLOG_BUFFER_BLOCKS)
+        {
+            SDLogBlockClose();
+            g_ui32SDLogFillBlock++;
+            SDLogBlockOpen();
+        }
+        else
+        {
+            SDLogBufferQueue();
+            bQueued = true;
+
+            if(!SDLogBufferGet())
+            {
+                g_sSDLogStats.ui32Dropped += ui32Count;
+                CompressBlockInit(&g_sSDLogBlock, ADC_NUM_CHANNELS);
+                return bQueued;
+            }
+        }
+    }
+
+    pui8Record = g_pui8SDLogFill + (g_ui32SDLogFillBlock * STORAGE_BLOCK_SIZE) +
+                 g_ui32SDLogFillPos;
+    ui32Len = CompressBlockFinish(&g_sSDLogBlock,
+                                  pui8Record + SDLOG_RECORD_HDR_SIZE);
+    SDLogPut16(pui8Record, (uint16_t)ui32Len);
+    g_ui32SDLogFillPos += SDLOG_RECORD_HDR_SIZE + ui32Len;
+
+    g_sSDLogStats.ui32Frames += ui32Count;
+    g_sSDLogStats.ui32Records++;
+
+    return bQueued;
+}
+
+//*****************************************************************************
+//
+// Producer: adds a frame to the session. Returns true if a buffer was queued
+// and the consumer should be woken up.
+//
+//*****************************************************************************
+bool SDLogAddFrame(const tADCFrame *psFrame)
+{
+    uint32_t ui32Count;
+    bool bQueued = false;
+
+    if(!g_bSDLogActive)
+    {
+        return false;
+    }
+
+    ui32Count = CompressBlockAdd(&g_sSDLogBlock, psFrame->ui32Seq,
+                                 psFrame->ui32Time, psFrame->pui16Data);
+    if(ui32Count == 0)
+    {
+        bQueued = SDLogRecord();
+        ui32Count = CompressBlockAdd(&g_sSDLogBlock, psFrame->ui32Seq,
+                                     psFrame->ui32Time, psFrame->pui16Data);
+    }
+
+    if(ui32Count >= SDLOG_RECORD_FRAMES)
+    {
+        bQueued |= SDLogRecord();
+    }
+
+    return bQueued;
+}
+
+//*****************************************************************************
+//
+// Producer: writes out the pending frames and ends the session. Returns true
+// if a buffer was queued.
+//
+//*****************************************************************************
+bool SDLogFlush(void)
+{
+    bool bQueued;
+
+    if(!g_bSDLogActive)
+    {
+        return false;
+    }
+
+    bQueued = SDLogRecord();
+    if(g_pui8SDLogFill != NULL)
+    {
+        SDLogBufferQueue();
+        bQueued = true;
+    }
+
+    g_bSDLogActive = false;
+
+    return bQueued;
+}
+
+//*****************************************************************************
+//
+// Consumer: writes the oldest queued buffer and frees it. Returns false when
+// there was nothing to write.
+//
+//*****************************************************************************
+bool SDLogWriteNext(void)
+{
+    tSDLogQueued *psQueued;
+    uint8_t *pui8Buffer;
+
+    if(g_ui32SDLogTail == g_ui32SDLogHead)
+    {
+        return false;
+    }
+
+    SDLOG_BARRIER();
+    psQueued = &g_psSDLogQueue[g_ui32SDLogTail % SDLOG_NUM_BUFFERS];
+
+    if(g_psSDLogDevice->pfnWrite(g_ui32SDLogSlotStart + psQueued->ui32Index,
+                                 psQueued->pui8Buffer,
+                                 psQueued->ui32Blocks) != 0)
+    {
+        g_sSDLogStats.ui32WriteErrors++;
+    }
+    else
+    {
+        g_sSDLogStats.ui32Blocks += psQueued->ui32Blocks;
+    }
+    pui8Buffer = psQueued->pui8Buffer;
+
+    //
+    // Release the entry before the buffer, the producer can take the buffer
+    // and queue it again right away.
+    //
+    SDLOG_BARRIER();
+    g_ui32SDLogTail++;
+    BlockPoolFree(&g_sSDLogPool, pui8Buffer);
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Returns true while a session is recording.
+//
+//*****************************************************************************
+bool SDLogActive(void)
+{
+    return g_bSDLogActive;
+}
+
+//*****************************************************************************
+//
+// Returns the counters of the current or last session.
+//
+//*****************************************************************************
+const tSDLogStats *SDLogStats(void)
+{
+    return &g_sSDLogStats;
+}
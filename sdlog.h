@@ -0,0 +1,42 @@
+#ifndef SDLOG_H
+#define SDLOG_H
+
+#include "adc_api.h"
+#include "storage.h"
+#include "sdlog_format.h"
+
+//*****************************************************************************
+//
+// Write buffers. SDLOG_NUM_BUFFERS buffers of SDLOG_BUFFER_BLOCKS card blocks
+// each, one is filled while the others are written.
+//
+//*****************************************************************************
+#define SDLOG_BUFFER_BLOCKS             2
+#define SDLOG_NUM_BUFFERS               3
+#define SDLOG_BUFFER_SIZE               (SDLOG_BUFFER_BLOCKS * STORAGE_BLOCK_SIZE)
+
+// frames per compressed record
+#define SDLOG_RECORD_FRAMES             32
+
+typedef struct
+{
+    uint32_t ui32Session;
+    uint32_t ui32Slot;
+    uint32_t ui32Frames;                // frames stored in records
+    uint32_t ui32Dropped;               // frames lost, no free buffer
+    uint32_t ui32Records;
+    uint32_t ui32Blocks;                // blocks written to the card
+    uint32_t ui32WriteErrors;
+}
+tSDLogStats;
+
+int32_t SDLogMount(const tStorageDevice *psDevice);
+int32_t SDLogSessionStart(void);
+int32_t SDLogSessionClose(void);
+bool SDLogAddFrame(const tADCFrame *psFrame);
+bool SDLogFlush(void);
+bool SDLogWriteNext(void);
+bool SDLogActive(void);
+const tSDLogStats *SDLogStats(void);
+
+#endif
@@ -0,0 +1,109 @@
+//*****************************************************************************
+//
+// sdlog_format.h - Layout of the data logger on the SD card.
+//
+// Shared by the firmware and the host tools in tools/sdlog, so it must only
+// depend on stdint.h. Any change to the layout must bump SDLOG_VERSION.
+//
+// The card has no file system, the logger owns it completely:
+//
+//     block 0              superblock with the session table
+//     SDLOG_SLOT_ALIGN..   SDLOG_NUM_SLOTS slots of equal size
+//
+// Every slot is a preallocated, contiguous file holding one recording
+// session. Sessions take the slots round robin, so the oldest one is
+// overwritten when the card is full. The superblock is only written when a
+// session starts or is stopped from the console; after a power loss the end
+// of a session is found from the block headers.
+//
+// Superblock, little endian:
+//
+//     offset  size  field
+//     0       4     SDLOG_MAGIC
+//     4       2     SDLOG_VERSION
+//     6       2     number of slots
+//     8       4     first block of slot 0
+//     12      4     blocks per slot
+//     16      4     number of the last session started, 0 for none
+//     32      12*n  slot table: session number, blocks written (0xFFFFFFFF
+//                   while recording), reserved
+//
+// Data block:
+//
+//     0       2     SDLOG_BLOCK_MAGIC
+//     2       1     SDLOG_VERSION
+//     3       1     reserved
+//     4       4     session number
+//     8       4     block index within the session
+//     12      2     payload length
+//     14      2     CRC-16/CCITT-FALSE of bytes 0 to 13 and the payload
+//     16      n     payload: records of a 2 byte length and a compress.h
+//                   block of ADC frames. A record never spans two blocks.
+//
+//*****************************************************************************
+
+#ifndef SDLOG_FORMAT_H
+#define SDLOG_FORMAT_H
+
+#include <stdint.h>
+
+#define SDLOG_MAGIC                     0x474C5346      // "FSLG"
+#define SDLOG_BLOCK_MAGIC               0x4246          // "FB"
+#define SDLOG_VERSION                   1
+
+#define SDLOG_NUM_SLOTS                 16
+#define SDLOG_SLOT_ALIGN                2048            // 1MB, erase groups
+#define SDLOG_SLOT_OPEN                 0xFFFFFFFF
+
+#define SDLOG_SB_MAGIC                  0
+#define SDLOG_SB_VERSION                4
+#define SDLOG_SB_SLOTS                  6
+#define SDLOG_SB_FIRST_BLOCK            8
+#define SDLOG_SB_SLOT_BLOCKS            12
+#define SDLOG_SB_LAST_SESSION           16
+#define SDLOG_SB_TABLE                  32
+#define SDLOG_SB_ENTRY_SIZE             12
+#define SDLOG_SB_ENTRY_SESSION          0
+#define SDLOG_SB_ENTRY_BLOCKS           4
+
+#define SDLOG_BLK_MAGIC                 0
+#define SDLOG_BLK_VERSION               2
+#define SDLOG_BLK_SESSION               4
+#define SDLOG_BLK_INDEX                 8
+#define SDLOG_BLK_LENGTH                12
+#define SDLOG_BLK_CRC                   14
+#define SDLOG_BLK_HDR_SIZE              16
+
+#define SDLOG_RECORD_HDR_SIZE           2
+
+//*****************************************************************************
+//
+// Little endian field access.
+//
+//*****************************************************************************
+static inline void SDLogPut16(uint8_t *pui8Buf, uint16_t ui16Value)
+{
+    pui8Buf[0] = (uint8_t)ui16Value;
+    pui8Buf[1] = (uint8_t)(ui16Value >> 8);
+}
+
+static inline void SDLogPut32(uint8_t *pui8Buf, uint32_t ui32Value)
+{
+    pui8Buf[0] = (uint8_t)ui32Value;
+    pui8Buf[1] = (uint8_t)(ui32Value >> 8);
+    pui8Buf[2] = (uint8_t)(ui32Value >> 16);
+    pui8Buf[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static inline uint16_t SDLogGet16(const uint8_t *pui8Buf)
+{
+    return (uint16_t)(pui8Buf[0] | (pui8Buf[1] << 8));
+}
+
+static inline uint32_t SDLogGet32(const uint8_t *pui8Buf)
+{
+    return (uint32_t)pui8Buf[0] | ((uint32_t)pui8Buf[1] << 8) |
+           ((uint32_t)pui8Buf[2] << 16) | ((uint32_t)pui8Buf[3] << 24);
+}
+
+#endif
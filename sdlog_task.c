@@ -0,0 +1,256 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// SD card data logger tasks
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "adc_api.h"
+#include "timestamp.h"
+#include "uart_log.h"
+#include "sd_spi.h"
+#include "sdlog.h"
+#include "sdlog_task.h"
+
+/******************************************************************************
+Description: two tasks run the logger of sdlog.c on the SD card.
+
+SDL follows the ADC frame ring like the telemetry task and compresses every
+frame into the write buffers. It runs above the sensor tasks because the
+ring only holds 32ms of frames, 8ms while the freeze frame holds a snapshot,
+and never touches the card.
+
+SDW sleeps until SDL has filled a buffer and writes it. It can block for
+tens of milliseconds while the card is busy, meanwhile SDL keeps filling the
+other buffer. Starting and closing a session also happen here.
+
+Stopping: the console sets SDLOG_STOP_REQ, SDL flushes the last frames and
+hands over to SDW, which writes them and closes the session.
+******************************************************************************/
+
+#define SDLOGTASKSTACKSIZE              128             // Stack size in words
+#define SDWRITETASKSTACKSIZE            160             // Stack size in words
+#define SDLOG_IDLE_POLL_MS              20
+
+#define SDLOG_IDLE                      0
+#define SDLOG_START_REQ                 1
+#define SDLOG_RUNNING                   2
+#define SDLOG_STOP_REQ                  3
+#define SDLOG_STOPPING                  4
+
+static const char * const g_ppcSDLogStates[] =
+{
+    "idle", "starting", "recording", "stopping", "stopping"
+};
+
+static volatile uint32_t g_ui32SDLogState = SDLOG_IDLE;
+static xSemaphoreHandle g_pSDLogWake;
+static bool g_bSDLogMounted = false;
+
+// frames the reader missed because it fell behind the ring
+static uint32_t g_ui32SDLogLost = 0;
+static uint32_t g_ui32SDLogWriteMaxUs = 0;
+static uint32_t g_ui32SDLogWriteTotalUs = 0;
+
+//*****************************************************************************
+//
+// Requests a new session. The caller must own the UART.
+//
+//*****************************************************************************
+void SDLogTaskStart(void)
+{
+    if(g_ui32SDLogState != SDLOG_IDLE)
+    {
+        UARTprintf("sdlog: busy\n");
+        return;
+    }
+
+    g_ui32SDLogState = SDLOG_START_REQ;
+    xSemaphoreGive(g_pSDLogWake);
+}
+
+//*****************************************************************************
+//
+// Requests the end of the running session.
+//
+//*****************************************************************************
+void SDLogTaskStop(void)
+{
+    if(g_ui32SDLogState == SDLOG_RUNNING)
+    {
+        g_ui32SDLogState = SDLOG_STOP_REQ;
+    }
+}
+
+//*****************************************************************************
+//
+// Prints the logger counters. The caller must own the UART.
+//
+//*****************************************************************************
+void SDLogTaskReport(void)
+{
+    const tSDLogStats *psStats = SDLogStats();
+
+    UARTprintf("sdlog: %s, session %u slot %u\n",
+               g_ppcSDLogStates[g_ui32SDLogState], psStats->ui32Session,
+               psStats->ui32Slot);
+    UARTprintf("frames %u records %u dropped %u lost %u\n",
+               psStats->ui32Frames, psStats->ui32Records,
+               psStats->ui32Dropped, g_ui32SDLogLost);
+    UARTprintf("blocks %u write errors %u, write time max %u us total %u ms\n",
+               psStats->ui32Blocks, psStats->ui32WriteErrors,
+               g_ui32SDLogWriteMaxUs, g_ui32SDLogWriteTotalUs / 1000);
+}
+
+//*****************************************************************************
+//
+// Collector task: compresses the ADC frames into the write buffers.
+//
+//*****************************************************************************
+static void SDLogTask(void *pvParameters)
+{
+    tADCFrame sFrame;
+    uint32_t ui32Seq = ADCFrameSeqGet(), ui32Expect;
+
+    while(1)
+    {
+        if(g_ui32SDLogState == SDLOG_STOP_REQ)
+        {
+            SDLogFlush();
+            g_ui32SDLogState = SDLOG_STOPPING;
+            xSemaphoreGive(g_pSDLogWake);
+        }
+
+        if(!SDLogActive())
+        {
+            vTaskDelay(SDLOG_IDLE_POLL_MS);
+            ui32Seq = ADCFrameSeqGet();
+            continue;
+        }
+
+        ui32Expect = ui32Seq;
+        while(ADCFrameRead(&ui32Seq, &sFrame))
+        {
+            if(sFrame.ui32Seq != ui32Expect)
+            {
+                g_ui32SDLogLost += sFrame.ui32Seq - ui32Expect;
+            }
+            ui32Expect = ui32Seq;
+            if(SDLogAddFrame(&sFrame))
+            {
+                xSemaphoreGive(g_pSDLogWake);
+            }
+        }
+
+        vTaskDelay(1);
+    }
+}
+
+//*****************************************************************************
+//
+// Opens a session, mounting the card first if needed.
+//
+//*****************************************************************************
+static void SDWriteStart(void)
+{
+    const tSDLogStats *psStats = SDLogStats();
+
+    if(!g_bSDLogMounted)
+    {
+        g_bSDLogMounted = (SDLogMount(&g_sSDCardStorage) == 0);
+    }
+
+    if(!g_bSDLogMounted || (SDLogSessionStart() != 0))
+    {
+        g_bSDLogMounted = false;
+        g_ui32SDLogState = SDLOG_IDLE;
+        LOG0(LOG_SDLOG_CARD_ERROR);
+        return;
+    }
+
+    g_ui32SDLogLost = 0;
+    g_ui32SDLogWriteMaxUs = 0;
+    g_ui32SDLogWriteTotalUs = 0;
+    g_ui32SDLogState = SDLOG_RUNNING;
+    LOG2(LOG_SDLOG_START, psStats->ui32Session, psStats->ui32Slot);
+}
+
+//*****************************************************************************
+//
+// Writer task: moves the filled buffers to the card.
+//
+//*****************************************************************************
+static void SDWriteTask(void *pvParameters)
+{
+    const tSDLogStats *psStats = SDLogStats();
+    uint32_t ui32Start, ui32Us;
+
+    if(SDLOG_AUTO_START)
+    {
+        g_ui32SDLogState = SDLOG_START_REQ;
+    }
+
+    while(1)
+    {
+        if(g_ui32SDLogState == SDLOG_START_REQ)
+        {
+            SDWriteStart();
+        }
+
+        while(1)
+        {
+            ui32Start = TimestampGet();
+            if(!SDLogWriteNext())
+            {
+                break;
+            }
+
+            ui32Us = TimestampCyclesToUs(TimestampGet() - ui32Start);
+            g_ui32SDLogWriteTotalUs += ui32Us;
+            if(ui32Us > g_ui32SDLogWriteMaxUs)
+            {
+                g_ui32SDLogWriteMaxUs = ui32Us;
+            }
+        }
+
+        if(g_ui32SDLogState == SDLOG_STOPPING)
+        {
+            SDLogSessionClose();
+            g_ui32SDLogState = SDLOG_IDLE;
+            LOG3(LOG_SDLOG_STOP, psStats->ui32Session, psStats->ui32Frames,
+                 psStats->ui32Blocks);
+        }
+
+        xSemaphoreTake(g_pSDLogWake, SDLOG_IDLE_POLL_MS);
+    }
+}
+
+//*****************************************************************************
+//
+// Initializes the logger tasks.
+//
+//*****************************************************************************
+uint32_t SDLogTaskInit(void)
+{
+    g_pSDLogWake = xSemaphoreCreateBinary();
+
+    if(xTaskCreate(SDLogTask, (const portCHAR *)"SDL", SDLOGTASKSTACKSIZE,
+                   NULL, tskIDLE_PRIORITY + PRIORITY_SDLOG_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    if(xTaskCreate(SDWriteTask, (const portCHAR *)"SDW", SDWRITETASKSTACKSIZE,
+                   NULL, tskIDLE_PRIORITY + PRIORITY_SDWRITE_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
@@ -0,0 +1,12 @@
+#ifndef SDLOG_TASK_H
+#define SDLOG_TASK_H
+
+// start a session at power up when a card is present
+#define SDLOG_AUTO_START                1
+
+void SDLogTaskStart(void);
+void SDLogTaskStop(void);
+void SDLogTaskReport(void);
+uint32_t SDLogTaskInit(void);
+
+#endif
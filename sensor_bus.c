@@ -0,0 +1,362 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Publish/subscribe of sensor data without copies or locks
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "sensor_bus.h"
+
+/******************************************************************************
+Description: the sequence number of a topic counts the slots published. Slot
+s lives at index s & ui32Mask until the producer starts on s + size, which it
+does as soon as the sequence number reaches s + size. A reader that used slot
+s is therefore fine as long as the sequence number, read after the use, is
+still below s + size. The reader reads the slot before the sequence number
+and the producer writes it after, the barriers keep the compiler and a
+weakly ordered host from reordering that. On the board the producer is
+mostly an interrupt handler that runs to the end once it preempted a
+reader, which is the same case.
+
+Only the producer writes the topic, only the reader its subscription, so
+there are no locks and no read-modify-write shared between them. Topics and
+subscriptions are registered before the tasks that use them run.
+
+SensorBusTopicSwap() moves the producer to new storage from the next slot
+on, ui32Base. The storage given up is not written any more and stays the
+previous storage, so a reader behind the swap finds its slots there. The
+readers take the storage pointers, ui32Base and the sequence number together
+as a view, under ui32Gen like a seqlock, and work out from the view where a
+slot lives and whether it is still there. A slot a reader looked up in one
+view is still the same in a later view only if the later view still has it:
+after one swap the slot has moved to the previous storage, where nothing
+writes, after two the previous storage starts behind it.
+******************************************************************************/
+
+typedef struct
+{
+    const uint8_t *pui8Slots;
+    const uint8_t *pui8PrevSlots;
+    uint32_t ui32Mask;
+    uint32_t ui32PrevMask;
+    uint32_t ui32Base;
+    uint32_t ui32Oldest;                // oldest slot a reader still finds
+    uint32_t ui32Seq;                   // next slot to publish
+}
+tSensorBusView;
+
+static tSensorBusTopic *g_psSensorBusTopics = NULL;
+
+//*****************************************************************************
+//
+// Initializes a topic on the slot array of its producer and adds it to the
+// list of "bus". The number of slots must be a power of two, one slot more
+// than the oldest a reader must still find.
+//
+//*****************************************************************************
+void SensorBusTopicRegister(tSensorBusTopic *psTopic, const char *pcName,
+                            void *pvSlots, uint32_t ui32SlotSize,
+                            uint32_t ui32NumSlots)
+{
+    psTopic->pcName = pcName;
+    psTopic->pui8Slots = (uint8_t *)pvSlots;
+    psTopic->ui32SlotSize = ui32SlotSize;
+    psTopic->ui32Mask = ui32NumSlots - 1;
+    psTopic->ui32Seq = 0;
+    psTopic->pui8PrevSlots = psTopic->pui8Slots;
+    psTopic->ui32PrevMask = psTopic->ui32Mask;
+    psTopic->ui32PrevFirst = 0;
+    psTopic->ui32Base = 0;
+    psTopic->ui32Gen = 0;
+    psTopic->psSubs = NULL;
+
+    psTopic->psNext = g_psSensorBusTopics;
+    g_psSensorBusTopics = psTopic;
+}
+
+//*****************************************************************************
+//
+// The registered topics, linked by psNext.
+//
+//*****************************************************************************
+tSensorBusTopic *SensorBusTopics(void)
+{
+    return g_psSensorBusTopics;
+}
+
+tSensorBusTopic *SensorBusFind(const char *pcName)
+{
+    tSensorBusTopic *psTopic;
+
+    for(psTopic = g_psSensorBusTopics; psTopic; psTopic = psTopic->psNext)
+    {
+        if(strcmp(psTopic->pcName, pcName) == 0)
+        {
+            return psTopic;
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// The sequence number of the next slot, where a new reader starts.
+//
+//*****************************************************************************
+uint32_t SensorBusSeqGet(const tSensorBusTopic *psTopic)
+{
+    return psTopic->ui32Seq;
+}
+
+//*****************************************************************************
+//
+// Moves the producer to the slots of pvSlots from the next sequence number
+// on and returns the slots it used so far, which keep what they hold. The
+// number of slots must be a power of two. Called by the producer only,
+// between two slots.
+//
+//*****************************************************************************
+void *SensorBusTopicSwap(tSensorBusTopic *psTopic, void *pvSlots,
+                         uint32_t ui32NumSlots)
+{
+    uint8_t *pui8Old = psTopic->pui8Slots;
+    uint32_t ui32Seq = psTopic->ui32Seq;
+    uint32_t ui32First;
+
+    // the storage given up keeps all of its slots, or those since its swap
+    if((ui32Seq - psTopic->ui32Base) > psTopic->ui32Mask)
+    {
+        ui32First = ui32Seq - psTopic->ui32Mask - 1;
+    }
+    else
+    {
+        ui32First = psTopic->ui32Base;
+    }
+
+    psTopic->ui32Gen++;
+    SENSOR_BUS_BARRIER();
+    psTopic->pui8PrevSlots = pui8Old;
+    psTopic->ui32PrevMask = psTopic->ui32Mask;
+    psTopic->ui32PrevFirst = ui32First;
+    psTopic->pui8Slots = (uint8_t *)pvSlots;
+    psTopic->ui32Mask = ui32NumSlots - 1;
+    psTopic->ui32Base = ui32Seq;
+    SENSOR_BUS_BARRIER();
+    psTopic->ui32Gen++;
+
+    return pui8Old;
+}
+
+//*****************************************************************************
+//
+// The slot of a sequence number the producer published into its current
+// storage, for the producer only.
+//
+//*****************************************************************************
+const void *SensorBusSlotGet(const tSensorBusTopic *psTopic,
+                             uint32_t ui32Seq)
+{
+    return &psTopic->pui8Slots[(ui32Seq & psTopic->ui32Mask) *
+                               psTopic->ui32SlotSize];
+}
+
+static void SensorBusViewGet(const tSensorBusTopic *psTopic,
+                             tSensorBusView *psView)
+{
+    uint32_t ui32Gen, ui32PrevFirst;
+
+    do
+    {
+        ui32Gen = psTopic->ui32Gen;
+        SENSOR_BUS_BARRIER();
+        psView->pui8Slots = psTopic->pui8Slots;
+        psView->pui8PrevSlots = psTopic->pui8PrevSlots;
+        psView->ui32Mask = psTopic->ui32Mask;
+        psView->ui32PrevMask = psTopic->ui32PrevMask;
+        psView->ui32Base = psTopic->ui32Base;
+        psView->ui32Seq = psTopic->ui32Seq;
+        ui32PrevFirst = psTopic->ui32PrevFirst;
+        SENSOR_BUS_BARRIER();
+    }
+    while((ui32Gen & 1) || (ui32Gen != psTopic->ui32Gen));
+
+    // slots from before the swap count until the producer comes round to
+    // the swap in the current storage
+    if((psView->ui32Seq - psView->ui32Base) > psView->ui32Mask)
+    {
+        psView->ui32Oldest = psView->ui32Seq - psView->ui32Mask;
+    }
+    else
+    {
+        psView->ui32Oldest = ui32PrevFirst;
+    }
+}
+
+static bool SensorBusViewHas(const tSensorBusView *psView, uint32_t ui32Seq)
+{
+    return (ui32Seq - psView->ui32Oldest) <
+           (psView->ui32Seq - psView->ui32Oldest);
+}
+
+static const void *SensorBusViewSlot(const tSensorBusView *psView,
+                                     uint32_t ui32Seq, uint32_t ui32SlotSize)
+{
+    if((int32_t)(ui32Seq - psView->ui32Base) >= 0)
+    {
+        return &psView->pui8Slots[(ui32Seq & psView->ui32Mask) *
+                                  ui32SlotSize];
+    }
+
+    return &psView->pui8PrevSlots[(ui32Seq & psView->ui32PrevMask) *
+                                  ui32SlotSize];
+}
+
+//*****************************************************************************
+//
+// Returns the newest slot and its sequence number, NULL before the first.
+// The slot is used in place, SensorBusValid() tells afterwards whether it
+// was still the same.
+//
+//*****************************************************************************
+const void *SensorBusLatest(const tSensorBusTopic *psTopic,
+                            uint32_t *pui32Seq)
+{
+    tSensorBusView sView;
+
+    SensorBusViewGet(psTopic, &sView);
+
+    if(sView.ui32Seq == 0)
+    {
+        return NULL;
+    }
+
+    *pui32Seq = sView.ui32Seq - 1;
+
+    return SensorBusViewSlot(&sView, sView.ui32Seq - 1,
+                             psTopic->ui32SlotSize);
+}
+
+bool SensorBusValid(const tSensorBusTopic *psTopic, uint32_t ui32Seq)
+{
+    tSensorBusView sView;
+
+    SensorBusViewGet(psTopic, &sView);
+
+    return SensorBusViewHas(&sView, ui32Seq);
+}
+
+//*****************************************************************************
+//
+// Copies the newest slot, for interrupt handlers that only need the current
+// readings. Returns false before the first.
+//
+//*****************************************************************************
+bool SensorBusLatestRead(const tSensorBusTopic *psTopic, void *pvDest)
+{
+    const void *pvSlot;
+    uint32_t ui32Seq;
+
+    do
+    {
+        pvSlot = SensorBusLatest(psTopic, &ui32Seq);
+        if(!pvSlot)
+        {
+            return false;
+        }
+
+        memcpy(pvDest, pvSlot, psTopic->ui32SlotSize);
+    }
+    while(!SensorBusValid(psTopic, ui32Seq));
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Adds a reader to a topic. It starts with the next slot published.
+//
+//*****************************************************************************
+void SensorBusSubscribe(tSensorBusSub *psSub, tSensorBusTopic *psTopic,
+                        const char *pcName)
+{
+    psSub->pcName = pcName;
+    psSub->psTopic = psTopic;
+    psSub->ui32Seq = psTopic->ui32Seq;
+    psSub->ui32Reads = 0;
+    psSub->ui32Lost = 0;
+
+    psSub->psNext = psTopic->psSubs;
+    psTopic->psSubs = psSub;
+}
+
+//*****************************************************************************
+//
+// Returns the next unread slot of the reader, NULL if there is none. A
+// reader a whole ring behind skips to the oldest slot the producer is not
+// about to overwrite.
+//
+//*****************************************************************************
+const void *SensorBusPeek(tSensorBusSub *psSub)
+{
+    tSensorBusView sView;
+
+    SensorBusViewGet(psSub->psTopic, &sView);
+
+    if(sView.ui32Seq == psSub->ui32Seq)
+    {
+        return NULL;
+    }
+
+    if(!SensorBusViewHas(&sView, psSub->ui32Seq))
+    {
+        psSub->ui32Lost += sView.ui32Oldest - psSub->ui32Seq;
+        psSub->ui32Seq = sView.ui32Oldest;
+    }
+
+    return SensorBusViewSlot(&sView, psSub->ui32Seq,
+                             psSub->psTopic->ui32SlotSize);
+}
+
+//*****************************************************************************
+//
+// Ends the use of the slot of SensorBusPeek(). Returns true and moves on if
+// the slot stayed the same throughout, false if the producer overwrote it.
+// The next SensorBusPeek() then skips ahead and counts it as lost.
+//
+//*****************************************************************************
+bool SensorBusDone(tSensorBusSub *psSub)
+{
+    if(!SensorBusValid(psSub->psTopic, psSub->ui32Seq))
+    {
+        return false;
+    }
+
+    psSub->ui32Seq++;
+    psSub->ui32Reads++;
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Copies the next unread slot. Returns false when there is none.
+//
+//*****************************************************************************
+bool SensorBusRead(tSensorBusSub *psSub, void *pvDest)
+{
+    const void *pvSlot;
+
+    while((pvSlot = SensorBusPeek(psSub)) != NULL)
+    {
+        memcpy(pvDest, pvSlot, psSub->psTopic->ui32SlotSize);
+        if(SensorBusDone(psSub))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,119 @@
+//*****************************************************************************
+//
+// sensor_bus.h - Publish/subscribe of sensor data without copies or locks.
+//
+// Plain C without target dependencies, also built into the host tools.
+// A topic is a ring of fixed size slots with one producer, a task or an
+// interrupt handler. The producer fills the next slot in place and
+// publishes it by advancing the sequence number of the topic; it never
+// waits for the readers. Any number of readers use the slots in place and
+// check afterwards that the producer did not come round to the slot in the
+// meantime, like the reader of a seqlock:
+//
+//   psFrame = SensorBusPeek(&sSub);        // next unread slot, or NULL
+//   ... use *psFrame ...
+//   if(!SensorBusDone(&sSub))              // overwritten while in use,
+//   {                                      // throw the result away
+//   }
+//
+// A reader that cannot throw away what it did copies the slot with
+// SensorBusRead() instead. A reader that falls behind by a whole ring skips
+// to the oldest slot still there and counts the slots it lost.
+//
+// The producer can move a topic to other slot storage with
+// SensorBusTopicSwap(), to keep the slots it published so far, see
+// freeze_frame.c. The readers carry on across the swap without noticing.
+//
+//*****************************************************************************
+
+#ifndef SENSOR_BUS_H
+#define SENSOR_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__ARMCC_VERSION)
+#define SENSOR_BUS_BARRIER()    __schedule_barrier()
+#elif defined(__GNUC__)
+#define SENSOR_BUS_BARRIER()    __sync_synchronize()
+#else
+#define SENSOR_BUS_BARRIER()
+#endif
+
+struct tSensorBusTopic;
+
+typedef struct tSensorBusSub
+{
+    const char *pcName;
+    struct tSensorBusTopic *psTopic;
+    uint32_t ui32Seq;                   // next slot to read
+    uint32_t ui32Reads;
+    uint32_t ui32Lost;                  // skipped or overwritten in use
+
+    struct tSensorBusSub *psNext;
+}
+tSensorBusSub;
+
+typedef struct tSensorBusTopic
+{
+    const char *pcName;
+    uint8_t *pui8Slots;
+    uint32_t ui32SlotSize;
+    uint32_t ui32Mask;                  // number of slots - 1
+    volatile uint32_t ui32Seq;          // next slot to publish
+
+    // storage before the last SensorBusTopicSwap()
+    uint8_t *pui8PrevSlots;
+    uint32_t ui32PrevMask;
+    uint32_t ui32PrevFirst;             // oldest slot left in pui8PrevSlots
+    uint32_t ui32Base;                  // first slot in pui8Slots
+    volatile uint32_t ui32Gen;          // odd while swapping
+
+    tSensorBusSub *psSubs;
+    struct tSensorBusTopic *psNext;
+}
+tSensorBusTopic;
+
+//*****************************************************************************
+//
+// Producer side, inline for the interrupt handlers. SensorBusPublishBegin()
+// returns the slot of the next sequence number, SensorBusPublishEnd() makes
+// it visible. Only one producer per topic.
+//
+//*****************************************************************************
+static inline void *SensorBusPublishBegin(tSensorBusTopic *psTopic)
+{
+    SENSOR_BUS_BARRIER();
+    return &psTopic->pui8Slots[(psTopic->ui32Seq & psTopic->ui32Mask) *
+                               psTopic->ui32SlotSize];
+}
+
+static inline void SensorBusPublishEnd(tSensorBusTopic *psTopic)
+{
+    SENSOR_BUS_BARRIER();
+    psTopic->ui32Seq++;
+}
+
+void SensorBusTopicRegister(tSensorBusTopic *psTopic, const char *pcName,
+                            void *pvSlots, uint32_t ui32SlotSize,
+                            uint32_t ui32NumSlots);
+void *SensorBusTopicSwap(tSensorBusTopic *psTopic, void *pvSlots,
+                         uint32_t ui32NumSlots);
+const void *SensorBusSlotGet(const tSensorBusTopic *psTopic,
+                             uint32_t ui32Seq);
+tSensorBusTopic *SensorBusTopics(void);
+tSensorBusTopic *SensorBusFind(const char *pcName);
+uint32_t SensorBusSeqGet(const tSensorBusTopic *psTopic);
+
+const void *SensorBusLatest(const tSensorBusTopic *psTopic,
+                            uint32_t *pui32Seq);
+bool SensorBusValid(const tSensorBusTopic *psTopic, uint32_t ui32Seq);
+bool SensorBusLatestRead(const tSensorBusTopic *psTopic, void *pvDest);
+
+void SensorBusSubscribe(tSensorBusSub *psSub, tSensorBusTopic *psTopic,
+                        const char *pcName);
+const void *SensorBusPeek(tSensorBusSub *psSub);
+bool SensorBusDone(tSensorBusSub *psSub);
+bool SensorBusRead(tSensorBusSub *psSub, void *pvDest);
+
+#endif
@@ -0,0 +1,367 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Diagnostics of the analog sensor inputs
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "sensor_diag.h"
+
+/******************************************************************************
+Description: SensorDiagProcess() is called from the ADC interrupt with every
+frame, after the CAN event triggers. All statistics are updated in place with
+a fixed number of operations per channel, there is no window of past samples
+to walk: the stuck check keeps a reference value and a frame counter, the
+noise check an exponential mean, the rate check the previous reading.
+
+The checks only look at the raw readings, so they work the same with any
+calibration. The thresholds of each channel are in a tSensorDiagConfig that
+may only be changed before the ADC starts.
+
+Clearing the history is a request taken by the next frame, the interrupt is
+the only writer of the diagnostic state.
+******************************************************************************/
+
+//*****************************************************************************
+//
+// Defaults for 0.5V..4.5V ratiometric sensors behind the 5V to 3.3V divider,
+// 410..3686 counts. The noise limit is a deviation of 48 counts, the stuck
+// time 1s and the debounce 10ms to set, 100ms to clear.
+//
+//*****************************************************************************
+#define SENSOR_DIAG_FRAMES(ms)          (((ms) * ADC_SAMPLE_RATE_HZ) / 1000)
+
+static const tSensorDiagConfig g_sSensorDiagDefault =
+{
+    100,                                // open below
+    4000,                               // short above
+    0,                                  // stuck band
+    600,                                // rate limit
+    SENSOR_DIAG_FRAMES(1000),           // stuck frames
+    SENSOR_DIAG_NOISE_LIMIT(48),
+    {
+        SENSOR_DIAG_FRAMES(10),         // open
+        SENSOR_DIAG_FRAMES(10),         // short
+        1,                              // stuck, the check has its own time
+        SENSOR_DIAG_FRAMES(10),         // noise
+        SENSOR_DIAG_FRAMES(5),          // rate
+    },
+    SENSOR_DIAG_FRAMES(100),            // pass frames
+    (1 << SENSOR_DIAG_NUM_TYPES) - 1,   // all checks
+};
+
+const char * const g_ppcSensorDiagNames[SENSOR_DIAG_NUM_TYPES] =
+{
+    "open", "short", "stuck", "noise", "rate"
+};
+
+typedef struct
+{
+    uint16_t ui16Prev;                  // x[n-1]
+    uint16_t ui16Prev2;                 // x[n-2]
+    uint16_t ui16StuckRef;
+    uint16_t ui16Frames;                // frames seen, up to 2
+    uint16_t ui16RateHold;              // frames left failing the rate check
+    uint32_t ui32StuckCount;
+    uint32_t ui32NoiseEma;
+    uint16_t pui16Debounce[SENSOR_DIAG_NUM_TYPES];
+}
+tSensorDiagChannel;
+
+static tSensorDiagConfig g_psSensorDiagConfig[ADC_NUM_CHANNELS];
+static tSensorDiagChannel g_psSensorDiagState[ADC_NUM_CHANNELS];
+static tSensorDiagRecord g_ppsSensorDiagRecords[ADC_NUM_CHANNELS]
+                                               [SENSOR_DIAG_NUM_TYPES];
+
+static volatile uint32_t g_ui32SensorDiagActive;
+static volatile uint32_t g_ui32SensorDiagHistory;
+static volatile uint32_t g_ui32SensorDiagClearReq;
+static uint32_t g_ui32SensorDiagClearAck;
+
+//*****************************************************************************
+//
+// Resets the state and loads the default thresholds on all channels.
+//
+//*****************************************************************************
+void SensorDiagInit(void)
+{
+    uint32_t ui32Ch, ui32Type;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        g_psSensorDiagConfig[ui32Ch] = g_sSensorDiagDefault;
+        g_psSensorDiagState[ui32Ch].ui16Frames = 0;
+        for(ui32Type = 0; ui32Type < SENSOR_DIAG_NUM_TYPES; ui32Type++)
+        {
+            g_psSensorDiagState[ui32Ch].pui16Debounce[ui32Type] = 0;
+            g_ppsSensorDiagRecords[ui32Ch][ui32Type].ui32Count = 0;
+        }
+    }
+
+    g_ui32SensorDiagActive = 0;
+    g_ui32SensorDiagHistory = 0;
+    g_ui32SensorDiagClearAck = g_ui32SensorDiagClearReq;
+}
+
+void SensorDiagConfigSet(uint32_t ui32Ch, const tSensorDiagConfig *psConfig)
+{
+    if(ui32Ch < ADC_NUM_CHANNELS)
+    {
+        g_psSensorDiagConfig[ui32Ch] = *psConfig;
+    }
+}
+
+const tSensorDiagConfig *SensorDiagConfigGet(uint32_t ui32Ch)
+{
+    return (ui32Ch < ADC_NUM_CHANNELS) ? &g_psSensorDiagConfig[ui32Ch] : NULL;
+}
+
+//*****************************************************************************
+//
+// Debounces one check result. The counter holds the progress towards the
+// other state: failing frames count up to set an inactive DTC, passing frames
+// count up to clear an active one, frames agreeing with the state count it
+// back down. Returns the new DTC state.
+//
+//*****************************************************************************
+static bool SensorDiagDebounce(const tSensorDiagConfig *psConfig,
+                               uint32_t ui32Type, uint16_t *pui16Counter,
+                               bool bActive, bool bFail)
+{
+    if(bFail == bActive)
+    {
+        if(*pui16Counter)
+        {
+            (*pui16Counter)--;
+        }
+        return bActive;
+    }
+
+    if(++(*pui16Counter) < (bActive ? psConfig->ui16PassFrames :
+                                      psConfig->pui16FailFrames[ui32Type]))
+    {
+        return bActive;
+    }
+
+    *pui16Counter = 0;
+
+    return !bActive;
+}
+
+//*****************************************************************************
+//
+// Runs the checks of all channels on one frame.
+//
+//*****************************************************************************
+void SensorDiagProcess(const tADCFrame *psFrame)
+{
+    const tSensorDiagConfig *psConfig;
+    tSensorDiagChannel *psState;
+    tSensorDiagRecord *psRecord;
+    uint32_t ui32Ch, ui32Type, ui32Bit, ui32Active, ui32New, ui32Fails;
+    uint32_t ui32Value, ui32Step, ui32Square;
+    int32_t i32Diff2;
+
+    //
+    // A clear request from a task: forget the history, keep what is active.
+    //
+    if(g_ui32SensorDiagClearReq != g_ui32SensorDiagClearAck)
+    {
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            for(ui32Type = 0; ui32Type < SENSOR_DIAG_NUM_TYPES; ui32Type++)
+            {
+                g_ppsSensorDiagRecords[ui32Ch][ui32Type].ui32Count = 0;
+            }
+        }
+        g_ui32SensorDiagHistory = g_ui32SensorDiagActive;
+        g_ui32SensorDiagClearAck = g_ui32SensorDiagClearReq;
+    }
+
+    ui32Active = g_ui32SensorDiagActive;
+    ui32New = 0;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        psConfig = &g_psSensorDiagConfig[ui32Ch];
+        psState = &g_psSensorDiagState[ui32Ch];
+        ui32Value = psFrame->pui16Data[ui32Ch];
+        ui32Fails = 0;
+
+        //
+        // Open and short against the rails.
+        //
+        if(ui32Value < psConfig->ui16OpenBelow)
+        {
+            ui32Fails |= 1 << SENSOR_DIAG_OPEN;
+        }
+        if(ui32Value > psConfig->ui16ShortAbove)
+        {
+            ui32Fails |= 1 << SENSOR_DIAG_SHORT;
+        }
+
+        if(psState->ui16Frames < 2)
+        {
+            //
+            // Not enough history for the differences yet.
+            //
+            psState->ui16Prev2 = psState->ui16Prev;
+            psState->ui16Prev = (uint16_t)ui32Value;
+            psState->ui16StuckRef = (uint16_t)ui32Value;
+            psState->ui32StuckCount = 0;
+            psState->ui32NoiseEma = 0;
+            psState->ui16RateHold = 0;
+            psState->ui16Frames++;
+        }
+        else
+        {
+            //
+            // Stuck: frames since the reading last left the band around the
+            // reference.
+            //
+            ui32Step = (ui32Value > psState->ui16StuckRef) ?
+                       (ui32Value - psState->ui16StuckRef) :
+                       (psState->ui16StuckRef - ui32Value);
+            if(ui32Step > psConfig->ui16StuckBand)
+            {
+                psState->ui16StuckRef = (uint16_t)ui32Value;
+                psState->ui32StuckCount = 0;
+            }
+            else if(psState->ui32StuckCount < psConfig->ui32StuckFrames)
+            {
+                psState->ui32StuckCount++;
+            }
+            if(psState->ui32StuckCount >= psConfig->ui32StuckFrames)
+            {
+                ui32Fails |= 1 << SENSOR_DIAG_STUCK;
+            }
+
+            //
+            // Noise: exponential mean of the squared second difference.
+            //
+            i32Diff2 = (int32_t)ui32Value - (2 * (int32_t)psState->ui16Prev) +
+                       (int32_t)psState->ui16Prev2;
+            ui32Square = (uint32_t)(i32Diff2 * i32Diff2) <<
+                         SENSOR_DIAG_NOISE_FRAC;
+            if(ui32Square > (4 * psConfig->ui32NoiseLimit))
+            {
+                ui32Square = 4 * psConfig->ui32NoiseLimit;
+            }
+            psState->ui32NoiseEma +=
+                (int32_t)(ui32Square - psState->ui32NoiseEma) >>
+                SENSOR_DIAG_NOISE_SHIFT;
+            if(psState->ui32NoiseEma > psConfig->ui32NoiseLimit)
+            {
+                ui32Fails |= 1 << SENSOR_DIAG_NOISE;
+            }
+
+            //
+            // Rate of change between two frames.
+            //
+            ui32Step = (ui32Value > psState->ui16Prev) ?
+                       (ui32Value - psState->ui16Prev) :
+                       (psState->ui16Prev - ui32Value);
+            if(ui32Step > psConfig->ui16RateLimit)
+            {
+                psState->ui16RateHold = SENSOR_DIAG_RATE_HOLD;
+            }
+            else if(psState->ui16RateHold)
+            {
+                psState->ui16RateHold--;
+            }
+            if(psState->ui16RateHold)
+            {
+                ui32Fails |= 1 << SENSOR_DIAG_RATE;
+            }
+
+            psState->ui16Prev2 = psState->ui16Prev;
+            psState->ui16Prev = (uint16_t)ui32Value;
+        }
+
+        //
+        // Debounce into DTCs.
+        //
+        ui32Fails &= psConfig->ui16Types;
+        for(ui32Type = 0; ui32Type < SENSOR_DIAG_NUM_TYPES; ui32Type++)
+        {
+            ui32Bit = SENSOR_DIAG_DTC(ui32Ch, ui32Type);
+            if(SensorDiagDebounce(psConfig, ui32Type,
+                                  &psState->pui16Debounce[ui32Type],
+                                  (ui32Active & ui32Bit) != 0,
+                                  (ui32Fails & (1 << ui32Type)) != 0))
+            {
+                if(!(ui32Active & ui32Bit))
+                {
+                    ui32New |= ui32Bit;
+                    psRecord = &g_ppsSensorDiagRecords[ui32Ch][ui32Type];
+                    if(psRecord->ui32Count++ == 0)
+                    {
+                        psRecord->ui32FirstSeq = psFrame->ui32Seq;
+                    }
+                    psRecord->ui32LastSeq = psFrame->ui32Seq;
+                }
+                ui32Active |= ui32Bit;
+            }
+            else
+            {
+                ui32Active &= ~ui32Bit;
+            }
+        }
+    }
+
+    g_ui32SensorDiagActive = ui32Active;
+    g_ui32SensorDiagHistory |= ui32New;
+}
+
+//*****************************************************************************
+//
+// DTCs active now and DTCs that were active since the last clear.
+//
+//*****************************************************************************
+uint32_t SensorDiagActive(void)
+{
+    return g_ui32SensorDiagActive;
+}
+
+uint32_t SensorDiagHistory(void)
+{
+    return g_ui32SensorDiagHistory;
+}
+
+const tSensorDiagRecord *SensorDiagRecord(uint32_t ui32Ch, uint32_t ui32Type)
+{
+    if((ui32Ch >= ADC_NUM_CHANNELS) || (ui32Type >= SENSOR_DIAG_NUM_TYPES))
+    {
+        return NULL;
+    }
+
+    return &g_ppsSensorDiagRecords[ui32Ch][ui32Type];
+}
+
+//*****************************************************************************
+//
+// The noise statistic of a channel as a deviation estimate in counts squared.
+//
+//*****************************************************************************
+uint32_t SensorDiagNoise(uint32_t ui32Ch)
+{
+    if(ui32Ch >= ADC_NUM_CHANNELS)
+    {
+        return 0;
+    }
+
+    return (g_psSensorDiagState[ui32Ch].ui32NoiseEma >>
+            SENSOR_DIAG_NOISE_FRAC) / 6;
+}
+
+//*****************************************************************************
+//
+// Asks the interrupt to clear the history with the next frame.
+//
+//*****************************************************************************
+void SensorDiagClear(void)
+{
+    g_ui32SensorDiagClearReq++;
+}
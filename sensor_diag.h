@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+// sensor_diag.h - Diagnostics of the analog sensor inputs.
+//
+// Plain C without target dependencies, also built into the host tools.
+// SensorDiagProcess() runs four checks per channel on every ADC frame and
+// turns them into diagnostic trouble codes (DTCs):
+//
+//   open       reading below ui16OpenBelow, broken wire or lost supply
+//   short      reading above ui16ShortAbove, signal shorted to the supply
+//   stuck      reading within +-ui16StuckBand of one value for
+//              ui32StuckFrames frames, a frozen sensor or converter
+//   noise      mean square of the second difference above ui32NoiseLimit,
+//              a loose contact or coupled interference
+//   rate       steps between two frames above ui16RateLimit, faster than
+//              the sensor can move, less than SENSOR_DIAG_RATE_HOLD frames
+//              apart
+//
+// Every check feeds an up/down counter per DTC. An inactive DTC is set after
+// pui16FailFrames[type] more failing than passing frames, an active one is
+// cleared after ui16PassFrames more passing than failing frames, so a single
+// bad frame does not set it and a single good frame does not clear it.
+//
+//*****************************************************************************
+
+#ifndef SENSOR_DIAG_H
+#define SENSOR_DIAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "adc_api.h"
+
+//*****************************************************************************
+//
+// DTC types. The DTC bit of a channel is SENSOR_DIAG_DTC(ch, type), four
+// channels of five types fit the low 20 bits.
+//
+//*****************************************************************************
+#define SENSOR_DIAG_OPEN                0
+#define SENSOR_DIAG_SHORT               1
+#define SENSOR_DIAG_STUCK               2
+#define SENSOR_DIAG_NOISE               3
+#define SENSOR_DIAG_RATE                4
+#define SENSOR_DIAG_NUM_TYPES           5
+
+#define SENSOR_DIAG_DTC(ch, type)       (1 << (((ch) * SENSOR_DIAG_NUM_TYPES) + \
+                                               (type)))
+
+//*****************************************************************************
+//
+// The noise statistic is an exponential mean of the squared second
+// difference x[n] - 2x[n-1] + x[n-2], which removes the slow movement of the
+// sensor. For white noise of deviation s it averages 6 s^2. It is kept with
+// SENSOR_DIAG_NOISE_FRAC fraction bits and follows over 2^SENSOR_DIAG_NOISE_SHIFT
+// frames. One frame adds at most four times the limit, so a single step of
+// the reading does not look like noise.
+//
+//*****************************************************************************
+#define SENSOR_DIAG_NOISE_SHIFT         6
+#define SENSOR_DIAG_NOISE_FRAC          4
+#define SENSOR_DIAG_NOISE_LIMIT(s)      ((uint32_t)(6 * (s) * (s)) << \
+                                         SENSOR_DIAG_NOISE_FRAC)
+
+//*****************************************************************************
+//
+// A step above the rate limit fails the rate check for SENSOR_DIAG_RATE_HOLD
+// frames. One spike, a step out and a step back, is shorter than the rate
+// debounce, repeated spikes keep the check failing.
+//
+//*****************************************************************************
+#define SENSOR_DIAG_RATE_HOLD           32
+
+typedef struct
+{
+    uint16_t ui16OpenBelow;             // raw counts
+    uint16_t ui16ShortAbove;            // raw counts
+    uint16_t ui16StuckBand;             // raw counts
+    uint16_t ui16RateLimit;             // raw counts per frame
+    uint32_t ui32StuckFrames;
+    uint32_t ui32NoiseLimit;            // SENSOR_DIAG_NOISE_LIMIT(deviation)
+    uint16_t pui16FailFrames[SENSOR_DIAG_NUM_TYPES];  // debounce to set
+    uint16_t ui16PassFrames;            // debounce to clear a DTC
+    uint16_t ui16Types;                 // checks enabled, 1 << type
+}
+tSensorDiagConfig;
+
+typedef struct
+{
+    uint32_t ui32Count;                 // times the DTC became active
+    uint32_t ui32FirstSeq;              // frame of the first activation
+    uint32_t ui32LastSeq;               // frame of the last activation
+}
+tSensorDiagRecord;
+
+void SensorDiagInit(void);
+void SensorDiagConfigSet(uint32_t ui32Ch, const tSensorDiagConfig *psConfig);
+const tSensorDiagConfig *SensorDiagConfigGet(uint32_t ui32Ch);
+void SensorDiagProcess(const tADCFrame *psFrame);
+uint32_t SensorDiagActive(void);
+uint32_t SensorDiagHistory(void);
+const tSensorDiagRecord *SensorDiagRecord(uint32_t ui32Ch, uint32_t ui32Type);
+uint32_t SensorDiagNoise(uint32_t ui32Ch);
+void SensorDiagClear(void);
+
+extern const char * const g_ppcSensorDiagNames[SENSOR_DIAG_NUM_TYPES];
+
+#endif
@@ -14,8 +14,11 @@ their readings. Readings are stored into a 32-bits array with their location
 from 0 to 3 as follows:
 
 Sensor 1: Analog 0-5V Throttle Sensor 				connected to PE3 on AIN0 working
-Sensor 2: Analog 0-5V Break Pressure Sensor 	connected to PE1 on AIN2 not working
+Sensor 2: Analog 0-5V Break Pressure Sensor 	connected to PE2 on AIN1 working
 Sensor 3: Analog 0-5V Steering Sensor 				connected to PD1 on AIN6 working
+
+The frame channels of the three are ADC_CH_THROTTLE, ADC_CH_BRAKE and
+ADC_CH_STEERING in adc_api.h.
 ******************************************************************************/
 void ThrottleSensorInit(void)
 {
@@ -24,7 +27,7 @@ void ThrottleSensorInit(void)
 
 uint32_t ThrottleSensorGetValue(void)
 {
-	return ADCGetSensor2();
+	return ADCGetSensor1();
 }
 
 
@@ -1,7 +1,6 @@
 #ifndef	SENSORS_H
 #define	SENSORS_H
 
-
 void ThrottleSensorInit(void);
 uint32_t ThrottleSensorGetValue(void);
 
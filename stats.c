@@ -0,0 +1,350 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Streaming statistics of the ADC channels
+//
+// Plain C without target dependencies, also built into the host tools.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "stats.h"
+
+/******************************************************************************
+Description: the ADC interrupt hands every STATS_BLOCK_FRAMES frames to
+StatsProcessFrames() straight from the frame ring, one block kernel pass per
+channel with the frame size as stride. Each channel has a ring of STATS_SLOTS
+accumulators for the rolling window and one for everything since the last
+reset. A slot that is full is merged into the total and the oldest slot is
+reused, so the window moves in steps of one slot.
+
+Only the interrupt writes the accumulators. It increments g_ui32StatsVersion
+before and after an update; a reader copies what it needs and starts again
+if the version changed meanwhile. Window changes and resets are requests
+taken by the next block.
+
+The block sums of one channel are kept in 32 bits, StatsBlockUpdate() takes
+at most 2^19 samples at a time.
+******************************************************************************/
+
+#define STATS_FRAME_STRIDE              (sizeof(tADCFrame) / sizeof(uint16_t))
+
+static tStatsAccum g_ppsStatsSlots[ADC_NUM_CHANNELS][STATS_SLOTS];
+static tStatsAccum g_psStatsTotal[ADC_NUM_CHANNELS];
+static uint32_t g_ui32StatsSlot;                // slot being filled
+static uint32_t g_ui32StatsSlotFrames;          // frames in it
+static uint32_t g_ui32StatsSlotLength;          // frames per slot
+
+static volatile uint32_t g_ui32StatsVersion;
+static volatile uint32_t g_ui32StatsWindowMs = STATS_DEFAULT_WINDOW_MS;
+static volatile uint32_t g_ui32StatsResetReq;
+static uint32_t g_ui32StatsResetAck;
+
+void StatsAccumReset(tStatsAccum *psAccum)
+{
+    psAccum->ui32Count = 0;
+    psAccum->ui16Min = 0xFFFF;
+    psAccum->ui16Max = 0;
+    psAccum->i32Shift = 0;
+    psAccum->i64Sum = 0;
+    psAccum->ui64SumSq = 0;
+}
+
+//*****************************************************************************
+//
+// Adds ui32Count samples, ui32Stride samples apart, to an accumulator.
+//
+//*****************************************************************************
+void StatsBlockUpdate(tStatsAccum *psAccum, const uint16_t *pui16Samples,
+                      uint32_t ui32Stride, uint32_t ui32Count)
+{
+    uint32_t ui32Min = psAccum->ui16Min, ui32Max = psAccum->ui16Max;
+    uint32_t ui32Idx, ui32Value;
+    int32_t i32Shift, i32Diff, i32Sum = 0;
+    uint64_t ui64SumSq = 0;
+
+    if(ui32Count == 0)
+    {
+        return;
+    }
+    if(psAccum->ui32Count == 0)
+    {
+        psAccum->i32Shift = pui16Samples[0];
+    }
+    i32Shift = psAccum->i32Shift;
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        ui32Value = *pui16Samples;
+        pui16Samples += ui32Stride;
+
+        i32Diff = (int32_t)ui32Value - i32Shift;
+        i32Sum += i32Diff;
+        ui64SumSq += (uint32_t)(i32Diff * i32Diff);
+        ui32Min = (ui32Value < ui32Min) ? ui32Value : ui32Min;
+        ui32Max = (ui32Value > ui32Max) ? ui32Value : ui32Max;
+    }
+
+    psAccum->ui32Count += ui32Count;
+    psAccum->ui16Min = (uint16_t)ui32Min;
+    psAccum->ui16Max = (uint16_t)ui32Max;
+    psAccum->i64Sum += i32Sum;
+    psAccum->ui64SumSq += ui64SumSq;
+}
+
+//*****************************************************************************
+//
+// Moves the sums of an accumulator to another shift, exactly:
+// sum (d + c) = S + n c, sum (d + c)^2 = Q + 2 c S + n c^2.
+//
+//*****************************************************************************
+static void StatsRebase(tStatsAccum *psAccum, int32_t i32Shift)
+{
+    int64_t i64Delta = (int64_t)psAccum->i32Shift - i32Shift;
+
+    psAccum->ui64SumSq += (uint64_t)((2 * i64Delta * psAccum->i64Sum) +
+                                     ((int64_t)psAccum->ui32Count *
+                                      i64Delta * i64Delta));
+    psAccum->i64Sum += (int64_t)psAccum->ui32Count * i64Delta;
+    psAccum->i32Shift = i32Shift;
+}
+
+//*****************************************************************************
+//
+// Adds the samples of one accumulator to another.
+//
+//*****************************************************************************
+void StatsMerge(tStatsAccum *psInto, const tStatsAccum *psFrom)
+{
+    tStatsAccum sFrom;
+
+    if(psFrom->ui32Count == 0)
+    {
+        return;
+    }
+    if(psInto->ui32Count == 0)
+    {
+        *psInto = *psFrom;
+        return;
+    }
+
+    sFrom = *psFrom;
+    StatsRebase(&sFrom, psInto->i32Shift);
+
+    psInto->ui32Count += sFrom.ui32Count;
+    psInto->ui16Min = (sFrom.ui16Min < psInto->ui16Min) ? sFrom.ui16Min :
+                      psInto->ui16Min;
+    psInto->ui16Max = (sFrom.ui16Max > psInto->ui16Max) ? sFrom.ui16Max :
+                      psInto->ui16Max;
+    psInto->i64Sum += sFrom.i64Sum;
+    psInto->ui64SumSq += sFrom.ui64SumSq;
+}
+
+//*****************************************************************************
+//
+// Forms mean and sample variance. The sums are first moved to a shift next
+// to the mean so the square of the sum stays small.
+//
+//*****************************************************************************
+void StatsAccumResult(const tStatsAccum *psAccum, tStatsResult *psResult)
+{
+    tStatsAccum sAccum = *psAccum;
+    uint64_t ui64M2;
+    int64_t i64N = sAccum.ui32Count;
+
+    psResult->ui32Count = sAccum.ui32Count;
+    if(sAccum.ui32Count == 0)
+    {
+        psResult->ui32Min = 0;
+        psResult->ui32Max = 0;
+        psResult->i32MeanQ8 = 0;
+        psResult->ui32VarQ8 = 0;
+        return;
+    }
+
+    StatsRebase(&sAccum, sAccum.i32Shift + (int32_t)(sAccum.i64Sum / i64N));
+
+    ui64M2 = sAccum.ui64SumSq - (uint64_t)((sAccum.i64Sum * sAccum.i64Sum) /
+                                           i64N);
+
+    psResult->ui32Min = sAccum.ui16Min;
+    psResult->ui32Max = sAccum.ui16Max;
+    psResult->i32MeanQ8 = (sAccum.i32Shift * 256) +
+                          (int32_t)((sAccum.i64Sum * 256) / i64N);
+    psResult->ui32VarQ8 = (sAccum.ui32Count > 1) ?
+                          (uint32_t)((ui64M2 << 8) / (uint64_t)(i64N - 1)) : 0;
+}
+
+//*****************************************************************************
+//
+// Standard deviation from the variance, both with 8 fraction bits.
+//
+//*****************************************************************************
+uint32_t StatsStdQ8(uint32_t ui32VarQ8)
+{
+    uint64_t ui64Value = (uint64_t)ui32VarQ8 << 8, ui64Root = 0, ui64Bit;
+
+    for(ui64Bit = (uint64_t)1 << 40; ui64Bit; ui64Bit >>= 2)
+    {
+        if(ui64Value >= ui64Root + ui64Bit)
+        {
+            ui64Value -= ui64Root + ui64Bit;
+            ui64Root = (ui64Root >> 1) + ui64Bit;
+        }
+        else
+        {
+            ui64Root >>= 1;
+        }
+    }
+
+    return (uint32_t)ui64Root;
+}
+
+//*****************************************************************************
+//
+// Clears all accumulators and applies the window length. Interrupt side.
+//
+//*****************************************************************************
+static void StatsClear(void)
+{
+    uint32_t ui32Ch, ui32Slot, ui32Frames;
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        for(ui32Slot = 0; ui32Slot < STATS_SLOTS; ui32Slot++)
+        {
+            StatsAccumReset(&g_ppsStatsSlots[ui32Ch][ui32Slot]);
+        }
+        StatsAccumReset(&g_psStatsTotal[ui32Ch]);
+    }
+
+    ui32Frames = (g_ui32StatsWindowMs * (ADC_SAMPLE_RATE_HZ / 1000)) /
+                 STATS_SLOTS;
+    g_ui32StatsSlotLength = ((ui32Frames + STATS_BLOCK_FRAMES - 1) /
+                             STATS_BLOCK_FRAMES) * STATS_BLOCK_FRAMES;
+    g_ui32StatsSlot = 0;
+    g_ui32StatsSlotFrames = 0;
+}
+
+void StatsInit(void)
+{
+    g_ui32StatsResetAck = g_ui32StatsResetReq;
+    StatsClear();
+}
+
+//*****************************************************************************
+//
+// Adds a block of frames to all channels. Called from the ADC interrupt with
+// STATS_BLOCK_FRAMES frames, which never cross the end of a slot.
+//
+//*****************************************************************************
+void StatsProcessFrames(const tADCFrame *psFrames, uint32_t ui32Count)
+{
+    uint32_t ui32Ch, ui32Slot;
+
+    g_ui32StatsVersion++;
+
+    if(g_ui32StatsResetReq != g_ui32StatsResetAck)
+    {
+        g_ui32StatsResetAck = g_ui32StatsResetReq;
+        StatsClear();
+    }
+
+    ui32Slot = g_ui32StatsSlot;
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        StatsBlockUpdate(&g_ppsStatsSlots[ui32Ch][ui32Slot],
+                         &psFrames->pui16Data[ui32Ch], STATS_FRAME_STRIDE,
+                         ui32Count);
+    }
+
+    g_ui32StatsSlotFrames += ui32Count;
+    if(g_ui32StatsSlotFrames >= g_ui32StatsSlotLength)
+    {
+        ui32Slot = (ui32Slot + 1) % STATS_SLOTS;
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            StatsMerge(&g_psStatsTotal[ui32Ch],
+                       &g_ppsStatsSlots[ui32Ch][g_ui32StatsSlot]);
+            StatsAccumReset(&g_ppsStatsSlots[ui32Ch][ui32Slot]);
+        }
+        g_ui32StatsSlot = ui32Slot;
+        g_ui32StatsSlotFrames = 0;
+    }
+
+    g_ui32StatsVersion++;
+}
+
+//*****************************************************************************
+//
+// Reads the statistics of a channel over the rolling window or since the
+// last reset. Returns false before the first sample.
+//
+//*****************************************************************************
+bool StatsGet(uint32_t ui32Ch, bool bWindow, tStatsResult *psResult)
+{
+    tStatsAccum psSlots[STATS_SLOTS], sAccum;
+    uint32_t ui32Version, ui32Slot, ui32Current;
+
+    if(ui32Ch >= ADC_NUM_CHANNELS)
+    {
+        return false;
+    }
+
+    do
+    {
+        ui32Version = g_ui32StatsVersion;
+        ui32Current = g_ui32StatsSlot;
+        for(ui32Slot = 0; ui32Slot < STATS_SLOTS; ui32Slot++)
+        {
+            psSlots[ui32Slot] = g_ppsStatsSlots[ui32Ch][ui32Slot];
+        }
+        sAccum = g_psStatsTotal[ui32Ch];
+    }
+    while((ui32Version & 1) || (ui32Version != g_ui32StatsVersion));
+
+    if(bWindow)
+    {
+        StatsAccumReset(&sAccum);
+        for(ui32Slot = 0; ui32Slot < STATS_SLOTS; ui32Slot++)
+        {
+            StatsMerge(&sAccum, &psSlots[ui32Slot]);
+        }
+    }
+    else
+    {
+        StatsMerge(&sAccum, &psSlots[ui32Current]);
+    }
+
+    StatsAccumResult(&sAccum, psResult);
+
+    return psResult->ui32Count != 0;
+}
+
+//*****************************************************************************
+//
+// Sets the rolling window length, which also resets the statistics.
+//
+//*****************************************************************************
+void StatsWindowSet(uint32_t ui32Ms)
+{
+    if(ui32Ms > STATS_MAX_WINDOW_MS)
+    {
+        ui32Ms = STATS_MAX_WINDOW_MS;
+    }
+    if(ui32Ms == 0)
+    {
+        ui32Ms = 1;
+    }
+
+    g_ui32StatsWindowMs = ui32Ms;
+    g_ui32StatsResetReq++;
+}
+
+uint32_t StatsWindowGet(void)
+{
+    return g_ui32StatsWindowMs;
+}
+
+void StatsReset(void)
+{
+    g_ui32StatsResetReq++;
+}
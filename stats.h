@@ -0,0 +1,73 @@
+//*****************************************************************************
+//
+// stats.h - Streaming statistics of the ADC channels.
+//
+// Plain C without target dependencies, also built into the host tools.
+// Count, minimum, maximum, mean and variance are accumulated without keeping
+// the samples, in exact integer sums of the differences to a shift value,
+// the first sample of the accumulator. Welford's update needs a division per
+// sample to stay accurate in floating point; with integer samples the
+// shifted sums lose nothing, so the per sample work is a subtract, an add,
+// a multiply-accumulate and two compares, and mean and variance are only
+// formed when they are read. Accumulators with different shifts merge
+// exactly, which makes the rolling window a ring of STATS_SLOTS partial
+// accumulators.
+//
+//*****************************************************************************
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "adc_api.h"
+
+//*****************************************************************************
+//
+// The ADC interrupt passes every STATS_BLOCK_FRAMES frames as one block. The
+// rolling window of a channel is STATS_SLOTS slots of whole blocks, a read
+// merges the full slots and the one being filled, so it covers between
+// STATS_SLOTS - 1 and STATS_SLOTS slot lengths.
+//
+//*****************************************************************************
+#define STATS_BLOCK_FRAMES              16      // divides ADC_FRAME_RING_SIZE
+#define STATS_SLOTS                     4
+#define STATS_DEFAULT_WINDOW_MS         1000
+#define STATS_MAX_WINDOW_MS             60000
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint16_t ui16Min;
+    uint16_t ui16Max;
+    int32_t i32Shift;                   // first sample
+    int64_t i64Sum;                     // sum of x - shift
+    uint64_t ui64SumSq;                 // sum of (x - shift)^2
+}
+tStatsAccum;
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    int32_t i32MeanQ8;                  // counts, 8 fraction bits
+    uint32_t ui32VarQ8;                 // counts^2, sample variance
+}
+tStatsResult;
+
+void StatsAccumReset(tStatsAccum *psAccum);
+void StatsBlockUpdate(tStatsAccum *psAccum, const uint16_t *pui16Samples,
+                      uint32_t ui32Stride, uint32_t ui32Count);
+void StatsMerge(tStatsAccum *psInto, const tStatsAccum *psFrom);
+void StatsAccumResult(const tStatsAccum *psAccum, tStatsResult *psResult);
+uint32_t StatsStdQ8(uint32_t ui32VarQ8);
+
+void StatsInit(void);
+void StatsProcessFrames(const tADCFrame *psFrames, uint32_t ui32Count);
+bool StatsGet(uint32_t ui32Ch, bool bWindow, tStatsResult *psResult);
+void StatsWindowSet(uint32_t ui32Ms);
+uint32_t StatsWindowGet(void);
+void StatsReset(void);
+
+#endif
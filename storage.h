@@ -0,0 +1,28 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#define STORAGE_BLOCK_SIZE              512
+
+//*****************************************************************************
+//
+// A block device as seen by the data logger. All calls block the calling
+// task until the transfer is done and return 0 on success or a negative
+// value on error. Multi block writes of consecutive blocks should be used
+// whenever possible, they are much faster on SD cards.
+//
+// sd_spi.c implements this for a microSD card on SSI0 and
+// tools/sdlog/storage_file.c with an image file for the host tools.
+//
+//*****************************************************************************
+typedef struct
+{
+    int32_t (*pfnInit)(void);
+    uint32_t (*pfnBlockCount)(void);
+    int32_t (*pfnRead)(uint32_t ui32Block, uint8_t *pui8Data,
+                       uint32_t ui32Count);
+    int32_t (*pfnWrite)(uint32_t ui32Block, const uint8_t *pui8Data,
+                        uint32_t ui32Count);
+}
+tStorageDevice;
+
+#endif
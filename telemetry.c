@@ -0,0 +1,414 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Binary ADC frame telemetry over UART0
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "adc_api.h"
+#include "timestamp.h"
+#include "cobs.h"
+#include "compress.h"
+#include "crc16.h"
+#include "ram_budget.h"
+#include "telemetry_schema.h"
+#include "stats.h"
+#include "uart_dma.h"
+#include "telemetry.h"
+
+/******************************************************************************
+Description: while telemetry is enabled every n-th ADC frame is packed into
+TELEMETRY_TYPE_ADC_FRAMES packets (see telemetry_schema.h). Each packet is
+CRC protected, COBS encoded, enclosed in zero bytes and sent with UART0
+uDMA. The UART is switched to a higher baud rate for the duration of the
+stream, full rate at 8kHz needs about 1.4Mbaud.
+
+Every TELEMETRY_STATS_MS a TELEMETRY_TYPE_ADC_STATS packet with the channel
+statistics of stats.c goes in between the frame packets.
+
+In compressed mode the frames are delta and bit packed (compress.h) into
+TELEMETRY_TYPE_ADC_COMPRESSED packets instead, typically 4 to 6 bytes per
+frame instead of 16. Packing is done frame by frame as they are read, the
+cycles spent are reported by "telem stats".
+
+The task runs above the LCD task because the frame ring only holds 32ms of
+conversions, and the spare slots of the freeze frame only 8ms while it holds
+a snapshot. Console output in between packets is ignored by the host parser.
+******************************************************************************/
+
+//*****************************************************************************
+//
+// The stack size of the telemetry task and the packet configuration.
+//
+//*****************************************************************************
+#define TELEMETRYTASKSTACKSIZE          192             // Stack size in words
+#define TELEMETRY_FRAMES_PER_PACKET     8
+#define TELEMETRY_COMPRESSED_FRAMES     16
+#define TELEMETRY_IDLE_POLL_MS          20
+#define TELEMETRY_STATS_MS              250
+
+// must match ConfigureUART()
+#define TELEMETRY_CONSOLE_BAUD          115200
+
+#define TELEMETRY_RAW_SIZE                                                    \
+    (TELEMETRY_HDR_SIZE + TELEMETRY_ADC_FRAMES + TELEMETRY_CRC_SIZE +         \
+     (TELEMETRY_FRAMES_PER_PACKET * TELEMETRY_ADC_FRAME_SIZE(ADC_NUM_CHANNELS)))
+
+#define TELEMETRY_COMPRESSED_SIZE                                             \
+    (TELEMETRY_HDR_SIZE + TELEMETRY_CRC_SIZE +                                \
+     COMPRESS_BLOCK_MAX(TELEMETRY_COMPRESSED_FRAMES, ADC_NUM_CHANNELS))
+
+#define TELEMETRY_STATS_PACKET_SIZE                                           \
+    (TELEMETRY_HDR_SIZE + TELEMETRY_CRC_SIZE +                                \
+     TELEMETRY_STATS_LEN(ADC_NUM_CHANNELS))
+
+#define TELEMETRY_MAX2(a, b)    (((a) > (b)) ? (a) : (b))
+#define TELEMETRY_PACKET_SIZE                                                 \
+    TELEMETRY_MAX2(TELEMETRY_MAX2(TELEMETRY_RAW_SIZE,                         \
+                                  TELEMETRY_COMPRESSED_SIZE),                 \
+                   TELEMETRY_STATS_PACKET_SIZE)
+
+#define TELEMETRY_TX_SIZE       (TELEMETRY_COBS_MAX(TELEMETRY_PACKET_SIZE) + 2)
+
+extern xSemaphoreHandle g_pUARTSemaphore;
+
+static volatile bool g_bTelemetryEnabled = false;
+static volatile uint32_t g_ui32TelemetryDecimation = 1;
+static volatile bool g_bTelemetryCompress = false;
+static uint32_t g_ui32TelemetryBaud = TELEMETRY_CONSOLE_BAUD;
+static uint32_t g_ui32TelemetryPackets = 0;
+static uint32_t g_ui32TelemetryFrames = 0;
+static uint16_t g_ui16TelemetryCounter = 0;
+static uint32_t g_ui32TelemetryBytes = 0;
+static uint32_t g_ui32TelemetryCompressFrames = 0;
+static uint32_t g_ui32TelemetryCompressCycles = 0;
+
+static tCompressBlock g_sTelemetryBlock;
+
+static uint8_t g_pui8TelemetryPacket[TELEMETRY_PACKET_SIZE];
+static uint8_t g_pui8TelemetryTx[TELEMETRY_TX_SIZE];
+
+typedef char tTelemetryBudget[(sizeof(g_sTelemetryBlock) +
+                               sizeof(g_pui8TelemetryPacket) +
+                               sizeof(g_pui8TelemetryTx) <=
+                               RAM_BUDGET_TELEMETRY) ? 1 : -1];
+
+//*****************************************************************************
+//
+// Reprograms UART0 for a new baud rate.
+//
+//*****************************************************************************
+static void TelemetryBaudSet(uint32_t ui32Baud)
+{
+    HalUARTBaudSet(0, ui32Baud);
+
+    g_ui32TelemetryBaud = ui32Baud;
+}
+
+//*****************************************************************************
+//
+// Starts streaming every ui32Decimation-th frame at the given baud rate,
+// compressed or raw. The caller must own the UART.
+//
+//*****************************************************************************
+void TelemetryStart(uint32_t ui32Decimation, uint32_t ui32Baud,
+                    bool bCompress)
+{
+    if(ui32Decimation == 0)
+    {
+        ui32Decimation = 1;
+    }
+
+    UARTprintf("telemetry: 1/%u frames at %u baud%s\n", ui32Decimation,
+               ui32Baud, bCompress ? ", compressed" : "");
+
+    g_ui32TelemetryDecimation = ui32Decimation;
+    g_bTelemetryCompress = bCompress;
+    TelemetryBaudSet(ui32Baud);
+    g_bTelemetryEnabled = true;
+}
+
+//*****************************************************************************
+//
+// Stops the stream and restores the console baud rate. The caller must own
+// the UART.
+//
+//*****************************************************************************
+void TelemetryStop(void)
+{
+    g_bTelemetryEnabled = false;
+    TelemetryBaudSet(TELEMETRY_CONSOLE_BAUD);
+}
+
+//*****************************************************************************
+//
+// Prints the telemetry counters. The caller must own the UART.
+//
+//*****************************************************************************
+void TelemetryReport(void)
+{
+    UARTprintf("telemetry: %s baud %u decimation %u packets %u frames %u "
+               "bytes %u\n", g_bTelemetryEnabled ? "on" : "off",
+               g_ui32TelemetryBaud, g_ui32TelemetryDecimation,
+               g_ui32TelemetryPackets, g_ui32TelemetryFrames,
+               g_ui32TelemetryBytes);
+
+    if(g_ui32TelemetryCompressFrames != 0)
+    {
+        UARTprintf("compression: %u frames, %u cycles per frame\n",
+                   g_ui32TelemetryCompressFrames,
+                   g_ui32TelemetryCompressCycles /
+                   g_ui32TelemetryCompressFrames);
+    }
+}
+
+//*****************************************************************************
+//
+// Appends a frame to the packet under construction.
+//
+//*****************************************************************************
+static void TelemetryAddFrame(uint32_t ui32Index, const tADCFrame *psFrame)
+{
+    uint8_t *pui8Frame;
+    uint32_t ui32Ch;
+
+    pui8Frame = g_pui8TelemetryPacket + TELEMETRY_HDR_SIZE +
+                TELEMETRY_ADC_FRAMES +
+                (ui32Index * TELEMETRY_ADC_FRAME_SIZE(ADC_NUM_CHANNELS));
+
+    TelemetryPut32(pui8Frame, psFrame->ui32Seq);
+    TelemetryPut32(pui8Frame + 4, psFrame->ui32Time);
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        TelemetryPut16(pui8Frame + 8 + (2 * ui32Ch),
+                       psFrame->pui16Data[ui32Ch]);
+    }
+}
+
+//*****************************************************************************
+//
+// Completes the packet, encodes it into the transmit buffer and sends it with
+// the uDMA. The task sleeps until the transfer is done.
+//
+//*****************************************************************************
+static void TelemetrySendPacket(uint32_t ui32Type, uint32_t ui32PayloadLen,
+                                uint32_t ui32NumFrames)
+{
+    uint8_t *pui8Tx = g_pui8TelemetryTx;
+    uint32_t ui32Len;
+    uint16_t ui16Crc;
+
+    g_pui8TelemetryPacket[TELEMETRY_HDR_VERSION] = TELEMETRY_SCHEMA_VERSION;
+    g_pui8TelemetryPacket[TELEMETRY_HDR_TYPE] = (uint8_t)ui32Type;
+    TelemetryPut16(g_pui8TelemetryPacket + TELEMETRY_HDR_COUNTER,
+                   g_ui16TelemetryCounter++);
+    TelemetryPut16(g_pui8TelemetryPacket + TELEMETRY_HDR_LENGTH,
+                   (uint16_t)ui32PayloadLen);
+
+    ui32Len = TELEMETRY_HDR_SIZE + ui32PayloadLen;
+    ui16Crc = Crc16Ccitt(CRC16_CCITT_INIT, g_pui8TelemetryPacket, ui32Len);
+    TelemetryPut16(g_pui8TelemetryPacket + ui32Len, ui16Crc);
+    ui32Len += TELEMETRY_CRC_SIZE;
+
+    pui8Tx[0] = TELEMETRY_DELIMITER;
+    ui32Len = 1 + CobsEncode(g_pui8TelemetryPacket, ui32Len, pui8Tx + 1);
+    pui8Tx[ui32Len++] = TELEMETRY_DELIMITER;
+
+    xSemaphoreTake(g_pUARTSemaphore, portMAX_DELAY);
+    UARTDMASend(pui8Tx, ui32Len);
+    UARTDMAWait();
+    xSemaphoreGive(g_pUARTSemaphore);
+
+    g_ui32TelemetryPackets++;
+    g_ui32TelemetryFrames += ui32NumFrames;
+    g_ui32TelemetryBytes += ui32Len;
+}
+
+//*****************************************************************************
+//
+// Sends the raw frames collected with TelemetryAddFrame().
+//
+//*****************************************************************************
+static void TelemetrySendFrames(uint32_t ui32NumFrames)
+{
+    uint8_t *pui8Payload = g_pui8TelemetryPacket + TELEMETRY_HDR_SIZE;
+
+    pui8Payload[TELEMETRY_ADC_CHANNELS] = ADC_NUM_CHANNELS;
+    pui8Payload[TELEMETRY_ADC_COUNT] = (uint8_t)ui32NumFrames;
+    TelemetryPut16(pui8Payload + TELEMETRY_ADC_DECIMATION,
+                   (uint16_t)g_ui32TelemetryDecimation);
+
+    TelemetrySendPacket(TELEMETRY_TYPE_ADC_FRAMES,
+                        TELEMETRY_ADC_FRAMES +
+                        (ui32NumFrames *
+                         TELEMETRY_ADC_FRAME_SIZE(ADC_NUM_CHANNELS)),
+                        ui32NumFrames);
+}
+
+//*****************************************************************************
+//
+// Packs the compression block into a packet and sends it.
+//
+//*****************************************************************************
+static void TelemetrySendBlock(void)
+{
+    uint32_t ui32NumFrames = g_sTelemetryBlock.ui32Count, ui32Len, ui32Start;
+
+    ui32Start = TimestampGet();
+    ui32Len = CompressBlockFinish(&g_sTelemetryBlock,
+                                  g_pui8TelemetryPacket + TELEMETRY_HDR_SIZE);
+    g_ui32TelemetryCompressCycles += TimestampGet() - ui32Start;
+
+    TelemetrySendPacket(TELEMETRY_TYPE_ADC_COMPRESSED, ui32Len,
+                        ui32NumFrames);
+}
+
+//*****************************************************************************
+//
+// Sends the window and total statistics of every channel.
+//
+//*****************************************************************************
+static void TelemetrySendStats(void)
+{
+    uint8_t *pui8Payload = g_pui8TelemetryPacket + TELEMETRY_HDR_SIZE;
+    uint8_t *pui8Stats = pui8Payload + TELEMETRY_STATS_DATA;
+    tStatsResult sResult;
+    uint32_t ui32Ch, ui32Window;
+
+    pui8Payload[TELEMETRY_STATS_CHANNELS] = ADC_NUM_CHANNELS;
+    pui8Payload[TELEMETRY_STATS_CHANNELS + 1] = 0;
+    TelemetryPut16(pui8Payload + TELEMETRY_STATS_WINDOW,
+                   (uint16_t)StatsWindowGet());
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        for(ui32Window = 0; ui32Window < 2; ui32Window++)
+        {
+            StatsGet(ui32Ch, ui32Window == 0, &sResult);
+            TelemetryPut32(pui8Stats, sResult.ui32Count);
+            TelemetryPut16(pui8Stats + 4, (uint16_t)sResult.ui32Min);
+            TelemetryPut16(pui8Stats + 6, (uint16_t)sResult.ui32Max);
+            TelemetryPut32(pui8Stats + 8, (uint32_t)sResult.i32MeanQ8);
+            TelemetryPut32(pui8Stats + 12, sResult.ui32VarQ8);
+            pui8Stats += TELEMETRY_STATS_SIZE;
+        }
+    }
+
+    TelemetrySendPacket(TELEMETRY_TYPE_ADC_STATS,
+                        TELEMETRY_STATS_LEN(ADC_NUM_CHANNELS), 0);
+}
+
+//*****************************************************************************
+//
+// Adds a frame to the compression block and sends the block when it is full
+// or the frame does not continue it, e.g. after the reader fell behind.
+//
+//*****************************************************************************
+static void TelemetryCompressFrame(const tADCFrame *psFrame)
+{
+    uint32_t ui32Start, ui32Count;
+
+    while(1)
+    {
+        ui32Start = TimestampGet();
+        ui32Count = CompressBlockAdd(&g_sTelemetryBlock, psFrame->ui32Seq,
+                                     psFrame->ui32Time, psFrame->pui16Data);
+        g_ui32TelemetryCompressCycles += TimestampGet() - ui32Start;
+
+        if(ui32Count != 0)
+        {
+            break;
+        }
+        TelemetrySendBlock();
+    }
+
+    g_ui32TelemetryCompressFrames++;
+    if(ui32Count == TELEMETRY_COMPRESSED_FRAMES)
+    {
+        TelemetrySendBlock();
+    }
+}
+
+//*****************************************************************************
+//
+// This task follows the ADC frame ring and streams the frames while the
+// telemetry mode is on.
+//
+//*****************************************************************************
+static void TelemetryTask(void *pvParameters)
+{
+    tADCFrame sFrame;
+    uint32_t ui32Seq = ADCFrameSeqGet(), ui32Skip = 0, ui32NumFrames = 0;
+    TickType_t xStatsTime = xTaskGetTickCount();
+
+    while(1)
+    {
+        if(!g_bTelemetryEnabled)
+        {
+            ui32NumFrames = 0;
+            CompressBlockInit(&g_sTelemetryBlock, ADC_NUM_CHANNELS);
+            vTaskDelay(TELEMETRY_IDLE_POLL_MS);
+            ui32Seq = ADCFrameSeqGet();
+            continue;
+        }
+
+        while(ADCFrameRead(&ui32Seq, &sFrame))
+        {
+            if(ui32Skip != 0)
+            {
+                ui32Skip--;
+                continue;
+            }
+            ui32Skip = g_ui32TelemetryDecimation - 1;
+
+            if(g_bTelemetryCompress)
+            {
+                TelemetryCompressFrame(&sFrame);
+                continue;
+            }
+
+            TelemetryAddFrame(ui32NumFrames++, &sFrame);
+            if(ui32NumFrames == TELEMETRY_FRAMES_PER_PACKET)
+            {
+                TelemetrySendFrames(ui32NumFrames);
+                ui32NumFrames = 0;
+            }
+        }
+
+        //
+        // Statistics go between packets, the raw frames are collected in the
+        // packet buffer.
+        //
+        if(((xTaskGetTickCount() - xStatsTime) >= TELEMETRY_STATS_MS) &&
+           (g_bTelemetryCompress || (ui32NumFrames == 0)))
+        {
+            xStatsTime = xTaskGetTickCount();
+            TelemetrySendStats();
+        }
+
+        vTaskDelay(1);
+    }
+}
+
+//*****************************************************************************
+//
+// Initializes the telemetry task. UARTLogTaskInit() sets up the uDMA channel.
+//
+//*****************************************************************************
+uint32_t TelemetryTaskInit(void)
+{
+    if(xTaskCreate(TelemetryTask, (const portCHAR *)"TLM",
+                   TELEMETRYTASKSTACKSIZE, NULL,
+                   tskIDLE_PRIORITY + PRIORITY_TELEMETRY_TASK,
+                   NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
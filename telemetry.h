@@ -0,0 +1,12 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#define TELEMETRY_DEFAULT_BAUD          2000000
+
+void TelemetryStart(uint32_t ui32Decimation, uint32_t ui32Baud,
+                    bool bCompress);
+void TelemetryStop(void);
+void TelemetryReport(void);
+uint32_t TelemetryTaskInit(void);
+
+#endif
@@ -0,0 +1,146 @@
+//*****************************************************************************
+//
+// telemetry_schema.h - Layout of the binary telemetry packets.
+//
+// This header is shared by the firmware and the host parser library in
+// tools/telemetry, so it must only depend on stdint.h. Any change to the
+// layout must bump TELEMETRY_SCHEMA_VERSION.
+//
+//     version  change
+//     1        ADC frames
+//     2        compressed ADC frames
+//     3        channel statistics
+//
+// On the wire every packet is COBS encoded and enclosed in zero bytes, so
+// console text sent in between packets ends up in blocks of its own.
+// Decoded, a packet is a header, a payload and a CRC, all little endian:
+//
+//     offset  size  field
+//     0       1     schema version
+//     1       1     packet type
+//     2       2     packet counter, increments by one per packet
+//     4       2     payload length
+//     6       n     payload
+//     6+n     2     CRC-16/CCITT-FALSE of bytes 0 to 5+n
+//
+//*****************************************************************************
+
+#ifndef TELEMETRY_SCHEMA_H
+#define TELEMETRY_SCHEMA_H
+
+#include <stdint.h>
+
+#define TELEMETRY_SCHEMA_VERSION        3
+#define TELEMETRY_DELIMITER             0x00
+#define TELEMETRY_TIMESTAMP_HZ          80000000
+
+#define TELEMETRY_HDR_VERSION           0
+#define TELEMETRY_HDR_TYPE              1
+#define TELEMETRY_HDR_COUNTER           2
+#define TELEMETRY_HDR_LENGTH            4
+#define TELEMETRY_HDR_SIZE              6
+#define TELEMETRY_CRC_SIZE              2
+
+// largest decoded packet, header and CRC included
+#define TELEMETRY_MAX_PACKET            256
+
+// worst case COBS output size for n input bytes, without the delimiter
+#define TELEMETRY_COBS_MAX(n)           ((n) + ((n) / 254) + 1)
+
+//*****************************************************************************
+//
+// Packet types.
+//
+//*****************************************************************************
+#define TELEMETRY_TYPE_ADC_FRAMES       1
+#define TELEMETRY_TYPE_ADC_COMPRESSED   2
+#define TELEMETRY_TYPE_ADC_STATS        3
+
+//*****************************************************************************
+//
+// TELEMETRY_TYPE_ADC_FRAMES payload: a block of consecutive (or decimated)
+// ADC frames.
+//
+//     offset  size  field
+//     0       1     channels per frame
+//     1       1     frames in this packet
+//     2       2     decimation, every n-th conversion is sent
+//     4       ...   frames
+//
+// Frame:
+//     0       4     ADC frame sequence number
+//     4       4     timestamp, TELEMETRY_TIMESTAMP_HZ cycles
+//     8       2*ch  12-bit readings
+//
+//*****************************************************************************
+#define TELEMETRY_ADC_CHANNELS          0
+#define TELEMETRY_ADC_COUNT             1
+#define TELEMETRY_ADC_DECIMATION        2
+#define TELEMETRY_ADC_FRAMES            4
+#define TELEMETRY_ADC_FRAME_SIZE(ch)    (8 + (2 * (ch)))
+
+//*****************************************************************************
+//
+// TELEMETRY_TYPE_ADC_COMPRESSED payload: the same frames as one block of
+// compress.h, delta and bit packed. The block carries the channel count,
+// the sequence numbers with the decimation as step, and the timestamps.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// TELEMETRY_TYPE_ADC_STATS payload: the channel statistics of stats.h, sent
+// a few times per second while streaming.
+//
+//     offset  size  field
+//     0       1     channels
+//     1       1     reserved, 0
+//     2       2     rolling window length, ms
+//     4       ...   per channel the rolling window, then since the reset
+//
+// Statistics:
+//     0       4     sample count
+//     4       2     minimum
+//     6       2     maximum
+//     8       4     mean, signed, 8 fraction bits
+//     12      4     sample variance, 8 fraction bits
+//
+//*****************************************************************************
+#define TELEMETRY_STATS_CHANNELS        0
+#define TELEMETRY_STATS_WINDOW          2
+#define TELEMETRY_STATS_DATA            4
+#define TELEMETRY_STATS_SIZE            16
+#define TELEMETRY_STATS_LEN(ch)         (TELEMETRY_STATS_DATA +               \
+                                         (2 * (ch) * TELEMETRY_STATS_SIZE))
+
+//*****************************************************************************
+//
+// Little endian field access.
+//
+//*****************************************************************************
+static inline void TelemetryPut16(uint8_t *pui8Buf, uint16_t ui16Value)
+{
+    pui8Buf[0] = (uint8_t)ui16Value;
+    pui8Buf[1] = (uint8_t)(ui16Value >> 8);
+}
+
+static inline void TelemetryPut32(uint8_t *pui8Buf, uint32_t ui32Value)
+{
+    pui8Buf[0] = (uint8_t)ui32Value;
+    pui8Buf[1] = (uint8_t)(ui32Value >> 8);
+    pui8Buf[2] = (uint8_t)(ui32Value >> 16);
+    pui8Buf[3] = (uint8_t)(ui32Value >> 24);
+}
+
+static inline uint16_t TelemetryGet16(const uint8_t *pui8Buf)
+{
+    return (uint16_t)(pui8Buf[0] | (pui8Buf[1] << 8));
+}
+
+static inline uint32_t TelemetryGet32(const uint8_t *pui8Buf)
+{
+    return (uint32_t)pui8Buf[0] | ((uint32_t)pui8Buf[1] << 8) |
+           ((uint32_t)pui8Buf[2] << 16) | ((uint32_t)pui8Buf[3] << 24);
+}
+
+#endif
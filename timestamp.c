@@ -0,0 +1,32 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Timestamp service based on the DWT cycle counter
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "timestamp.h"
+
+//*****************************************************************************
+//
+// Core debug and DWT registers. These are part of the Cortex-M4 core so they
+// are not described by the TivaWare hw_*.h headers.
+//
+//*****************************************************************************
+#define CORE_DEBUG_DEMCR                0xE000EDFC
+#define CORE_DEBUG_DEMCR_TRCENA         0x01000000
+#define DWT_CTRL                        0xE0001000
+#define DWT_CTRL_CYCCNTENA              0x00000001
+#define DWT_CYCCNT                      0xE0001004
+
+//*****************************************************************************
+//
+// Enables the DWT cycle counter. Must be called once before TimestampGet().
+//
+//*****************************************************************************
+void TimestampInit(void)
+{
+    HWREG(CORE_DEBUG_DEMCR) |= CORE_DEBUG_DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
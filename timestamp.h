@@ -0,0 +1,39 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+//*****************************************************************************
+//
+// Cycle accurate timestamps taken from the Cortex-M4 DWT cycle counter. One
+// count is one system clock cycle (12.5ns at 80MHz). The counter wraps every
+// ~53s so only differences between two timestamps are meaningful.
+//
+//*****************************************************************************
+
+// system clock is set to 80MHz in main()
+#define TIMESTAMP_CYCLES_PER_US         80
+
+// the simulation counts 80MHz cycles of the host clock, see hal.h
+#ifdef HAL_SIM
+uint32_t HalCycleCount(void);
+#define TIMESTAMP_DWT_CYCCNT            HalCycleCount()
+#else
+#define TIMESTAMP_DWT_CYCCNT            (*((volatile uint32_t *)0xE0001004))
+#endif
+
+#define TimestampUsToCycles(us)         ((us) * TIMESTAMP_CYCLES_PER_US)
+#define TimestampCyclesToUs(cycles)     ((cycles) / TIMESTAMP_CYCLES_PER_US)
+
+void TimestampInit(void);
+
+//*****************************************************************************
+//
+// Returns the current cycle count. Reading the counter is a single load so
+// this is safe to call from any task or interrupt handler.
+//
+//*****************************************************************************
+static inline uint32_t TimestampGet(void)
+{
+    return TIMESTAMP_DWT_CYCCNT;
+}
+
+#endif
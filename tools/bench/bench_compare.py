@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Compare two runs of the firmware micro benchmarks of bench.c.
+
+Each file is a console capture of the `bench` command on the board, the CSV
+or the JSON output of ecu_bench. Lines other than `bench,...` in a capture
+are ignored. Compare board with board and host with host:
+
+    tools/bench/bench_compare.py old.log new.log [--threshold 10]
+
+Prints the minimum cycles per item and the output bytes per item of every
+case found in both files. Exits with 1 if any case got slower or larger by
+more than the threshold in percent.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Returns {name: (min cycles per item, bytes per item)}."""
+    with open(path, errors="replace") as f:
+        text = f.read()
+
+    rows = []
+    if text.lstrip().startswith("{"):
+        for b in json.loads(text)["benchmarks"]:
+            rows.append((b["name"], b["min_cycles"], b["items_per_iteration"],
+                         b["bytes"]))
+    else:
+        for line in text.splitlines():
+            fields = line.strip().split(",")
+            if len(fields) != 9 or fields[0] != "bench" or fields[1] == "name":
+                continue
+            rows.append((fields[1], int(fields[3]), int(fields[6]),
+                         int(fields[8])))
+
+    return {name: (cycles / max(items, 1), size / max(items, 1))
+            for name, cycles, items, size in rows}
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0 if new == 0 else float("inf")
+    return 100.0 * (new - old) / old
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed increase in percent (default 10)")
+    args = parser.parse_args()
+
+    old = load(args.old)
+    new = load(args.new)
+    regressions = 0
+
+    print("%-20s %12s %12s %8s %10s %10s" %
+          ("case", "old cyc/it", "new cyc/it", "change", "old B/it",
+           "new B/it"))
+    for name in sorted(set(old) & set(new)):
+        cycles = change(old[name][0], new[name][0])
+        size = change(old[name][1], new[name][1])
+        flag = ""
+        if cycles > args.threshold or size > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-20s %12.1f %12.1f %+7.1f%% %10.2f %10.2f%s" %
+              (name, old[name][0], new[name][0], cycles, old[name][1],
+               new[name][1], flag))
+
+    for name in sorted(set(old) ^ set(new)):
+        print("%-20s only in %s" % (name, args.old if name in old else
+                                     args.new))
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
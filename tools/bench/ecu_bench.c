@@ -0,0 +1,218 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host runner of the firmware micro benchmarks of bench.c
+//
+// Usage: ecu_bench [--benchmark_filter=regex] [--benchmark_format=console|csv|json]
+// Runs the cases of bench.c in a task on the simulated board, with the ADC
+// sampling at 8kHz, the 1MHz delay timer and the LCD on I2C1 as in
+// ecu_sim. The console format is a table, csv prints the same lines as the
+// "bench" command on the board and json follows the layout of Google
+// Benchmark. Cycles are 80MHz cycles of host time: compare host runs with
+// host runs and board runs with board runs, tools/bench/bench_compare.py
+// does that for two CSV or JSON files.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <regex.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "lcd_sim.h"
+#include "lcd_i2c.h"
+#include "sensors.h"
+#include "calib.h"
+#include "bench.h"
+
+#define ECU_BENCH_LCD_I2C_PORT          1
+#define ECU_BENCH_LCD_I2C_ADDR          0x3F
+
+#define ECU_BENCH_FORMAT_CONSOLE        0
+#define ECU_BENCH_FORMAT_CSV            1
+#define ECU_BENCH_FORMAT_JSON           2
+
+// created by main() on the board
+xSemaphoreHandle g_pUARTSemaphore;
+xSemaphoreHandle g_pLCDSemaphore;
+xSemaphoreHandle g_pADCSemaphore;
+
+static regex_t g_sBenchFilter;
+static bool g_bBenchFiltered = false;
+static uint32_t g_ui32BenchFormat = ECU_BENCH_FORMAT_CONSOLE;
+static uint32_t g_ui32BenchRan = 0;
+
+static void BenchConsoleLine(const tBenchCase *psCase,
+                             const tBenchResult *psResult)
+{
+    char pcPerItem[32];
+
+    snprintf(pcPerItem, sizeof(pcPerItem), "%.1f/%s",
+             psResult->ui32Items ?
+             (double)psResult->ui32MinCycles / psResult->ui32Items : 0.0,
+             psCase->pcItem);
+
+    printf("%-20s %10u %10u %10u %16s %8u", psCase->pcName,
+           psResult->ui32MinCycles, psResult->ui32AvgCycles,
+           psResult->ui32MaxCycles, pcPerItem, psResult->ui32Runs);
+    if(psResult->ui32Bytes)
+    {
+        printf("  %.2f bytes/%s", (double)psResult->ui32Bytes /
+               psResult->ui32Items, psCase->pcItem);
+    }
+    printf("\n");
+}
+
+static void BenchJSONEntry(const tBenchCase *psCase,
+                           const tBenchResult *psResult, bool bFirst)
+{
+    printf("%s    {\n"
+           "      \"name\": \"%s\",\n"
+           "      \"run_type\": \"iteration\",\n"
+           "      \"iterations\": %u,\n"
+           "      \"min_cycles\": %u,\n"
+           "      \"avg_cycles\": %u,\n"
+           "      \"max_cycles\": %u,\n"
+           "      \"items_per_iteration\": %u,\n"
+           "      \"item\": \"%s\",\n"
+           "      \"bytes\": %u\n"
+           "    }", bFirst ? "" : ",\n", psCase->pcName, psResult->ui32Runs,
+           psResult->ui32MinCycles, psResult->ui32AvgCycles,
+           psResult->ui32MaxCycles, psResult->ui32Items, psCase->pcItem,
+           psResult->ui32Bytes);
+}
+
+static void BenchTask(void *pvParameters)
+{
+    const tBenchCase *psCase;
+    tBenchResult sResult;
+    uint32_t ui32Idx;
+
+    BenchInit();
+
+    if(g_ui32BenchFormat == ECU_BENCH_FORMAT_CSV)
+    {
+        BenchPrintHeader();
+    }
+    else if(g_ui32BenchFormat == ECU_BENCH_FORMAT_JSON)
+    {
+        printf("{\n  \"context\": {\n    \"executable\": \"ecu_bench\",\n"
+               "    \"cycles_hz\": %u\n  },\n  \"benchmarks\": [\n",
+               HAL_SYS_CLOCK_HZ);
+    }
+    else
+    {
+        printf("%-20s %10s %10s %10s %16s %8s\n", "Benchmark", "Min", "Avg",
+               "Max", "Min per item", "Runs");
+        printf("------------------------------------------------------------"
+               "-------------------\n");
+    }
+    fflush(stdout);
+
+    for(ui32Idx = 0; ui32Idx < g_ui32BenchNumCases; ui32Idx++)
+    {
+        psCase = &g_psBenchCases[ui32Idx];
+        if(g_bBenchFiltered &&
+           (regexec(&g_sBenchFilter, psCase->pcName, 0, NULL, 0) != 0))
+        {
+            continue;
+        }
+
+        psCase->pfnRun(&sResult);
+
+        if(g_ui32BenchFormat == ECU_BENCH_FORMAT_CSV)
+        {
+            BenchPrint(psCase, &sResult);
+        }
+        else if(g_ui32BenchFormat == ECU_BENCH_FORMAT_JSON)
+        {
+            BenchJSONEntry(psCase, &sResult, g_ui32BenchRan == 0);
+        }
+        else
+        {
+            BenchConsoleLine(psCase, &sResult);
+        }
+        fflush(stdout);
+        g_ui32BenchRan++;
+    }
+
+    if(g_ui32BenchFormat == ECU_BENCH_FORMAT_JSON)
+    {
+        printf("\n  ]\n}\n");
+        fflush(stdout);
+    }
+
+    vTaskEndScheduler();
+    while(1)
+    {
+        vTaskDelay(1000);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int iArg;
+
+    for(iArg = 1; iArg < argc; iArg++)
+    {
+        if(strncmp(argv[iArg], "--benchmark_filter=", 19) == 0)
+        {
+            if(regcomp(&g_sBenchFilter, argv[iArg] + 19,
+                       REG_EXTENDED | REG_NOSUB) != 0)
+            {
+                fprintf(stderr, "bad filter %s\n", argv[iArg] + 19);
+                return 1;
+            }
+            g_bBenchFiltered = true;
+        }
+        else if(strcmp(argv[iArg], "--benchmark_format=csv") == 0)
+        {
+            g_ui32BenchFormat = ECU_BENCH_FORMAT_CSV;
+        }
+        else if(strcmp(argv[iArg], "--benchmark_format=json") == 0)
+        {
+            g_ui32BenchFormat = ECU_BENCH_FORMAT_JSON;
+        }
+        else if(strcmp(argv[iArg], "--benchmark_format=console") != 0)
+        {
+            fprintf(stderr, "usage: %s [--benchmark_filter=regex] "
+                    "[--benchmark_format=console|csv|json]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    //
+    // The board as main() leaves it for the tasks: clock, console,
+    // mutexes, calibration, the LCD and the timer triggered ADC.
+    //
+    HalSysClockInit();
+    HalUARTInit(0, 115200);
+    g_pUARTSemaphore = xSemaphoreCreateMutex();
+    g_pLCDSemaphore = xSemaphoreCreateMutex();
+    g_pADCSemaphore = xSemaphoreCreateMutex();
+    CalibInit();
+
+    LCDSimAttach(ECU_BENCH_LCD_I2C_PORT, ECU_BENCH_LCD_I2C_ADDR);
+    lcdI2cInit(ECU_BENCH_LCD_I2C_ADDR, 16, 2, 0);
+    ThrottleSensorInit();
+
+    if(xTaskCreate(BenchTask, (const portCHAR *)"BEN", 512, NULL,
+                   tskIDLE_PRIORITY + 1, NULL) != pdTRUE)
+    {
+        return 1;
+    }
+
+    vTaskStartScheduler();
+
+    if(g_ui32BenchRan == 0)
+    {
+        fprintf(stderr, "no benchmark matches the filter\n");
+    }
+
+    return (g_ui32BenchRan == 0);
+}
@@ -0,0 +1,411 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host check of the sensor bus with concurrent readers
+//
+// Usage: sensor_bus_check [-n frames] [-r readers] [-s slots] [-d delay_us]
+//                         [-y] [-w swap_frames]
+//
+// One producer thread publishes frames as fast as it can on a topic of
+// sensor_bus.c while reader threads follow it at the same time: readers
+// that use the slots in place with SensorBusPeek()/SensorBusDone(), readers
+// that copy with SensorBusRead() and one that only looks at the newest
+// frame. Every frame is filled from its sequence number, so a reader can
+// tell a frame the producer was overwriting while it was read. Such a frame
+// must never be accepted, every frame must be read or counted as lost, in
+// order, and the readers must never slow the producer down. The in place
+// readers stop for -d microseconds now and then to fall behind on purpose,
+// with -y they give up the CPU in the middle of every frame they read in
+// place, as if the producer preempted them, which tears frames on a single
+// core host as well. With -w the producer moves the topic between its slots
+// and half as many spare slots, at least 2, every swap_frames frames, as the freeze frame
+// does, and the readers must carry on across the moves.
+// Prints a line per reader, exits with 1 if a check fails.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "sensor_bus.h"
+
+#define CHECK_FRAME_WORDS       15
+#define CHECK_MAX_READERS       16
+#define CHECK_MAX_SLOTS         1024
+#define CHECK_STALL_EVERY       4096        // frames between stalls
+#define CHECK_BURST             16          // frames between producer yields
+
+typedef struct
+{
+    uint32_t ui32Seq;
+    uint32_t pui32Data[CHECK_FRAME_WORDS];
+}
+tCheckFrame;
+
+#define CHECK_PEEK              0
+#define CHECK_READ              1
+#define CHECK_LATEST            2
+
+typedef struct
+{
+    uint32_t ui32Mode;
+    tSensorBusSub sSub;
+    char pcName[16];
+    uint32_t ui32Accepted;
+    uint32_t ui32Rejected;              // torn in use, caught by the bus
+    uint32_t ui32Bad;                   // torn or out of order, accepted
+}
+tCheckReader;
+
+static const char * const g_ppcCheckModes[] = { "peek", "read", "latest" };
+
+static tCheckFrame g_psCheckSlots[CHECK_MAX_SLOTS];
+static tCheckFrame g_psCheckSpare[CHECK_MAX_SLOTS / 2];
+static tSensorBusTopic g_sCheckTopic;
+static tCheckReader g_psCheckReaders[CHECK_MAX_READERS];
+
+static uint32_t g_ui32CheckFrames = 2000000;
+static uint32_t g_ui32CheckDelayUs = 50;
+static bool g_bCheckYield = false;
+static uint32_t g_ui32CheckSlots = 8;
+static uint32_t g_ui32CheckSwapFrames = 0;
+static uint32_t g_ui32CheckSwaps = 0;
+static volatile bool g_bCheckDone = false;
+static uint64_t g_ui64CheckProducerNs = 0;
+
+static void CheckSleepUs(uint32_t ui32Us)
+{
+    struct timespec sTime;
+
+    sTime.tv_sec = ui32Us / 1000000;
+    sTime.tv_nsec = (long)(ui32Us % 1000000) * 1000;
+    nanosleep(&sTime, NULL);
+}
+
+static uint64_t CheckNow(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return ((uint64_t)sTime.tv_sec * 1000000000ULL) + sTime.tv_nsec;
+}
+
+static uint32_t CheckWord(uint32_t ui32Seq, uint32_t ui32Idx)
+{
+    return (ui32Seq * 2654435761U) ^ (ui32Idx * 0x9E3779B9U);
+}
+
+//*****************************************************************************
+//
+// True if all words of the frame belong to its sequence number. bInPlace
+// yields halfway with -y.
+//
+//*****************************************************************************
+static bool CheckFrameWhole(const tCheckFrame *psFrame, bool bInPlace)
+{
+    uint32_t ui32Seq = psFrame->ui32Seq, ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < CHECK_FRAME_WORDS; ui32Idx++)
+    {
+        if(bInPlace && g_bCheckYield && (ui32Idx == (CHECK_FRAME_WORDS / 2)))
+        {
+            sched_yield();
+        }
+        if(psFrame->pui32Data[ui32Idx] != CheckWord(ui32Seq, ui32Idx))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//*****************************************************************************
+//
+// Producer thread, the interrupt handler of the firmware. Writes the words
+// one by one, sequence number last, so a slot read in the middle is torn.
+// The time per publish includes the yields and the swaps.
+//
+//*****************************************************************************
+static void *CheckProducer(void *pvArg)
+{
+    tCheckFrame *psFrame, *psOther = g_psCheckSpare;
+    uint32_t ui32Seq, ui32Idx, ui32Other, ui32Slots;
+    uint64_t ui64Start = CheckNow();
+
+    (void)pvArg;
+
+    ui32Other = (g_ui32CheckSlots > 2) ? (g_ui32CheckSlots / 2) : 2;
+
+    for(ui32Seq = 0; ui32Seq < g_ui32CheckFrames; ui32Seq++)
+    {
+        psFrame = (tCheckFrame *)SensorBusPublishBegin(&g_sCheckTopic);
+        for(ui32Idx = 0; ui32Idx < CHECK_FRAME_WORDS; ui32Idx++)
+        {
+            ((volatile uint32_t *)psFrame->pui32Data)[ui32Idx] =
+                CheckWord(ui32Seq, ui32Idx);
+        }
+        ((volatile tCheckFrame *)psFrame)->ui32Seq = ui32Seq;
+        SensorBusPublishEnd(&g_sCheckTopic);
+
+        if(g_ui32CheckSwapFrames &&
+           (((ui32Seq + 1) % g_ui32CheckSwapFrames) == 0))
+        {
+            ui32Slots = g_sCheckTopic.ui32Mask + 1;
+            psOther = SensorBusTopicSwap(&g_sCheckTopic, psOther, ui32Other);
+            ui32Other = ui32Slots;
+            g_ui32CheckSwaps++;
+        }
+
+        // lets the readers in on a host with fewer cores than threads
+        if((ui32Seq % CHECK_BURST) == 0)
+        {
+            sched_yield();
+        }
+    }
+
+    g_ui64CheckProducerNs = CheckNow() - ui64Start;
+    g_bCheckDone = true;
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Reader threads. A frame is checked while it is in the ring, as a zero copy
+// consumer would use it, then handed back to the bus.
+//
+//*****************************************************************************
+static void CheckPeek(tCheckReader *psReader)
+{
+    const tCheckFrame *psFrame;
+    uint32_t ui32Seq, ui32Last = UINT32_MAX;
+    bool bWhole;
+
+    while(!g_bCheckDone || SensorBusSeqGet(&g_sCheckTopic) !=
+                           psReader->sSub.ui32Seq)
+    {
+        psFrame = SensorBusPeek(&psReader->sSub);
+        if(!psFrame)
+        {
+            sched_yield();
+            continue;
+        }
+
+        ui32Seq = psReader->sSub.ui32Seq;
+        bWhole = CheckFrameWhole(psFrame, true) &&
+                 (psFrame->ui32Seq == ui32Seq);
+
+        if(!SensorBusDone(&psReader->sSub))
+        {
+            psReader->ui32Rejected++;
+            continue;
+        }
+
+        if(!bWhole || ((ui32Last != UINT32_MAX) && (ui32Seq <= ui32Last)))
+        {
+            psReader->ui32Bad++;
+        }
+        ui32Last = ui32Seq;
+        psReader->ui32Accepted++;
+
+        if(g_ui32CheckDelayUs && ((ui32Seq % CHECK_STALL_EVERY) == 0))
+        {
+            CheckSleepUs(g_ui32CheckDelayUs);
+        }
+    }
+}
+
+static void CheckRead(tCheckReader *psReader)
+{
+    tCheckFrame sFrame;
+    uint32_t ui32Last = UINT32_MAX;
+
+    while(!g_bCheckDone || SensorBusSeqGet(&g_sCheckTopic) !=
+                           psReader->sSub.ui32Seq)
+    {
+        if(!SensorBusRead(&psReader->sSub, &sFrame))
+        {
+            sched_yield();
+            continue;
+        }
+
+        if(!CheckFrameWhole(&sFrame, false) ||
+           ((ui32Last != UINT32_MAX) && (sFrame.ui32Seq <= ui32Last)))
+        {
+            psReader->ui32Bad++;
+        }
+        ui32Last = sFrame.ui32Seq;
+        psReader->ui32Accepted++;
+    }
+}
+
+static void CheckLatest(tCheckReader *psReader)
+{
+    const tCheckFrame *psFrame;
+    uint32_t ui32Seq, ui32Last = 0;
+    bool bWhole;
+
+    while(!g_bCheckDone)
+    {
+        psFrame = SensorBusLatest(&g_sCheckTopic, &ui32Seq);
+        if(!psFrame || (ui32Seq == ui32Last))
+        {
+            sched_yield();
+            continue;
+        }
+
+        bWhole = CheckFrameWhole(psFrame, true) &&
+                 (psFrame->ui32Seq == ui32Seq);
+        if(!SensorBusValid(&g_sCheckTopic, ui32Seq))
+        {
+            psReader->ui32Rejected++;
+            continue;
+        }
+
+        if(!bWhole || (ui32Seq < ui32Last))
+        {
+            psReader->ui32Bad++;
+        }
+        ui32Last = ui32Seq;
+        psReader->ui32Accepted++;
+    }
+}
+
+static void *CheckReader(void *pvArg)
+{
+    tCheckReader *psReader = (tCheckReader *)pvArg;
+
+    switch(psReader->ui32Mode)
+    {
+        case CHECK_PEEK:
+            CheckPeek(psReader);
+            break;
+        case CHECK_READ:
+            CheckRead(psReader);
+            break;
+        default:
+            CheckLatest(psReader);
+            break;
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t psThreads[CHECK_MAX_READERS], sProducer;
+    uint32_t ui32Readers = 4, ui32Slots = 8, ui32Idx, ui32Failed = 0;
+    tCheckReader *psReader;
+    bool bFail;
+    int iOpt;
+
+    while((iOpt = getopt(argc, argv, "n:r:s:d:yw:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 'n':
+                g_ui32CheckFrames = strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                ui32Readers = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                ui32Slots = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                g_ui32CheckDelayUs = strtoul(optarg, NULL, 0);
+                break;
+            case 'y':
+                g_bCheckYield = true;
+                break;
+            case 'w':
+                g_ui32CheckSwapFrames = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n frames] [-r readers] "
+                        "[-s slots] [-d delay_us] [-y] [-w swap_frames]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    if((ui32Readers == 0) || (ui32Readers > CHECK_MAX_READERS) ||
+       (ui32Slots < 2) || (ui32Slots > CHECK_MAX_SLOTS) ||
+       (ui32Slots & (ui32Slots - 1)))
+    {
+        fprintf(stderr, "1..%u readers, slots a power of two 2..%u\n",
+                CHECK_MAX_READERS, CHECK_MAX_SLOTS);
+        return 1;
+    }
+    g_ui32CheckSlots = ui32Slots;
+
+    SensorBusTopicRegister(&g_sCheckTopic, "check", g_psCheckSlots,
+                           sizeof(tCheckFrame), ui32Slots);
+
+    //
+    // The last reader looks at the newest frame only, the others take turns
+    // at in place and copying reads.
+    //
+    for(ui32Idx = 0; ui32Idx < ui32Readers; ui32Idx++)
+    {
+        psReader = &g_psCheckReaders[ui32Idx];
+        psReader->ui32Mode = ((ui32Idx == (ui32Readers - 1)) &&
+                              (ui32Readers > 1)) ? CHECK_LATEST :
+                             (ui32Idx & 1) ? CHECK_READ : CHECK_PEEK;
+        snprintf(psReader->pcName, sizeof(psReader->pcName), "%s%u",
+                 g_ppcCheckModes[psReader->ui32Mode], ui32Idx);
+        if(psReader->ui32Mode != CHECK_LATEST)
+        {
+            SensorBusSubscribe(&psReader->sSub, &g_sCheckTopic,
+                               psReader->pcName);
+        }
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32Readers; ui32Idx++)
+    {
+        pthread_create(&psThreads[ui32Idx], NULL, CheckReader,
+                       &g_psCheckReaders[ui32Idx]);
+    }
+    pthread_create(&sProducer, NULL, CheckProducer, NULL);
+
+    pthread_join(sProducer, NULL);
+    for(ui32Idx = 0; ui32Idx < ui32Readers; ui32Idx++)
+    {
+        pthread_join(psThreads[ui32Idx], NULL);
+    }
+
+    printf("%u frames of %u bytes in %u slots, %u swaps, %.1f ns per "
+           "publish\n", g_ui32CheckFrames, (uint32_t)sizeof(tCheckFrame),
+           ui32Slots, g_ui32CheckSwaps,
+           (double)g_ui64CheckProducerNs / g_ui32CheckFrames);
+    printf("reader    accepted      lost  rejected  bad\n");
+    for(ui32Idx = 0; ui32Idx < ui32Readers; ui32Idx++)
+    {
+        psReader = &g_psCheckReaders[ui32Idx];
+
+        //
+        // A follower must account for every frame, read or lost.
+        //
+        bFail = (psReader->ui32Bad != 0) ||
+                ((psReader->ui32Mode != CHECK_LATEST) &&
+                 ((psReader->sSub.ui32Reads != psReader->ui32Accepted) ||
+                  ((psReader->sSub.ui32Reads + psReader->sSub.ui32Lost) !=
+                   g_ui32CheckFrames)));
+        ui32Failed += bFail;
+
+        printf("%-8s %9u %9u %9u %4u  %s\n", psReader->pcName,
+               psReader->ui32Accepted,
+               (psReader->ui32Mode == CHECK_LATEST) ? 0 :
+               psReader->sSub.ui32Lost,
+               psReader->ui32Rejected, psReader->ui32Bad,
+               bFail ? "FAIL" : "ok");
+    }
+
+    return (ui32Failed != 0);
+}
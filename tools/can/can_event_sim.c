@@ -0,0 +1,320 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host simulation of the event triggered CAN message
+//
+// Runs the periodic scheduler and the event triggers of the firmware against
+// the loopback bus. Sensor edges (pedal steps, brake presses and releases,
+// sensor faults) are placed at random times between the ADC samples, the
+// ADC frames carry DWT style timestamps like on the target. For every edge
+// the time until the first frame reporting it has left the bus is measured,
+// once for the event message and once for the periodic FS_Pedals message.
+// A second phase chatters the brake around its threshold on every sample to
+// show the rate limit.
+//
+// Usage: can_event_sim [seconds] [bitrate]
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "timestamp.h"
+#include "can_loopback.h"
+#include "can_scheduler.h"
+#include "can_events.h"
+
+#define SIM_ADC_PERIOD_NS       (1000000000ULL / ADC_SAMPLE_RATE_HZ)
+#define SIM_TICK_PERIOD_NS      (1000000000ULL / CAN_SCHEDULER_TICK_HZ)
+
+// 4 steps with 8x hardware averaging at 1 Msps before the interrupt
+#define SIM_CONVERSION_NS       32000
+
+#define SIM_MAX_SAMPLES         4096
+
+//*****************************************************************************
+//
+// The sensor edges of the first phase, repeated in this order.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Ch;
+    uint16_t ui16Value;
+    uint8_t ui8Cause;                   // cause bit the event must carry
+}
+tSimEdge;
+
+static const tSimEdge g_psSimEdges[] =
+{
+    { "pedal step up",   ADC_CH_THROTTLE, 2000, CAN_EVENT_CAUSE_PEDAL_STEP },
+    { "pedal step down", ADC_CH_THROTTLE, 600,  CAN_EVENT_CAUSE_PEDAL_STEP },
+    { "brake on",        ADC_CH_BRAKE,    2000, CAN_EVENT_CAUSE_BRAKE_ON },
+    { "brake off",       ADC_CH_BRAKE,    400,  CAN_EVENT_CAUSE_BRAKE_OFF },
+    { "throttle short",  ADC_CH_THROTTLE, 4095, CAN_EVENT_CAUSE_FAULT },
+    { "throttle ok",     ADC_CH_THROTTLE, 600,  CAN_EVENT_CAUSE_FAULT },
+};
+
+#define SIM_NUM_EDGES   (sizeof(g_psSimEdges) / sizeof(g_psSimEdges[0]))
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint64_t pui64Latency[SIM_MAX_SAMPLES];
+}
+tSimLatency;
+
+static tSimLatency g_psSimEvent[SIM_NUM_EDGES];
+static tSimLatency g_psSimPeriodic[SIM_NUM_EDGES];
+
+static uint16_t g_pui16SimSensor[ADC_NUM_CHANNELS];
+static tADCFrame g_sSimFrame;
+
+// the edge waiting to be seen on the bus
+static bool g_bSimEdgeEvent, g_bSimEdgePeriodic;
+static uint32_t g_ui32SimEdge;
+static uint64_t g_ui64SimEdgeTime;
+
+static uint32_t g_ui32SimEventFrames;
+static uint32_t g_ui32SimRandom = 12345;
+
+static uint32_t SimRandom(uint32_t ui32Range)
+{
+    g_ui32SimRandom = g_ui32SimRandom * 1103515245 + 12345;
+    return (g_ui32SimRandom >> 8) % ui32Range;
+}
+
+static void SimRecord(tSimLatency *psLat, uint64_t ui64Latency)
+{
+    if(psLat->ui32Count < SIM_MAX_SAMPLES)
+    {
+        psLat->pui64Latency[psLat->ui32Count++] = ui64Latency;
+    }
+}
+
+//*****************************************************************************
+//
+// Bus receiver: matches frames against the edge under test.
+//
+//*****************************************************************************
+static void SimReceive(const tCANFrame *psFrame, uint64_t ui64TimeNs,
+                       void *pvContext)
+{
+    const tSimEdge *psEdge = &g_psSimEdges[g_ui32SimEdge];
+    uint64_t ui64Data = 0;
+    uint32_t ui32Idx, ui32Value;
+
+    (void)pvContext;
+
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        ui64Data |= (uint64_t)psFrame->pui8Data[ui32Idx] << (8 * ui32Idx);
+    }
+
+    if(psFrame->ui32Id == CAN_EVENT_ID)
+    {
+        g_ui32SimEventFrames++;
+
+        if(g_bSimEdgeEvent && ((ui64Data & 0xFF) & psEdge->ui8Cause))
+        {
+            SimRecord(&g_psSimEvent[g_ui32SimEdge],
+                      ui64TimeNs - g_ui64SimEdgeTime);
+            g_bSimEdgeEvent = false;
+        }
+    }
+    else if((psFrame->ui32Id == 0x100) && g_bSimEdgePeriodic)
+    {
+        //
+        // FS_Pedals: throttle at bit 0, brake at bit 16.
+        //
+        ui32Value = (uint32_t)(ui64Data >>
+                               ((psEdge->ui32Ch == ADC_CH_BRAKE) ?
+                                16 : 0)) & 0xFFF;
+        if(ui32Value == psEdge->ui16Value)
+        {
+            SimRecord(&g_psSimPeriodic[g_ui32SimEdge],
+                      ui64TimeNs - g_ui64SimEdgeTime);
+            g_bSimEdgePeriodic = false;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Runs the ADC, the tick and the bus until the given time. With bChatter the
+// brake reading alternates around the threshold on every sample.
+//
+//*****************************************************************************
+static uint64_t g_ui64SimNextADC, g_ui64SimNextTick;
+
+static void SimRun(uint64_t ui64Until, bool bChatter)
+{
+    uint64_t ui64Sample;
+    uint32_t ui32Ch;
+
+    while(1)
+    {
+        ui64Sample = g_ui64SimNextADC + SIM_CONVERSION_NS;
+
+        if((ui64Sample <= g_ui64SimNextTick) && (ui64Sample <= ui64Until))
+        {
+            //
+            // The conversion started at the timer trigger, the interrupt
+            // publishes the frame when it is done.
+            //
+            CANLoopbackRun(ui64Sample);
+
+            if(bChatter)
+            {
+                g_pui16SimSensor[ADC_CH_BRAKE] =
+                    (g_sSimFrame.ui32Seq & 1) ? 650 : 850;
+            }
+            for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+            {
+                g_sSimFrame.pui16Data[ui32Ch] = g_pui16SimSensor[ui32Ch];
+            }
+            g_sSimFrame.ui32Seq++;
+            g_sSimFrame.ui32Time =
+                (uint32_t)((ui64Sample * TIMESTAMP_CYCLES_PER_US) / 1000);
+
+            CANEventsProcess(&g_sSimFrame);
+            g_ui64SimNextADC += SIM_ADC_PERIOD_NS;
+        }
+        else if(g_ui64SimNextTick <= ui64Until)
+        {
+            CANLoopbackRun(g_ui64SimNextTick);
+            CANSchedulerTick(&g_sSimFrame);
+            g_ui64SimNextTick += SIM_TICK_PERIOD_NS;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    CANLoopbackRun(ui64Until);
+}
+
+static void SimReset(uint32_t ui32Bitrate)
+{
+    CANLoopbackInit(ui32Bitrate, SimReceive, NULL);
+    CANSchedulerInit(&g_sCANLoopbackPort);
+    CANEventsInit(&g_sCANLoopbackPort);
+
+    g_pui16SimSensor[ADC_CH_THROTTLE] = 600;
+    g_pui16SimSensor[ADC_CH_BRAKE] = 400;
+    g_pui16SimSensor[2] = 2048;
+    g_pui16SimSensor[3] = 2048;
+
+    g_ui64SimNextADC = 0;
+    g_ui64SimNextTick = SIM_TICK_PERIOD_NS;
+    g_ui32SimEventFrames = 0;
+}
+
+static int SimCompare(const void *pvA, const void *pvB)
+{
+    uint64_t ui64A = *(const uint64_t *)pvA, ui64B = *(const uint64_t *)pvB;
+
+    return (ui64A > ui64B) - (ui64A < ui64B);
+}
+
+static void SimPrint(const char *pcPath, tSimLatency *psLat)
+{
+    uint64_t ui64Sum = 0;
+    uint32_t ui32Idx, ui32N = psLat->ui32Count;
+
+    if(ui32N == 0)
+    {
+        printf("  %-9s no samples\n", pcPath);
+        return;
+    }
+
+    qsort(psLat->pui64Latency, ui32N, sizeof(uint64_t), SimCompare);
+    for(ui32Idx = 0; ui32Idx < ui32N; ui32Idx++)
+    {
+        ui64Sum += psLat->pui64Latency[ui32Idx];
+    }
+
+    printf("  %-9s n %4u  min %7.1f  avg %7.1f  p99 %7.1f  max %7.1f us\n",
+           pcPath, ui32N, psLat->pui64Latency[0] / 1e3,
+           ui64Sum / 1e3 / ui32N,
+           psLat->pui64Latency[(ui32N * 99) / 100] / 1e3,
+           psLat->pui64Latency[ui32N - 1] / 1e3);
+}
+
+int main(int argc, char *argv[])
+{
+    const tCANEventStats *psStats;
+    uint64_t ui64Now, ui64Busy;
+    uint32_t ui32Seconds = 10, ui32Bitrate = 500000, ui32Idx;
+    uint32_t ui32Lost = 0;
+
+    if(argc > 1)
+    {
+        ui32Seconds = strtoul(argv[1], NULL, 0);
+    }
+    if(argc > 2)
+    {
+        ui32Bitrate = strtoul(argv[2], NULL, 0);
+    }
+
+    //
+    // Phase 1: one edge every 20..60ms, at a random point between samples.
+    //
+    SimReset(ui32Bitrate);
+    SimRun(10000000, false);
+    ui64Now = 10000000;
+    ui32Idx = 0;
+
+    while(ui64Now < (uint64_t)ui32Seconds * 1000000000ULL)
+    {
+        g_ui32SimEdge = ui32Idx;
+        g_ui64SimEdgeTime = ui64Now + SimRandom(1000000);
+        SimRun(g_ui64SimEdgeTime, false);
+
+        g_pui16SimSensor[g_psSimEdges[ui32Idx].ui32Ch] =
+            g_psSimEdges[ui32Idx].ui16Value;
+        g_bSimEdgeEvent = true;
+        g_bSimEdgePeriodic = true;
+
+        ui64Now = g_ui64SimEdgeTime + 20000000 + SimRandom(40000000);
+        SimRun(ui64Now, false);
+
+        if(g_bSimEdgeEvent)
+        {
+            ui32Lost++;
+        }
+
+        ui32Idx = (ui32Idx + 1) % SIM_NUM_EDGES;
+    }
+
+    psStats = CANEventsStats();
+    printf("sensor edge to frame on wire, %u s at %u bit/s\n", ui32Seconds,
+           ui32Bitrate);
+    for(ui32Idx = 0; ui32Idx < SIM_NUM_EDGES; ui32Idx++)
+    {
+        printf("%s\n", g_psSimEdges[ui32Idx].pcName);
+        SimPrint("event", &g_psSimEvent[ui32Idx]);
+        SimPrint("periodic", &g_psSimPeriodic[ui32Idx]);
+    }
+    printf("event frames %u merged %u deferred %u, edges not reported %u\n",
+           psStats->ui32Sent, psStats->ui32Merged, psStats->ui32Deferred,
+           ui32Lost);
+
+    //
+    // Phase 2: brake chattering across the threshold for one second.
+    //
+    SimReset(ui32Bitrate);
+    SimRun(1000000000, true);
+    ui64Busy = CANLoopbackBusyTime();
+
+    printf("\nbrake chatter for 1 s: %u brake events, %u event frames on the "
+           "bus (limit %u), deferred %u, bus load %.1f %%\n",
+           psStats->pui32Causes[0] + psStats->pui32Causes[1],
+           g_ui32SimEventFrames,
+           CAN_EVENT_BURST + (1000000 / CAN_EVENT_REFILL_US),
+           psStats->ui32Deferred, 100.0 * ui64Busy / 1e9);
+
+    return (ui32Lost != 0) ||
+           (g_ui32SimEventFrames >
+            CAN_EVENT_BURST + (1000000 / CAN_EVENT_REFILL_US));
+}
@@ -0,0 +1,235 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host simulation of the periodic CAN messages
+//
+// Runs the message scheduler of the firmware against the loopback bus for a
+// number of simulated seconds with a synthetic 8 kHz ADC stream and reports
+// the rate, latency and bus load of every message. The received frames are
+// decoded with the signal table to check the packing.
+//
+// Usage: can_sim [seconds] [bitrate]
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "can_loopback.h"
+#include "can_scheduler.h"
+
+#define SIM_ADC_PERIOD_NS       (1000000000ULL / ADC_SAMPLE_RATE_HZ)
+#define SIM_TICK_PERIOD_NS      (1000000000ULL / CAN_SCHEDULER_TICK_HZ)
+
+typedef struct
+{
+    uint32_t ui32Received;
+    uint32_t ui32CounterErrors;
+    uint32_t ui32ValueErrors;
+    uint32_t ui32LastCounter;
+    uint64_t ui64LoadTime;
+    uint64_t ui64LatencySum;
+    uint64_t ui64LatencyMax;
+}
+tSimMessage;
+
+static tSimMessage g_psSimMessages[CAN_SCHEDULER_MAX_MESSAGES];
+static tADCFrame g_sSimFrame;
+static uint64_t g_ui64SimNow;
+
+//*****************************************************************************
+//
+// Synthetic sensor readings, the frame sequence number offset by a quarter
+// of the range on every channel so any reading gives back the sequence.
+//
+//*****************************************************************************
+static uint16_t SimADCValue(uint32_t ui32Seq, uint32_t ui32Ch)
+{
+    return (uint16_t)((ui32Seq + (ui32Ch * 1024)) & 0xFFF);
+}
+
+static int SimFindMessage(uint32_t ui32Id)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32CANNumMessages; ui32Idx++)
+    {
+        if(g_psCANMessages[ui32Idx].ui32Id == ui32Id)
+        {
+            return (int)ui32Idx;
+        }
+    }
+
+    return -1;
+}
+
+//*****************************************************************************
+//
+// Records the load time and passes the frame on to the loopback controller.
+//
+//*****************************************************************************
+static void SimObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame)
+{
+    int iMsg = SimFindMessage(psFrame->ui32Id);
+
+    if(iMsg >= 0)
+    {
+        g_psSimMessages[iMsg].ui64LoadTime = g_ui64SimNow;
+    }
+
+    g_sCANLoopbackPort.pfnObjectLoad(ui32Obj, psFrame);
+}
+
+static const tCANPort g_sSimPort =
+{
+    SimObjectLoad
+};
+
+//*****************************************************************************
+//
+// Decodes a received frame. The packed readings must all belong to the same
+// ADC frame and the counter must advance by one.
+//
+//*****************************************************************************
+static void SimReceive(const tCANFrame *psFrame, uint64_t ui64TimeNs,
+                       void *pvContext)
+{
+    const tCANMessage *psMsg;
+    const tCANSignal *psSignal;
+    tSimMessage *psSim;
+    uint64_t ui64Data = 0, ui64Latency;
+    uint32_t ui32Idx, ui32Value, ui32Seq = 0;
+    bool bHaveSeq = false;
+    int iMsg;
+
+    (void)pvContext;
+
+    iMsg = SimFindMessage(psFrame->ui32Id);
+    if(iMsg < 0)
+    {
+        return;
+    }
+    psMsg = &g_psCANMessages[iMsg];
+    psSim = &g_psSimMessages[iMsg];
+
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        ui64Data |= (uint64_t)psFrame->pui8Data[ui32Idx] << (8 * ui32Idx);
+    }
+
+    for(ui32Idx = 0; ui32Idx < psMsg->ui8NumSignals; ui32Idx++)
+    {
+        psSignal = &psMsg->psSignals[ui32Idx];
+        ui32Value = (uint32_t)(ui64Data >> psSignal->ui8StartBit) &
+                    ((1UL << psSignal->ui8Length) - 1);
+
+        if(psSignal->ui8Source == CAN_SRC_COUNTER)
+        {
+            if((psSim->ui32Received != 0) &&
+               (ui32Value != ((psSim->ui32LastCounter + 1) &
+                              ((1UL << psSignal->ui8Length) - 1))))
+            {
+                psSim->ui32CounterErrors++;
+            }
+            psSim->ui32LastCounter = ui32Value;
+        }
+        else if(!bHaveSeq)
+        {
+            ui32Seq = (ui32Value - (psSignal->ui8Source * 1024)) & 0xFFF;
+            bHaveSeq = true;
+        }
+        else if(SimADCValue(ui32Seq, psSignal->ui8Source) != ui32Value)
+        {
+            psSim->ui32ValueErrors++;
+        }
+    }
+
+    ui64Latency = ui64TimeNs - psSim->ui64LoadTime;
+    psSim->ui64LatencySum += ui64Latency;
+    if(ui64Latency > psSim->ui64LatencyMax)
+    {
+        psSim->ui64LatencyMax = ui64Latency;
+    }
+    psSim->ui32Received++;
+}
+
+int main(int argc, char *argv[])
+{
+    const tCANMessageStats *psStats;
+    tSimMessage *psSim;
+    uint64_t ui64End, ui64NextADC = 0, ui64NextTick = SIM_TICK_PERIOD_NS;
+    uint32_t ui32Seconds = 1, ui32Bitrate = 500000, ui32Idx, ui32Ch;
+    int iErrors = 0;
+
+    if(argc > 1)
+    {
+        ui32Seconds = strtoul(argv[1], NULL, 0);
+    }
+    if(argc > 2)
+    {
+        ui32Bitrate = strtoul(argv[2], NULL, 0);
+    }
+    ui64End = (uint64_t)ui32Seconds * 1000000000ULL;
+
+    CANLoopbackInit(ui32Bitrate, SimReceive, NULL);
+    CANSchedulerInit(&g_sSimPort);
+
+    //
+    // The ADC interrupt outranks the tick, so at equal times the frame is
+    // published first.
+    //
+    while(ui64NextTick <= ui64End)
+    {
+        if(ui64NextADC <= ui64NextTick)
+        {
+            g_ui64SimNow = ui64NextADC;
+            CANLoopbackRun(g_ui64SimNow);
+
+            for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+            {
+                g_sSimFrame.pui16Data[ui32Ch] =
+                    SimADCValue(g_sSimFrame.ui32Seq + 1, ui32Ch);
+            }
+            g_sSimFrame.ui32Seq++;
+            ui64NextADC += SIM_ADC_PERIOD_NS;
+        }
+        else
+        {
+            g_ui64SimNow = ui64NextTick;
+            CANLoopbackRun(g_ui64SimNow);
+            CANSchedulerTick(&g_sSimFrame);
+            ui64NextTick += SIM_TICK_PERIOD_NS;
+        }
+    }
+    CANLoopbackRun(ui64End + SIM_TICK_PERIOD_NS);
+
+    printf("%u s at %u bit/s, bus load %.1f %%\n", ui32Seconds, ui32Bitrate,
+           100.0 * CANLoopbackBusyTime() / (double)ui64End);
+    printf("%-12s %5s %6s %8s %8s %8s %6s %8s %8s\n", "message", "id",
+           "period", "sent", "received", "rate/s", "overwr", "lat avg",
+           "lat max");
+
+    for(ui32Idx = 0; ui32Idx < g_ui32CANNumMessages; ui32Idx++)
+    {
+        psStats = CANSchedulerStats(ui32Idx);
+        psSim = &g_psSimMessages[ui32Idx];
+
+        printf("%-12s 0x%03x %4u ms %8u %8u %8.1f %6u %5.1f us %5.1f us\n",
+               g_psCANMessages[ui32Idx].pcName,
+               g_psCANMessages[ui32Idx].ui32Id,
+               g_psCANMessages[ui32Idx].ui16PeriodMs, psStats->ui32Sent,
+               psSim->ui32Received,
+               (double)psSim->ui32Received / ui32Seconds,
+               psStats->ui32Overwritten,
+               psSim->ui32Received ?
+                   psSim->ui64LatencySum / 1e3 / psSim->ui32Received : 0.0,
+               psSim->ui64LatencyMax / 1e3);
+
+        if(psSim->ui32CounterErrors || psSim->ui32ValueErrors)
+        {
+            printf("  counter errors %u value errors %u\n",
+                   psSim->ui32CounterErrors, psSim->ui32ValueErrors);
+            iErrors = 1;
+        }
+    }
+
+    return iErrors;
+}
@@ -0,0 +1,320 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Throughput and compression ratio benchmark of compress.c
+//
+// Usage: compress_bench [frames.csv]
+// Without a file synthetic 8kHz sensor signals with different noise levels
+// are used. A CSV written by telemetry_dump (seq,time_us,ch0,...) benchmarks
+// a real capture. Every block is decoded again and compared.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "compress.h"
+
+#define BENCH_SAMPLE_RATE_HZ    8000
+#define BENCH_CYCLES_PER_SAMPLE (80000000 / BENCH_SAMPLE_RATE_HZ)
+#define BENCH_BLOCK_FRAMES      16      // as used by the telemetry task
+#define BENCH_RUNS              5
+
+typedef struct
+{
+    uint32_t ui32Frames;
+    uint32_t ui32Channels;
+    uint32_t *pui32Seq;
+    uint32_t *pui32Time;
+    uint16_t *pui16Data;                // ui32Frames * ui32Channels
+}
+tBenchData;
+
+static double BenchNow(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return sTime.tv_sec + (sTime.tv_nsec * 1e-9);
+}
+
+static void BenchAlloc(tBenchData *psData, uint32_t ui32Frames,
+                       uint32_t ui32Channels)
+{
+    psData->ui32Frames = ui32Frames;
+    psData->ui32Channels = ui32Channels;
+    psData->pui32Seq = malloc(ui32Frames * sizeof(uint32_t));
+    psData->pui32Time = malloc(ui32Frames * sizeof(uint32_t));
+    psData->pui16Data = malloc(ui32Frames * ui32Channels * sizeof(uint16_t));
+}
+
+//*****************************************************************************
+//
+// Slow sensor movement plus uniform noise of +-ui32Noise counts, timestamps
+// with a few cycles of interrupt jitter.
+//
+//*****************************************************************************
+static void BenchSynthetic(tBenchData *psData, uint32_t ui32Frames,
+                           uint32_t ui32Channels, uint32_t ui32Noise)
+{
+    uint32_t ui32Idx, ui32Ch;
+    double dValue;
+
+    BenchAlloc(psData, ui32Frames, ui32Channels);
+    srand(1);
+
+    for(ui32Idx = 0; ui32Idx < ui32Frames; ui32Idx++)
+    {
+        psData->pui32Seq[ui32Idx] = ui32Idx;
+        psData->pui32Time[ui32Idx] = (ui32Idx * BENCH_CYCLES_PER_SAMPLE) +
+                                     (rand() % 24);
+        for(ui32Ch = 0; ui32Ch < ui32Channels; ui32Ch++)
+        {
+            dValue = 2048 + 1500 * sin((ui32Idx * (ui32Ch + 1) * 2 * M_PI) /
+                                       (BENCH_SAMPLE_RATE_HZ * 2.0));
+            if(ui32Noise)
+            {
+                dValue += (int32_t)(rand() % (2 * ui32Noise + 1)) -
+                          (int32_t)ui32Noise;
+            }
+            psData->pui16Data[(ui32Idx * ui32Channels) + ui32Ch] =
+                (uint16_t)dValue & 0xFFF;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Loads a telemetry_dump CSV.
+//
+//*****************************************************************************
+static int BenchLoadCSV(tBenchData *psData, const char *pcFile)
+{
+    FILE *psIn = fopen(pcFile, "r");
+    char pcLine[512], *pcField;
+    uint32_t ui32Max = 1024, ui32Ch;
+    double dTime;
+
+    if(psIn == NULL)
+    {
+        perror(pcFile);
+        return -1;
+    }
+
+    //
+    // The channel count follows from the header line.
+    //
+    if(fgets(pcLine, sizeof(pcLine), psIn) == NULL)
+    {
+        fclose(psIn);
+        return -1;
+    }
+    ui32Ch = 0;
+    for(pcField = pcLine; (pcField = strstr(pcField, ",ch")) != NULL;
+        pcField++)
+    {
+        ui32Ch++;
+    }
+    if((ui32Ch == 0) || (ui32Ch > COMPRESS_MAX_CHANNELS))
+    {
+        fprintf(stderr, "%s: unsupported channel count %u\n", pcFile, ui32Ch);
+        fclose(psIn);
+        return -1;
+    }
+
+    BenchAlloc(psData, ui32Max, ui32Ch);
+    psData->ui32Frames = 0;
+
+    while(fgets(pcLine, sizeof(pcLine), psIn))
+    {
+        if(psData->ui32Frames == ui32Max)
+        {
+            ui32Max *= 2;
+            psData->pui32Seq = realloc(psData->pui32Seq,
+                                       ui32Max * sizeof(uint32_t));
+            psData->pui32Time = realloc(psData->pui32Time,
+                                        ui32Max * sizeof(uint32_t));
+            psData->pui16Data = realloc(psData->pui16Data,
+                                        ui32Max * ui32Ch * sizeof(uint16_t));
+        }
+
+        pcField = strtok(pcLine, ",");
+        psData->pui32Seq[psData->ui32Frames] = strtoul(pcField, NULL, 0);
+        dTime = strtod(strtok(NULL, ","), NULL);
+        psData->pui32Time[psData->ui32Frames] = (uint32_t)(dTime * 80.0);
+        for(ui32Ch = 0; ui32Ch < psData->ui32Channels; ui32Ch++)
+        {
+            pcField = strtok(NULL, ",");
+            psData->pui16Data[(psData->ui32Frames * psData->ui32Channels) +
+                              ui32Ch] =
+                pcField ? (uint16_t)strtoul(pcField, NULL, 0) : 0;
+        }
+        psData->ui32Frames++;
+    }
+
+    fclose(psIn);
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Compresses the data in blocks, then decodes and compares. Prints ratio and
+// throughput, returns the number of mismatching frames.
+//
+//*****************************************************************************
+static uint32_t BenchRun(const char *pcName, const tBenchData *psData)
+{
+    static tCompressBlock sBlock;
+    tCompressHeader sHeader;
+    uint32_t pui32Time[COMPRESS_MAX_FRAMES];
+    uint16_t pui16Out[COMPRESS_MAX_FRAMES * COMPRESS_MAX_CHANNELS];
+    uint8_t *pui8Packed, *pui8Pos;
+    uint32_t ui32Idx, ui32Frame, ui32Ch, ui32Run, ui32Errors = 0;
+    uint32_t ui32Channels = psData->ui32Channels;
+    size_t ui32Packed = 0, ui32Raw, ui32Ideal;
+    double dStart, dEncode = 1e9, dDecode = 1e9, dTime;
+    int32_t i32Len;
+
+    pui8Packed = malloc(((psData->ui32Frames / BENCH_BLOCK_FRAMES) + 1) *
+                        COMPRESS_BLOCK_MAX(BENCH_BLOCK_FRAMES, ui32Channels));
+
+    for(ui32Run = 0; ui32Run < BENCH_RUNS; ui32Run++)
+    {
+        dStart = BenchNow();
+        CompressBlockInit(&sBlock, ui32Channels);
+        pui8Pos = pui8Packed;
+        for(ui32Idx = 0; ui32Idx < psData->ui32Frames; ui32Idx++)
+        {
+            while(CompressBlockAdd(&sBlock, psData->pui32Seq[ui32Idx],
+                                   psData->pui32Time[ui32Idx],
+                                   &psData->pui16Data[ui32Idx *
+                                                      ui32Channels]) == 0)
+            {
+                pui8Pos += CompressBlockFinish(&sBlock, pui8Pos);
+            }
+            if(sBlock.ui32Count == BENCH_BLOCK_FRAMES)
+            {
+                pui8Pos += CompressBlockFinish(&sBlock, pui8Pos);
+            }
+        }
+        if(sBlock.ui32Count)
+        {
+            pui8Pos += CompressBlockFinish(&sBlock, pui8Pos);
+        }
+        dTime = BenchNow() - dStart;
+        dEncode = (dTime < dEncode) ? dTime : dEncode;
+        ui32Packed = pui8Pos - pui8Packed;
+    }
+
+    for(ui32Run = 0; ui32Run < BENCH_RUNS; ui32Run++)
+    {
+        dStart = BenchNow();
+        pui8Pos = pui8Packed;
+        ui32Frame = 0;
+        while(pui8Pos < pui8Packed + ui32Packed)
+        {
+            i32Len = CompressBlockDecode(pui8Pos,
+                                         pui8Packed + ui32Packed - pui8Pos,
+                                         &sHeader, pui32Time, pui16Out);
+            if(i32Len < 0)
+            {
+                ui32Errors++;
+                break;
+            }
+            pui8Pos += i32Len;
+
+            if(ui32Run != 0)
+            {
+                ui32Frame += sHeader.ui32Count;
+                continue;
+            }
+
+            for(ui32Idx = 0; ui32Idx < sHeader.ui32Count; ui32Idx++, ui32Frame++)
+            {
+                if((sHeader.ui32Seq + (ui32Idx * sHeader.ui32Step) !=
+                    psData->pui32Seq[ui32Frame]) ||
+                   (pui32Time[ui32Idx] != psData->pui32Time[ui32Frame]))
+                {
+                    ui32Errors++;
+                    continue;
+                }
+                for(ui32Ch = 0; ui32Ch < ui32Channels; ui32Ch++)
+                {
+                    if(pui16Out[(ui32Idx * ui32Channels) + ui32Ch] !=
+                       psData->pui16Data[(ui32Frame * ui32Channels) + ui32Ch])
+                    {
+                        ui32Errors++;
+                        break;
+                    }
+                }
+            }
+        }
+        dTime = BenchNow() - dStart;
+        dDecode = (dTime < dDecode) ? dTime : dDecode;
+        if(ui32Frame != psData->ui32Frames)
+        {
+            ui32Errors++;
+        }
+    }
+
+    //
+    // Raw: the uncompressed telemetry frame. Ideal: 12-bit samples and
+    // 32-bit seq/time packed without gaps.
+    //
+    ui32Raw = (size_t)psData->ui32Frames * (8 + (2 * ui32Channels));
+    ui32Ideal = ((size_t)psData->ui32Frames * (64 + (12 * ui32Channels))) / 8;
+
+    printf("%-24s %2u ch %8u frames: %6.2f B/frame, ratio %5.2f (raw) "
+           "%5.2f (12-bit), encode %6.1f Mframe/s, decode %6.1f Mframe/s%s\n",
+           pcName, ui32Channels, psData->ui32Frames,
+           (double)ui32Packed / psData->ui32Frames,
+           (double)ui32Raw / ui32Packed, (double)ui32Ideal / ui32Packed,
+           psData->ui32Frames / dEncode / 1e6,
+           psData->ui32Frames / dDecode / 1e6,
+           ui32Errors ? "  MISMATCH" : "");
+
+    free(pui8Packed);
+    return ui32Errors;
+}
+
+static void BenchFree(tBenchData *psData)
+{
+    free(psData->pui32Seq);
+    free(psData->pui32Time);
+    free(psData->pui16Data);
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint32_t pui32Noise[] = { 0, 2, 8, 32, 2048 };
+    tBenchData sData;
+    uint32_t ui32Idx, ui32Ch, ui32Errors = 0;
+    char pcName[32];
+
+    if(argc > 1)
+    {
+        if(BenchLoadCSV(&sData, argv[1]) != 0)
+        {
+            return 1;
+        }
+        ui32Errors += BenchRun(argv[1], &sData);
+        BenchFree(&sData);
+        return ui32Errors != 0;
+    }
+
+    for(ui32Ch = 4; ui32Ch <= COMPRESS_MAX_CHANNELS; ui32Ch *= 2)
+    {
+        for(ui32Idx = 0; ui32Idx < sizeof(pui32Noise) / sizeof(pui32Noise[0]);
+            ui32Idx++)
+        {
+            snprintf(pcName, sizeof(pcName), "sine, noise +-%u",
+                     pui32Noise[ui32Idx]);
+            BenchSynthetic(&sData, 10 * BENCH_SAMPLE_RATE_HZ, ui32Ch,
+                           pui32Noise[ui32Idx]);
+            ui32Errors += BenchRun(pcName, &sData);
+            BenchFree(&sData);
+        }
+    }
+
+    return ui32Errors != 0;
+}
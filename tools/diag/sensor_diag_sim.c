@@ -0,0 +1,285 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host simulation of the sensor diagnostics with injected faults
+//
+// Feeds SensorDiagProcess() with 8kHz frames of four healthy sensor signals:
+// slow movement, pedal stomps of full travel in 50ms and a few counts of
+// noise. Every scenario injects one fault on one channel for a while and
+// checks that exactly the expected DTC is set within its latency and clears
+// again after the fault is gone. The "clean" scenario injects nothing and
+// must not set any DTC.
+//
+// Usage: sensor_diag_sim [-v]
+// Exits with 1 if a scenario fails.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sensor_diag.h"
+
+#define SIM_FRAMES(ms)          (((ms) * ADC_SAMPLE_RATE_HZ) / 1000)
+#define SIM_RUN_MS              4000
+#define SIM_FAULT_START_MS      1000
+#define SIM_NOISE_COUNTS        3
+
+#define SIM_FAULT_NONE          0
+#define SIM_FAULT_OPEN          1
+#define SIM_FAULT_SHORT         2
+#define SIM_FAULT_STUCK         3
+#define SIM_FAULT_NOISE         4
+#define SIM_FAULT_SPIKES        5
+#define SIM_FAULT_INTERMITTENT  6
+#define SIM_FAULT_GLITCH        7
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Fault;
+    uint32_t ui32Ch;
+    uint32_t ui32LengthMs;
+    int32_t i32Type;                    // expected DTC type, -1 for none
+    uint32_t ui32Also;                  // other types allowed on the channel
+    uint32_t ui32MaxSetMs;              // latency from the fault start
+    uint32_t ui32MaxClearMs;            // latency from the fault end
+}
+tSimScenario;
+
+static const tSimScenario g_psSimScenarios[] =
+{
+    { "clean",             SIM_FAULT_NONE,         0, 0,    -1, 0, 0, 0 },
+    { "single glitch",     SIM_FAULT_GLITCH,       1, 1,    -1, 0, 0, 0 },
+    { "open wire",         SIM_FAULT_OPEN,         0, 300,  SENSOR_DIAG_OPEN,  0, 12, 110 },
+    { "short to supply",   SIM_FAULT_SHORT,        1, 300,  SENSOR_DIAG_SHORT, 0, 12, 110 },
+    { "frozen reading",    SIM_FAULT_STUCK,        2, 1500, SENSOR_DIAG_STUCK, 0, 1002, 110 },
+    { "loose contact",     SIM_FAULT_NOISE,        3, 300,  SENSOR_DIAG_NOISE, 0, 25, 150 },
+    { "wiper spikes",      SIM_FAULT_SPIKES,       1, 300,  SENSOR_DIAG_RATE,  0, 10, 110 },
+    // a contact lost and found every frame is also noise and steps
+    { "intermittent open", SIM_FAULT_INTERMITTENT, 2, 300,  SENSOR_DIAG_OPEN,
+      (1 << SENSOR_DIAG_NOISE) | (1 << SENSOR_DIAG_RATE), 40, 150 },
+};
+
+#define SIM_NUM_SCENARIOS   (sizeof(g_psSimScenarios) / sizeof(g_psSimScenarios[0]))
+
+static uint32_t g_ui32SimRandom = 1;
+static bool g_bSimVerbose = false;
+
+static uint32_t SimRandom(uint32_t ui32Range)
+{
+    g_ui32SimRandom = (g_ui32SimRandom * 1103515245) + 12345;
+    return (g_ui32SimRandom >> 8) % ui32Range;
+}
+
+//*****************************************************************************
+//
+// Roughly normal noise of the given deviation, the sum of four uniforms.
+//
+//*****************************************************************************
+static int32_t SimNoise(uint32_t ui32Deviation)
+{
+    int32_t i32Sum = 0, i32Idx;
+
+    for(i32Idx = 0; i32Idx < 4; i32Idx++)
+    {
+        i32Sum += (int32_t)SimRandom(2001) - 1000;
+    }
+
+    return (i32Sum * (int32_t)ui32Deviation * 1732) / (2 * 1000 * 1000);
+}
+
+//*****************************************************************************
+//
+// A healthy sensor: slow movement over the 410..3686 range of a 0.5..4.5V
+// sensor, with a pedal stomp to full travel and back in 50ms every second.
+//
+//*****************************************************************************
+static int32_t SimHealthy(uint32_t ui32Ch, uint32_t ui32Frame)
+{
+    double dTime = (double)ui32Frame / ADC_SAMPLE_RATE_HZ;
+    double dPhase = dTime - floor(dTime);
+    double dValue = 1500 + 600 * sin(2 * M_PI * (0.3 + 0.2 * ui32Ch) * dTime);
+
+    if((ui32Ch == 0) && (dPhase >= 0.5) && (dPhase < 0.6))
+    {
+        dValue += (3600 - dValue) * ((dPhase < 0.55) ? (dPhase - 0.5) / 0.05 :
+                                     (0.6 - dPhase) / 0.05);
+    }
+
+    return (int32_t)dValue + SimNoise(SIM_NOISE_COUNTS);
+}
+
+static uint16_t SimClamp(int32_t i32Value)
+{
+    return (i32Value < 0) ? 0 : (i32Value > 4095) ? 4095 : (uint16_t)i32Value;
+}
+
+//*****************************************************************************
+//
+// Runs one scenario, returns true if it passed.
+//
+//*****************************************************************************
+static bool SimRun(const tSimScenario *psScenario)
+{
+    tADCFrame sFrame;
+    uint32_t ui32Frame, ui32Ch, ui32Active, ui32Prev = 0, ui32Expect = 0;
+    uint32_t ui32Allowed = 0, ui32Type;
+    uint32_t ui32Start = SIM_FRAMES(SIM_FAULT_START_MS);
+    uint32_t ui32End = ui32Start + SIM_FRAMES(psScenario->ui32LengthMs);
+    uint32_t ui32Set = 0, ui32Clear = 0, ui32Other = 0;
+    uint16_t ui16Stuck = 0;
+    int32_t i32Value;
+    bool bFault, bPass;
+
+    SensorDiagInit();
+    if(psScenario->i32Type >= 0)
+    {
+        ui32Expect = SENSOR_DIAG_DTC(psScenario->ui32Ch, psScenario->i32Type);
+    }
+    for(ui32Type = 0; ui32Type < SENSOR_DIAG_NUM_TYPES; ui32Type++)
+    {
+        if(psScenario->ui32Also & (1 << ui32Type))
+        {
+            ui32Allowed |= SENSOR_DIAG_DTC(psScenario->ui32Ch, ui32Type);
+        }
+    }
+
+    for(ui32Frame = 0; ui32Frame < SIM_FRAMES(SIM_RUN_MS); ui32Frame++)
+    {
+        sFrame.ui32Seq = ui32Frame;
+        sFrame.ui32Time = ui32Frame * (80000000 / ADC_SAMPLE_RATE_HZ);
+        bFault = (ui32Frame >= ui32Start) && (ui32Frame < ui32End);
+
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            i32Value = SimHealthy(ui32Ch, ui32Frame);
+
+            if(bFault && (ui32Ch == psScenario->ui32Ch))
+            {
+                switch(psScenario->ui32Fault)
+                {
+                    case SIM_FAULT_OPEN:
+                        i32Value = SimRandom(20);
+                        break;
+                    case SIM_FAULT_SHORT:
+                        i32Value = 4095 - SimRandom(10);
+                        break;
+                    case SIM_FAULT_STUCK:
+                        if(ui32Frame == ui32Start)
+                        {
+                            ui16Stuck = SimClamp(i32Value);
+                        }
+                        i32Value = ui16Stuck;
+                        break;
+                    case SIM_FAULT_NOISE:
+                        i32Value += SimNoise(150);
+                        break;
+                    case SIM_FAULT_SPIKES:
+                        // the wiper lifts off for one frame every 2ms
+                        if((ui32Frame % 16) == 0)
+                        {
+                            i32Value += 1200;
+                        }
+                        break;
+                    case SIM_FAULT_GLITCH:
+                        // one frame of interference, not a fault
+                        if(ui32Frame == ui32Start)
+                        {
+                            i32Value = 4095;
+                        }
+                        break;
+                    case SIM_FAULT_INTERMITTENT:
+                        // contact lost 3 frames out of 4
+                        if((ui32Frame % 4) != 0)
+                        {
+                            i32Value = SimRandom(20);
+                        }
+                        break;
+                }
+            }
+
+            sFrame.pui16Data[ui32Ch] = SimClamp(i32Value);
+        }
+
+        SensorDiagProcess(&sFrame);
+
+        ui32Active = SensorDiagActive();
+        if(ui32Active != ui32Prev)
+        {
+            if(g_bSimVerbose)
+            {
+                printf("    %7.3fms  active 0x%05X\n",
+                       (ui32Frame * 1000.0) / ADC_SAMPLE_RATE_HZ, ui32Active);
+            }
+            if((ui32Active & ~ui32Prev & ui32Expect) && !ui32Set)
+            {
+                ui32Set = ui32Frame;
+            }
+            if((ui32Prev & ~ui32Active & ui32Expect) && (ui32Frame >= ui32End))
+            {
+                ui32Clear = ui32Frame;
+            }
+            ui32Other |= ui32Active & ~(ui32Expect | ui32Allowed);
+        }
+        ui32Prev = ui32Active;
+    }
+
+    bPass = (ui32Other == 0) && !(ui32Prev & (ui32Expect | ui32Allowed));
+    if(ui32Expect)
+    {
+        bPass = bPass && ui32Set && ui32Clear &&
+                (ui32Set - ui32Start <= SIM_FRAMES(psScenario->ui32MaxSetMs)) &&
+                (ui32Clear - ui32End <= SIM_FRAMES(psScenario->ui32MaxClearMs));
+    }
+
+    printf("%-18s ch%u %-6s ", psScenario->pcName, psScenario->ui32Ch,
+           (psScenario->i32Type >= 0) ?
+           g_ppcSensorDiagNames[psScenario->i32Type] : "-");
+    if(ui32Expect && ui32Set)
+    {
+        printf("set %7.2fms ", ((ui32Set - ui32Start) * 1000.0) /
+                               ADC_SAMPLE_RATE_HZ);
+    }
+    else
+    {
+        printf("%-15s", ui32Expect ? "never set" : "");
+    }
+    if(ui32Expect && ui32Clear)
+    {
+        printf("clear %7.2fms ", ((ui32Clear - ui32End) * 1000.0) /
+                                 ADC_SAMPLE_RATE_HZ);
+    }
+    else
+    {
+        printf("%-17s", ui32Expect ? "never cleared" : "");
+    }
+    if(ui32Other)
+    {
+        printf("unexpected 0x%05X ", ui32Other);
+    }
+    printf("%s\n", bPass ? "ok" : "FAIL");
+
+    return bPass;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t ui32Idx, ui32Failed = 0;
+
+    g_bSimVerbose = (argc > 1) && (strcmp(argv[1], "-v") == 0);
+
+    for(ui32Idx = 0; ui32Idx < SIM_NUM_SCENARIOS; ui32Idx++)
+    {
+        if(!SimRun(&g_psSimScenarios[ui32Idx]))
+        {
+            ui32Failed++;
+        }
+    }
+
+    printf("%u of %u scenarios passed\n",
+           (uint32_t)SIM_NUM_SCENARIOS - ui32Failed,
+           (uint32_t)SIM_NUM_SCENARIOS);
+
+    return ui32Failed != 0;
+}
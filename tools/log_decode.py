@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Rebuild the text of a binary UART log capture.
+
+Switch the logger to binary mode with the `log bin` console command, capture
+the raw UART bytes to a file and run:
+
+    tools/log_decode.py capture.bin [--ids log_ids.h] [--hz 80000000]
+
+Console text mixed into the capture is skipped. The frame format is described
+in uart_log.c and the messages are read from log_ids.h.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+MAX_WORDS = 6
+
+LOG_MSG_RE = re.compile(r'^\s*LOG_MSG\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)',
+                        re.M)
+SPEC_RE = re.compile(r'%([-0]?\d*)([udxXcs%])')
+
+
+def load_formats(path):
+    """Returns the format strings in id order."""
+    with open(path) as f:
+        text = f.read()
+    formats = []
+    for name, fmt in LOG_MSG_RE.findall(text):
+        fmt = bytes(fmt, "utf-8").decode("unicode_escape")
+        formats.append((name, fmt))
+    return formats
+
+
+def render(fmt, args):
+    """Applies a C format string to raw 32-bit arguments."""
+    args = list(args)
+    out = []
+    pos = 0
+    for match in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, conv = match.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        value = args.pop(0) if args else 0
+        if conv == "d" and value & 0x80000000:
+            value -= 1 << 32
+        if conv == "c":
+            text = chr(value & 0xFF)
+        elif conv == "s":
+            text = "<str 0x%08x>" % value
+        elif conv == "u":
+            text = ("%" + flags + "d") % value
+        else:
+            text = ("%" + flags + conv) % value
+        out.append(text)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def frames(data):
+    """Yields the word lists of all valid frames in a byte stream."""
+    idx = 0
+    while idx < len(data) - 2:
+        if data[idx] != FRAME_SYNC:
+            idx += 1
+            continue
+        words = data[idx + 1]
+        end = idx + 2 + words * 4
+        if not 2 <= words <= MAX_WORDS or end >= len(data):
+            idx += 1
+            continue
+        payload = data[idx + 1:end]
+        if sum(payload) & 0xFF != data[end]:
+            idx += 1
+            continue
+        yield list(struct.unpack("<%dI" % words, data[idx + 2:end]))
+        idx = end + 1
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="raw UART capture")
+    parser.add_argument("--ids", default=os.path.join(here, "..", "log_ids.h"),
+                        help="message table (default: ../log_ids.h)")
+    parser.add_argument("--hz", type=int, default=80000000,
+                        help="timestamp clock (default: 80 MHz)")
+    args = parser.parse_args()
+
+    formats = load_formats(args.ids)
+    with open(args.capture, "rb") as f:
+        data = f.read()
+
+    base = 0
+    last = None
+    for record in frames(data):
+        ident = record[0] >> 16
+        nargs = record[0] & 0xF
+        stamp = record[1]
+        if len(record) != 2 + nargs:
+            continue
+        if last is not None and stamp < last:
+            base += 1 << 32
+        last = stamp
+        usec = (base + stamp) * 1e6 / args.hz
+        if ident < len(formats):
+            text = render(formats[ident][1], record[2:])
+        else:
+            text = "unknown message %d %s\n" % (ident, record[2:])
+        sys.stdout.write("[%14.3f] %s" % (usec, text))
+        if not text.endswith("\n"):
+            sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
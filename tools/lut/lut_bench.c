@@ -0,0 +1,311 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Speed and accuracy benchmark of the lut.h conversion tables
+//
+// Usage: lut_bench [runs]
+// Converts every 12-bit input with three methods and compares them with the
+// exact curve:
+//   lut       lut.h uniform index table, as used by the firmware
+//   search    binary search of the breakpoints and a division per sample
+//   poly      least squares cubic in float, evaluated with Horner's rule
+// for a nonlinear sensor calibration given by breakpoints and for the
+// throttle response maps.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "lut.h"
+
+#define BENCH_RUNS              2000
+#define BENCH_POLY_DEGREE       3
+#define BENCH_POINTS            8
+
+//*****************************************************************************
+//
+// Coolant temperature sensor, NTC divider: raw counts to 0.1 degC.
+//
+//*****************************************************************************
+static const int32_t g_pi32TempRaw[BENCH_POINTS] =
+{
+    300, 700, 1200, 1800, 2400, 3000, 3500, 3900
+};
+static const int32_t g_pi32TempValue[BENCH_POINTS] =
+{
+    1200, 950, 750, 560, 400, 250, 120, 0
+};
+
+typedef struct
+{
+    const char *pcName;
+    double (*pfnExact)(double dIn);     // input 0..4096
+    tLutTable sLut;
+    float pfPoly[BENCH_POLY_DEGREE + 1];
+}
+tBenchCase;
+
+static volatile int32_t g_i32Sink;
+
+static double BenchNow(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return sTime.tv_sec + (sTime.tv_nsec * 1e-9);
+}
+
+//*****************************************************************************
+//
+// Exact curves. The calibration is defined by its breakpoints, the throttle
+// maps by the formulas in lut.c, both scaled to the 12-bit domain.
+//
+//*****************************************************************************
+static double ExactTemp(double dIn)
+{
+    uint32_t ui32Point;
+
+    if(dIn <= g_pi32TempRaw[0])
+    {
+        return g_pi32TempValue[0];
+    }
+    for(ui32Point = 1; ui32Point < BENCH_POINTS; ui32Point++)
+    {
+        if(dIn <= g_pi32TempRaw[ui32Point])
+        {
+            return g_pi32TempValue[ui32Point - 1] +
+                   ((dIn - g_pi32TempRaw[ui32Point - 1]) *
+                    (g_pi32TempValue[ui32Point] -
+                     g_pi32TempValue[ui32Point - 1]) /
+                    (g_pi32TempRaw[ui32Point] - g_pi32TempRaw[ui32Point - 1]));
+        }
+    }
+
+    return g_pi32TempValue[BENCH_POINTS - 1];
+}
+
+static double ExactProgressive(double dIn)
+{
+    double dX = dIn / LUT_INPUT_FULL;
+
+    return 1000.0 * ((0.3 * dX) + (0.7 * dX * dX));
+}
+
+static double ExactSport(double dIn)
+{
+    double dX = 1.0 - (dIn / LUT_INPUT_FULL);
+
+    return 1000.0 * (1.0 - (dX * dX));
+}
+
+//*****************************************************************************
+//
+// Least squares polynomial of x = input / 4096 through the normal equations.
+//
+//*****************************************************************************
+static void PolyFit(tBenchCase *psCase)
+{
+    double ppdA[BENCH_POLY_DEGREE + 1][BENCH_POLY_DEGREE + 2] = {{0}};
+    double dX, dY, dPow, dScale;
+    int32_t i32In, i32Row, i32Col, i32Pivot;
+
+    for(i32In = 0; i32In < LUT_INPUT_FULL; i32In++)
+    {
+        dX = (double)i32In / LUT_INPUT_FULL;
+        dY = psCase->pfnExact(i32In);
+        for(i32Row = 0; i32Row <= BENCH_POLY_DEGREE; i32Row++)
+        {
+            dPow = pow(dX, i32Row);
+            for(i32Col = 0; i32Col <= BENCH_POLY_DEGREE; i32Col++)
+            {
+                ppdA[i32Row][i32Col] += dPow * pow(dX, i32Col);
+            }
+            ppdA[i32Row][BENCH_POLY_DEGREE + 1] += dPow * dY;
+        }
+    }
+
+    for(i32Pivot = 0; i32Pivot <= BENCH_POLY_DEGREE; i32Pivot++)
+    {
+        for(i32Row = 0; i32Row <= BENCH_POLY_DEGREE; i32Row++)
+        {
+            if(i32Row == i32Pivot)
+            {
+                continue;
+            }
+            dScale = ppdA[i32Row][i32Pivot] / ppdA[i32Pivot][i32Pivot];
+            for(i32Col = i32Pivot; i32Col <= BENCH_POLY_DEGREE + 1; i32Col++)
+            {
+                ppdA[i32Row][i32Col] -= dScale * ppdA[i32Pivot][i32Col];
+            }
+        }
+    }
+
+    for(i32Row = 0; i32Row <= BENCH_POLY_DEGREE; i32Row++)
+    {
+        psCase->pfPoly[i32Row] = (float)(ppdA[i32Row][BENCH_POLY_DEGREE + 1] /
+                                         ppdA[i32Row][i32Row]);
+    }
+}
+
+static int32_t PolyEval(const float *pfPoly, int32_t i32In)
+{
+    float fX = (float)i32In * (1.0f / LUT_INPUT_FULL);
+    float fY = pfPoly[BENCH_POLY_DEGREE];
+    int32_t i32Term;
+
+    for(i32Term = BENCH_POLY_DEGREE - 1; i32Term >= 0; i32Term--)
+    {
+        fY = (fY * fX) + pfPoly[i32Term];
+    }
+
+    return (int32_t)lrintf(fY);
+}
+
+//*****************************************************************************
+//
+// The straightforward conversion: find the segment of the breakpoints with a
+// binary search, interpolate with a division.
+//
+//*****************************************************************************
+static int32_t SearchEval(const int32_t *pi32Raw, const int32_t *pi32Value,
+                          uint32_t ui32Points, int32_t i32In)
+{
+    uint32_t ui32Lo = 0, ui32Hi = ui32Points - 1, ui32Mid;
+
+    if(i32In <= pi32Raw[0])
+    {
+        return pi32Value[0];
+    }
+    if(i32In >= pi32Raw[ui32Hi])
+    {
+        return pi32Value[ui32Hi];
+    }
+
+    while((ui32Hi - ui32Lo) > 1)
+    {
+        ui32Mid = (ui32Lo + ui32Hi) / 2;
+        if(i32In < pi32Raw[ui32Mid])
+        {
+            ui32Hi = ui32Mid;
+        }
+        else
+        {
+            ui32Lo = ui32Mid;
+        }
+    }
+
+    return pi32Value[ui32Lo] + (((i32In - pi32Raw[ui32Lo]) *
+                                 (pi32Value[ui32Hi] - pi32Value[ui32Lo])) /
+                                (pi32Raw[ui32Hi] - pi32Raw[ui32Lo]));
+}
+
+//*****************************************************************************
+//
+// Breakpoints of a throttle map at the 17 inputs of every fourth table value,
+// for the search method.
+//
+//*****************************************************************************
+static void MapPoints(double (*pfnExact)(double), int32_t *pi32Raw,
+                      int32_t *pi32Value, uint32_t ui32Points)
+{
+    uint32_t ui32Point;
+
+    for(ui32Point = 0; ui32Point < ui32Points; ui32Point++)
+    {
+        pi32Raw[ui32Point] = (ui32Point * LUT_INPUT_FULL) / (ui32Points - 1);
+        pi32Value[ui32Point] = (int32_t)lrint(pfnExact(pi32Raw[ui32Point]));
+    }
+}
+
+static void BenchReport(const char *pcMethod, double dSeconds,
+                        uint32_t ui32Runs, double dMaxErr, double dSumErr)
+{
+    printf("  %-8s %7.2f ns/sample   max error %6.2f   mean error %5.2f\n",
+           pcMethod, (dSeconds * 1e9) / ((double)ui32Runs * LUT_INPUT_FULL),
+           dMaxErr, dSumErr / LUT_INPUT_FULL);
+}
+
+static void BenchCase(tBenchCase *psCase, const int32_t *pi32Raw,
+                      const int32_t *pi32Value, uint32_t ui32Points,
+                      uint32_t ui32Runs)
+{
+    double dStart, dErr, dMaxErr, dSumErr;
+    int32_t i32In, i32Sum;
+    uint32_t ui32Method, ui32Run;
+    static const char *ppcMethods[] = { "lut", "search", "poly" };
+
+    PolyFit(psCase);
+    printf("%s\n", psCase->pcName);
+
+    for(ui32Method = 0; ui32Method < 3; ui32Method++)
+    {
+        dMaxErr = 0;
+        dSumErr = 0;
+        for(i32In = 0; i32In < LUT_INPUT_FULL; i32In++)
+        {
+            dErr = (ui32Method == 0) ? LutApply(&psCase->sLut, i32In) :
+                   (ui32Method == 1) ? SearchEval(pi32Raw, pi32Value,
+                                                  ui32Points, i32In) :
+                   PolyEval(psCase->pfPoly, i32In);
+            dErr = fabs(dErr - psCase->pfnExact(i32In));
+            dMaxErr = (dErr > dMaxErr) ? dErr : dMaxErr;
+            dSumErr += dErr;
+        }
+
+        i32Sum = 0;
+        dStart = BenchNow();
+        for(ui32Run = 0; ui32Run < ui32Runs; ui32Run++)
+        {
+            for(i32In = 0; i32In < LUT_INPUT_FULL; i32In++)
+            {
+                if(ui32Method == 0)
+                {
+                    i32Sum += LutApply(&psCase->sLut, i32In ^ ui32Run);
+                }
+                else if(ui32Method == 1)
+                {
+                    i32Sum += SearchEval(pi32Raw, pi32Value, ui32Points,
+                                         i32In ^ ui32Run);
+                }
+                else
+                {
+                    i32Sum += PolyEval(psCase->pfPoly, i32In ^ ui32Run);
+                }
+            }
+        }
+        BenchReport(ppcMethods[ui32Method], BenchNow() - dStart, ui32Runs,
+                    dMaxErr, dSumErr);
+        g_i32Sink = i32Sum;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t ui32Runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : BENCH_RUNS;
+    int32_t pi32MapRaw[17], pi32MapValue[17];
+    tBenchCase sCase;
+
+    printf("%u inputs, %u runs, %u byte table\n\n", LUT_INPUT_FULL, ui32Runs,
+           (uint32_t)sizeof(tLutTable));
+
+    sCase.pcName = "coolant temperature, 8 breakpoints, 0.1 degC";
+    sCase.pfnExact = ExactTemp;
+    LutBuild(&sCase.sLut, g_pi32TempRaw, g_pi32TempValue, BENCH_POINTS);
+    BenchCase(&sCase, g_pi32TempRaw, g_pi32TempValue, BENCH_POINTS, ui32Runs);
+
+    sCase.pcName = "throttle map progressive, 0.1 %";
+    sCase.pfnExact = ExactProgressive;
+    sCase.sLut = g_psLutThrottleMaps[LUT_MAP_PROGRESSIVE - 1];
+    MapPoints(ExactProgressive, pi32MapRaw, pi32MapValue, 17);
+    BenchCase(&sCase, pi32MapRaw, pi32MapValue, 17, ui32Runs);
+
+    sCase.pcName = "throttle map sport, 0.1 %";
+    sCase.pfnExact = ExactSport;
+    sCase.sLut = g_psLutThrottleMaps[LUT_MAP_SPORT - 1];
+    MapPoints(ExactSport, pi32MapRaw, pi32MapValue, 17);
+    BenchCase(&sCase, pi32MapRaw, pi32MapValue, 17, ui32Runs);
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Replays recorded sensor traces through the firmware signal chain
+//
+// Usage: trace_replay [-b] [-x speed] [-e eeprom.bin] [-o out.csv] trace
+// The trace is the CSV of sdlog_extract or telemetry_dump (seq,time_us,ch0..
+// ch3), or with -b a raw telemetry capture. Every frame is converted by the
+// simulated ADC at its recorded time and handled by ADC0IntHandler() of
+// adc_api.c: CAN events, sensor diagnostics, statistics and freeze frame.
+// Every 5ms of trace time the throttle request of the ADC task is computed
+// from the latest reading, with the calibration from the EEPROM file given
+// by -e (defaults otherwise). The requests go to out.csv, or stdout:
+//   time_us,raw,filtered,request,events,dtc
+// with the CAN event fault bits and the active trouble codes. The replay runs
+// as fast as it can unless -x gives a multiple of real time to keep. At the
+// end the cycles of every stage of the interrupt handler and of the task's
+// computation are printed to stderr, counted at 80MHz on the host clock.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "timestamp.h"
+#include "adc_api.h"
+#include "ADC_task.h"
+#include "sensors.h"
+#include "calib.h"
+#include "can_loopback.h"
+#include "can_events.h"
+#include "sensor_diag.h"
+#include "telemetry_parser.h"
+
+// the sequencer of ADCTimerTriggeredInit()
+#define REPLAY_ADC_SEQUENCER            1
+
+#define REPLAY_CAN_BITRATE              500000
+#define REPLAY_TASK_PERIOD_NS           (ADC_TASK_PERIOD_MS * 1000000ULL)
+
+typedef struct
+{
+    FILE *psOut;
+    double dSpeed;
+    struct timespec sHostStart;
+    uint64_t ui64Base;                  // simulation time of the first frame
+    uint64_t ui64First;                 // trace time of the first frame
+    uint64_t ui64Last;
+    uint64_t ui64NextTask;
+    uint32_t ui32Frames;
+    uint32_t ui32Skipped;
+    uint32_t ui32EventFrames;
+
+    // ADC task computation
+    int32_t i32Filtered;
+    uint32_t ui32TaskRuns;
+    uint64_t ui64TaskCycles;
+    uint32_t ui32TaskMaxCycles;
+
+    // telemetry capture, the cycle counter extended to 64 bits
+    bool bHaveStamp;
+    uint32_t ui32LastStamp;
+    uint64_t ui64Stamp;
+}
+tReplayState;
+
+static tReplayState g_sReplay;
+
+// created by main() on the board, the replay runs no tasks
+xSemaphoreHandle g_pUARTSemaphore;
+xSemaphoreHandle g_pADCSemaphore;
+
+static uint64_t ReplayHostNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return ((uint64_t)(sNow.tv_sec - g_sReplay.sHostStart.tv_sec) *
+            1000000000ULL) + (uint64_t)sNow.tv_nsec -
+           (uint64_t)g_sReplay.sHostStart.tv_nsec;
+}
+
+//*****************************************************************************
+//
+// Keeps -x times real time, never sleeps without -x.
+//
+//*****************************************************************************
+static void ReplayPace(uint64_t ui64TraceNs)
+{
+    uint64_t ui64Due, ui64Now;
+    struct timespec sWait;
+
+    if(g_sReplay.dSpeed <= 0)
+    {
+        return;
+    }
+
+    ui64Due = (uint64_t)((double)ui64TraceNs / g_sReplay.dSpeed);
+    ui64Now = ReplayHostNs();
+    if(ui64Due > ui64Now)
+    {
+        sWait.tv_sec = (time_t)((ui64Due - ui64Now) / 1000000000ULL);
+        sWait.tv_nsec = (long)((ui64Due - ui64Now) % 1000000000ULL);
+        nanosleep(&sWait, NULL);
+    }
+}
+
+//*****************************************************************************
+//
+// One period of the ADC task on the latest reading.
+//
+//*****************************************************************************
+static void ReplayTask(uint64_t ui64TraceNs)
+{
+    uint32_t ui32Raw, ui32Request, ui32Start, ui32Cycles;
+
+    ui32Start = TimestampGet();
+    ui32Raw = ThrottleSensorGetValue();
+    ui32Request = ADCTaskThrottleRequest(ui32Raw, &g_sReplay.i32Filtered);
+    ui32Cycles = TimestampGet() - ui32Start;
+
+    g_sReplay.ui32TaskRuns++;
+    g_sReplay.ui64TaskCycles += ui32Cycles;
+    if(ui32Cycles > g_sReplay.ui32TaskMaxCycles)
+    {
+        g_sReplay.ui32TaskMaxCycles = ui32Cycles;
+    }
+
+    fprintf(g_sReplay.psOut, "%.3f,%u,%d,%u,0x%02x,0x%04x\n",
+            (double)ui64TraceNs / 1e3, ui32Raw, g_sReplay.i32Filtered,
+            ui32Request, CANEventsFaults(), SensorDiagActive());
+}
+
+//*****************************************************************************
+//
+// Converts one recorded frame at its time, trace times count from the first
+// frame. The ADC task runs at its release times up to the frame.
+//
+//*****************************************************************************
+static void ReplayFrame(uint64_t ui64TraceNs, const uint16_t *pui16Data)
+{
+    if(g_sReplay.ui32Frames == 0)
+    {
+        g_sReplay.ui64First = ui64TraceNs;
+    }
+    if((g_sReplay.ui32Frames != 0) && (ui64TraceNs < g_sReplay.ui64Last))
+    {
+        g_sReplay.ui32Skipped++;
+        return;
+    }
+    g_sReplay.ui64Last = ui64TraceNs;
+    ui64TraceNs -= g_sReplay.ui64First;
+
+    while(g_sReplay.ui64NextTask < ui64TraceNs)
+    {
+        ReplayTask(g_sReplay.ui64NextTask);
+        g_sReplay.ui64NextTask += REPLAY_TASK_PERIOD_NS;
+    }
+
+    ReplayPace(ui64TraceNs);
+    HalSimTimeSet(g_sReplay.ui64Base + ui64TraceNs);
+    CANLoopbackRun(g_sReplay.ui64Base + ui64TraceNs);
+    HalSimADCInject(REPLAY_ADC_SEQUENCER, pui16Data);
+    g_sReplay.ui32Frames++;
+
+    if(g_sReplay.ui64NextTask == ui64TraceNs)
+    {
+        ReplayTask(ui64TraceNs);
+        g_sReplay.ui64NextTask += REPLAY_TASK_PERIOD_NS;
+    }
+}
+
+//*****************************************************************************
+//
+// CSV: seq,time_us,ch0,ch1,ch2,ch3. The header and lines that do not start
+// with a number are skipped.
+//
+//*****************************************************************************
+static void ReplayCSV(FILE *psIn)
+{
+    char pcLine[256], *pcPos;
+    uint16_t pui16Data[ADC_NUM_CHANNELS];
+    double dTimeUs;
+    uint32_t ui32Ch;
+
+    while(fgets(pcLine, sizeof(pcLine), psIn))
+    {
+        if(!isdigit((unsigned char)pcLine[0]))
+        {
+            continue;
+        }
+
+        pcPos = strchr(pcLine, ',');
+        if(!pcPos)
+        {
+            g_sReplay.ui32Skipped++;
+            continue;
+        }
+        dTimeUs = strtod(pcPos + 1, &pcPos);
+
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            if(*pcPos != ',')
+            {
+                break;
+            }
+            pui16Data[ui32Ch] = (uint16_t)strtoul(pcPos + 1, &pcPos, 10);
+        }
+
+        if((ui32Ch < ADC_NUM_CHANNELS) || (dTimeUs < 0))
+        {
+            g_sReplay.ui32Skipped++;
+            continue;
+        }
+
+        ReplayFrame((uint64_t)(dTimeUs * 1e3 + 0.5), pui16Data);
+    }
+}
+
+//*****************************************************************************
+//
+// Raw telemetry capture, frames are replayed as the parser finds them.
+//
+//*****************************************************************************
+static void ReplayTelemetryFrame(const tTelemetryFrame *psFrame,
+                                 void *pvContext)
+{
+    (void)pvContext;
+
+    if(psFrame->ui32NumChannels < ADC_NUM_CHANNELS)
+    {
+        g_sReplay.ui32Skipped++;
+        return;
+    }
+
+    if(g_sReplay.bHaveStamp)
+    {
+        g_sReplay.ui64Stamp += (uint32_t)(psFrame->ui32Time -
+                                          g_sReplay.ui32LastStamp);
+    }
+    g_sReplay.ui32LastStamp = psFrame->ui32Time;
+    g_sReplay.bHaveStamp = true;
+
+    ReplayFrame((g_sReplay.ui64Stamp * 1000000000ULL) / TELEMETRY_TIMESTAMP_HZ,
+                psFrame->pui16Data);
+}
+
+static void ReplayTelemetry(FILE *psIn)
+{
+    tTelemetryParser sParser;
+    uint8_t pui8Buf[4096];
+    size_t ui32Len;
+
+    TelemetryParserInit(&sParser, ReplayTelemetryFrame, NULL);
+    while((ui32Len = fread(pui8Buf, 1, sizeof(pui8Buf), psIn)) != 0)
+    {
+        TelemetryParserFeed(&sParser, pui8Buf, ui32Len);
+    }
+
+    if(sParser.ui32CrcErrors || sParser.ui32LostPackets)
+    {
+        fprintf(stderr, "capture: %u crc errors, %u packets lost\n",
+                sParser.ui32CrcErrors, sParser.ui32LostPackets);
+    }
+}
+
+static void ReplayCANRx(const tCANFrame *psFrame, uint64_t ui64TimeNs,
+                        void *pvContext)
+{
+    (void)ui64TimeNs;
+    (void)pvContext;
+
+    if(psFrame->ui32Id == CAN_EVENT_ID)
+    {
+        g_sReplay.ui32EventFrames++;
+    }
+}
+
+static void ReplayReport(uint64_t ui64HostNs)
+{
+    const tCANEventStats *psEvents = CANEventsStats();
+    double dTrace = (double)(g_sReplay.ui64Last - g_sReplay.ui64First) / 1e9;
+
+    fprintf(stderr, "%u frames, %.3f s of trace in %.3f s (%.1fx real time)",
+            g_sReplay.ui32Frames, dTrace, (double)ui64HostNs / 1e9,
+            (ui64HostNs != 0) ? (dTrace * 1e9 / (double)ui64HostNs) : 0.0);
+    if(g_sReplay.ui32Skipped)
+    {
+        fprintf(stderr, ", %u skipped", g_sReplay.ui32Skipped);
+    }
+    fprintf(stderr, "\nCAN events: %u frames on the bus, merged %u deferred %u,"
+            " brake on %u off %u pedal step %u fault %u\n",
+            g_sReplay.ui32EventFrames, psEvents->ui32Merged,
+            psEvents->ui32Deferred, psEvents->pui32Causes[0],
+            psEvents->pui32Causes[1], psEvents->pui32Causes[2],
+            psEvents->pui32Causes[3]);
+    fprintf(stderr, "trouble codes seen 0x%04x, active 0x%04x\n",
+            SensorDiagHistory(), SensorDiagActive());
+
+    ADCStageReport();
+    if(g_sReplay.ui32TaskRuns)
+    {
+        fprintf(stderr, "ADC task: %u periods, cycles avg %u max %u\n",
+                g_sReplay.ui32TaskRuns,
+                (uint32_t)(g_sReplay.ui64TaskCycles / g_sReplay.ui32TaskRuns),
+                g_sReplay.ui32TaskMaxCycles);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const char *pcOut = NULL;
+    bool bBinary = false;
+    FILE *psIn;
+    int iOpt;
+
+    g_sReplay.psOut = stdout;
+
+    while((iOpt = getopt(argc, argv, "bx:e:o:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 'b':
+            {
+                bBinary = true;
+                break;
+            }
+
+            case 'x':
+            {
+                g_sReplay.dSpeed = strtod(optarg, NULL);
+                break;
+            }
+
+            case 'e':
+            {
+                if(HalSimEEPROMFileSet(optarg) != 0)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 'o':
+            {
+                pcOut = optarg;
+                break;
+            }
+
+            default:
+            {
+                optind = argc;
+                break;
+            }
+        }
+    }
+
+    if(optind != (argc - 1))
+    {
+        fprintf(stderr, "usage: %s [-b] [-x speed] [-e eeprom.bin] "
+                        "[-o out.csv] trace\n", argv[0]);
+        return 1;
+    }
+
+    psIn = fopen(argv[optind], bBinary ? "rb" : "r");
+    if(!psIn)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if(pcOut && !(g_sReplay.psOut = fopen(pcOut, "w")))
+    {
+        perror(pcOut);
+        return 1;
+    }
+
+    //
+    // The console goes to stderr, the outputs are on stdout. The clock is
+    // stepped from here on, so the ADC timer is configured but never runs.
+    //
+    HalSimUARTFdSet(0, STDIN_FILENO, STDERR_FILENO);
+    HalSimTimeSet(0);
+    g_sReplay.ui64Base = HalSimTimeNs();
+
+    CalibInit();
+    CANLoopbackInit(REPLAY_CAN_BITRATE, ReplayCANRx, NULL);
+    CANEventsInit(&g_sCANLoopbackPort);
+    ThrottleSensorInit();
+
+    fprintf(g_sReplay.psOut, "time_us,raw,filtered,request,events,dtc\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &g_sReplay.sHostStart);
+    if(bBinary)
+    {
+        ReplayTelemetry(psIn);
+    }
+    else
+    {
+        ReplayCSV(psIn);
+    }
+    fflush(g_sReplay.psOut);
+
+    ReplayReport(ReplayHostNs());
+
+    return (g_sReplay.ui32Frames == 0);
+}
@@ -0,0 +1,261 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Reads the data logger sessions from an SD card image
+//
+// Usage: sdlog_extract image            list the sessions
+//        sdlog_extract image session    write the session as CSV to stdout
+//
+// The image is a dump of the whole card (dd if=/dev/sdX of=card.img) or a
+// file written by sdlog_sim. Every block is checked against its CRC and the
+// frame sequence numbers are followed, damaged blocks and gaps are reported
+// on stderr. A session that was not stopped from the console is read until
+// the first block that does not belong to it.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "crc16.h"
+#include "compress.h"
+#include "timestamp.h"
+#include "sdlog_format.h"
+#include "storage_file.h"
+
+typedef struct
+{
+    uint32_t ui32Blocks;
+    uint32_t ui32BadBlocks;
+    uint32_t ui32Records;
+    uint32_t ui32BadRecords;
+    uint32_t ui32Frames;
+    uint32_t ui32Gaps;
+    uint32_t ui32Missing;
+    bool bHaveFrame;
+    uint32_t ui32NextSeq;
+    uint32_t ui32LastStamp;
+    uint64_t ui64Time;
+}
+tExtractState;
+
+static uint8_t g_pui8Super[STORAGE_BLOCK_SIZE];
+static uint8_t g_pui8Block[STORAGE_BLOCK_SIZE];
+
+static void ExtractList(void)
+{
+    uint32_t ui32Slot, ui32Session, ui32Blocks;
+    const uint8_t *pui8Entry;
+
+    printf("%u slots of %u blocks, last session %u\n",
+           SDLogGet16(g_pui8Super + SDLOG_SB_SLOTS),
+           SDLogGet32(g_pui8Super + SDLOG_SB_SLOT_BLOCKS),
+           SDLogGet32(g_pui8Super + SDLOG_SB_LAST_SESSION));
+
+    for(ui32Slot = 0; ui32Slot < SDLOG_NUM_SLOTS; ui32Slot++)
+    {
+        pui8Entry = g_pui8Super + SDLOG_SB_TABLE +
+                    (ui32Slot * SDLOG_SB_ENTRY_SIZE);
+        ui32Session = SDLogGet32(pui8Entry + SDLOG_SB_ENTRY_SESSION);
+        ui32Blocks = SDLogGet32(pui8Entry + SDLOG_SB_ENTRY_BLOCKS);
+
+        if(ui32Session == 0)
+        {
+            continue;
+        }
+
+        if(ui32Blocks == SDLOG_SLOT_OPEN)
+        {
+            printf("session %u slot %u: not closed\n", ui32Session,
+                   ui32Slot);
+        }
+        else
+        {
+            printf("session %u slot %u: %u blocks\n", ui32Session, ui32Slot,
+                   ui32Blocks);
+        }
+    }
+}
+
+static void ExtractRecord(tExtractState *psState, const uint8_t *pui8Record,
+                          uint32_t ui32Len)
+{
+    uint32_t pui32Time[COMPRESS_MAX_FRAMES];
+    uint16_t pui16Data[COMPRESS_MAX_FRAMES * COMPRESS_MAX_CHANNELS];
+    tCompressHeader sHeader;
+    uint32_t ui32Frame, ui32Ch, ui32Seq;
+
+    if(CompressBlockDecode(pui8Record, ui32Len, &sHeader, pui32Time,
+                           pui16Data) < 0)
+    {
+        psState->ui32BadRecords++;
+        return;
+    }
+
+    if(!psState->bHaveFrame)
+    {
+        printf("seq,time_us");
+        for(ui32Ch = 0; ui32Ch < sHeader.ui32Channels; ui32Ch++)
+        {
+            printf(",ch%u", ui32Ch);
+        }
+        printf("\n");
+    }
+
+    psState->ui32Records++;
+
+    for(ui32Frame = 0; ui32Frame < sHeader.ui32Count; ui32Frame++)
+    {
+        ui32Seq = sHeader.ui32Seq + (ui32Frame * sHeader.ui32Step);
+
+        if(psState->bHaveFrame)
+        {
+            if(ui32Seq != psState->ui32NextSeq)
+            {
+                psState->ui32Gaps++;
+                psState->ui32Missing += ui32Seq - psState->ui32NextSeq;
+            }
+            psState->ui64Time += (uint32_t)(pui32Time[ui32Frame] -
+                                            psState->ui32LastStamp);
+        }
+        psState->bHaveFrame = true;
+        psState->ui32NextSeq = ui32Seq + sHeader.ui32Step;
+        psState->ui32LastStamp = pui32Time[ui32Frame];
+        psState->ui32Frames++;
+
+        printf("%u,%.3f", ui32Seq,
+               (double)psState->ui64Time / TIMESTAMP_CYCLES_PER_US);
+        for(ui32Ch = 0; ui32Ch < sHeader.ui32Channels; ui32Ch++)
+        {
+            printf(",%u",
+                   pui16Data[(ui32Frame * sHeader.ui32Channels) + ui32Ch]);
+        }
+        printf("\n");
+    }
+}
+
+static bool ExtractBlock(tExtractState *psState, uint32_t ui32Session,
+                         uint32_t ui32Index)
+{
+    uint32_t ui32Len, ui32Pos, ui32Record;
+    uint16_t ui16Crc;
+
+    if((SDLogGet16(g_pui8Block + SDLOG_BLK_MAGIC) != SDLOG_BLOCK_MAGIC) ||
+       (g_pui8Block[SDLOG_BLK_VERSION] != SDLOG_VERSION) ||
+       (SDLogGet32(g_pui8Block + SDLOG_BLK_SESSION) != ui32Session) ||
+       (SDLogGet32(g_pui8Block + SDLOG_BLK_INDEX) != ui32Index))
+    {
+        return false;
+    }
+
+    psState->ui32Blocks++;
+
+    ui32Len = SDLogGet16(g_pui8Block + SDLOG_BLK_LENGTH);
+    if(ui32Len > (STORAGE_BLOCK_SIZE - SDLOG_BLK_HDR_SIZE))
+    {
+        psState->ui32BadBlocks++;
+        return true;
+    }
+
+    ui16Crc = Crc16Ccitt(CRC16_CCITT_INIT, g_pui8Block, SDLOG_BLK_CRC);
+    ui16Crc = Crc16Ccitt(ui16Crc, g_pui8Block + SDLOG_BLK_HDR_SIZE, ui32Len);
+    if(ui16Crc != SDLogGet16(g_pui8Block + SDLOG_BLK_CRC))
+    {
+        fprintf(stderr, "block %u: CRC error\n", ui32Index);
+        psState->ui32BadBlocks++;
+        return true;
+    }
+
+    ui32Pos = SDLOG_BLK_HDR_SIZE;
+    ui32Len += SDLOG_BLK_HDR_SIZE;
+    while((ui32Pos + SDLOG_RECORD_HDR_SIZE) <= ui32Len)
+    {
+        ui32Record = SDLogGet16(g_pui8Block + ui32Pos);
+        ui32Pos += SDLOG_RECORD_HDR_SIZE;
+        if((ui32Record == 0) || ((ui32Pos + ui32Record) > ui32Len))
+        {
+            psState->ui32BadRecords++;
+            break;
+        }
+
+        ExtractRecord(psState, g_pui8Block + ui32Pos, ui32Record);
+        ui32Pos += ui32Record;
+    }
+
+    return true;
+}
+
+static int ExtractSession(uint32_t ui32Session)
+{
+    tExtractState sState = { 0 };
+    uint32_t ui32Slot = ui32Session % SDLOG_NUM_SLOTS;
+    const uint8_t *pui8Entry = g_pui8Super + SDLOG_SB_TABLE +
+                               (ui32Slot * SDLOG_SB_ENTRY_SIZE);
+    uint32_t ui32SlotBlocks = SDLogGet32(g_pui8Super + SDLOG_SB_SLOT_BLOCKS);
+    uint32_t ui32Start = SDLogGet32(g_pui8Super + SDLOG_SB_FIRST_BLOCK) +
+                         (ui32Slot * ui32SlotBlocks);
+    uint32_t ui32Blocks, ui32Index;
+
+    if((ui32Session == 0) ||
+       (SDLogGet32(pui8Entry + SDLOG_SB_ENTRY_SESSION) != ui32Session))
+    {
+        fprintf(stderr, "session %u is not on the card\n", ui32Session);
+        return 1;
+    }
+
+    ui32Blocks = SDLogGet32(pui8Entry + SDLOG_SB_ENTRY_BLOCKS);
+    if(ui32Blocks > ui32SlotBlocks)
+    {
+        ui32Blocks = ui32SlotBlocks;
+    }
+
+    for(ui32Index = 0; ui32Index < ui32Blocks; ui32Index++)
+    {
+        if(g_sStorageFile.pfnRead(ui32Start + ui32Index, g_pui8Block, 1) != 0)
+        {
+            fprintf(stderr, "block %u: read error\n", ui32Index);
+            break;
+        }
+
+        if(!ExtractBlock(&sState, ui32Session, ui32Index))
+        {
+            break;
+        }
+    }
+
+    fprintf(stderr, "blocks %u (%u bad), records %u (%u bad), frames %u, "
+                    "%u gaps with %u frames missing\n",
+            sState.ui32Blocks, sState.ui32BadBlocks, sState.ui32Records,
+            sState.ui32BadRecords, sState.ui32Frames, sState.ui32Gaps,
+            sState.ui32Missing);
+
+    return (sState.ui32BadBlocks || sState.ui32BadRecords) ? 2 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: sdlog_extract image [session]\n");
+        return 1;
+    }
+
+    if((StorageFileOpen(argv[1], 0) != 0) ||
+       (g_sStorageFile.pfnRead(0, g_pui8Super, 1) != 0))
+    {
+        return 1;
+    }
+
+    if((SDLogGet32(g_pui8Super + SDLOG_SB_MAGIC) != SDLOG_MAGIC) ||
+       (SDLogGet16(g_pui8Super + SDLOG_SB_VERSION) != SDLOG_VERSION))
+    {
+        fprintf(stderr, "%s: no logger superblock\n", argv[1]);
+        return 1;
+    }
+
+    if(argc < 3)
+    {
+        ExtractList();
+        return 0;
+    }
+
+    return ExtractSession(strtoul(argv[2], NULL, 0));
+}
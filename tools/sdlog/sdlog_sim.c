@@ -0,0 +1,262 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host throughput test of the SD card data logger
+//
+// Runs sdlog.c on an image file with the same two thread split as the
+// firmware: a producer paced to the ADC rate that adds frames and a writer
+// that moves the filled buffers to the storage. The storage delay models the
+// card, so the buffer sizes can be checked against the write latency of real
+// cards before they go on the car. Read the image back with sdlog_extract.
+//
+// Usage: sdlog_sim [-s seconds] [-r rate_hz] [-w write_us] [-b block_us]
+//                  [-x stall_us] [-e stall_every] [-m image_mb] image
+//
+// e.g. -w 2000 -b 100 -x 60000 -e 50 for a card that takes 2ms per write
+// and stalls for 60ms every 50 writes.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#include "timestamp.h"
+#include "sdlog.h"
+#include "storage_file.h"
+
+#define SIM_TICK_NS             1000000     // producer wakes up every 1ms
+#define SIM_WRITER_POLL_MS      20
+
+typedef struct
+{
+    double dSeconds;
+    uint32_t ui32RateHz;
+}
+tSimConfig;
+
+static tSimConfig g_sSimConfig = { 10.0, ADC_SAMPLE_RATE_HZ };
+static sem_t g_sSimWake;
+static volatile bool g_bSimDone = false;
+
+static uint32_t g_ui32SimWrites = 0;
+static uint64_t g_ui64SimWriteNs = 0;
+static uint64_t g_ui64SimWriteMaxNs = 0;
+
+static uint64_t SimNow(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return ((uint64_t)sTime.tv_sec * 1000000000ULL) + sTime.tv_nsec;
+}
+
+//*****************************************************************************
+//
+// Synthetic sensor signals: slow pedal like ramps with some noise.
+//
+//*****************************************************************************
+static void SimFrame(uint32_t ui32Seq, tADCFrame *psFrame)
+{
+    double dT = (double)ui32Seq / g_sSimConfig.ui32RateHz;
+    uint32_t ui32Ch;
+    double dValue;
+
+    psFrame->ui32Seq = ui32Seq;
+    psFrame->ui32Time = (uint32_t)TimestampUsToCycles(
+        (uint64_t)ui32Seq * 1000000ULL / g_sSimConfig.ui32RateHz);
+
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        dValue = 2048.0 + (1500.0 * sin(dT * (ui32Ch + 1))) +
+                 (rand() % 9) - 4;
+        psFrame->pui16Data[ui32Ch] = (uint16_t)dValue & 0xFFF;
+    }
+}
+
+//*****************************************************************************
+//
+// Producer thread, the SDL task of the firmware.
+//
+//*****************************************************************************
+static void *SimProducer(void *pvArg)
+{
+    uint64_t ui64Frames = (uint64_t)(g_sSimConfig.dSeconds *
+                                     g_sSimConfig.ui32RateHz);
+    uint64_t ui64Seq = 0, ui64Due;
+    struct timespec sWake;
+    tADCFrame sFrame;
+    uint64_t ui64Tick = 0, ui64Start;
+
+    (void)pvArg;
+
+    ui64Start = SimNow();
+    while(ui64Seq < ui64Frames)
+    {
+        ui64Tick++;
+        ui64Due = (ui64Tick * SIM_TICK_NS * g_sSimConfig.ui32RateHz) /
+                  1000000000ULL;
+        if(ui64Due > ui64Frames)
+        {
+            ui64Due = ui64Frames;
+        }
+
+        while(ui64Seq < ui64Due)
+        {
+            SimFrame((uint32_t)ui64Seq++, &sFrame);
+            if(SDLogAddFrame(&sFrame))
+            {
+                sem_post(&g_sSimWake);
+            }
+        }
+
+        sWake.tv_sec = (time_t)((ui64Start + (ui64Tick * SIM_TICK_NS)) /
+                                1000000000ULL);
+        sWake.tv_nsec = (long)((ui64Start + (ui64Tick * SIM_TICK_NS)) %
+                               1000000000ULL);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sWake, NULL);
+    }
+
+    SDLogFlush();
+    g_bSimDone = true;
+    sem_post(&g_sSimWake);
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Writer thread, the SDW task of the firmware.
+//
+//*****************************************************************************
+static void *SimWriter(void *pvArg)
+{
+    struct timespec sTimeout;
+    uint64_t ui64Start, ui64Ns;
+    bool bDone;
+
+    (void)pvArg;
+
+    while(1)
+    {
+        bDone = g_bSimDone;
+
+        while(1)
+        {
+            ui64Start = SimNow();
+            if(!SDLogWriteNext())
+            {
+                break;
+            }
+
+            ui64Ns = SimNow() - ui64Start;
+            g_ui32SimWrites++;
+            g_ui64SimWriteNs += ui64Ns;
+            if(ui64Ns > g_ui64SimWriteMaxNs)
+            {
+                g_ui64SimWriteMaxNs = ui64Ns;
+            }
+        }
+
+        if(bDone)
+        {
+            return NULL;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &sTimeout);
+        sTimeout.tv_nsec += SIM_WRITER_POLL_MS * 1000000L;
+        if(sTimeout.tv_nsec >= 1000000000L)
+        {
+            sTimeout.tv_sec++;
+            sTimeout.tv_nsec -= 1000000000L;
+        }
+        sem_timedwait(&g_sSimWake, &sTimeout);
+    }
+}
+
+static void SimUsage(void)
+{
+    fprintf(stderr, "usage: sdlog_sim [-s seconds] [-r rate_hz] "
+                    "[-w write_us] [-b block_us] [-x stall_us] "
+                    "[-e stall_every] [-m image_mb] image\n");
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t ui32WriteUs = 0, ui32BlockUs = 0, ui32ImageMB = 64;
+    uint32_t ui32StallUs = 0, ui32StallEvery = 0;
+    pthread_t sProducer, sWriter;
+    const tSDLogStats *psStats = SDLogStats();
+    uint64_t ui64Start;
+    double dElapsed, dRaw;
+    int iOpt;
+
+    while((iOpt = getopt(argc, argv, "s:r:w:b:x:e:m:")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 's': g_sSimConfig.dSeconds = atof(optarg); break;
+            case 'r': g_sSimConfig.ui32RateHz = atoi(optarg); break;
+            case 'w': ui32WriteUs = atoi(optarg); break;
+            case 'b': ui32BlockUs = atoi(optarg); break;
+            case 'x': ui32StallUs = atoi(optarg); break;
+            case 'e': ui32StallEvery = atoi(optarg); break;
+            case 'm': ui32ImageMB = atoi(optarg); break;
+            default: SimUsage(); return 1;
+        }
+    }
+
+    if((optind >= argc) || (g_sSimConfig.ui32RateHz == 0))
+    {
+        SimUsage();
+        return 1;
+    }
+
+    if(StorageFileOpen(argv[optind], ui32ImageMB * 2048) != 0)
+    {
+        return 1;
+    }
+    StorageFileDelaySet(ui32WriteUs, ui32BlockUs, ui32StallUs,
+                        ui32StallEvery);
+
+    if((SDLogMount(&g_sStorageFile) != 0) || (SDLogSessionStart() != 0))
+    {
+        fprintf(stderr, "sdlog_sim: mount failed, image too small?\n");
+        return 1;
+    }
+
+    sem_init(&g_sSimWake, 0, 0);
+    ui64Start = SimNow();
+    pthread_create(&sWriter, NULL, SimWriter, NULL);
+    pthread_create(&sProducer, NULL, SimProducer, NULL);
+    pthread_join(sProducer, NULL);
+    pthread_join(sWriter, NULL);
+    dElapsed = (SimNow() - ui64Start) * 1e-9;
+
+    if(SDLogSessionClose() != 0)
+    {
+        fprintf(stderr, "sdlog_sim: closing the session failed\n");
+    }
+    StorageFileClose();
+
+    dRaw = (double)psStats->ui32Frames * sizeof(tADCFrame);
+    printf("session %u slot %u, %.1f s at %u Hz\n", psStats->ui32Session,
+           psStats->ui32Slot, dElapsed, g_sSimConfig.ui32RateHz);
+    printf("frames %u records %u dropped %u\n", psStats->ui32Frames,
+           psStats->ui32Records, psStats->ui32Dropped);
+    printf("blocks %u write errors %u, %.1f kB/s to storage, "
+           "%.2f raw bytes per stored byte\n",
+           psStats->ui32Blocks, psStats->ui32WriteErrors,
+           psStats->ui32Blocks * (STORAGE_BLOCK_SIZE / 1024.0) / dElapsed,
+           psStats->ui32Blocks ?
+           dRaw / ((double)psStats->ui32Blocks * STORAGE_BLOCK_SIZE) : 0.0);
+    printf("writes %u, latency avg %.0f us max %.0f us\n", g_ui32SimWrites,
+           g_ui32SimWrites ? g_ui64SimWriteNs * 1e-3 / g_ui32SimWrites : 0.0,
+           g_ui64SimWriteMaxNs * 1e-3);
+
+    return (psStats->ui32Dropped != 0) ? 2 : 0;
+}
@@ -0,0 +1,153 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// File backed block device for the host tools
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "storage_file.h"
+
+static int g_iStorageFd = -1;
+static uint32_t g_ui32StorageBlocks = 0;
+static uint32_t g_ui32StorageWriteUs = 0;
+static uint32_t g_ui32StorageBlockUs = 0;
+static uint32_t g_ui32StorageStallUs = 0;
+static uint32_t g_ui32StorageStallEvery = 0;
+static uint32_t g_ui32StorageWrites = 0;
+
+//*****************************************************************************
+//
+// Opens or creates the image. An existing image keeps its size when
+// ui32Blocks is 0.
+//
+//*****************************************************************************
+int32_t StorageFileOpen(const char *pcPath, uint32_t ui32Blocks)
+{
+    struct stat sStat;
+
+    g_iStorageFd = open(pcPath, O_RDWR | O_CREAT, 0644);
+    if(g_iStorageFd < 0)
+    {
+        perror(pcPath);
+        return -1;
+    }
+
+    if(ui32Blocks != 0)
+    {
+        if(ftruncate(g_iStorageFd,
+                     (off_t)ui32Blocks * STORAGE_BLOCK_SIZE) != 0)
+        {
+            perror(pcPath);
+            return -1;
+        }
+    }
+    else
+    {
+        if(fstat(g_iStorageFd, &sStat) != 0)
+        {
+            perror(pcPath);
+            return -1;
+        }
+        ui32Blocks = (uint32_t)(sStat.st_size / STORAGE_BLOCK_SIZE);
+    }
+
+    g_ui32StorageBlocks = ui32Blocks;
+
+    return 0;
+}
+
+void StorageFileDelaySet(uint32_t ui32WriteUs, uint32_t ui32BlockUs,
+                         uint32_t ui32StallUs, uint32_t ui32StallEvery)
+{
+    g_ui32StorageWriteUs = ui32WriteUs;
+    g_ui32StorageBlockUs = ui32BlockUs;
+    g_ui32StorageStallUs = ui32StallUs;
+    g_ui32StorageStallEvery = ui32StallEvery;
+}
+
+void StorageFileClose(void)
+{
+    if(g_iStorageFd >= 0)
+    {
+        close(g_iStorageFd);
+        g_iStorageFd = -1;
+    }
+}
+
+static int32_t StorageFileInit(void)
+{
+    return (g_iStorageFd >= 0) ? 0 : -1;
+}
+
+static uint32_t StorageFileBlockCount(void)
+{
+    return g_ui32StorageBlocks;
+}
+
+static int32_t StorageFileRead(uint32_t ui32Block, uint8_t *pui8Data,
+                               uint32_t ui32Count)
+{
+    size_t sLen = (size_t)ui32Count * STORAGE_BLOCK_SIZE;
+
+    if((ui32Block + ui32Count) > g_ui32StorageBlocks)
+    {
+        return -1;
+    }
+
+    if(pread(g_iStorageFd, pui8Data, sLen,
+             (off_t)ui32Block * STORAGE_BLOCK_SIZE) != (ssize_t)sLen)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int32_t StorageFileWrite(uint32_t ui32Block, const uint8_t *pui8Data,
+                                uint32_t ui32Count)
+{
+    size_t sLen = (size_t)ui32Count * STORAGE_BLOCK_SIZE;
+    uint64_t ui64DelayUs;
+    struct timespec sDelay;
+
+    if((ui32Block + ui32Count) > g_ui32StorageBlocks)
+    {
+        return -1;
+    }
+
+    if(pwrite(g_iStorageFd, pui8Data, sLen,
+              (off_t)ui32Block * STORAGE_BLOCK_SIZE) != (ssize_t)sLen)
+    {
+        return -1;
+    }
+
+    ui64DelayUs = g_ui32StorageWriteUs +
+                  ((uint64_t)g_ui32StorageBlockUs * ui32Count);
+    g_ui32StorageWrites++;
+    if((g_ui32StorageStallEvery != 0) &&
+       ((g_ui32StorageWrites % g_ui32StorageStallEvery) == 0))
+    {
+        ui64DelayUs += g_ui32StorageStallUs;
+    }
+    if(ui64DelayUs != 0)
+    {
+        sDelay.tv_sec = (time_t)(ui64DelayUs / 1000000);
+        sDelay.tv_nsec = (long)(ui64DelayUs % 1000000) * 1000;
+        nanosleep(&sDelay, NULL);
+    }
+
+    return 0;
+}
+
+const tStorageDevice g_sStorageFile =
+{
+    StorageFileInit,
+    StorageFileBlockCount,
+    StorageFileRead,
+    StorageFileWrite
+};
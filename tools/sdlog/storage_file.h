@@ -0,0 +1,22 @@
+#ifndef STORAGE_FILE_H
+#define STORAGE_FILE_H
+
+#include "storage.h"
+
+//*****************************************************************************
+//
+// Block device on an image file for the host tools. StorageFileOpen() sets
+// the file and its size before the logger mounts g_sStorageFile. The write
+// delay models the card: a fixed time per multi block write plus a time per
+// block, and every ui32StallEvery writes a stall like the internal garbage
+// collection of a card. All 0 for the raw speed of the file.
+//
+//*****************************************************************************
+int32_t StorageFileOpen(const char *pcPath, uint32_t ui32Blocks);
+void StorageFileDelaySet(uint32_t ui32WriteUs, uint32_t ui32BlockUs,
+                         uint32_t ui32StallUs, uint32_t ui32StallEvery);
+void StorageFileClose(void);
+
+extern const tStorageDevice g_sStorageFile;
+
+#endif
@@ -0,0 +1,152 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// CAN0 of the Linux simulation, stands in for can_driver.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "trace_recorder.h"
+#include "adc_api.h"
+#include "can_loopback.h"
+#include "can_messages.h"
+#include "can_scheduler.h"
+#include "can_events.h"
+#include "can_driver.h"
+
+/******************************************************************************
+Description: the controller and bus are can_loopback.c, a bus with no other
+senders, run up to the current time whenever a frame is loaded and on every
+scheduler tick. Transmit completions therefore reach the scheduler at the
+next load or tick instead of in their own interrupt. Timer 2 runs the
+scheduler at CAN_SCHEDULER_TICK_HZ as on the board; the loads of the tick and
+of the ADC interrupt happen with the simulated interrupt lock held, so the
+bus is never run by two threads at once.
+******************************************************************************/
+
+#define CAN_DRIVER_TIMER                2
+
+static bool g_bCANSimRunning = false;
+static uint32_t g_ui32CANSimFrames = 0;
+static uint64_t g_ui64CANSimStart = 0;
+
+static void CANDriverObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame);
+
+const tCANPort g_sCANDriverPort =
+{
+    CANDriverObjectLoad
+};
+
+//*****************************************************************************
+//
+// Brings the bus up to the current time. Loads from the completion callbacks
+// are stamped with the completion time by the loopback itself.
+//
+//*****************************************************************************
+static void CANDriverBusRun(void)
+{
+    if(!g_bCANSimRunning)
+    {
+        g_bCANSimRunning = true;
+        CANLoopbackRun(HalSimTimeNs());
+        g_bCANSimRunning = false;
+    }
+}
+
+static void CANDriverObjectLoad(uint32_t ui32Obj, const tCANFrame *psFrame)
+{
+    CANDriverBusRun();
+    g_sCANLoopbackPort.pfnObjectLoad(ui32Obj, psFrame);
+}
+
+static void CANDriverReceive(const tCANFrame *psFrame, uint64_t ui64TimeNs,
+                             void *pvContext)
+{
+    g_ui32CANSimFrames++;
+}
+
+void CAN0IntHandler(void)
+{
+}
+
+//*****************************************************************************
+//
+// Timer 2A interrupt: one scheduler tick.
+//
+//*****************************************************************************
+void CANTickIntHandler(void)
+{
+    tADCFrame sFrame;
+
+    TRACE_ISR_ENTER(TRACE_ISR_TIMER2A);
+
+    HalTimerIntClear(CAN_DRIVER_TIMER);
+
+    CANDriverBusRun();
+
+    //
+    // Nothing to send until the ADC has produced its first frame.
+    //
+    if(ADCFrameLatest(&sFrame))
+    {
+        CANSchedulerTick(&sFrame);
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_TIMER2A);
+}
+
+//*****************************************************************************
+//
+// Sets up the simulated bus, the message scheduler and the tick timer.
+//
+//*****************************************************************************
+void CANDriverInit(void)
+{
+    g_ui64CANSimStart = HalSimTimeNs();
+    CANLoopbackInit(CAN_DRIVER_BITRATE, CANDriverReceive, NULL);
+    CANLoopbackRun(g_ui64CANSimStart);
+
+    CANSchedulerInit(&g_sCANDriverPort);
+    CANEventsInit(&g_sCANDriverPort);
+
+    HalTimerPeriodicInit(CAN_DRIVER_TIMER, CAN_SCHEDULER_TICK_HZ);
+    HalTimerIntRegister(CAN_DRIVER_TIMER, CANTickIntHandler);
+    HalTimerEnable(CAN_DRIVER_TIMER);
+}
+
+//*****************************************************************************
+//
+// Prints the message counters and the bus load. The caller must hold the
+// UART.
+//
+//*****************************************************************************
+void CANDriverReport(void)
+{
+    const tCANMessageStats *psStats;
+    const tCANEventStats *psEvents = CANEventsStats();
+    uint64_t ui64Run = CANLoopbackTime() - g_ui64CANSimStart + 1;
+    uint32_t ui32Idx, ui32Load;
+
+    ui32Load = (uint32_t)((CANLoopbackBusyTime() * 1000) / ui64Run);
+    UARTprintf("CAN %u bit/s, simulated bus, %u frames, load %u.%u%%\n",
+               CAN_DRIVER_BITRATE, g_ui32CANSimFrames, ui32Load / 10,
+               ui32Load % 10);
+
+    for(ui32Idx = 0; ui32Idx < g_ui32CANNumMessages; ui32Idx++)
+    {
+        psStats = CANSchedulerStats(ui32Idx);
+        UARTprintf("  %s 0x%03x %u ms: sent %u done %u overwritten %u\n",
+                   g_psCANMessages[ui32Idx].pcName,
+                   g_psCANMessages[ui32Idx].ui32Id,
+                   g_psCANMessages[ui32Idx].ui16PeriodMs, psStats->ui32Sent,
+                   psStats->ui32Done, psStats->ui32Overwritten);
+    }
+
+    UARTprintf("  FS_Event 0x%03x: sent %u done %u merged %u deferred %u\n",
+               CAN_EVENT_ID, psEvents->ui32Sent, psEvents->ui32Done,
+               psEvents->ui32Merged, psEvents->ui32Deferred);
+    UARTprintf("    brake on %u off %u pedal step %u fault %u\n",
+               psEvents->pui32Causes[0], psEvents->pui32Causes[1],
+               psEvents->pui32Causes[2], psEvents->pui32Causes[3]);
+}
@@ -0,0 +1,56 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Command line processor of the Linux simulation, stands in for
+// utils/cmdline.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/cmdline.h"
+
+//*****************************************************************************
+//
+// Splits the line at spaces in place and calls the handler of the first
+// word from g_psCmdTable. Returns the result of the handler, or
+// CMDLINE_BAD_CMD and CMDLINE_TOO_MANY_ARGS like the TivaWare version.
+//
+//*****************************************************************************
+int CmdLineProcess(char *pcCmdLine)
+{
+    static char *ppcArgv[CMDLINE_MAX_ARGS + 1];
+    tCmdLineEntry *psEntry;
+    bool bFindArg = true;
+    int iArgc = 0;
+
+    while(*pcCmdLine)
+    {
+        if(*pcCmdLine == ' ')
+        {
+            *pcCmdLine = 0;
+            bFindArg = true;
+        }
+        else if(bFindArg)
+        {
+            if(iArgc >= CMDLINE_MAX_ARGS)
+            {
+                return(CMDLINE_TOO_MANY_ARGS);
+            }
+            ppcArgv[iArgc++] = pcCmdLine;
+            bFindArg = false;
+        }
+        pcCmdLine++;
+    }
+
+    if(iArgc)
+    {
+        for(psEntry = g_psCmdTable; psEntry->pcCmd; psEntry++)
+        {
+            if(!strcmp(ppcArgv[0], psEntry->pcCmd))
+            {
+                return(psEntry->pfnCmd(iArgc, ppcArgv));
+            }
+        }
+    }
+
+    return(CMDLINE_BAD_CMD);
+}
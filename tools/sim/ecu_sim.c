@@ -0,0 +1,505 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Whole ECU simulation: main.c and all its tasks on the simulated board
+//
+// Usage: ecu_sim [-t seconds] [-e eeprom.bin] [-s sdcard.img] [-l]
+//                [-f faults.txt] [-v]
+// Runs the firmware as it boots on the board: main() of main.c creates the
+// tasks and starts the scheduler of sim_rtos.c, the ADC samples a synthetic
+// drive cycle at 8kHz from timer 0 and the dampers at 2kHz from the PWM
+// trigger, the wheel speed inputs follow it, CAN frames go onto a simulated
+// bus and the console is this terminal. -e keeps the EEPROM (event log,
+// calibration) in a file from run to run, -s gives the SD logger a card
+// image, created with 64MB if missing. -l draws the LCD in the top right
+// corner of the terminal, or prints every change when stderr is not one.
+// -f injects the sensor and bus faults of a script, see fault_sim.h, and -v
+// runs in virtual time, as fast as the host allows and the same every run.
+// After -t seconds or on Ctrl-C the tasks are stopped and the CPU time of
+// every task, the deadline statistics, the wheel speeds, the ADC stages and
+// rates, the CAN counters and the detection of the faults are printed. The
+// exit status is 1 if a fault failed.
+
+#define _DEFAULT_SOURCE
+
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "lcd_sim.h"
+#include "storage_file.h"
+#include "deadline_monitor.h"
+#include "rate_group.h"
+#include "adc_api.h"
+#include "wheel_speed.h"
+#include "can_driver.h"
+#include "fault_sim.h"
+
+// main() of main.c, renamed by the build
+int EcuMain(void);
+
+// the LCD backpack of lcd_task.c on I2C1
+#define SIM_LCD_I2C_PORT                1
+#define SIM_LCD_I2C_ADDR                0x3F
+
+#define SIM_SD_BLOCKS                   131072
+#define SIM_LCD_REFRESH_NS              100000000ULL
+#define SIM_VIRTUAL_POLL_NS             10000000ULL
+#define SIM_MAX_TASKS                   16
+
+// drive cycle, see SimDriveCycle()
+#define SIM_CYCLE_NS                    8000000000ULL
+
+static bool g_bSimLCD = false;
+static bool g_bSimVirtual = false;
+static bool g_bSimTermRaw = false;
+static struct termios g_sSimTermios;
+
+//*****************************************************************************
+//
+// The console is a serial terminal: characters go to the firmware as they
+// are typed and the firmware echoes them.
+//
+//*****************************************************************************
+static void SimTerminalRestore(void)
+{
+    if(g_bSimTermRaw)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &g_sSimTermios);
+    }
+}
+
+static void SimTerminalRaw(void)
+{
+    struct termios sRaw;
+
+    if(!isatty(STDIN_FILENO) || (tcgetattr(STDIN_FILENO, &g_sSimTermios) != 0))
+    {
+        return;
+    }
+
+    sRaw = g_sSimTermios;
+    sRaw.c_lflag &= ~(ICANON | ECHO);
+    sRaw.c_cc[VMIN] = 0;
+    sRaw.c_cc[VTIME] = 0;
+    if(tcsetattr(STDIN_FILENO, TCSANOW, &sRaw) == 0)
+    {
+        g_bSimTermRaw = true;
+        atexit(SimTerminalRestore);
+    }
+}
+
+//*****************************************************************************
+//
+// Synthetic inputs, repeating every 8s: the throttle (AIN0) is pressed over
+// 2s, held and released, then the brake (AIN1) is pressed for 2s. The
+// rotary sensor of the throttle pedal (AIN10) follows AIN0 inverted. AIN6
+// carries a 1Hz sine. The front dampers (AIN3, AIN4) move with the road at
+// 3Hz and 17Hz, the right one out of phase, and compress under the brake.
+// The temperature (AIN5) rises over the cycle. All channels have a few counts of noise so the stuck
+// sensor check of sensor_diag.c stays quiet.
+//
+//*****************************************************************************
+static uint32_t SimDriveCycle(uint32_t ui32Ch, uint64_t ui64TimeNs)
+{
+    static uint32_t ui32Noise = 1;
+    double dT = (double)(ui64TimeNs % SIM_CYCLE_NS) / 1e9, dValue;
+
+    ui32Noise = (ui32Noise * 1103515245) + 12345;
+
+    switch(ui32Ch)
+    {
+        case 0:
+        case 10:
+        {
+            if(dT < 2.0)
+            {
+                dValue = 400 + (1300 * (1 - cos(M_PI * dT / 2.0)));
+            }
+            else if(dT < 3.0)
+            {
+                dValue = 3000;
+            }
+            else if(dT < 4.0)
+            {
+                dValue = 400 + (1300 * (1 + cos(M_PI * (dT - 3.0))));
+            }
+            else
+            {
+                dValue = 400;
+            }
+            if(ui32Ch == 10)
+            {
+                dValue = 4095 - dValue;
+            }
+            break;
+        }
+
+        case 1:
+        {
+            dValue = ((dT >= 5.0) && (dT < 7.0)) ? 1500 : 300;
+            break;
+        }
+
+        case 3:
+        case 4:
+        {
+            dValue = 2048 + (300 * sin((2 * M_PI * 3 * dT) +
+                                       ((ui32Ch == 4) ? M_PI : 0))) +
+                     (80 * sin(2 * M_PI * 17 * dT));
+            dValue += ((dT >= 5.0) && (dT < 7.0)) ? 500 : 0;
+            break;
+        }
+
+        case 5:
+        {
+            dValue = 1200 + (50 * dT);
+            break;
+        }
+
+        case 6:
+        {
+            dValue = 2048 + (600 * sin(2 * M_PI * dT));
+            break;
+        }
+
+        default:
+        {
+            dValue = 2048;
+            break;
+        }
+    }
+
+    return (uint32_t)dValue + ((ui32Noise >> 16) & 7);
+}
+
+//*****************************************************************************
+//
+// Wheel speeds of the same cycle: the car pulls away from walking pace to
+// 100km/h while the throttle is pressed, rolls on, slows down to walking
+// pace under the brake and stands for the last second. The right wheel
+// turns 2% faster, the car is in a left hand bend.
+//
+//*****************************************************************************
+static double SimWheels(uint32_t ui32Input, uint64_t ui64TimeNs)
+{
+    double dT = (double)(ui64TimeNs % SIM_CYCLE_NS) / 1e9, dKmh;
+
+    if(dT < 4.0)
+    {
+        dKmh = 5.0 + (95.0 * dT / 4.0);
+    }
+    else if(dT < 5.0)
+    {
+        dKmh = 100.0;
+    }
+    else if(dT < 7.0)
+    {
+        dKmh = 100.0 - (95.0 * (dT - 5.0) / 2.0);
+    }
+    else
+    {
+        dKmh = 0.0;
+    }
+
+    if(ui32Input == WHEEL_SPEED_FRONT_RIGHT)
+    {
+        dKmh *= 1.02;
+    }
+
+    // teeth per second
+    return (dKmh / 3.6) * 1000.0 * WHEEL_SPEED_TEETH /
+           WHEEL_SPEED_CIRCUMFERENCE_MM;
+}
+
+//*****************************************************************************
+//
+// Draws the LCD when it changed, at most ten times a second.
+//
+//*****************************************************************************
+static void SimLCDDraw(char ppcText[LCD_SIM_ROWS][LCD_SIM_COLS + 1])
+{
+    struct winsize sWin;
+    uint32_t ui32Col = 80 - (LCD_SIM_COLS + 2) + 1;
+    const char *pcBox = LCDSimBacklight() ? "\033[7m" : "";
+
+    if(!isatty(STDERR_FILENO))
+    {
+        fprintf(stderr, "LCD %.3f |%s|%s|\n", (double)HalSimTimeNs() / 1e9,
+                ppcText[0], ppcText[1]);
+        return;
+    }
+
+    if((ioctl(STDERR_FILENO, TIOCGWINSZ, &sWin) == 0) &&
+       (sWin.ws_col > (LCD_SIM_COLS + 2)))
+    {
+        ui32Col = sWin.ws_col - (LCD_SIM_COLS + 2) + 1;
+    }
+
+    fprintf(stderr, "\0337\033[1;%uH+----------------+"
+                    "\033[2;%uH|%s%s\033[0m|"
+                    "\033[3;%uH|%s%s\033[0m|"
+                    "\033[4;%uH+----------------+\0338",
+            ui32Col, ui32Col, pcBox, ppcText[0], ui32Col, pcBox, ppcText[1],
+            ui32Col);
+    fflush(stderr);
+}
+
+//*****************************************************************************
+//
+// Host threads must not wait in virtual time, they wait on the host clock.
+//
+//*****************************************************************************
+static void SimHostSleep(uint64_t ui64Ns)
+{
+    struct timespec sDelay;
+
+    sDelay.tv_sec = (time_t)(ui64Ns / 1000000000ULL);
+    sDelay.tv_nsec = (long)(ui64Ns % 1000000000ULL);
+    nanosleep(&sDelay, NULL);
+}
+
+static void *SimLCDThread(void *pvArg)
+{
+    char ppcText[LCD_SIM_ROWS][LCD_SIM_COLS + 1];
+    uint32_t ui32Version, ui32Drawn = 0;
+    uint64_t ui64Next = HalSimTimeNs();
+
+    while(1)
+    {
+        ui64Next += SIM_LCD_REFRESH_NS;
+        if(g_bSimVirtual)
+        {
+            SimHostSleep(SIM_LCD_REFRESH_NS);
+        }
+        else
+        {
+            HalSimSleepUntil(ui64Next);
+        }
+
+        ui32Version = LCDSimRead(ppcText);
+        if(ui32Version != ui32Drawn)
+        {
+            ui32Drawn = ui32Version;
+            SimLCDDraw(ppcText);
+        }
+    }
+
+    return NULL;
+}
+
+//*****************************************************************************
+//
+// Stops the tasks and the peripherals and prints where the CPU time went.
+// Returns the number of faults that failed.
+//
+//*****************************************************************************
+static uint32_t SimReport(void)
+{
+    static const char * const ppcStates[] =
+    {
+        "running", "ready", "blocked", "suspended", "deleted"
+    };
+    static TaskStatus_t psTasks[SIM_MAX_TASKS];
+    uint32_t ui32Idx, ui32NumTasks, ui32Total, ui32Busy = 0;
+
+    vTaskEndScheduler();
+    for(ui32Idx = 0; ui32Idx < HAL_NUM_TIMERS; ui32Idx++)
+    {
+        HalTimerDisable(ui32Idx);
+    }
+
+    ui32NumTasks = uxTaskGetSystemState(psTasks, SIM_MAX_TASKS, &ui32Total);
+    if(ui32Total == 0)
+    {
+        ui32Total = 1;
+    }
+
+    UARTprintf("\n--- %u.%03u s, %u ticks ---\n", ui32Total / 1000000,
+               (ui32Total / 1000) % 1000, xTaskGetTickCount());
+    UARTprintf("task  pri  state      cpu %%\n");
+    for(ui32Idx = 0; ui32Idx < ui32NumTasks; ui32Idx++)
+    {
+        UARTprintf("%-5s %3u  %-9s %3u.%02u\n", psTasks[ui32Idx].pcTaskName,
+                   psTasks[ui32Idx].uxCurrentPriority,
+                   ppcStates[psTasks[ui32Idx].eCurrentState],
+                   (uint32_t)(((uint64_t)psTasks[ui32Idx].ulRunTimeCounter *
+                               100) / ui32Total),
+                   (uint32_t)((((uint64_t)psTasks[ui32Idx].ulRunTimeCounter *
+                                10000) / ui32Total) % 100));
+        ui32Busy += psTasks[ui32Idx].ulRunTimeCounter;
+    }
+    UARTprintf("idle             %3u.%02u\n\n",
+               (uint32_t)(((uint64_t)(ui32Total - ui32Busy) * 100) /
+                          ui32Total),
+               (uint32_t)((((uint64_t)(ui32Total - ui32Busy) * 10000) /
+                           ui32Total) % 100));
+
+    DeadlineMonitorReport();
+    RateGroupReport();
+    WheelSpeedReport();
+    ADCStageReport();
+    CANDriverReport();
+
+    return FaultSimReport();
+}
+
+//*****************************************************************************
+//
+// Waits for the end of the run: the time limit, Ctrl-C or a kill.
+//
+//*****************************************************************************
+static void *SimControlThread(void *pvSeconds)
+{
+    uint64_t ui64End = *(uint32_t *)pvSeconds * 1000000000ULL, ui64Now;
+    struct timespec sLimit;
+    sigset_t sSignals;
+
+    sigemptyset(&sSignals);
+    sigaddset(&sSignals, SIGINT);
+    sigaddset(&sSignals, SIGTERM);
+
+    if(ui64End)
+    {
+        while((ui64Now = HalSimTimeNs()) < ui64End)
+        {
+            // virtual time runs ahead of the host clock
+            if(g_bSimVirtual && ((ui64End - ui64Now) > SIM_VIRTUAL_POLL_NS))
+            {
+                ui64Now = ui64End - SIM_VIRTUAL_POLL_NS;
+            }
+            sLimit.tv_sec = (time_t)((ui64End - ui64Now) / 1000000000ULL);
+            sLimit.tv_nsec = (long)((ui64End - ui64Now) % 1000000000ULL);
+            if(sigtimedwait(&sSignals, NULL, &sLimit) >= 0)
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        while(sigwaitinfo(&sSignals, NULL) < 0)
+        {
+        }
+    }
+
+    exit(SimReport() ? 1 : 0);
+
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint32_t ui32Seconds = 0;
+    const char *pcSDCard = NULL;
+    pthread_t sThread;
+    sigset_t sSignals;
+    struct stat sStat;
+    int iOpt;
+
+    while((iOpt = getopt(argc, argv, "t:e:s:lf:v")) != -1)
+    {
+        switch(iOpt)
+        {
+            case 't':
+            {
+                ui32Seconds = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            }
+
+            case 'e':
+            {
+                if(HalSimEEPROMFileSet(optarg) != 0)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            }
+
+            case 's':
+            {
+                pcSDCard = optarg;
+                break;
+            }
+
+            case 'l':
+            {
+                g_bSimLCD = true;
+                break;
+            }
+
+            case 'f':
+            {
+                if(FaultSimLoad(optarg) != 0)
+                {
+                    return 1;
+                }
+                break;
+            }
+
+            case 'v':
+            {
+                g_bSimVirtual = true;
+                break;
+            }
+
+            default:
+            {
+                fprintf(stderr, "usage: %s [-t seconds] [-e eeprom.bin] "
+                                "[-s sdcard.img] [-l] [-f faults.txt] [-v]\n",
+                        argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if(pcSDCard &&
+       (StorageFileOpen(pcSDCard, (stat(pcSDCard, &sStat) == 0) ?
+                                  0 : SIM_SD_BLOCKS) != 0))
+    {
+        return 1;
+    }
+
+    //
+    // Every thread inherits the blocked signals, the control thread takes
+    // them with sigwait.
+    //
+    sigemptyset(&sSignals);
+    sigaddset(&sSignals, SIGINT);
+    sigaddset(&sSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sSignals, NULL);
+
+    if(g_bSimVirtual)
+    {
+        HalSimVirtualTimeEnable();
+    }
+
+    SimTerminalRaw();
+    HalSimADCSourceSet(SimDriveCycle);
+    HalSimCaptureSourceSet(SimWheels);
+    FaultSimAttach();
+    LCDSimAttach(SIM_LCD_I2C_PORT, SIM_LCD_I2C_ADDR);
+
+    if((pthread_create(&sThread, NULL, SimControlThread, &ui32Seconds) != 0) ||
+       (g_bSimLCD &&
+        (pthread_create(&sThread, NULL, SimLCDThread, NULL) != 0)))
+    {
+        return 1;
+    }
+
+    return EcuMain();
+}
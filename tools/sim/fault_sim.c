@@ -0,0 +1,592 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Sensor and bus faults injected into the simulated board
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "adc_api.h"
+#include "ADC_task.h"
+#include "can_events.h"
+#include "sensor_diag.h"
+#include "deadline_monitor.h"
+#include "i2cDriver.h"
+#include "fault_sim.h"
+
+/******************************************************************************
+Description: the faults sit in the fault hooks of hal_sim.c. The ADC hook
+changes the steps of sequencer 1 before the interrupt handler reads them and
+watches the firmware at the same time, so detection is measured to one
+conversion, 125us, in real and in virtual time. The I2C hook only reads the
+list. A fault starts at the first conversion at or after its start time,
+which is also when the state of the firmware it is compared against is
+taken.
+******************************************************************************/
+
+// the sequencer of the frame, see ADCTimerTriggeredInit()
+#define FAULT_SIM_ADC_SEQ               1
+
+// how the firmware saw a fault
+#define FAULT_SIM_SEEN_DTC              1
+#define FAULT_SIM_SEEN_CAN              2
+#define FAULT_SIM_SEEN_OVERRUN          3
+#define FAULT_SIM_SEEN_I2C              4
+
+// longest gap between two activations of the throttle request
+#define FAULT_SIM_MAX_GAP_NS            (2 * ADC_TASK_PERIOD_MS * 1000000ULL)
+
+typedef struct
+{
+    uint64_t ui64StartNs;
+    uint64_t ui64StopNs;
+    uint32_t ui32Type;
+    uint32_t ui32Target;
+    int32_t i32Param;
+
+    volatile bool bStarted;
+    bool bHeld;
+    uint32_t ui32Held;                  // stuck reading
+    uint32_t ui32Conversions;           // overrun
+
+    // the firmware at the start
+    uint32_t ui32DTCs;
+    uint32_t ui32CANFaults;
+    uint32_t ui32Overruns;
+    uint32_t ui32I2CErrors;
+    uint32_t ui32Misses;
+
+    // what it made of the fault
+    uint32_t ui32Seen;
+    uint32_t ui32SeenBits;
+    uint64_t ui64SeenNs;
+    uint64_t ui64ClearNs;
+    uint32_t ui32ADCMisses;
+    uint64_t ui64ADCGapNs;
+}
+tFaultSim;
+
+const char * const g_ppcFaultSimNames[FAULT_SIM_NUM_TYPES] =
+{
+    "open", "short", "stuck", "noise", "drift", "overrun", "i2c_nak",
+    "i2c_hang"
+};
+
+// param when the script gives none
+static const int32_t g_pi32FaultSimDefaults[FAULT_SIM_NUM_TYPES] =
+{
+    0, 4095, 0, 200, 500, 2, 0, 0
+};
+
+static tFaultSim g_psFaultSim[FAULT_SIM_MAX_FAULTS];
+static uint32_t g_ui32FaultSimNum = 0;
+static uint32_t g_ui32FaultSimNoise = 1;
+
+// activations of the 5ms rate group, see FaultSimWatch()
+static tDeadlineMonitor *g_psFaultSimADCTask = NULL;
+static uint32_t g_ui32FaultSimActivations = 0;
+static uint64_t g_ui64FaultSimActivationNs = 0;
+
+static bool FaultSimIsSensor(uint32_t ui32Type)
+{
+    return ui32Type <= FAULT_SIM_DRIFT;
+}
+
+static bool FaultSimActive(const tFaultSim *psFault, uint64_t ui64Now)
+{
+    return psFault->bStarted && (ui64Now < psFault->ui64StopNs);
+}
+
+//*****************************************************************************
+//
+// Adds a fault to the list. Returns 0, or -1 if the list is full or the
+// fault makes no sense.
+//
+//*****************************************************************************
+int32_t FaultSimAdd(uint32_t ui32StartMs, uint32_t ui32StopMs,
+                    uint32_t ui32Type, uint32_t ui32Target, int32_t i32Param)
+{
+    tFaultSim *psFault;
+
+    if((g_ui32FaultSimNum == FAULT_SIM_MAX_FAULTS) ||
+       (ui32Type >= FAULT_SIM_NUM_TYPES) || (ui32StopMs <= ui32StartMs) ||
+       (FaultSimIsSensor(ui32Type) && (ui32Target >= ADC_NUM_CHANNELS)) ||
+       ((ui32Type == FAULT_SIM_OVERRUN) && (i32Param < 1)))
+    {
+        return -1;
+    }
+
+    psFault = &g_psFaultSim[g_ui32FaultSimNum++];
+    memset(psFault, 0, sizeof(tFaultSim));
+    psFault->ui64StartNs = ui32StartMs * 1000000ULL;
+    psFault->ui64StopNs = ui32StopMs * 1000000ULL;
+    psFault->ui32Type = ui32Type;
+    psFault->ui32Target = ui32Target;
+    psFault->i32Param = i32Param;
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Reads a fault script, see fault_sim.h. Returns 0, or -1 after printing the
+// line in error.
+//
+//*****************************************************************************
+int32_t FaultSimLoad(const char *pcPath)
+{
+    char pcLine[128], pcType[16];
+    unsigned int uiStart, uiStop, uiTarget;
+    uint32_t ui32Line = 0, ui32Type;
+    int32_t i32Param;
+    FILE *psFile;
+    int iFields;
+
+    psFile = fopen(pcPath, "r");
+    if(!psFile)
+    {
+        perror(pcPath);
+        return -1;
+    }
+
+    while(fgets(pcLine, sizeof(pcLine), psFile))
+    {
+        ui32Line++;
+        pcLine[strcspn(pcLine, "#\r\n")] = 0;
+        iFields = sscanf(pcLine, "%u %u %15s %u %d", &uiStart, &uiStop, pcType,
+                         &uiTarget, &i32Param);
+        if(iFields <= 0)
+        {
+            continue;
+        }
+
+        for(ui32Type = 0; ui32Type < FAULT_SIM_NUM_TYPES; ui32Type++)
+        {
+            if(strcmp(pcType, g_ppcFaultSimNames[ui32Type]) == 0)
+            {
+                break;
+            }
+        }
+
+        if((iFields < 4) || (ui32Type == FAULT_SIM_NUM_TYPES) ||
+           (FaultSimAdd(uiStart, uiStop, ui32Type, uiTarget,
+                        (iFields == 5) ? i32Param :
+                        g_pi32FaultSimDefaults[ui32Type]) != 0))
+        {
+            fprintf(stderr, "%s:%u: bad fault\n", pcPath, ui32Line);
+            fclose(psFile);
+            return -1;
+        }
+    }
+
+    fclose(psFile);
+
+    return 0;
+}
+
+//*****************************************************************************
+//
+// Takes the state of the firmware a fault is compared against.
+//
+//*****************************************************************************
+static void FaultSimStart(tFaultSim *psFault, const tADCStageStats *psStages)
+{
+    psFault->ui32DTCs = SensorDiagActive();
+    psFault->ui32CANFaults = CANEventsFaults();
+    psFault->ui32Overruns = psStages->ui32Overruns +
+                            psStages->ui32SuspensionOverruns;
+    psFault->ui32I2CErrors = i2cDriverErrors();
+    psFault->ui32Misses = g_psFaultSimADCTask ?
+                          g_psFaultSimADCTask->ui32Misses : 0;
+    psFault->bStarted = true;
+}
+
+//*****************************************************************************
+//
+// Looks for the first sign of an active fault in the firmware: a DTC of the
+// channel or a CAN event fault, more ADC overruns or more failed I2C writes.
+//
+//*****************************************************************************
+static void FaultSimDetect(tFaultSim *psFault, const tADCStageStats *psStages,
+                           uint64_t ui64Now)
+{
+    uint32_t ui32Bits;
+
+    if(FaultSimIsSensor(psFault->ui32Type))
+    {
+        ui32Bits = SensorDiagActive() & ~psFault->ui32DTCs &
+                   (((1 << SENSOR_DIAG_NUM_TYPES) - 1) <<
+                    (psFault->ui32Target * SENSOR_DIAG_NUM_TYPES));
+        if(ui32Bits)
+        {
+            psFault->ui32Seen = FAULT_SIM_SEEN_DTC;
+        }
+        else
+        {
+            ui32Bits = CANEventsFaults() & ~psFault->ui32CANFaults;
+            psFault->ui32Seen = ui32Bits ? FAULT_SIM_SEEN_CAN : 0;
+        }
+        psFault->ui32SeenBits = ui32Bits;
+    }
+    else if(psFault->ui32Type == FAULT_SIM_OVERRUN)
+    {
+        psFault->ui32Seen = ((psStages->ui32Overruns +
+                              psStages->ui32SuspensionOverruns) !=
+                             psFault->ui32Overruns) ?
+                            FAULT_SIM_SEEN_OVERRUN : 0;
+    }
+    else
+    {
+        psFault->ui32Seen = (i2cDriverErrors() != psFault->ui32I2CErrors) ?
+                            FAULT_SIM_SEEN_I2C : 0;
+    }
+
+    if(psFault->ui32Seen)
+    {
+        psFault->ui64SeenNs = ui64Now;
+    }
+}
+
+//*****************************************************************************
+//
+// Follows the firmware at every conversion: starts the faults that are due,
+// looks for their detection, times the clearing of the fault bits after the
+// stop and keeps the worst gap between activations of the throttle request.
+//
+//*****************************************************************************
+static void FaultSimWatch(uint64_t ui64Now)
+{
+    tADCStageStats sStages;
+    tFaultSim *psFault;
+    uint64_t ui64Gap = 0;
+    uint32_t ui32Idx, ui32Bits;
+
+    ADCStageStatsGet(&sStages);
+
+    if(!g_psFaultSimADCTask)
+    {
+        // the group of the throttle request, ADCTaskRun()
+        g_psFaultSimADCTask = DeadlineMonitorFind("5ms");
+    }
+    if(g_psFaultSimADCTask)
+    {
+        if(g_psFaultSimADCTask->ui32Activations != g_ui32FaultSimActivations)
+        {
+            g_ui32FaultSimActivations = g_psFaultSimADCTask->ui32Activations;
+            g_ui64FaultSimActivationNs = ui64Now;
+        }
+        if(g_ui32FaultSimActivations)
+        {
+            ui64Gap = ui64Now - g_ui64FaultSimActivationNs;
+        }
+    }
+
+    for(ui32Idx = 0; ui32Idx < g_ui32FaultSimNum; ui32Idx++)
+    {
+        psFault = &g_psFaultSim[ui32Idx];
+
+        if(!psFault->bStarted && (ui64Now >= psFault->ui64StartNs))
+        {
+            FaultSimStart(psFault, &sStages);
+        }
+
+        if(FaultSimActive(psFault, ui64Now))
+        {
+            if(!psFault->ui32Seen)
+            {
+                FaultSimDetect(psFault, &sStages, ui64Now);
+            }
+            if(g_psFaultSimADCTask)
+            {
+                psFault->ui32ADCMisses = g_psFaultSimADCTask->ui32Misses -
+                                         psFault->ui32Misses;
+            }
+            if(ui64Gap > psFault->ui64ADCGapNs)
+            {
+                psFault->ui64ADCGapNs = ui64Gap;
+            }
+        }
+        else if(psFault->bStarted && !psFault->ui64ClearNs &&
+                ((psFault->ui32Seen == FAULT_SIM_SEEN_DTC) ||
+                 (psFault->ui32Seen == FAULT_SIM_SEEN_CAN)))
+        {
+            ui32Bits = (psFault->ui32Seen == FAULT_SIM_SEEN_DTC) ?
+                       SensorDiagActive() : CANEventsFaults();
+            if(!(ui32Bits & psFault->ui32SeenBits))
+            {
+                psFault->ui64ClearNs = ui64Now;
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// The reading of a channel under a sensor fault, within 12 bits.
+//
+//*****************************************************************************
+static uint32_t FaultSimSample(tFaultSim *psFault, uint32_t ui32Value,
+                               uint64_t ui64Now)
+{
+    int64_t i64Value = ui32Value;
+    int32_t i32Span;
+
+    switch(psFault->ui32Type)
+    {
+        case FAULT_SIM_OPEN:
+        {
+            i64Value = psFault->i32Param;
+            break;
+        }
+
+        case FAULT_SIM_SHORT:
+        {
+            i64Value = 4095;
+            break;
+        }
+
+        case FAULT_SIM_STUCK:
+        {
+            if(!psFault->bHeld)
+            {
+                psFault->ui32Held = ui32Value;
+                psFault->bHeld = true;
+            }
+            i64Value = psFault->ui32Held;
+            break;
+        }
+
+        case FAULT_SIM_NOISE:
+        {
+            //
+            // Uniform over +-1.73 param has a deviation of param.
+            //
+            i32Span = ((psFault->i32Param * 7) / 4) + 1;
+            g_ui32FaultSimNoise = (g_ui32FaultSimNoise * 1103515245) + 12345;
+            i64Value += (int32_t)((g_ui32FaultSimNoise >> 8) %
+                                  (uint32_t)((2 * i32Span) + 1)) - i32Span;
+            break;
+        }
+
+        case FAULT_SIM_DRIFT:
+        {
+            i64Value += ((int64_t)psFault->i32Param *
+                         (int64_t)(ui64Now - psFault->ui64StartNs)) /
+                        1000000000LL;
+            break;
+        }
+    }
+
+    return (i64Value < 0) ? 0 : (i64Value > 4095) ? 4095 : (uint32_t)i64Value;
+}
+
+//*****************************************************************************
+//
+// The ADC hook: watches the firmware, then applies the active faults to
+// the conversion.
+//
+//*****************************************************************************
+static bool FaultSimADC(uint32_t ui32Seq, uint32_t *pui32Steps,
+                        uint32_t ui32Steps, uint64_t ui64TimeNs)
+{
+    tFaultSim *psFault;
+    uint32_t ui32Idx;
+    bool bKeep = true;
+
+    if(ui32Seq == FAULT_SIM_ADC_SEQ)
+    {
+        FaultSimWatch(ui64TimeNs);
+    }
+
+    for(ui32Idx = 0; ui32Idx < g_ui32FaultSimNum; ui32Idx++)
+    {
+        psFault = &g_psFaultSim[ui32Idx];
+        if(!FaultSimActive(psFault, ui64TimeNs))
+        {
+            continue;
+        }
+
+        if(psFault->ui32Type == FAULT_SIM_OVERRUN)
+        {
+            if((psFault->ui32Target == ui32Seq) &&
+               ((++psFault->ui32Conversions % psFault->i32Param) == 0))
+            {
+                bKeep = false;
+            }
+        }
+        else if(FaultSimIsSensor(psFault->ui32Type) &&
+                (ui32Seq == FAULT_SIM_ADC_SEQ) &&
+                (psFault->ui32Target < ui32Steps))
+        {
+            pui32Steps[psFault->ui32Target] =
+                FaultSimSample(psFault, pui32Steps[psFault->ui32Target],
+                               ui64TimeNs);
+        }
+    }
+
+    return bKeep;
+}
+
+//*****************************************************************************
+//
+// The I2C hook: a bus fault of the port, once FaultSimWatch() started it.
+//
+//*****************************************************************************
+static uint32_t FaultSimI2C(uint32_t ui32Port, uint8_t ui8Addr,
+                            uint64_t ui64TimeNs)
+{
+    tFaultSim *psFault;
+    uint32_t ui32Idx, ui32Result = HAL_I2C_OK;
+
+    HalSimIntLock();
+    for(ui32Idx = 0; ui32Idx < g_ui32FaultSimNum; ui32Idx++)
+    {
+        psFault = &g_psFaultSim[ui32Idx];
+        if(FaultSimActive(psFault, ui64TimeNs) &&
+           (psFault->ui32Target == ui32Port))
+        {
+            if(psFault->ui32Type == FAULT_SIM_I2C_HANG)
+            {
+                ui32Result = HAL_I2C_ERR_TIMEOUT;
+            }
+            else if((psFault->ui32Type == FAULT_SIM_I2C_NAK) &&
+                    (ui32Result == HAL_I2C_OK))
+            {
+                ui32Result = HAL_I2C_ERR_ADDR_NACK;
+            }
+        }
+    }
+    HalSimIntUnlock();
+
+    return ui32Result;
+}
+
+//*****************************************************************************
+//
+// Puts the faults of the list into the simulated ADC and I2C.
+//
+//*****************************************************************************
+void FaultSimAttach(void)
+{
+    if(g_ui32FaultSimNum)
+    {
+        HalSimADCFaultSet(FaultSimADC);
+        HalSimI2CFaultSet(FaultSimI2C);
+    }
+}
+
+static void FaultSimPrintMs(uint64_t ui64Ns)
+{
+    UARTprintf(" %7u.%03u", (uint32_t)(ui64Ns / 1000000),
+               (uint32_t)((ui64Ns / 1000) % 1000));
+}
+
+//*****************************************************************************
+//
+// Prints a line per fault and returns the number of faults that failed:
+// never detected while active, or the throttle request missed its period. Faults
+// the run did not reach neither pass nor fail.
+//
+//*****************************************************************************
+uint32_t FaultSimReport(void)
+{
+    tFaultSim *psFault;
+    uint32_t ui32Idx, ui32Bit, ui32Failed = 0;
+    char pcSeen[24], pcTarget[8];
+    bool bFail;
+
+    if(!g_ui32FaultSimNum)
+    {
+        return 0;
+    }
+
+    UARTprintf("\nfault    target   start ms  seen by      latency ms"
+               "    clear ms  adc gap ms  miss\n");
+    for(ui32Idx = 0; ui32Idx < g_ui32FaultSimNum; ui32Idx++)
+    {
+        psFault = &g_psFaultSim[ui32Idx];
+
+        snprintf(pcTarget, sizeof(pcTarget), "%s%u",
+                 FaultSimIsSensor(psFault->ui32Type) ? "ch" :
+                 (psFault->ui32Type == FAULT_SIM_OVERRUN) ? "ss" : "i2c",
+                 psFault->ui32Target);
+
+        for(ui32Bit = 0; (ui32Bit < 31) &&
+            !(psFault->ui32SeenBits & (1 << ui32Bit)); ui32Bit++)
+        {
+        }
+        switch(psFault->ui32Seen)
+        {
+            case FAULT_SIM_SEEN_DTC:
+            {
+                snprintf(pcSeen, sizeof(pcSeen), "dtc %s",
+                         g_ppcSensorDiagNames[ui32Bit %
+                                              SENSOR_DIAG_NUM_TYPES]);
+                break;
+            }
+
+            case FAULT_SIM_SEEN_CAN:
+            {
+                snprintf(pcSeen, sizeof(pcSeen), "can 0x%02x",
+                         psFault->ui32SeenBits);
+                break;
+            }
+
+            case FAULT_SIM_SEEN_OVERRUN:
+            {
+                snprintf(pcSeen, sizeof(pcSeen), "adc overrun");
+                break;
+            }
+
+            case FAULT_SIM_SEEN_I2C:
+            {
+                snprintf(pcSeen, sizeof(pcSeen), "i2c error");
+                break;
+            }
+
+            default:
+            {
+                snprintf(pcSeen, sizeof(pcSeen), psFault->bStarted ?
+                         "-" : "not reached");
+                break;
+            }
+        }
+
+        bFail = psFault->bStarted &&
+                (!psFault->ui32Seen || psFault->ui32ADCMisses ||
+                 (psFault->ui64ADCGapNs > FAULT_SIM_MAX_GAP_NS));
+        ui32Failed += bFail ? 1 : 0;
+
+        UARTprintf("%-8s %-6s", g_ppcFaultSimNames[psFault->ui32Type],
+                   pcTarget);
+        FaultSimPrintMs(psFault->ui64StartNs);
+        UARTprintf("  %-12s", pcSeen);
+        if(psFault->ui32Seen)
+        {
+            FaultSimPrintMs(psFault->ui64SeenNs - psFault->ui64StartNs);
+        }
+        else
+        {
+            UARTprintf(" %11s", "-");
+        }
+        if(psFault->ui64ClearNs)
+        {
+            FaultSimPrintMs(psFault->ui64ClearNs - psFault->ui64StopNs);
+        }
+        else
+        {
+            UARTprintf(" %11s", "-");
+        }
+        FaultSimPrintMs(psFault->ui64ADCGapNs);
+        UARTprintf(" %5u%s\n", psFault->ui32ADCMisses, bFail ? "  FAIL" : "");
+    }
+    UARTprintf("%u of %u faults failed\n", ui32Failed, g_ui32FaultSimNum);
+
+    return ui32Failed;
+}
@@ -0,0 +1,59 @@
+//*****************************************************************************
+//
+// fault_sim.h - Sensor and bus faults injected into the simulated board.
+//
+// A fault script lists one fault per line, times in milliseconds of
+// simulated time, '#' starts a comment:
+//
+//   start_ms stop_ms type target [param]
+//
+//   open       channel     reads param, 0 by default: broken wire
+//   short      channel     reads 4095: signal shorted to the supply
+//   stuck      channel     holds the reading of the start
+//   noise      channel     adds noise of deviation param, 200 by default
+//   drift      channel     moves param counts per second, 500 by default
+//   overrun    sequencer   loses every param-th conversion, 2 by default
+//   i2c_nak    port        no device answers its address
+//   i2c_hang   port        a slave holds the bus low
+//
+// A channel is a channel of the ADC frame, a step of sequencer 1. Faults on
+// the same channel apply in the order of the script.
+//
+// While a fault is active the firmware is watched at every conversion of
+// the ADC: new DTCs of the channel or new CAN event faults for the sensor
+// faults, the overrun count of the ADC interrupt for overruns and the
+// failed writes of i2cDriver.c for the bus faults. The first of them after
+// the start is the detection, its latency and the time the fault bits take
+// to clear after the stop are reported. The 5ms rate group with the
+// throttle request must keep its period throughout: a deadline miss or a gap
+// of more than two periods between its activations while a fault is active
+// fails the fault.
+//
+//*****************************************************************************
+
+#ifndef FAULT_SIM_H
+#define FAULT_SIM_H
+
+#include <stdint.h>
+
+#define FAULT_SIM_OPEN                  0
+#define FAULT_SIM_SHORT                 1
+#define FAULT_SIM_STUCK                 2
+#define FAULT_SIM_NOISE                 3
+#define FAULT_SIM_DRIFT                 4
+#define FAULT_SIM_OVERRUN               5
+#define FAULT_SIM_I2C_NAK               6
+#define FAULT_SIM_I2C_HANG              7
+#define FAULT_SIM_NUM_TYPES             8
+
+#define FAULT_SIM_MAX_FAULTS            32
+
+extern const char * const g_ppcFaultSimNames[FAULT_SIM_NUM_TYPES];
+
+int32_t FaultSimAdd(uint32_t ui32StartMs, uint32_t ui32StopMs,
+                    uint32_t ui32Type, uint32_t ui32Target, int32_t i32Param);
+int32_t FaultSimLoad(const char *pcPath);
+void FaultSimAttach(void);
+uint32_t FaultSimReport(void);
+
+#endif
@@ -0,0 +1,1196 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Hardware abstraction layer, Linux simulation backend
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal.h"
+#include "hal_sim.h"
+#include "timestamp.h"
+
+/******************************************************************************
+Description: every HAL call works on a small model of the peripheral. Timers
+are host threads that sleep until their next timeout, trigger the ADC
+sequencers and raise their interrupt. A thread that falls behind, the 1MHz
+timer of delay.c always does, catches up with back to back timeouts, so the
+number of interrupts over time is exact even where their spacing is not.
+The ADC converts a sequence at the trigger, reading the inputs from the
+source function, and raises its interrupt right away. A conversion lost to
+a fault or to a FIFO the handler has not read sets the overflow of the
+sequencer and raises nothing.
+
+In virtual time the timers have no threads. A single clock thread waits
+until the simulated CPU waits or is idle, then moves the clock to the next
+event and either runs the timeout there or ends the wait of the CPU. Only
+one of the two runs at a time, which is what makes the times repeatable.
+A task that is preempted while it waits stops as soon as it leaves the wait
+and waits again when it runs next.
+******************************************************************************/
+
+#define HAL_SIM_ADC_SEQUENCERS          4
+#define HAL_SIM_I2C_PORTS               2
+#define HAL_SIM_UART_PORTS              1
+#define HAL_SIM_UART_FIFO               16
+#define HAL_SIM_EEPROM_WORDS            (HAL_EEPROM_SIZE / 4)
+
+// SysCtlResetCauseGet() after power on
+#define HAL_SIM_RESET_CAUSE_POR         0x00000002
+
+// the PWM generator of the ADC trigger and the kernel tick of sim_rtos.c
+// follow the timers of hal.h
+#define HAL_SIM_PWM                     HAL_NUM_TIMERS
+#define HAL_SIM_SYSTICK                 (HAL_NUM_TIMERS + 1)
+
+// what the CPU waits for in virtual time
+#define HAL_SIM_WAIT_NONE               0
+#define HAL_SIM_WAIT_TIME               1
+#define HAL_SIM_WAIT_INT                2
+
+static struct timespec g_sHalSimStart;
+
+// stepped time, see HalSimTimeSet()
+static pthread_mutex_t g_sHalSimStepLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sHalSimStepCond;
+static volatile bool g_bHalSimStepped = false;
+static uint64_t g_ui64HalSimStepTime;
+static uint64_t g_ui64HalSimStepHost;
+static sigset_t g_sHalSimPreemptSet;
+
+// virtual time, see HalSimVirtualTimeEnable(), under the step lock as well
+static volatile bool g_bHalSimVirtual = false;
+static uint64_t g_ui64HalSimVirtualNs = 0;
+static bool g_bHalSimCPUIdle = false;
+static uint32_t g_ui32HalSimCPUWait = HAL_SIM_WAIT_NONE;
+static uint64_t g_ui64HalSimCPUWake;
+static uint32_t g_ui32HalSimCPUInts;
+static uint32_t g_ui32HalSimInts = 0;
+static pthread_t g_sHalSimClockThread;
+
+//*****************************************************************************
+//
+// The interrupt lock. The depth counts the nesting of the calling thread.
+//
+//*****************************************************************************
+static pthread_mutex_t g_sHalSimIntLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread uint32_t g_ui32HalSimIntDepth = 0;
+static __thread bool g_bHalSimInISR = false;
+static __thread bool g_bHalSimPreemptible = false;
+
+typedef struct
+{
+    bool bConfigured;
+    uint32_t ui32Trigger;
+    uint32_t ui32Steps;
+    uint8_t pui8Channels[HAL_ADC_MAX_STEPS];
+    uint32_t pui32Fifo[HAL_ADC_MAX_STEPS];
+    bool bStatus;
+    bool bUnread;
+    bool bOverflow;
+    void (*pfnHandler)(void);
+}
+tHalSimADCSeq;
+
+typedef struct
+{
+    uint64_t ui64PeriodNs;
+    uint32_t ui32ADCTrigger;            // HAL_ADC_TRIGGER_PROCESSOR for none
+    void (*pfnHandler)(void);
+    volatile bool bEnabled;
+    uint64_t ui64Next;
+    bool bThread;
+    pthread_t sThread;
+}
+tHalSimTimer;
+
+typedef struct
+{
+    uint64_t ui64Last;
+    double dEdges;
+    uint64_t ui64EdgeNs;
+}
+tHalSimCapture;
+
+typedef struct
+{
+    uint8_t ui8Addr;
+    tHalSimI2CDevice pfnDevice;
+}
+tHalSimI2CSlave;
+
+static uint32_t HalSimADCMidScale(uint32_t ui32Ch, uint64_t ui64TimeNs);
+static double HalSimCaptureStill(uint32_t ui32Input, uint64_t ui64TimeNs);
+
+static tHalSimADCSeq g_psHalSimADCSeq[HAL_SIM_ADC_SEQUENCERS];
+static tHalSimADCSource g_pfnHalSimADCSource = HalSimADCMidScale;
+static tHalSimADCFault g_pfnHalSimADCFault = NULL;
+static tHalSimI2CFault g_pfnHalSimI2CFault = NULL;
+static tHalSimTimer g_psHalSimTimers[HAL_SIM_SYSTICK + 1];
+static tHalSimCaptureSource g_pfnHalSimCaptureSource = HalSimCaptureStill;
+static tHalSimCapture g_psHalSimCaptures[HAL_NUM_CAPTURES];
+static pthread_mutex_t g_sHalSimCaptureLock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_pui32HalSimI2CRate[HAL_SIM_I2C_PORTS] = { 100000, 100000 };
+static tHalSimI2CSlave g_ppsHalSimI2C[HAL_SIM_I2C_PORTS][HAL_SIM_I2C_MAX_DEVICES];
+static int g_piHalSimUARTIn[HAL_SIM_UART_PORTS] = { 0 };
+static int g_piHalSimUARTOut[HAL_SIM_UART_PORTS] = { 1 };
+static uint32_t g_pui32HalSimUARTBaud[HAL_SIM_UART_PORTS] = { 115200 };
+static uint64_t g_pui64HalSimUARTIdle[HAL_SIM_UART_PORTS];
+static pthread_mutex_t g_sHalSimUARTLock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t g_pui8HalSimGPIOIn[HAL_GPIO_NUM_PORTS];
+static uint8_t g_pui8HalSimGPIOOut[HAL_GPIO_NUM_PORTS];
+static uint32_t g_pui32HalSimEEPROM[HAL_SIM_EEPROM_WORDS];
+static FILE *g_psHalSimEEPROMFile = NULL;
+static uint32_t g_ui32HalSimResetCause = HAL_SIM_RESET_CAUSE_POR;
+
+//*****************************************************************************
+//
+// Runs before main(). The preemption signal is blocked here so that every
+// thread inherits it blocked, task threads unblock it themselves.
+//
+//*****************************************************************************
+static void __attribute__((constructor)) HalSimStart(void)
+{
+    pthread_condattr_t sAttr;
+
+    clock_gettime(CLOCK_MONOTONIC, &g_sHalSimStart);
+
+    pthread_condattr_init(&sAttr);
+    pthread_condattr_setclock(&sAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_sHalSimStepCond, &sAttr);
+    pthread_condattr_destroy(&sAttr);
+
+    sigemptyset(&g_sHalSimPreemptSet);
+    sigaddset(&g_sHalSimPreemptSet, HAL_SIM_PREEMPT_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &g_sHalSimPreemptSet, NULL);
+
+    memset(g_pui32HalSimEEPROM, 0xFF, sizeof(g_pui32HalSimEEPROM));
+}
+
+//*****************************************************************************
+//
+// Time.
+//
+//*****************************************************************************
+static uint64_t HalSimHostNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return ((uint64_t)(sNow.tv_sec - g_sHalSimStart.tv_sec) * 1000000000ULL) +
+           (uint64_t)sNow.tv_nsec - (uint64_t)g_sHalSimStart.tv_nsec;
+}
+
+static void HalSimHostTimespec(uint64_t ui64Ns, struct timespec *psTime)
+{
+    uint64_t ui64Nsec = (uint64_t)g_sHalSimStart.tv_nsec + ui64Ns;
+
+    psTime->tv_sec = g_sHalSimStart.tv_sec + (time_t)(ui64Nsec / 1000000000ULL);
+    psTime->tv_nsec = (long)(ui64Nsec % 1000000000ULL);
+}
+
+static void HalSimVirtualWait(uint32_t ui32Wait, uint64_t ui64Ns);
+
+uint64_t HalSimTimeNs(void)
+{
+    uint64_t ui64Now;
+
+    if(g_bHalSimVirtual)
+    {
+        pthread_mutex_lock(&g_sHalSimStepLock);
+        ui64Now = g_ui64HalSimVirtualNs;
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+        return ui64Now;
+    }
+
+    if(!g_bHalSimStepped)
+    {
+        return HalSimHostNs();
+    }
+
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    ui64Now = g_ui64HalSimStepTime + HalSimHostNs() - g_ui64HalSimStepHost;
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+
+    return ui64Now;
+}
+
+void HalSimSleepUntil(uint64_t ui64Ns)
+{
+    struct timespec sWake;
+    uint64_t ui64Now;
+
+    if(g_bHalSimVirtual)
+    {
+        HalSimVirtualWait(HAL_SIM_WAIT_TIME, ui64Ns);
+        return;
+    }
+
+    if(!g_bHalSimStepped)
+    {
+        HalSimHostTimespec(ui64Ns, &sWake);
+        while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &sWake, NULL) ==
+              EINTR)
+        {
+        }
+        return;
+    }
+
+    //
+    // The clock gets there by running on or by a step over the time.
+    //
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    while((ui64Now = g_ui64HalSimStepTime + HalSimHostNs() -
+                     g_ui64HalSimStepHost) < ui64Ns)
+    {
+        HalSimHostTimespec(HalSimHostNs() + (ui64Ns - ui64Now), &sWake);
+        pthread_cond_timedwait(&g_sHalSimStepCond, &g_sHalSimStepLock, &sWake);
+    }
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+}
+
+void HalSimTimeSet(uint64_t ui64Ns)
+{
+    uint64_t ui64Host = HalSimHostNs();
+
+    // virtual time has no steps, the events up to the time are all due
+    if(g_bHalSimVirtual)
+    {
+        HalSimSleepUntil(ui64Ns);
+        return;
+    }
+
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    if(!g_bHalSimStepped)
+    {
+        g_ui64HalSimStepTime = ui64Host;
+        g_ui64HalSimStepHost = ui64Host;
+        g_bHalSimStepped = true;
+    }
+    if(ui64Ns > (g_ui64HalSimStepTime + ui64Host - g_ui64HalSimStepHost))
+    {
+        g_ui64HalSimStepTime = ui64Ns;
+        g_ui64HalSimStepHost = ui64Host;
+    }
+    pthread_cond_broadcast(&g_sHalSimStepCond);
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+}
+
+//*****************************************************************************
+//
+// Virtual time. The CPU waits until the clock thread has moved the clock to
+// the end of its wait or raised an interrupt. Preemption is held off while
+// the step lock is taken, a task losing the CPU in the wait is stopped by
+// the pending signal when it leaves the wait and starts over once it runs.
+//
+//*****************************************************************************
+static void HalSimVirtualWait(uint32_t ui32Wait, uint64_t ui64Ns)
+{
+    sigset_t sMask;
+    uint32_t ui32Ints;
+
+    pthread_sigmask(SIG_BLOCK, &g_sHalSimPreemptSet, &sMask);
+    pthread_mutex_lock(&g_sHalSimStepLock);
+
+    //
+    // With interrupts held off nothing else can run until the wait is over.
+    //
+    if(g_ui32HalSimIntDepth != 0)
+    {
+        if((ui32Wait == HAL_SIM_WAIT_TIME) && (g_ui64HalSimVirtualNs < ui64Ns))
+        {
+            g_ui64HalSimVirtualNs = ui64Ns;
+        }
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+        pthread_sigmask(SIG_SETMASK, &sMask, NULL);
+        return;
+    }
+
+    ui32Ints = g_ui32HalSimInts;
+    while((ui32Wait == HAL_SIM_WAIT_TIME) ?
+          (g_ui64HalSimVirtualNs < ui64Ns) : (g_ui32HalSimInts == ui32Ints))
+    {
+        g_ui32HalSimCPUWait = ui32Wait;
+        g_ui64HalSimCPUWake = ui64Ns;
+        g_ui32HalSimCPUInts = ui32Ints;
+        pthread_cond_broadcast(&g_sHalSimStepCond);
+        while(g_ui32HalSimCPUWait != HAL_SIM_WAIT_NONE)
+        {
+            pthread_cond_wait(&g_sHalSimStepCond, &g_sHalSimStepLock);
+        }
+
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+        pthread_sigmask(SIG_SETMASK, &sMask, NULL);
+        pthread_sigmask(SIG_BLOCK, &g_sHalSimPreemptSet, NULL);
+        pthread_mutex_lock(&g_sHalSimStepLock);
+    }
+
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+    pthread_sigmask(SIG_SETMASK, &sMask, NULL);
+}
+
+static void HalSimTimerExpire(tHalSimTimer *psTimer);
+
+static void *HalSimClockThread(void *pvArg)
+{
+    tHalSimTimer *psNext;
+    uint32_t ui32Timer;
+
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    while(1)
+    {
+        if(!g_bHalSimCPUIdle && (g_ui32HalSimCPUWait == HAL_SIM_WAIT_NONE))
+        {
+            pthread_cond_wait(&g_sHalSimStepCond, &g_sHalSimStepLock);
+            continue;
+        }
+
+        if((g_ui32HalSimCPUWait == HAL_SIM_WAIT_INT) &&
+           (g_ui32HalSimInts != g_ui32HalSimCPUInts))
+        {
+            g_ui32HalSimCPUWait = HAL_SIM_WAIT_NONE;
+            pthread_cond_broadcast(&g_sHalSimStepCond);
+            continue;
+        }
+
+        //
+        // The next timeout, the first timer of the earliest ones.
+        //
+        psNext = NULL;
+        for(ui32Timer = 0; ui32Timer <= HAL_SIM_SYSTICK; ui32Timer++)
+        {
+            if(g_psHalSimTimers[ui32Timer].bEnabled &&
+               (!psNext ||
+                (g_psHalSimTimers[ui32Timer].ui64Next < psNext->ui64Next)))
+            {
+                psNext = &g_psHalSimTimers[ui32Timer];
+            }
+        }
+
+        if((g_ui32HalSimCPUWait == HAL_SIM_WAIT_TIME) &&
+           (!psNext || (g_ui64HalSimCPUWake < psNext->ui64Next)))
+        {
+            if(g_ui64HalSimVirtualNs < g_ui64HalSimCPUWake)
+            {
+                g_ui64HalSimVirtualNs = g_ui64HalSimCPUWake;
+            }
+            g_ui32HalSimCPUWait = HAL_SIM_WAIT_NONE;
+            pthread_cond_broadcast(&g_sHalSimStepCond);
+            continue;
+        }
+
+        if(!psNext)
+        {
+            pthread_cond_wait(&g_sHalSimStepCond, &g_sHalSimStepLock);
+            continue;
+        }
+
+        //
+        // A timeout held off by a handler or a masked wait comes late, the
+        // ones after it follow back to back.
+        //
+        if(g_ui64HalSimVirtualNs < psNext->ui64Next)
+        {
+            g_ui64HalSimVirtualNs = psNext->ui64Next;
+        }
+        psNext->ui64Next += psNext->ui64PeriodNs;
+        g_ui32HalSimInts++;
+
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+        HalSimTimerExpire(psNext);
+        pthread_mutex_lock(&g_sHalSimStepLock);
+    }
+
+    return NULL;
+}
+
+void HalSimVirtualTimeEnable(void)
+{
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    if(!g_bHalSimVirtual && !g_bHalSimStepped &&
+       (pthread_create(&g_sHalSimClockThread, NULL, HalSimClockThread,
+                       NULL) == 0))
+    {
+        g_bHalSimVirtual = true;
+    }
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+}
+
+void HalSimCPUSwitch(bool bIdle)
+{
+    if(g_bHalSimVirtual)
+    {
+        pthread_mutex_lock(&g_sHalSimStepLock);
+        g_bHalSimCPUIdle = bIdle;
+        g_ui32HalSimCPUWait = HAL_SIM_WAIT_NONE;
+        pthread_cond_broadcast(&g_sHalSimStepCond);
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+    }
+}
+
+void HalBusyWait(void)
+{
+    // in real time the caller spins as it did before
+    if(g_bHalSimVirtual)
+    {
+        HalSimVirtualWait(HAL_SIM_WAIT_INT, 0);
+    }
+}
+
+// 80 cycles per microsecond
+uint32_t HalCycleCount(void)
+{
+    return (uint32_t)((HalSimTimeNs() * 2) / 25);
+}
+
+// timestamp.c is not built for the simulation, the counter always runs
+void TimestampInit(void)
+{
+}
+
+//*****************************************************************************
+//
+// Interrupts.
+//
+//*****************************************************************************
+void HalSimIntLock(void)
+{
+    if(g_ui32HalSimIntDepth++ == 0)
+    {
+        if(g_bHalSimPreemptible)
+        {
+            pthread_sigmask(SIG_BLOCK, &g_sHalSimPreemptSet, NULL);
+        }
+        pthread_mutex_lock(&g_sHalSimIntLock);
+    }
+}
+
+void HalSimIntUnlock(void)
+{
+    if(--g_ui32HalSimIntDepth == 0)
+    {
+        pthread_mutex_unlock(&g_sHalSimIntLock);
+        if(g_bHalSimPreemptible)
+        {
+            pthread_sigmask(SIG_UNBLOCK, &g_sHalSimPreemptSet, NULL);
+        }
+    }
+}
+
+void HalSimIntWait(pthread_cond_t *psCond)
+{
+    pthread_cond_wait(psCond, &g_sHalSimIntLock);
+}
+
+bool HalSimInInterrupt(void)
+{
+    return g_bHalSimInISR;
+}
+
+void HalSimThreadPreemptible(void)
+{
+    g_bHalSimPreemptible = true;
+    pthread_sigmask(SIG_UNBLOCK, &g_sHalSimPreemptSet, NULL);
+}
+
+void HalSimInterrupt(void (*pfnHandler)(void))
+{
+    HalSimIntLock();
+    g_bHalSimInISR = true;
+    pfnHandler();
+    g_bHalSimInISR = false;
+    HalSimIntUnlock();
+}
+
+uint32_t HalIntMasterDisable(void)
+{
+    if(g_ui32HalSimIntDepth != 0)
+    {
+        return 1;
+    }
+
+    HalSimIntLock();
+
+    return 0;
+}
+
+void HalIntMasterEnable(void)
+{
+    // handlers always run to the end with the lock held
+    if((g_ui32HalSimIntDepth != 0) && !g_bHalSimInISR)
+    {
+        g_ui32HalSimIntDepth = 1;
+        HalSimIntUnlock();
+    }
+}
+
+//*****************************************************************************
+//
+// System.
+//
+//*****************************************************************************
+void HalSysClockInit(void)
+{
+}
+
+uint32_t HalSysClockGet(void)
+{
+    return HAL_SYS_CLOCK_HZ;
+}
+
+uint32_t HalSysResetCauseGet(void)
+{
+    uint32_t ui32Cause = g_ui32HalSimResetCause;
+
+    g_ui32HalSimResetCause = 0;
+
+    return ui32Cause;
+}
+
+uint32_t HalSysFaultStatusGet(void)
+{
+    return 0;
+}
+
+//*****************************************************************************
+//
+// ADC0.
+//
+//*****************************************************************************
+static uint32_t HalSimADCMidScale(uint32_t ui32Ch, uint64_t ui64TimeNs)
+{
+    return 2048;
+}
+
+void HalSimADCSourceSet(tHalSimADCSource pfnSource)
+{
+    g_pfnHalSimADCSource = pfnSource;
+}
+
+void HalSimADCFaultSet(tHalSimADCFault pfnFault)
+{
+    g_pfnHalSimADCFault = pfnFault;
+}
+
+void HalADCInit(uint32_t ui32Oversample)
+{
+}
+
+void HalADCSequenceInit(uint32_t ui32Seq, uint32_t ui32Trigger,
+                        const uint8_t *pui8Channels, uint32_t ui32Steps)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+
+    HalSimIntLock();
+    psSeq->ui32Trigger = ui32Trigger;
+    psSeq->ui32Steps = ui32Steps;
+    memcpy(psSeq->pui8Channels, pui8Channels, ui32Steps);
+    psSeq->bStatus = false;
+    psSeq->bUnread = false;
+    psSeq->bOverflow = false;
+    psSeq->bConfigured = true;
+    HalSimIntUnlock();
+}
+
+//*****************************************************************************
+//
+// Puts the steps of a conversion through the fault into the FIFO and raises
+// the interrupt of the sequence, or loses them to an overflow.
+//
+//*****************************************************************************
+static void HalSimADCComplete(uint32_t ui32Seq, uint32_t *pui32Steps,
+                              uint64_t ui64Now)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+    uint32_t ui32Step;
+    bool bLost;
+
+    HalSimIntLock();
+    bLost = psSeq->bUnread ||
+            (g_pfnHalSimADCFault &&
+             !g_pfnHalSimADCFault(ui32Seq, pui32Steps, psSeq->ui32Steps,
+                                  ui64Now));
+    if(bLost)
+    {
+        psSeq->bOverflow = true;
+        HalSimIntUnlock();
+        return;
+    }
+    for(ui32Step = 0; ui32Step < psSeq->ui32Steps; ui32Step++)
+    {
+        psSeq->pui32Fifo[ui32Step] = pui32Steps[ui32Step] & 0xFFF;
+    }
+    psSeq->bStatus = true;
+    psSeq->bUnread = true;
+    HalSimIntUnlock();
+
+    if(psSeq->pfnHandler)
+    {
+        HalSimInterrupt(psSeq->pfnHandler);
+    }
+}
+
+//*****************************************************************************
+//
+// Converts the steps of a sequence and raises its interrupt.
+//
+//*****************************************************************************
+static void HalSimADCConvert(uint32_t ui32Seq)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+    uint32_t pui32Steps[HAL_ADC_MAX_STEPS];
+    uint64_t ui64Now = HalSimTimeNs();
+    uint32_t ui32Step;
+
+    for(ui32Step = 0; ui32Step < psSeq->ui32Steps; ui32Step++)
+    {
+        pui32Steps[ui32Step] =
+            g_pfnHalSimADCSource(psSeq->pui8Channels[ui32Step], ui64Now);
+    }
+
+    HalSimADCComplete(ui32Seq, pui32Steps, ui64Now);
+}
+
+void HalSimADCInject(uint32_t ui32Seq, const uint16_t *pui16Samples)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+    uint32_t pui32Steps[HAL_ADC_MAX_STEPS];
+    uint32_t ui32Step;
+
+    for(ui32Step = 0; ui32Step < psSeq->ui32Steps; ui32Step++)
+    {
+        pui32Steps[ui32Step] = pui16Samples[ui32Step];
+    }
+
+    HalSimADCComplete(ui32Seq, pui32Steps, HalSimTimeNs());
+}
+
+void HalADCIntRegister(uint32_t ui32Seq, void (*pfnHandler)(void))
+{
+    g_psHalSimADCSeq[ui32Seq].pfnHandler = pfnHandler;
+}
+
+void HalADCIntClear(uint32_t ui32Seq)
+{
+    g_psHalSimADCSeq[ui32Seq].bStatus = false;
+}
+
+bool HalADCIntStatus(uint32_t ui32Seq)
+{
+    return g_psHalSimADCSeq[ui32Seq].bStatus;
+}
+
+uint32_t HalADCDataGet(uint32_t ui32Seq, uint32_t *pui32Buffer)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+
+    memcpy(pui32Buffer, psSeq->pui32Fifo, psSeq->ui32Steps * 4);
+    psSeq->bUnread = false;
+
+    return psSeq->ui32Steps;
+}
+
+void HalADCProcessorTrigger(uint32_t ui32Seq)
+{
+    if(g_psHalSimADCSeq[ui32Seq].bConfigured &&
+       (g_psHalSimADCSeq[ui32Seq].ui32Trigger == HAL_ADC_TRIGGER_PROCESSOR))
+    {
+        HalSimADCConvert(ui32Seq);
+    }
+}
+
+bool HalADCOverflow(uint32_t ui32Seq)
+{
+    tHalSimADCSeq *psSeq = &g_psHalSimADCSeq[ui32Seq];
+    bool bOverflow;
+
+    HalSimIntLock();
+    bOverflow = psSeq->bOverflow;
+    psSeq->bOverflow = false;
+    HalSimIntUnlock();
+
+    return bOverflow;
+}
+
+//*****************************************************************************
+//
+// Timers.
+//
+//*****************************************************************************
+static void HalSimTimerExpire(tHalSimTimer *psTimer)
+{
+    uint32_t ui32Seq;
+
+    if(psTimer->ui32ADCTrigger != HAL_ADC_TRIGGER_PROCESSOR)
+    {
+        for(ui32Seq = 0; ui32Seq < HAL_SIM_ADC_SEQUENCERS; ui32Seq++)
+        {
+            if(g_psHalSimADCSeq[ui32Seq].bConfigured &&
+               (g_psHalSimADCSeq[ui32Seq].ui32Trigger ==
+                psTimer->ui32ADCTrigger))
+            {
+                HalSimADCConvert(ui32Seq);
+            }
+        }
+    }
+
+    if(psTimer->pfnHandler)
+    {
+        HalSimInterrupt(psTimer->pfnHandler);
+    }
+}
+
+static void *HalSimTimerThread(void *pvTimer)
+{
+    tHalSimTimer *psTimer = pvTimer;
+    uint64_t ui64Next = HalSimTimeNs();
+
+    while(psTimer->bEnabled)
+    {
+        ui64Next += psTimer->ui64PeriodNs;
+        HalSimSleepUntil(ui64Next);
+        if(psTimer->bEnabled)
+        {
+            HalSimTimerExpire(psTimer);
+        }
+    }
+
+    return NULL;
+}
+
+void HalTimerPeriodicInit(uint32_t ui32Timer, uint32_t ui32Hz)
+{
+    // the load value is rounded to whole system clock cycles
+    g_psHalSimTimers[ui32Timer].ui64PeriodNs =
+        ((uint64_t)(HAL_SYS_CLOCK_HZ / ui32Hz) * 1000000000ULL) /
+        HAL_SYS_CLOCK_HZ;
+}
+
+void HalTimerADCTriggerEnable(uint32_t ui32Timer)
+{
+    g_psHalSimTimers[ui32Timer].ui32ADCTrigger = HAL_ADC_TRIGGER_TIMER;
+}
+
+void HalTimerIntRegister(uint32_t ui32Timer, void (*pfnHandler)(void))
+{
+    g_psHalSimTimers[ui32Timer].pfnHandler = pfnHandler;
+}
+
+void HalTimerIntPrioritySet(uint32_t ui32Timer, uint32_t ui32Priority)
+{
+    // handlers never nest here, see hal_sim.h
+}
+
+void HalTimerIntClear(uint32_t ui32Timer)
+{
+}
+
+void HalTimerEnable(uint32_t ui32Timer)
+{
+    tHalSimTimer *psTimer = &g_psHalSimTimers[ui32Timer];
+
+    if(g_bHalSimVirtual)
+    {
+        pthread_mutex_lock(&g_sHalSimStepLock);
+        if(!psTimer->bEnabled)
+        {
+            psTimer->ui64Next = g_ui64HalSimVirtualNs + psTimer->ui64PeriodNs;
+            psTimer->bEnabled = true;
+            pthread_cond_broadcast(&g_sHalSimStepCond);
+        }
+        pthread_mutex_unlock(&g_sHalSimStepLock);
+        return;
+    }
+
+    if(psTimer->bEnabled)
+    {
+        return;
+    }
+    if(psTimer->bThread)
+    {
+        pthread_join(psTimer->sThread, NULL);
+    }
+
+    //
+    // Timers do not run in stepped time.
+    //
+    psTimer->bEnabled = true;
+    psTimer->bThread = !g_bHalSimStepped &&
+                       (pthread_create(&psTimer->sThread, NULL,
+                                       HalSimTimerThread, psTimer) == 0);
+}
+
+void HalTimerDisable(uint32_t ui32Timer)
+{
+    pthread_mutex_lock(&g_sHalSimStepLock);
+    g_psHalSimTimers[ui32Timer].bEnabled = false;
+    pthread_mutex_unlock(&g_sHalSimStepLock);
+}
+
+//*****************************************************************************
+//
+// The PWM generator only triggers the ADC, it runs as one more timer.
+//
+//*****************************************************************************
+void HalADCPWMTriggerInit(uint32_t ui32Hz)
+{
+    tHalSimTimer *psPWM = &g_psHalSimTimers[HAL_SIM_PWM];
+
+    // the load value is rounded to whole PWM clock cycles, the system
+    // clock / 8
+    psPWM->ui64PeriodNs = ((uint64_t)((HAL_SYS_CLOCK_HZ / 8) / ui32Hz) *
+                           1000000000ULL) / (HAL_SYS_CLOCK_HZ / 8);
+    psPWM->ui32ADCTrigger = HAL_ADC_TRIGGER_PWM;
+    HalTimerEnable(HAL_SIM_PWM);
+}
+
+void HalSimSysTickStart(uint32_t ui32Hz, void (*pfnHandler)(void))
+{
+    g_psHalSimTimers[HAL_SIM_SYSTICK].ui64PeriodNs = 1000000000ULL / ui32Hz;
+    g_psHalSimTimers[HAL_SIM_SYSTICK].pfnHandler = pfnHandler;
+    HalTimerEnable(HAL_SIM_SYSTICK);
+}
+
+void HalSimSysTickStop(void)
+{
+    HalTimerDisable(HAL_SIM_SYSTICK);
+}
+
+//*****************************************************************************
+//
+// Edge capture.
+//
+//*****************************************************************************
+static double HalSimCaptureStill(uint32_t ui32Input, uint64_t ui64TimeNs)
+{
+    return 0.0;
+}
+
+void HalSimCaptureSourceSet(tHalSimCaptureSource pfnSource)
+{
+    g_pfnHalSimCaptureSource = pfnSource;
+}
+
+void HalCaptureInit(uint32_t ui32Input)
+{
+    tHalSimCapture *psCapture = &g_psHalSimCaptures[ui32Input];
+
+    pthread_mutex_lock(&g_sHalSimCaptureLock);
+    psCapture->ui64Last = HalSimTimeNs();
+    psCapture->dEdges = 0.0;
+    psCapture->ui64EdgeNs = psCapture->ui64Last;
+    pthread_mutex_unlock(&g_sHalSimCaptureLock);
+}
+
+//*****************************************************************************
+//
+// Counts the edges since the last read at the mean of the rates at both
+// ends. The last edge is where the count passed its last whole number.
+//
+//*****************************************************************************
+void HalCaptureRead(uint32_t ui32Input, uint32_t *pui32Edges,
+                    uint32_t *pui32Time)
+{
+    tHalSimCapture *psCapture = &g_psHalSimCaptures[ui32Input];
+    uint64_t ui64Now;
+    double dRate, dEdges;
+
+    pthread_mutex_lock(&g_sHalSimCaptureLock);
+
+    ui64Now = HalSimTimeNs();
+    if(ui64Now > psCapture->ui64Last)
+    {
+        dRate = (g_pfnHalSimCaptureSource(ui32Input, psCapture->ui64Last) +
+                 g_pfnHalSimCaptureSource(ui32Input, ui64Now)) / 2.0;
+        dEdges = psCapture->dEdges +
+                 ((dRate * (double)(ui64Now - psCapture->ui64Last)) / 1e9);
+        if((uint64_t)dEdges > (uint64_t)psCapture->dEdges)
+        {
+            psCapture->ui64EdgeNs = ui64Now -
+                (uint64_t)(((dEdges - (double)(uint64_t)dEdges) / dRate) *
+                           1e9);
+        }
+        psCapture->dEdges = dEdges;
+        psCapture->ui64Last = ui64Now;
+    }
+
+    *pui32Edges = (uint32_t)(uint64_t)psCapture->dEdges;
+    *pui32Time = (uint32_t)((psCapture->ui64EdgeNs * 2) / 25);
+
+    pthread_mutex_unlock(&g_sHalSimCaptureLock);
+}
+
+//*****************************************************************************
+//
+// I2C masters.
+//
+//*****************************************************************************
+void HalSimI2CDeviceSet(uint32_t ui32Port, uint8_t ui8Addr,
+                        tHalSimI2CDevice pfnDevice)
+{
+    tHalSimI2CSlave *psSlaves = g_ppsHalSimI2C[ui32Port];
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < HAL_SIM_I2C_MAX_DEVICES; ui32Idx++)
+    {
+        if(!psSlaves[ui32Idx].pfnDevice ||
+           (psSlaves[ui32Idx].ui8Addr == ui8Addr))
+        {
+            psSlaves[ui32Idx].ui8Addr = ui8Addr;
+            psSlaves[ui32Idx].pfnDevice = pfnDevice;
+            return;
+        }
+    }
+}
+
+void HalSimI2CFaultSet(tHalSimI2CFault pfnFault)
+{
+    g_pfnHalSimI2CFault = pfnFault;
+}
+
+void HalI2CMasterInit(uint32_t ui32Port, bool bFast)
+{
+    g_pui32HalSimI2CRate[ui32Port] = bFast ? 400000 : 100000;
+}
+
+uint32_t HalI2CMasterWrite(uint32_t ui32Port, uint8_t ui8Addr,
+                           const uint8_t *pui8Data, uint32_t ui32Count)
+{
+    tHalSimI2CSlave *psSlaves = g_ppsHalSimI2C[ui32Port], *psSlave = NULL;
+    uint64_t ui64Start = HalSimTimeNs();
+    uint32_t ui32Idx, ui32Bytes = 1, ui32Result = HAL_I2C_ERR_ADDR_NACK;
+    uint32_t ui32Fault = HAL_I2C_OK;
+
+    if(g_pfnHalSimI2CFault)
+    {
+        ui32Fault = g_pfnHalSimI2CFault(ui32Port, ui8Addr, ui64Start);
+    }
+
+    //
+    // A bus held low keeps the master busy until it gives up.
+    //
+    if(ui32Fault == HAL_I2C_ERR_TIMEOUT)
+    {
+        HalSimSleepUntil(ui64Start + (HAL_I2C_TIMEOUT_US * 1000ULL));
+        return HAL_I2C_ERR_TIMEOUT;
+    }
+
+    for(ui32Idx = 0; (ui32Fault == HAL_I2C_OK) &&
+        (ui32Idx < HAL_SIM_I2C_MAX_DEVICES); ui32Idx++)
+    {
+        if(psSlaves[ui32Idx].pfnDevice &&
+           (psSlaves[ui32Idx].ui8Addr == ui8Addr))
+        {
+            psSlave = &psSlaves[ui32Idx];
+            ui32Bytes += ui32Count;
+            break;
+        }
+    }
+
+    //
+    // 9 bits per byte after the start condition, the device takes the data
+    // at its last acknowledge, then the stop condition.
+    //
+    HalSimSleepUntil(ui64Start + ((((ui32Bytes * 9) + 1) * 1000000000ULL) /
+                                  g_pui32HalSimI2CRate[ui32Port]));
+    if(psSlave)
+    {
+        ui32Result = psSlave->pfnDevice(ui8Addr, pui8Data, ui32Count);
+    }
+    HalSimSleepUntil(ui64Start + ((((ui32Bytes * 9) + 2) * 1000000000ULL) /
+                                  g_pui32HalSimI2CRate[ui32Port]));
+
+    return ui32Result;
+}
+
+//*****************************************************************************
+//
+// UART.
+//
+//*****************************************************************************
+void HalSimUARTFdSet(uint32_t ui32Port, int iIn, int iOut)
+{
+    g_piHalSimUARTIn[ui32Port] = iIn;
+    g_piHalSimUARTOut[ui32Port] = iOut;
+}
+
+void HalUARTInit(uint32_t ui32Port, uint32_t ui32Baud)
+{
+    g_pui32HalSimUARTBaud[ui32Port] = ui32Baud;
+}
+
+void HalUARTBaudSet(uint32_t ui32Port, uint32_t ui32Baud)
+{
+    HalSimSleepUntil(g_pui64HalSimUARTIdle[ui32Port]);
+    g_pui32HalSimUARTBaud[ui32Port] = ui32Baud;
+}
+
+//*****************************************************************************
+//
+// Writes the bytes at the pace of the line, 10 bits per byte at the baud
+// rate. Like UARTCharPut() the call returns once the last bytes fit into the
+// transmit FIFO.
+//
+//*****************************************************************************
+void HalUARTWrite(uint32_t ui32Port, const uint8_t *pui8Data,
+                  uint32_t ui32Count)
+{
+    uint64_t ui64ByteNs = 10000000000ULL / g_pui32HalSimUARTBaud[ui32Port];
+    uint64_t ui64Now = HalSimTimeNs(), ui64Idle;
+    ssize_t iLen;
+
+    pthread_mutex_lock(&g_sHalSimUARTLock);
+    ui64Idle = g_pui64HalSimUARTIdle[ui32Port];
+    if(ui64Idle < ui64Now)
+    {
+        ui64Idle = ui64Now;
+    }
+    ui64Idle += ui32Count * ui64ByteNs;
+    g_pui64HalSimUARTIdle[ui32Port] = ui64Idle;
+    pthread_mutex_unlock(&g_sHalSimUARTLock);
+
+    while(ui32Count)
+    {
+        iLen = write(g_piHalSimUARTOut[ui32Port], pui8Data, ui32Count);
+        if(iLen < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        pui8Data += iLen;
+        ui32Count -= (uint32_t)iLen;
+    }
+
+    if(ui64Idle > (ui64Now + (HAL_SIM_UART_FIFO * ui64ByteNs)))
+    {
+        HalSimSleepUntil(ui64Idle - (HAL_SIM_UART_FIFO * ui64ByteNs));
+    }
+}
+
+int32_t HalUARTCharGetNonBlocking(uint32_t ui32Port)
+{
+    struct pollfd sPoll;
+    uint8_t ui8Char;
+
+    sPoll.fd = g_piHalSimUARTIn[ui32Port];
+    sPoll.events = POLLIN;
+    if((poll(&sPoll, 1, 0) != 1) || !(sPoll.revents & POLLIN) ||
+       (read(sPoll.fd, &ui8Char, 1) != 1))
+    {
+        return -1;
+    }
+
+    return ui8Char;
+}
+
+//*****************************************************************************
+//
+// GPIO.
+//
+//*****************************************************************************
+void HalSimGPIOInputSet(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Value)
+{
+    g_pui8HalSimGPIOIn[ui32Port] = (g_pui8HalSimGPIOIn[ui32Port] & ~ui8Pins) |
+                                   (ui8Value & ui8Pins);
+}
+
+uint8_t HalSimGPIOOutputGet(uint32_t ui32Port)
+{
+    return g_pui8HalSimGPIOOut[ui32Port];
+}
+
+void HalGPIOOutputInit(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void HalGPIOInputInit(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void HalGPIOWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Value)
+{
+    g_pui8HalSimGPIOOut[ui32Port] = (g_pui8HalSimGPIOOut[ui32Port] &
+                                     ~ui8Pins) | (ui8Value & ui8Pins);
+}
+
+uint8_t HalGPIORead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return (g_pui8HalSimGPIOIn[ui32Port] | g_pui8HalSimGPIOOut[ui32Port]) &
+           ui8Pins;
+}
+
+//*****************************************************************************
+//
+// EEPROM.
+//
+//*****************************************************************************
+int32_t HalSimEEPROMFileSet(const char *pcPath)
+{
+    g_psHalSimEEPROMFile = fopen(pcPath, "r+b");
+    if(g_psHalSimEEPROMFile)
+    {
+        if(fread(g_pui32HalSimEEPROM, 1, sizeof(g_pui32HalSimEEPROM),
+                 g_psHalSimEEPROMFile) != sizeof(g_pui32HalSimEEPROM))
+        {
+            memset(g_pui32HalSimEEPROM, 0xFF, sizeof(g_pui32HalSimEEPROM));
+        }
+        return 0;
+    }
+
+    g_psHalSimEEPROMFile = fopen(pcPath, "w+b");
+
+    return g_psHalSimEEPROMFile ? 0 : -1;
+}
+
+bool HalEEPROMInit(void)
+{
+    return true;
+}
+
+void HalEEPROMRead(uint32_t *pui32Data, uint32_t ui32Addr, uint32_t ui32Count)
+{
+    memcpy(pui32Data, &g_pui32HalSimEEPROM[ui32Addr / 4], ui32Count);
+}
+
+uint32_t HalEEPROMProgram(uint32_t *pui32Data, uint32_t ui32Addr,
+                          uint32_t ui32Count)
+{
+    if((ui32Addr + ui32Count) > HAL_EEPROM_SIZE)
+    {
+        return 1;
+    }
+
+    memcpy(&g_pui32HalSimEEPROM[ui32Addr / 4], pui32Data, ui32Count);
+
+    if(g_psHalSimEEPROMFile)
+    {
+        rewind(g_psHalSimEEPROMFile);
+        fwrite(g_pui32HalSimEEPROM, 1, sizeof(g_pui32HalSimEEPROM),
+               g_psHalSimEEPROMFile);
+        fflush(g_psHalSimEEPROMFile);
+    }
+
+    return 0;
+}
+
+void HalEEPROMProgramWord(uint32_t ui32Data, uint32_t ui32Addr)
+{
+    HalEEPROMProgram(&ui32Data, ui32Addr, 4);
+}
+
+bool HalEEPROMBusy(void)
+{
+    return false;
+}
@@ -0,0 +1,166 @@
+//*****************************************************************************
+//
+// hal_sim.h - Controls of the simulated peripherals of hal_sim.c.
+//
+// The simulation runs the firmware on host threads. Interrupt handlers run
+// on the thread of the peripheral that raised them, with the simulated
+// interrupt lock held: one handler at a time, and never while a task masks
+// interrupts. The FreeRTOS stand-in of sim_rtos.c uses the same lock for its
+// own critical sections, as the Cortex-M4 port does with BASEPRI.
+//
+// Time is the host monotonic clock from the start of the process. The DWT
+// cycle counter of TimestampGet() counts 80MHz cycles of it.
+//
+// HalSimTimeSet() switches to stepped time, for running recorded input
+// faster than real time: the clock jumps to the given time, never back, and
+// runs on with the host clock until the next step, so cycle counts taken
+// around code stay meaningful. Timers started in stepped time do not run.
+//
+// HalSimVirtualTimeEnable() switches to virtual time, for checking timing
+// exactly and running long stretches quickly. The clock starts at 0 and
+// only moves while the simulated CPU waits: in HalSimSleepUntil(), in the
+// bus time of a peripheral, in HalBusyWait() or when no task is
+// ready. Code takes no time. The clock then jumps to the next timer timeout
+// or the end of the wait, whichever is first, and runs the timer interrupt
+// on its own thread, so a run gives the same times every time. Timeouts due
+// at the same time go in timer order, the kernel tick last, and before a
+// wait ending then. A wait with interrupts held off cannot be interrupted
+// and moves the clock on directly. Only the firmware, main() and the tasks
+// may wait in virtual time, other host threads must not.
+//
+//*****************************************************************************
+
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Time.
+//
+//*****************************************************************************
+uint64_t HalSimTimeNs(void);
+void HalSimSleepUntil(uint64_t ui64Ns);
+void HalSimTimeSet(uint64_t ui64Ns);
+void HalSimVirtualTimeEnable(void);
+uint32_t HalCycleCount(void);
+
+//*****************************************************************************
+//
+// The kernel of sim_rtos.c: the tick is a timer of the simulation after the
+// timers of hal.h, and every change of the running task is reported, with
+// bIdle set when no task is ready.
+//
+//*****************************************************************************
+void HalSimSysTickStart(uint32_t ui32Hz, void (*pfnHandler)(void));
+void HalSimSysTickStop(void);
+void HalSimCPUSwitch(bool bIdle);
+
+//*****************************************************************************
+//
+// Interrupts. HalSimInterrupt() runs a handler as an interrupt of the
+// calling thread. HalSimIntLock() nests per thread, HalSimIntWait() waits on
+// a condition with the lock released and must be called with it held.
+//
+// Task threads are preemptible: the scheduler stops them with
+// HAL_SIM_PREEMPT_SIGNAL. The signal is blocked while a thread holds the
+// interrupt lock, so a task is never stopped inside a critical section, and
+// in all other threads.
+//
+//*****************************************************************************
+#define HAL_SIM_PREEMPT_SIGNAL          SIGUSR1
+
+void HalSimInterrupt(void (*pfnHandler)(void));
+void HalSimIntLock(void);
+void HalSimIntUnlock(void);
+void HalSimIntWait(pthread_cond_t *psCond);
+bool HalSimInInterrupt(void);
+void HalSimThreadPreemptible(void);
+
+//*****************************************************************************
+//
+// ADC inputs. The source returns the 12-bit reading of channel AINn at the
+// given time, by default all channels read mid scale. HalSimADCInject()
+// completes a conversion of the sequence with recorded samples, one per
+// step, and raises its interrupt from the calling thread.
+//
+//*****************************************************************************
+typedef uint32_t (*tHalSimADCSource)(uint32_t ui32Ch, uint64_t ui64TimeNs);
+
+void HalSimADCSourceSet(tHalSimADCSource pfnSource);
+void HalSimADCInject(uint32_t ui32Seq, const uint16_t *pui16Samples);
+
+//*****************************************************************************
+//
+// Edge capture inputs. The source returns the edge rate of input n in Hz at
+// the given time, by default every input stands still. The edges of a read
+// are those of the mean rate since the read before.
+//
+//*****************************************************************************
+typedef double (*tHalSimCaptureSource)(uint32_t ui32Input, uint64_t ui64TimeNs);
+
+void HalSimCaptureSourceSet(tHalSimCaptureSource pfnSource);
+
+//*****************************************************************************
+//
+// Faults. The ADC fault sees the steps of every conversion of a sequence,
+// converted or injected, before the firmware does. It may change them, or
+// return false to lose the conversion as a FIFO overflow does. The I2C fault
+// is asked at the start of every write: HAL_I2C_OK leaves the bus alone,
+// HAL_I2C_ERR_ADDR_NACK makes the address go unanswered and
+// HAL_I2C_ERR_TIMEOUT holds the bus low until the master gives up. Both run
+// with the interrupt lock held or on the writing task, keep them short.
+//
+//*****************************************************************************
+typedef bool (*tHalSimADCFault)(uint32_t ui32Seq, uint32_t *pui32Steps,
+                                uint32_t ui32Steps, uint64_t ui64TimeNs);
+typedef uint32_t (*tHalSimI2CFault)(uint32_t ui32Port, uint8_t ui8Addr,
+                                    uint64_t ui64TimeNs);
+
+void HalSimADCFaultSet(tHalSimADCFault pfnFault);
+void HalSimI2CFaultSet(tHalSimI2CFault pfnFault);
+
+//*****************************************************************************
+//
+// I2C devices. A device receives the bytes written to its address and
+// returns HAL_I2C_OK to acknowledge them. Addresses without a device do not
+// acknowledge. A write takes the time of its bits on the bus.
+//
+//*****************************************************************************
+#define HAL_SIM_I2C_MAX_DEVICES         4
+
+typedef uint32_t (*tHalSimI2CDevice)(uint8_t ui8Addr, const uint8_t *pui8Data,
+                                     uint32_t ui32Count);
+
+void HalSimI2CDeviceSet(uint32_t ui32Port, uint8_t ui8Addr,
+                        tHalSimI2CDevice pfnDevice);
+
+//*****************************************************************************
+//
+// UART0 reads stdin and writes stdout unless given other file descriptors.
+// Writes take the time of their bits at the baud rate.
+//
+//*****************************************************************************
+void HalSimUARTFdSet(uint32_t ui32Port, int iIn, int iOut);
+
+//*****************************************************************************
+//
+// GPIO pins driven from outside, and the outputs driven by the firmware.
+//
+//*****************************************************************************
+void HalSimGPIOInputSet(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Value);
+uint8_t HalSimGPIOOutputGet(uint32_t ui32Port);
+
+//*****************************************************************************
+//
+// The EEPROM starts erased. With a file it keeps its contents from run to
+// run, the file is written after every program.
+//
+//*****************************************************************************
+int32_t HalSimEEPROMFileSet(const char *pcPath);
+
+#endif
@@ -0,0 +1,309 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Virtual HD44780 LCD with PCF8574 I2C backpack for the Linux simulation
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "hal.h"
+#include "hal_sim.h"
+#include "lcd_i2c.h"
+#include "lcd_sim.h"
+
+// PCF8574 outputs, the data nibble is on P4 to P7
+#define LCD_SIM_BACKLIGHT               0x08
+
+// display data RAM, the second line starts at 0x40
+#define LCD_SIM_DDRAM_LINE              0x40
+#define LCD_SIM_DDRAM_LINE_LEN          40
+
+// HD44780 timing in ns
+#define LCD_SIM_PULSE_MIN_NS            450
+#define LCD_SIM_CYCLE_MIN_NS            1000
+#define LCD_SIM_POWER_ON_NS             40000000
+#define LCD_SIM_RESET1_NS               4100000
+#define LCD_SIM_RESET2_NS               100000
+#define LCD_SIM_HOME_NS                 1520000
+#define LCD_SIM_EXEC_NS                 37000
+
+static uint8_t g_ui8LCDSimPins = 0;
+static bool g_b4Bit = false;
+static bool g_bHighNibble = true;
+static uint8_t g_ui8LCDSimLatch = 0;
+static uint8_t g_ui8LCDSimAddr = 0;
+static bool g_bLCDSimCGRAM = false;
+static bool g_bLCDSimDecrement = false;
+static bool g_bLCDSimDisplayOn = false;
+static int32_t g_i32LCDSimShift = 0;
+static char g_ppcLCDSimDDRAM[LCD_SIM_ROWS][LCD_SIM_DDRAM_LINE_LEN];
+static volatile uint32_t g_ui32LCDSimVersion = 0;
+static uint32_t g_ui32LCDSimResets = 0;
+static uint64_t g_ui64LCDSimRise = 0;
+static uint64_t g_ui64LCDSimBusy = 0;
+static tLCDSimTiming g_sLCDSimTiming;
+
+//*****************************************************************************
+//
+// Checks the timing at the edges of EN. The busy time starts when the last
+// nibble of an instruction or character is taken.
+//
+//*****************************************************************************
+static void LCDSimEnableRise(uint64_t ui64Now)
+{
+    int64_t i64Slack = (int64_t)(ui64Now - g_ui64LCDSimBusy);
+
+    if(g_sLCDSimTiming.ui32Pulses &&
+       ((ui64Now - g_ui64LCDSimRise) < g_sLCDSimTiming.ui64MinCycleNs))
+    {
+        g_sLCDSimTiming.ui64MinCycleNs = ui64Now - g_ui64LCDSimRise;
+        if(g_sLCDSimTiming.ui64MinCycleNs < LCD_SIM_CYCLE_MIN_NS)
+        {
+            g_sLCDSimTiming.ui32Violations++;
+        }
+    }
+
+    if(i64Slack < g_sLCDSimTiming.i64MinSlackNs)
+    {
+        g_sLCDSimTiming.i64MinSlackNs = i64Slack;
+    }
+    if(i64Slack < 0)
+    {
+        g_sLCDSimTiming.ui32Violations++;
+    }
+
+    g_ui64LCDSimRise = ui64Now;
+}
+
+static void LCDSimEnableFall(uint64_t ui64Now)
+{
+    g_sLCDSimTiming.ui32Pulses++;
+    if((ui64Now - g_ui64LCDSimRise) < g_sLCDSimTiming.ui64MinPulseNs)
+    {
+        g_sLCDSimTiming.ui64MinPulseNs = ui64Now - g_ui64LCDSimRise;
+        if(g_sLCDSimTiming.ui64MinPulseNs < LCD_SIM_PULSE_MIN_NS)
+        {
+            g_sLCDSimTiming.ui32Violations++;
+        }
+    }
+}
+
+static void LCDSimBusySet(uint64_t ui64Now, uint8_t ui8Value, bool bData)
+{
+    uint64_t ui64Exec = LCD_SIM_EXEC_NS;
+
+    if(!bData && !g_b4Bit && (g_ui32LCDSimResets < 2))
+    {
+        ui64Exec = g_ui32LCDSimResets++ ? LCD_SIM_RESET2_NS :
+                                          LCD_SIM_RESET1_NS;
+    }
+    else if(!bData && !(ui8Value & 0xFC))
+    {
+        ui64Exec = LCD_SIM_HOME_NS;
+    }
+
+    g_ui64LCDSimBusy = ui64Now + ui64Exec;
+}
+
+//*****************************************************************************
+//
+// Moves the address counter by one within the 40 character line.
+//
+//*****************************************************************************
+static void LCDSimAddrStep(void)
+{
+    uint32_t ui32Line = g_ui8LCDSimAddr & LCD_SIM_DDRAM_LINE;
+    int32_t i32Col = g_ui8LCDSimAddr & ~LCD_SIM_DDRAM_LINE;
+
+    i32Col += g_bLCDSimDecrement ? -1 : 1;
+    if(i32Col < 0)
+    {
+        i32Col = LCD_SIM_DDRAM_LINE_LEN - 1;
+        ui32Line ^= LCD_SIM_DDRAM_LINE;
+    }
+    else if(i32Col >= LCD_SIM_DDRAM_LINE_LEN)
+    {
+        i32Col = 0;
+        ui32Line ^= LCD_SIM_DDRAM_LINE;
+    }
+
+    g_ui8LCDSimAddr = (uint8_t)(ui32Line | (uint32_t)i32Col);
+}
+
+static void LCDSimInstruction(uint8_t ui8Cmd)
+{
+    if(ui8Cmd & LCD_SETDDRAMADDR)
+    {
+        g_ui8LCDSimAddr = ui8Cmd & 0x7F;
+        g_bLCDSimCGRAM = false;
+    }
+    else if(ui8Cmd & LCD_SETCGRAMADDR)
+    {
+        g_bLCDSimCGRAM = true;
+    }
+    else if(ui8Cmd & LCD_FUNCTIONSET)
+    {
+        g_b4Bit = !(ui8Cmd & LCD_8BITMODE);
+    }
+    else if(ui8Cmd & LCD_CURSORSHIFT)
+    {
+        if(ui8Cmd & LCD_DISPLAYMOVE)
+        {
+            g_i32LCDSimShift += (ui8Cmd & LCD_MOVERIGHT) ? -1 : 1;
+        }
+    }
+    else if(ui8Cmd & LCD_DISPLAYCONTROL)
+    {
+        g_bLCDSimDisplayOn = (ui8Cmd & LCD_DISPLAYON) != 0;
+    }
+    else if(ui8Cmd & LCD_ENTRYMODESET)
+    {
+        g_bLCDSimDecrement = !(ui8Cmd & LCD_ENTRYLEFT);
+    }
+    else if(ui8Cmd & LCD_RETURNHOME)
+    {
+        g_ui8LCDSimAddr = 0;
+        g_i32LCDSimShift = 0;
+    }
+    else if(ui8Cmd & LCD_CLEARDISPLAY)
+    {
+        memset(g_ppcLCDSimDDRAM, ' ', sizeof(g_ppcLCDSimDDRAM));
+        g_ui8LCDSimAddr = 0;
+        g_i32LCDSimShift = 0;
+        g_bLCDSimDecrement = false;
+    }
+}
+
+static void LCDSimData(uint8_t ui8Data)
+{
+    if(!g_bLCDSimCGRAM)
+    {
+        g_ppcLCDSimDDRAM[(g_ui8LCDSimAddr & LCD_SIM_DDRAM_LINE) ? 1 : 0]
+                        [(g_ui8LCDSimAddr & ~LCD_SIM_DDRAM_LINE) %
+                         LCD_SIM_DDRAM_LINE_LEN] = (char)ui8Data;
+        LCDSimAddrStep();
+    }
+}
+
+//*****************************************************************************
+//
+// Called with every byte written to the backpack.
+//
+//*****************************************************************************
+static uint32_t LCDSimI2CWrite(uint8_t ui8Addr, const uint8_t *pui8Data,
+                               uint32_t ui32Count)
+{
+    uint64_t ui64Now = HalSimTimeNs();
+    uint8_t ui8Pins, ui8Value;
+
+    while(ui32Count--)
+    {
+        ui8Pins = *pui8Data++;
+
+        if(!(g_ui8LCDSimPins & En) && (ui8Pins & En))
+        {
+            LCDSimEnableRise(ui64Now);
+        }
+
+        if((g_ui8LCDSimPins & En) && !(ui8Pins & En) && !(ui8Pins & Rw))
+        {
+            LCDSimEnableFall(ui64Now);
+
+            if(!g_b4Bit)
+            {
+                ui8Value = g_ui8LCDSimPins & 0xF0;
+            }
+            else if(g_bHighNibble)
+            {
+                g_ui8LCDSimLatch = g_ui8LCDSimPins & 0xF0;
+                g_bHighNibble = false;
+                g_ui8LCDSimPins = ui8Pins;
+                continue;
+            }
+            else
+            {
+                ui8Value = g_ui8LCDSimLatch | (g_ui8LCDSimPins >> 4);
+                g_bHighNibble = true;
+            }
+
+            LCDSimBusySet(ui64Now, ui8Value, (g_ui8LCDSimPins & Rs) != 0);
+            if(g_ui8LCDSimPins & Rs)
+            {
+                LCDSimData(ui8Value);
+            }
+            else
+            {
+                LCDSimInstruction(ui8Value);
+                if(!g_b4Bit)
+                {
+                    g_bHighNibble = true;
+                }
+            }
+            g_ui32LCDSimVersion++;
+        }
+
+        if((ui8Pins ^ g_ui8LCDSimPins) & LCD_SIM_BACKLIGHT)
+        {
+            g_ui32LCDSimVersion++;
+        }
+        g_ui8LCDSimPins = ui8Pins;
+    }
+
+    return HAL_I2C_OK;
+}
+
+void LCDSimAttach(uint32_t ui32Port, uint8_t ui8Addr)
+{
+    memset(g_ppcLCDSimDDRAM, ' ', sizeof(g_ppcLCDSimDDRAM));
+    memset(&g_sLCDSimTiming, 0, sizeof(g_sLCDSimTiming));
+    g_sLCDSimTiming.ui64MinPulseNs = UINT64_MAX;
+    g_sLCDSimTiming.ui64MinCycleNs = UINT64_MAX;
+    g_sLCDSimTiming.i64MinSlackNs = INT64_MAX;
+    g_ui64LCDSimBusy = HalSimTimeNs() + LCD_SIM_POWER_ON_NS;
+    HalSimI2CDeviceSet(ui32Port, ui8Addr, LCDSimI2CWrite);
+}
+
+//*****************************************************************************
+//
+// Copies the visible text, blank while the display is off, and returns a
+// counter that changes with every instruction, character and backlight
+// change.
+//
+//*****************************************************************************
+uint32_t LCDSimRead(char ppcText[LCD_SIM_ROWS][LCD_SIM_COLS + 1])
+{
+    uint32_t ui32Row, ui32Col;
+    int32_t i32Pos;
+
+    for(ui32Row = 0; ui32Row < LCD_SIM_ROWS; ui32Row++)
+    {
+        for(ui32Col = 0; ui32Col < LCD_SIM_COLS; ui32Col++)
+        {
+            i32Pos = ((int32_t)ui32Col + g_i32LCDSimShift) %
+                     LCD_SIM_DDRAM_LINE_LEN;
+            if(i32Pos < 0)
+            {
+                i32Pos += LCD_SIM_DDRAM_LINE_LEN;
+            }
+            ppcText[ui32Row][ui32Col] = g_bLCDSimDisplayOn ?
+                                        g_ppcLCDSimDDRAM[ui32Row][i32Pos] : ' ';
+            if((ppcText[ui32Row][ui32Col] < ' ') ||
+               (ppcText[ui32Row][ui32Col] > '~'))
+            {
+                ppcText[ui32Row][ui32Col] = '?';
+            }
+        }
+        ppcText[ui32Row][LCD_SIM_COLS] = 0;
+    }
+
+    return g_ui32LCDSimVersion;
+}
+
+void LCDSimTimingGet(tLCDSimTiming *psTiming)
+{
+    *psTiming = g_sLCDSimTiming;
+}
+
+bool LCDSimBacklight(void)
+{
+    return (g_ui8LCDSimPins & LCD_SIM_BACKLIGHT) != 0;
+}
@@ -0,0 +1,44 @@
+//*****************************************************************************
+//
+// lcd_sim.h - Virtual 16x2 character LCD on the simulated I2C bus.
+//
+// An HD44780 controller behind a PCF8574 I2C backpack, the module lcd_i2c.c
+// drives. Every byte written to the backpack sets its eight outputs: RS, RW,
+// EN, the backlight and the four data lines. The controller takes a nibble
+// on the falling edge of EN, starts in 8-bit mode and follows the
+// instructions into 4-bit mode as the real one does.
+//
+// The timing of the HD44780 data sheet is checked on every edge of EN, in
+// simulated time. A violation is an enable pulse shorter than 450ns, enable
+// pulses starting less than 1000ns apart, or a pulse starting while the
+// controller is busy: 40ms after power on, 4.1ms and 100us after the first
+// two function sets of the reset sequence, 1.52ms after clear display and
+// return home and 37us after any other instruction or character.
+//
+//*****************************************************************************
+
+#ifndef LCD_SIM_H
+#define LCD_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LCD_SIM_COLS                    16
+#define LCD_SIM_ROWS                    2
+
+typedef struct
+{
+    uint32_t ui32Pulses;
+    uint32_t ui32Violations;
+    uint64_t ui64MinPulseNs;                // shortest enable pulse
+    uint64_t ui64MinCycleNs;                // shortest start to start
+    int64_t i64MinSlackNs;                  // least time left after busy
+}
+tLCDSimTiming;
+
+void LCDSimAttach(uint32_t ui32Port, uint8_t ui8Addr);
+void LCDSimTimingGet(tLCDSimTiming *psTiming);
+uint32_t LCDSimRead(char ppcText[LCD_SIM_ROWS][LCD_SIM_COLS + 1]);
+bool LCDSimBacklight(void);
+
+#endif
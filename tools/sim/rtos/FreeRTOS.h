@@ -0,0 +1,67 @@
+//*****************************************************************************
+//
+// FreeRTOS.h - Stand-in for the FreeRTOS kernel headers in the Linux
+// simulation.
+//
+// The firmware is written against the FreeRTOS V9 API. The simulation build
+// puts this directory ahead of the kernel include path, the calls are served
+// by tools/sim/sim_rtos.c, a small fixed priority preemptive scheduler with
+// one host thread per task. Only the part of the API used by the firmware is
+// provided, with the types and constants of the Cortex-M4 port.
+//
+//*****************************************************************************
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portCHAR                        char
+#define portBASE_TYPE                   long
+#define portTickType                    TickType_t
+
+#define portMAX_DELAY                   ((TickType_t)0xFFFFFFFFUL)
+
+#define pdFALSE                         ((BaseType_t)0)
+#define pdTRUE                          ((BaseType_t)1)
+#define pdPASS                          (pdTRUE)
+#define pdFAIL                          (pdFALSE)
+#define errQUEUE_EMPTY                  ((BaseType_t)0)
+#define errQUEUE_FULL                   ((BaseType_t)0)
+
+#include "FreeRTOSConfig.h"
+
+#define portTICK_PERIOD_MS              ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs)                                              \
+    ((TickType_t)(((TickType_t)(xTimeInMs) *                                  \
+                   (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+
+//*****************************************************************************
+//
+// Critical sections take the simulated interrupt lock, the same lock the
+// interrupt handlers of hal_sim.c run under.
+//
+//*****************************************************************************
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+void vPortYieldFromISR(void);
+
+#define portYIELD_FROM_ISR(x)                                                 \
+    do                                                                        \
+    {                                                                         \
+        if(x)                                                                 \
+        {                                                                     \
+            vPortYieldFromISR();                                              \
+        }                                                                     \
+    }                                                                         \
+    while(0)
+
+void *pvPortMalloc(size_t xSize);
+void vPortFree(void *pv);
+
+#endif
@@ -0,0 +1,86 @@
+//*****************************************************************************
+//
+// queue.h - Queue API of the simulated FreeRTOS kernel, see FreeRTOS.h.
+//
+//*****************************************************************************
+
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#ifndef INC_FREERTOS_H
+#error "include FreeRTOS.h must appear in source files before include queue.h"
+#endif
+
+typedef void *QueueHandle_t;
+
+#define xQueueHandle                    QueueHandle_t
+
+#define queueSEND_TO_BACK               ((BaseType_t)0)
+#define queueSEND_TO_FRONT              ((BaseType_t)1)
+#define queueOVERWRITE                  ((BaseType_t)2)
+
+#define queueQUEUE_TYPE_BASE            ((uint8_t)0U)
+#define queueQUEUE_TYPE_MUTEX           ((uint8_t)1U)
+#define queueQUEUE_TYPE_COUNTING_SEMAPHORE ((uint8_t)2U)
+#define queueQUEUE_TYPE_BINARY_SEMAPHORE ((uint8_t)3U)
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength,
+                                  const UBaseType_t uxItemSize,
+                                  const uint8_t ucQueueType);
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType);
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t uxMaxCount,
+                                            const UBaseType_t uxInitialCount);
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue,
+                             const void * const pvItemToQueue,
+                             TickType_t xTicksToWait,
+                             const BaseType_t xCopyPosition);
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue,
+                                    const void * const pvItemToQueue,
+                                    BaseType_t * const pxHigherPriorityTaskWoken,
+                                    const BaseType_t xCopyPosition);
+BaseType_t xQueueGiveFromISR(QueueHandle_t xQueue,
+                             BaseType_t * const pxHigherPriorityTaskWoken);
+BaseType_t xQueueGenericReceive(QueueHandle_t xQueue, void * const pvBuffer,
+                                TickType_t xTicksToWait,
+                                const BaseType_t xJustPeek);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t xQueue, void * const pvBuffer,
+                                BaseType_t * const pxHigherPriorityTaskWoken);
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+UBaseType_t uxQueueMessagesWaitingFromISR(const QueueHandle_t xQueue);
+void vQueueDelete(QueueHandle_t xQueue);
+void vQueueSetQueueNumber(QueueHandle_t xQueue, UBaseType_t uxQueueNumber);
+
+#define xQueueCreate(uxQueueLength, uxItemSize)                               \
+    xQueueGenericCreate((uxQueueLength), (uxItemSize), queueQUEUE_TYPE_BASE)
+
+#define xQueueSend(xQueue, pvItemToQueue, xTicksToWait)                       \
+    xQueueGenericSend((xQueue), (pvItemToQueue), (xTicksToWait),              \
+                      queueSEND_TO_BACK)
+
+#define xQueueSendToBack(xQueue, pvItemToQueue, xTicksToWait)                 \
+    xQueueGenericSend((xQueue), (pvItemToQueue), (xTicksToWait),              \
+                      queueSEND_TO_BACK)
+
+#define xQueueSendToFront(xQueue, pvItemToQueue, xTicksToWait)                \
+    xQueueGenericSend((xQueue), (pvItemToQueue), (xTicksToWait),              \
+                      queueSEND_TO_FRONT)
+
+#define xQueueOverwrite(xQueue, pvItemToQueue)                                \
+    xQueueGenericSend((xQueue), (pvItemToQueue), 0, queueOVERWRITE)
+
+#define xQueueSendFromISR(xQueue, pvItemToQueue, pxHigherPriorityTaskWoken)   \
+    xQueueGenericSendFromISR((xQueue), (pvItemToQueue),                       \
+                             (pxHigherPriorityTaskWoken), queueSEND_TO_BACK)
+
+#define xQueueOverwriteFromISR(xQueue, pvItemToQueue,                         \
+                               pxHigherPriorityTaskWoken)                     \
+    xQueueGenericSendFromISR((xQueue), (pvItemToQueue),                       \
+                             (pxHigherPriorityTaskWoken), queueOVERWRITE)
+
+#define xQueueReceive(xQueue, pvBuffer, xTicksToWait)                         \
+    xQueueGenericReceive((xQueue), (pvBuffer), (xTicksToWait), pdFALSE)
+
+#define xQueuePeek(xQueue, pvBuffer, xTicksToWait)                            \
+    xQueueGenericReceive((xQueue), (pvBuffer), (xTicksToWait), pdTRUE)
+
+#endif
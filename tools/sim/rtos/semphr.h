@@ -0,0 +1,50 @@
+//*****************************************************************************
+//
+// semphr.h - Semaphore API of the simulated FreeRTOS kernel, semaphores and
+// mutexes are queues without item storage as in the real kernel.
+//
+//*****************************************************************************
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#ifndef INC_FREERTOS_H
+#error "include FreeRTOS.h must appear in source files before include semphr.h"
+#endif
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreHandle                SemaphoreHandle_t
+
+#define xSemaphoreCreateBinary()                                              \
+    xQueueGenericCreate(1, 0, queueQUEUE_TYPE_BINARY_SEMAPHORE)
+
+#define xSemaphoreCreateMutex()         xQueueCreateMutex(queueQUEUE_TYPE_MUTEX)
+
+#define xSemaphoreCreateCounting(uxMaxCount, uxInitialCount)                  \
+    xQueueCreateCountingSemaphore((uxMaxCount), (uxInitialCount))
+
+#define xSemaphoreTake(xSemaphore, xBlockTime)                                \
+    xQueueGenericReceive((QueueHandle_t)(xSemaphore), NULL, (xBlockTime),     \
+                         pdFALSE)
+
+#define xSemaphoreGive(xSemaphore)                                            \
+    xQueueGenericSend((QueueHandle_t)(xSemaphore), NULL, 0,                   \
+                      queueSEND_TO_BACK)
+
+#define xSemaphoreGiveFromISR(xSemaphore, pxHigherPriorityTaskWoken)          \
+    xQueueGiveFromISR((QueueHandle_t)(xSemaphore),                            \
+                      (pxHigherPriorityTaskWoken))
+
+#define xSemaphoreTakeFromISR(xSemaphore, pxHigherPriorityTaskWoken)          \
+    xQueueReceiveFromISR((QueueHandle_t)(xSemaphore), NULL,                   \
+                         (pxHigherPriorityTaskWoken))
+
+#define uxSemaphoreGetCount(xSemaphore)                                       \
+    uxQueueMessagesWaiting((QueueHandle_t)(xSemaphore))
+
+#define vSemaphoreDelete(xSemaphore)    vQueueDelete((QueueHandle_t)(xSemaphore))
+
+#endif
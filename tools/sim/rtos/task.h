@@ -0,0 +1,70 @@
+//*****************************************************************************
+//
+// task.h - Task API of the simulated FreeRTOS kernel, see FreeRTOS.h.
+//
+//*****************************************************************************
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#ifndef INC_FREERTOS_H
+#error "include FreeRTOS.h must appear in source files before include task.h"
+#endif
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define xTaskHandle                     TaskHandle_t
+
+#define tskIDLE_PRIORITY                ((UBaseType_t)0U)
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted
+}
+eTaskState;
+
+typedef struct xTASK_STATUS
+{
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    uint16_t usStackHighWaterMark;
+}
+TaskStatus_t;
+
+#define taskENTER_CRITICAL()            vPortEnterCritical()
+#define taskEXIT_CRITICAL()             vPortExitCritical()
+#define taskYIELD()                     vTaskYield()
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+                       const uint16_t usStackDepth, void * const pvParameters,
+                       UBaseType_t uxPriority,
+                       TaskHandle_t * const pxCreatedTask);
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+void vTaskDelay(const TickType_t xTicksToDelay);
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime,
+                     const TickType_t xTimeIncrement);
+void vTaskYield(void);
+TickType_t xTaskGetTickCount(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void vTaskStartScheduler(void);
+void vTaskEndScheduler(void);
+char *pcTaskGetName(TaskHandle_t xTaskToQuery);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * const pxTaskStatusArray,
+                                 const UBaseType_t uxArraySize,
+                                 uint32_t * const pulTotalRunTime);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+#endif
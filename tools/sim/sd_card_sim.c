@@ -0,0 +1,66 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// microSD card of the Linux simulation, stands in for sd_spi.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sd_spi.h"
+#include "storage_file.h"
+
+/******************************************************************************
+Description: the card is an image file of tools/sdlog/storage_file.c, opened
+with StorageFileOpen() before the scheduler starts; without one the mount
+fails as with no card in the slot. On the board the writing task blocks on a
+semaphore while the uDMA moves the blocks and the card programs them, here it
+blocks for the modelled card time, a fixed time per multi block write and a
+time per block, in whole ticks.
+******************************************************************************/
+
+#define SD_CARD_SIM_WRITE_US            800
+#define SD_CARD_SIM_BLOCK_US            120
+
+static int32_t SDCardSimInit(void)
+{
+    return g_sStorageFile.pfnInit();
+}
+
+static uint32_t SDCardSimBlockCount(void)
+{
+    return g_sStorageFile.pfnBlockCount();
+}
+
+static int32_t SDCardSimRead(uint32_t ui32Block, uint8_t *pui8Data,
+                             uint32_t ui32Count)
+{
+    return g_sStorageFile.pfnRead(ui32Block, pui8Data, ui32Count);
+}
+
+static int32_t SDCardSimWrite(uint32_t ui32Block, const uint8_t *pui8Data,
+                              uint32_t ui32Count)
+{
+    uint32_t ui32Us = SD_CARD_SIM_WRITE_US + (SD_CARD_SIM_BLOCK_US * ui32Count);
+
+    if(g_sStorageFile.pfnWrite(ui32Block, pui8Data, ui32Count) != 0)
+    {
+        return -1;
+    }
+
+    vTaskDelay((ui32Us + (1000 * portTICK_PERIOD_MS) - 1) /
+               (1000 * portTICK_PERIOD_MS));
+
+    return 0;
+}
+
+const tStorageDevice g_sSDCardStorage =
+{
+    SDCardSimInit,
+    SDCardSimBlockCount,
+    SDCardSimRead,
+    SDCardSimWrite
+};
+
+void SSI0IntHandler(void)
+{
+}
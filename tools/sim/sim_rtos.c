@@ -0,0 +1,911 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// FreeRTOS stand-in kernel of the Linux simulation
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "hal.h"
+#include "hal_sim.h"
+
+/******************************************************************************
+Description: a fixed priority preemptive scheduler with the semantics of the
+FreeRTOS kernel the firmware runs on. Every task is a host thread, but only
+one of them, pxCurrentTCB, is allowed to run at a time: the simulated CPU.
+The highest priority ready task runs, tasks of equal priority share the CPU
+round robin on every tick.
+
+A task gives up the CPU in a kernel call by waiting on its condition variable
+until it is current again. A task that is preempted from an interrupt handler,
+the tick or an ISR readying a higher priority task, is stopped by
+HAL_SIM_PREEMPT_SIGNAL and waits in the signal handler. The kernel data is
+guarded by the simulated interrupt lock, so the kernel, the critical sections
+of the tasks and the interrupt handlers exclude each other as they do on the
+Cortex-M4.
+
+Waiting on a queue or semaphore readies all its waiters whenever the object
+changes; they retry in priority order and the losers block again until their
+timeout. Mutexes raise the priority of their holder to that of the highest
+waiter.
+******************************************************************************/
+
+#define SIM_RTOS_MAX_TASKS              24
+
+typedef struct
+{
+    // the kernel hooks of trace_recorder.h read these two
+    UBaseType_t uxTCBNumber;
+    UBaseType_t uxPriority;
+
+    UBaseType_t uxBasePriority;
+    UBaseType_t uxMutexesHeld;
+    char pcTaskName[configMAX_TASK_NAME_LEN];
+    uint16_t usStackDepth;
+    TaskFunction_t pxTaskCode;
+    void *pvParameters;
+    eTaskState eState;
+    void *pvWaitObject;
+    bool bTimed;
+    TickType_t xWakeTick;
+    uint32_t ui32ReadyOrder;
+    volatile bool bPreempted;
+    uint64_t ui64RunNs;
+    uint64_t ui64SwitchedInNs;
+    pthread_t sThread;
+    pthread_cond_t sWake;
+}
+tSimTCB;
+
+typedef struct
+{
+    // the kernel hooks of trace_recorder.h read these two
+    UBaseType_t uxQueueNumber;
+    uint8_t ucQueueType;
+
+    UBaseType_t uxLength;
+    UBaseType_t uxItemSize;
+    UBaseType_t uxMessagesWaiting;
+    UBaseType_t uxReadIdx;
+    tSimTCB *pxMutexHolder;
+    uint8_t *pui8Storage;
+}
+tSimQueue;
+
+static tSimTCB * volatile pxCurrentTCB = NULL;
+static __thread tSimTCB *g_psSimSelf = NULL;
+static tSimTCB *g_ppsSimTasks[SIM_RTOS_MAX_TASKS];
+static UBaseType_t g_uxSimNumTasks = 0;
+static uint32_t g_ui32SimReadyOrder = 0;
+static volatile TickType_t g_xSimTickCount = 0;
+static volatile bool g_bSimRunning = false;
+static bool g_bSimEnded = false;
+static pthread_cond_t g_sSimEnded = PTHREAD_COND_INITIALIZER;
+
+//*****************************************************************************
+//
+// Stops the preempted task until the scheduler makes it current again. The
+// signal stays blocked in the handler, a resume that races the check is held
+// pending until sigsuspend() and not lost.
+//
+//*****************************************************************************
+static void SimPreemptHandler(int iSig)
+{
+    int iErrno = errno;
+    sigset_t sNone;
+
+    sigemptyset(&sNone);
+    while(pxCurrentTCB != g_psSimSelf)
+    {
+        sigsuspend(&sNone);
+    }
+
+    errno = iErrno;
+}
+
+static void SimInit(void)
+{
+    static bool bInit = false;
+    struct sigaction sAction;
+
+    if(bInit)
+    {
+        return;
+    }
+    bInit = true;
+
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_handler = SimPreemptHandler;
+    sAction.sa_flags = SA_RESTART;
+    sigemptyset(&sAction.sa_mask);
+    sigaction(HAL_SIM_PREEMPT_SIGNAL, &sAction, NULL);
+}
+
+//*****************************************************************************
+//
+// Scheduler core, called with the interrupt lock held.
+//
+//*****************************************************************************
+static void SimReady(tSimTCB *psTCB)
+{
+    psTCB->eState = eReady;
+    psTCB->pvWaitObject = NULL;
+    psTCB->bTimed = false;
+    psTCB->ui32ReadyOrder = ++g_ui32SimReadyOrder;
+}
+
+static tSimTCB *SimSelect(void)
+{
+    tSimTCB *psBest = NULL, *psTCB;
+    UBaseType_t uxIdx;
+
+    if(!g_bSimRunning)
+    {
+        return NULL;
+    }
+
+    for(uxIdx = 0; uxIdx < g_uxSimNumTasks; uxIdx++)
+    {
+        psTCB = g_ppsSimTasks[uxIdx];
+        if((psTCB->eState == eReady) &&
+           (!psBest || (psTCB->uxPriority > psBest->uxPriority) ||
+            ((psTCB->uxPriority == psBest->uxPriority) &&
+             ((int32_t)(psTCB->ui32ReadyOrder - psBest->ui32ReadyOrder) < 0))))
+        {
+            psBest = psTCB;
+        }
+    }
+
+    return psBest;
+}
+
+//*****************************************************************************
+//
+// Hands the CPU to the task that should run. A ready task losing the CPU is
+// stopped with the preemption signal unless it is the caller, which waits
+// for its turn itself. A task preempted from an interrupt handler running on
+// its own thread is signalled too and stops when it leaves the handler. The
+// simulated CPU learns of the switch after the signal, for virtual time.
+//
+//*****************************************************************************
+static void SimSwitch(void)
+{
+    tSimTCB *psOld = pxCurrentTCB, *psNew = SimSelect();
+    uint64_t ui64Now;
+
+    if(psNew == psOld)
+    {
+        return;
+    }
+
+    ui64Now = HalSimTimeNs();
+    pxCurrentTCB = psNew;
+
+    if(psOld)
+    {
+        psOld->ui64RunNs += ui64Now - psOld->ui64SwitchedInNs;
+        if((psOld->eState == eReady) &&
+           ((psOld != g_psSimSelf) || HalSimInInterrupt()))
+        {
+            psOld->bPreempted = true;
+            pthread_kill(psOld->sThread, HAL_SIM_PREEMPT_SIGNAL);
+        }
+    }
+
+    if(psNew)
+    {
+        psNew->ui64SwitchedInNs = ui64Now;
+        traceTASK_SWITCHED_IN();
+        pthread_cond_signal(&psNew->sWake);
+        if(psNew->bPreempted)
+        {
+            psNew->bPreempted = false;
+            pthread_kill(psNew->sThread, HAL_SIM_PREEMPT_SIGNAL);
+        }
+    }
+
+    // without a task main() runs again once the scheduler has ended
+    HalSimCPUSwitch(!psNew && g_bSimRunning);
+}
+
+static void SimWaitTurn(void)
+{
+    tSimTCB *psSelf = g_psSimSelf;
+
+    if(psSelf && !HalSimInInterrupt())
+    {
+        while(pxCurrentTCB != psSelf)
+        {
+            HalSimIntWait(&psSelf->sWake);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Blocks the calling task on an object, or only on time with a NULL object,
+// until the object changes or the tick reaches xWakeTick.
+//
+//*****************************************************************************
+static void SimBlock(void *pvObject, bool bTimed, TickType_t xWakeTick)
+{
+    tSimTCB *psSelf = g_psSimSelf;
+
+    psSelf->eState = eBlocked;
+    psSelf->pvWaitObject = pvObject;
+    psSelf->bTimed = bTimed;
+    psSelf->xWakeTick = xWakeTick;
+
+    SimSwitch();
+    SimWaitTurn();
+}
+
+//*****************************************************************************
+//
+// Readies the tasks waiting on an object. Returns true if one of them has a
+// higher priority than the running task.
+//
+//*****************************************************************************
+static bool SimWakeWaiters(void *pvObject)
+{
+    tSimTCB *psTCB;
+    UBaseType_t uxIdx;
+    bool bHigher = false;
+
+    for(uxIdx = 0; uxIdx < g_uxSimNumTasks; uxIdx++)
+    {
+        psTCB = g_ppsSimTasks[uxIdx];
+        if((psTCB->eState == eBlocked) && (psTCB->pvWaitObject == pvObject))
+        {
+            SimReady(psTCB);
+            if(!pxCurrentTCB || (psTCB->uxPriority > pxCurrentTCB->uxPriority))
+            {
+                bHigher = true;
+            }
+        }
+    }
+
+    return bHigher;
+}
+
+//*****************************************************************************
+//
+// The tick interrupt: wakes the tasks whose timeout expired and rotates the
+// tasks sharing the priority of the running one.
+//
+//*****************************************************************************
+static void SimTickHandler(void)
+{
+    tSimTCB *psTCB;
+    UBaseType_t uxIdx;
+
+    if(!g_bSimRunning)
+    {
+        return;
+    }
+
+    g_xSimTickCount++;
+
+    for(uxIdx = 0; uxIdx < g_uxSimNumTasks; uxIdx++)
+    {
+        psTCB = g_ppsSimTasks[uxIdx];
+        if((psTCB->eState == eBlocked) && psTCB->bTimed &&
+           ((int32_t)(g_xSimTickCount - psTCB->xWakeTick) >= 0))
+        {
+            SimReady(psTCB);
+        }
+    }
+
+    if(pxCurrentTCB && (pxCurrentTCB->eState == eReady))
+    {
+        pxCurrentTCB->ui32ReadyOrder = ++g_ui32SimReadyOrder;
+    }
+
+    SimSwitch();
+}
+
+//*****************************************************************************
+//
+// Tasks.
+//
+//*****************************************************************************
+static void *SimTaskThread(void *pvTCB)
+{
+    tSimTCB *psSelf = pvTCB;
+
+    g_psSimSelf = psSelf;
+    HalSimThreadPreemptible();
+
+    HalSimIntLock();
+    SimWaitTurn();
+    HalSimIntUnlock();
+
+    psSelf->pxTaskCode(psSelf->pvParameters);
+
+    // a FreeRTOS task must not return, treat it as deleting itself
+    vTaskDelete(NULL);
+
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+                       const uint16_t usStackDepth, void * const pvParameters,
+                       UBaseType_t uxPriority,
+                       TaskHandle_t * const pxCreatedTask)
+{
+    tSimTCB *psTCB;
+
+    SimInit();
+
+    if((g_uxSimNumTasks >= SIM_RTOS_MAX_TASKS) ||
+       !(psTCB = calloc(1, sizeof(tSimTCB))))
+    {
+        return pdFAIL;
+    }
+
+    strncpy(psTCB->pcTaskName, pcName, configMAX_TASK_NAME_LEN - 1);
+    psTCB->usStackDepth = usStackDepth;
+    psTCB->pxTaskCode = pxTaskCode;
+    psTCB->pvParameters = pvParameters;
+    psTCB->uxPriority = uxPriority;
+    psTCB->uxBasePriority = uxPriority;
+    pthread_cond_init(&psTCB->sWake, NULL);
+
+    HalSimIntLock();
+    psTCB->uxTCBNumber = g_uxSimNumTasks + 1;
+    SimReady(psTCB);
+    if(pthread_create(&psTCB->sThread, NULL, SimTaskThread, psTCB) != 0)
+    {
+        HalSimIntUnlock();
+        free(psTCB);
+        return pdFAIL;
+    }
+    g_ppsSimTasks[g_uxSimNumTasks++] = psTCB;
+    if(pxCreatedTask)
+    {
+        *pxCreatedTask = psTCB;
+    }
+    SimSwitch();
+    SimWaitTurn();
+    HalSimIntUnlock();
+
+    return pdPASS;
+}
+
+//*****************************************************************************
+//
+// Deleted tasks stay in the task list so that their numbers remain valid in
+// the trace, only a task deleting itself is supported.
+//
+//*****************************************************************************
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    tSimTCB *psTCB = xTaskToDelete ? xTaskToDelete : g_psSimSelf;
+
+    if(!psTCB || (psTCB != g_psSimSelf))
+    {
+        return;
+    }
+
+    HalSimIntLock();
+    psTCB->eState = eDeleted;
+    SimSwitch();
+    HalSimIntUnlock();
+
+    pthread_exit(NULL);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    if(!g_psSimSelf)
+    {
+        return;
+    }
+
+    HalSimIntLock();
+    if(xTicksToDelay == 0)
+    {
+        g_psSimSelf->ui32ReadyOrder = ++g_ui32SimReadyOrder;
+        SimSwitch();
+        SimWaitTurn();
+    }
+    else
+    {
+        SimBlock(NULL, true, g_xSimTickCount + xTicksToDelay);
+    }
+    HalSimIntUnlock();
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime,
+                     const TickType_t xTimeIncrement)
+{
+    TickType_t xWakeTick;
+
+    HalSimIntLock();
+    xWakeTick = *pxPreviousWakeTime + xTimeIncrement;
+    *pxPreviousWakeTime = xWakeTick;
+    if(g_psSimSelf && ((int32_t)(xWakeTick - g_xSimTickCount) > 0))
+    {
+        SimBlock(NULL, true, xWakeTick);
+    }
+    HalSimIntUnlock();
+}
+
+void vTaskYield(void)
+{
+    vTaskDelay(0);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return g_xSimTickCount;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return g_xSimTickCount;
+}
+
+//*****************************************************************************
+//
+// Starts the tick and runs the tasks. Returns after vTaskEndScheduler(), the
+// tasks are left stopped.
+//
+//*****************************************************************************
+void vTaskStartScheduler(void)
+{
+    SimInit();
+
+    HalSimIntLock();
+    g_bSimRunning = true;
+    HalSimSysTickStart(configTICK_RATE_HZ, SimTickHandler);
+    SimSwitch();
+    if(!pxCurrentTCB)
+    {
+        HalSimCPUSwitch(true);
+    }
+    while(!g_bSimEnded)
+    {
+        HalSimIntWait(&g_sSimEnded);
+    }
+    HalSimIntUnlock();
+}
+
+void vTaskEndScheduler(void)
+{
+    HalSimIntLock();
+    g_bSimRunning = false;
+    g_bSimEnded = true;
+    HalSimSysTickStop();
+    SimSwitch();
+    pthread_cond_broadcast(&g_sSimEnded);
+    SimWaitTurn();
+    HalSimIntUnlock();
+}
+
+char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    tSimTCB *psTCB = xTaskToQuery ? xTaskToQuery : g_psSimSelf;
+
+    if(!psTCB)
+    {
+        psTCB = pxCurrentTCB;
+    }
+
+    return psTCB ? psTCB->pcTaskName : NULL;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return g_psSimSelf ? g_psSimSelf : pxCurrentTCB;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask)
+{
+    tSimTCB *psTCB = xTask ? xTask : g_psSimSelf;
+
+    return psTCB ? psTCB->uxPriority : 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    return g_uxSimNumTasks;
+}
+
+//*****************************************************************************
+//
+// Run time is counted in microseconds of host time on the simulated CPU.
+// Host threads have no stack limit to measure, the high water mark is the
+// stack size the task was created with.
+//
+//*****************************************************************************
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * const pxTaskStatusArray,
+                                 const UBaseType_t uxArraySize,
+                                 uint32_t * const pulTotalRunTime)
+{
+    tSimTCB *psTCB;
+    UBaseType_t uxIdx, uxCount = 0;
+
+    HalSimIntLock();
+    for(uxIdx = 0; (uxIdx < g_uxSimNumTasks) && (uxCount < uxArraySize);
+        uxIdx++)
+    {
+        psTCB = g_ppsSimTasks[uxIdx];
+        if(psTCB->eState == eDeleted)
+        {
+            continue;
+        }
+        pxTaskStatusArray[uxCount].xHandle = psTCB;
+        pxTaskStatusArray[uxCount].pcTaskName = psTCB->pcTaskName;
+        pxTaskStatusArray[uxCount].xTaskNumber = psTCB->uxTCBNumber;
+        pxTaskStatusArray[uxCount].eCurrentState =
+            (psTCB == pxCurrentTCB) ? eRunning : psTCB->eState;
+        pxTaskStatusArray[uxCount].uxCurrentPriority = psTCB->uxPriority;
+        pxTaskStatusArray[uxCount].uxBasePriority = psTCB->uxBasePriority;
+        pxTaskStatusArray[uxCount].ulRunTimeCounter =
+            (uint32_t)(psTCB->ui64RunNs / 1000);
+        pxTaskStatusArray[uxCount].usStackHighWaterMark = psTCB->usStackDepth;
+        uxCount++;
+    }
+    if(pulTotalRunTime)
+    {
+        *pulTotalRunTime = (uint32_t)(HalSimTimeNs() / 1000);
+    }
+    HalSimIntUnlock();
+
+    return uxCount;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    tSimTCB *psTCB = xTask ? xTask : g_psSimSelf;
+
+    return psTCB ? psTCB->usStackDepth : 0;
+}
+
+//*****************************************************************************
+//
+// Port layer.
+//
+//*****************************************************************************
+void vPortEnterCritical(void)
+{
+    HalSimIntLock();
+    SimWaitTurn();
+}
+
+void vPortExitCritical(void)
+{
+    HalSimIntUnlock();
+}
+
+void vPortYieldFromISR(void)
+{
+    HalSimIntLock();
+    SimSwitch();
+    SimWaitTurn();
+    HalSimIntUnlock();
+}
+
+void *pvPortMalloc(size_t xSize)
+{
+    return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+    free(pv);
+}
+
+//*****************************************************************************
+//
+// Queues, semaphores and mutexes.
+//
+//*****************************************************************************
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength,
+                                  const UBaseType_t uxItemSize,
+                                  const uint8_t ucQueueType)
+{
+    tSimQueue *pxQueue;
+
+    pxQueue = calloc(1, sizeof(tSimQueue) + (uxQueueLength * uxItemSize));
+    if(pxQueue)
+    {
+        pxQueue->ucQueueType = ucQueueType;
+        pxQueue->uxLength = uxQueueLength;
+        pxQueue->uxItemSize = uxItemSize;
+        pxQueue->pui8Storage = (uint8_t *)(pxQueue + 1);
+    }
+
+    return pxQueue;
+}
+
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType)
+{
+    tSimQueue *pxQueue = xQueueGenericCreate(1, 0, ucQueueType);
+
+    if(pxQueue)
+    {
+        pxQueue->uxMessagesWaiting = 1;
+    }
+
+    return pxQueue;
+}
+
+QueueHandle_t xQueueCreateCountingSemaphore(const UBaseType_t uxMaxCount,
+                                            const UBaseType_t uxInitialCount)
+{
+    tSimQueue *pxQueue = xQueueGenericCreate(uxMaxCount, 0,
+                                             queueQUEUE_TYPE_COUNTING_SEMAPHORE);
+
+    if(pxQueue)
+    {
+        pxQueue->uxMessagesWaiting = uxInitialCount;
+    }
+
+    return pxQueue;
+}
+
+//*****************************************************************************
+//
+// Copies an item in or out. Called with the interrupt lock held and the
+// queue known to have room or an item.
+//
+//*****************************************************************************
+static void SimQueueCopyIn(tSimQueue *pxQueue, const void *pvItem,
+                           BaseType_t xCopyPosition)
+{
+    UBaseType_t uxIdx;
+
+    if(pxQueue->ucQueueType == queueQUEUE_TYPE_MUTEX)
+    {
+        // the holder gives the mutex back and drops any inherited priority
+        if(pxQueue->pxMutexHolder)
+        {
+            if(--pxQueue->pxMutexHolder->uxMutexesHeld == 0)
+            {
+                pxQueue->pxMutexHolder->uxPriority =
+                    pxQueue->pxMutexHolder->uxBasePriority;
+            }
+            pxQueue->pxMutexHolder = NULL;
+        }
+    }
+    else if(pxQueue->uxItemSize)
+    {
+        if((xCopyPosition == queueOVERWRITE) && pxQueue->uxMessagesWaiting)
+        {
+            pxQueue->uxMessagesWaiting--;
+        }
+        if(xCopyPosition == queueSEND_TO_FRONT)
+        {
+            pxQueue->uxReadIdx = (pxQueue->uxReadIdx + pxQueue->uxLength - 1) %
+                                 pxQueue->uxLength;
+            uxIdx = pxQueue->uxReadIdx;
+        }
+        else
+        {
+            uxIdx = (pxQueue->uxReadIdx + pxQueue->uxMessagesWaiting) %
+                    pxQueue->uxLength;
+        }
+        memcpy(&pxQueue->pui8Storage[uxIdx * pxQueue->uxItemSize], pvItem,
+               pxQueue->uxItemSize);
+    }
+
+    pxQueue->uxMessagesWaiting++;
+}
+
+static void SimQueueCopyOut(tSimQueue *pxQueue, void *pvBuffer,
+                            BaseType_t xJustPeek)
+{
+    if(pxQueue->uxItemSize && pvBuffer)
+    {
+        memcpy(pvBuffer,
+               &pxQueue->pui8Storage[pxQueue->uxReadIdx * pxQueue->uxItemSize],
+               pxQueue->uxItemSize);
+    }
+
+    if(xJustPeek)
+    {
+        return;
+    }
+
+    if(pxQueue->uxItemSize)
+    {
+        pxQueue->uxReadIdx = (pxQueue->uxReadIdx + 1) % pxQueue->uxLength;
+    }
+    pxQueue->uxMessagesWaiting--;
+
+    if((pxQueue->ucQueueType == queueQUEUE_TYPE_MUTEX) && g_psSimSelf)
+    {
+        pxQueue->pxMutexHolder = g_psSimSelf;
+        g_psSimSelf->uxMutexesHeld++;
+    }
+}
+
+static bool SimQueueHasRoom(tSimQueue *pxQueue, BaseType_t xCopyPosition)
+{
+    return (pxQueue->uxMessagesWaiting < pxQueue->uxLength) ||
+           (xCopyPosition == queueOVERWRITE);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue,
+                             const void * const pvItemToQueue,
+                             TickType_t xTicksToWait,
+                             const BaseType_t xCopyPosition)
+{
+    tSimQueue *pxQueue = xQueue;
+    TickType_t xWakeTick;
+
+    if(!g_psSimSelf)
+    {
+        xTicksToWait = 0;
+    }
+
+    HalSimIntLock();
+    SimWaitTurn();
+    xWakeTick = g_xSimTickCount + xTicksToWait;
+    for(;;)
+    {
+        if(SimQueueHasRoom(pxQueue, xCopyPosition))
+        {
+            traceQUEUE_SEND(pxQueue);
+            SimQueueCopyIn(pxQueue, pvItemToQueue, xCopyPosition);
+            SimWakeWaiters(pxQueue);
+            SimSwitch();
+            SimWaitTurn();
+            HalSimIntUnlock();
+            return pdPASS;
+        }
+
+        if((xTicksToWait == 0) ||
+           ((xTicksToWait != portMAX_DELAY) &&
+            ((int32_t)(g_xSimTickCount - xWakeTick) >= 0)))
+        {
+            traceQUEUE_SEND_FAILED(pxQueue);
+            HalSimIntUnlock();
+            return errQUEUE_FULL;
+        }
+
+        traceBLOCKING_ON_QUEUE_SEND(pxQueue);
+        SimBlock(pxQueue, xTicksToWait != portMAX_DELAY, xWakeTick);
+    }
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue,
+                                    const void * const pvItemToQueue,
+                                    BaseType_t * const pxHigherPriorityTaskWoken,
+                                    const BaseType_t xCopyPosition)
+{
+    tSimQueue *pxQueue = xQueue;
+    BaseType_t xReturn = errQUEUE_FULL;
+
+    HalSimIntLock();
+    if(SimQueueHasRoom(pxQueue, xCopyPosition))
+    {
+        traceQUEUE_SEND_FROM_ISR(pxQueue);
+        SimQueueCopyIn(pxQueue, pvItemToQueue, xCopyPosition);
+        if(SimWakeWaiters(pxQueue) && pxHigherPriorityTaskWoken)
+        {
+            *pxHigherPriorityTaskWoken = pdTRUE;
+        }
+        xReturn = pdPASS;
+    }
+    else
+    {
+        traceQUEUE_SEND_FAILED(pxQueue);
+    }
+    HalSimIntUnlock();
+
+    return xReturn;
+}
+
+BaseType_t xQueueGiveFromISR(QueueHandle_t xQueue,
+                             BaseType_t * const pxHigherPriorityTaskWoken)
+{
+    return xQueueGenericSendFromISR(xQueue, NULL, pxHigherPriorityTaskWoken,
+                                    queueSEND_TO_BACK);
+}
+
+BaseType_t xQueueGenericReceive(QueueHandle_t xQueue, void * const pvBuffer,
+                                TickType_t xTicksToWait,
+                                const BaseType_t xJustPeek)
+{
+    tSimQueue *pxQueue = xQueue;
+    TickType_t xWakeTick;
+
+    if(!g_psSimSelf)
+    {
+        xTicksToWait = 0;
+    }
+
+    HalSimIntLock();
+    SimWaitTurn();
+    xWakeTick = g_xSimTickCount + xTicksToWait;
+    for(;;)
+    {
+        if(pxQueue->uxMessagesWaiting)
+        {
+            traceQUEUE_RECEIVE(pxQueue);
+            SimQueueCopyOut(pxQueue, pvBuffer, xJustPeek);
+            SimWakeWaiters(pxQueue);
+            SimSwitch();
+            SimWaitTurn();
+            HalSimIntUnlock();
+            return pdPASS;
+        }
+
+        if((xTicksToWait == 0) ||
+           ((xTicksToWait != portMAX_DELAY) &&
+            ((int32_t)(g_xSimTickCount - xWakeTick) >= 0)))
+        {
+            traceQUEUE_RECEIVE_FAILED(pxQueue);
+            HalSimIntUnlock();
+            return errQUEUE_EMPTY;
+        }
+
+        // priority inheritance
+        if(pxQueue->pxMutexHolder &&
+           (pxQueue->pxMutexHolder->uxPriority < g_psSimSelf->uxPriority))
+        {
+            pxQueue->pxMutexHolder->uxPriority = g_psSimSelf->uxPriority;
+        }
+
+        traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue);
+        SimBlock(pxQueue, xTicksToWait != portMAX_DELAY, xWakeTick);
+    }
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t xQueue, void * const pvBuffer,
+                                BaseType_t * const pxHigherPriorityTaskWoken)
+{
+    tSimQueue *pxQueue = xQueue;
+    BaseType_t xReturn = errQUEUE_EMPTY;
+
+    HalSimIntLock();
+    if(pxQueue->uxMessagesWaiting)
+    {
+        traceQUEUE_RECEIVE_FROM_ISR(pxQueue);
+        SimQueueCopyOut(pxQueue, pvBuffer, pdFALSE);
+        if(SimWakeWaiters(pxQueue) && pxHigherPriorityTaskWoken)
+        {
+            *pxHigherPriorityTaskWoken = pdTRUE;
+        }
+        xReturn = pdPASS;
+    }
+    else
+    {
+        traceQUEUE_RECEIVE_FAILED(pxQueue);
+    }
+    HalSimIntUnlock();
+
+    return xReturn;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    return ((tSimQueue *)xQueue)->uxMessagesWaiting;
+}
+
+UBaseType_t uxQueueMessagesWaitingFromISR(const QueueHandle_t xQueue)
+{
+    return ((tSimQueue *)xQueue)->uxMessagesWaiting;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    free(xQueue);
+}
+
+void vQueueSetQueueNumber(QueueHandle_t xQueue, UBaseType_t uxQueueNumber)
+{
+    ((tSimQueue *)xQueue)->uxQueueNumber = uxQueueNumber;
+}
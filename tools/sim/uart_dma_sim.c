@@ -0,0 +1,31 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// UART0 transmit of the Linux simulation, stands in for uart_dma.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hal.h"
+#include "uart_dma.h"
+
+/******************************************************************************
+Description: the simulation has no uDMA controller. UARTDMASend() writes the
+buffer out before it returns, so UARTDMAWait() never has anything to wait
+for and the buffer is free again right away.
+******************************************************************************/
+
+void UARTDMAInit(void)
+{
+}
+
+void UARTDMASend(const void *pvData, uint32_t ui32Len)
+{
+    HalUARTWrite(0, pvData, ui32Len);
+}
+
+void UARTDMAWait(void)
+{
+}
+
+void UART0IntHandler(void)
+{
+}
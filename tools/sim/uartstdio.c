@@ -0,0 +1,108 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// UART console of the Linux simulation, stands in for utils/uartstdio.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "hal.h"
+#include "utils/uartstdio.h"
+
+// UARTprintf() output longer than this is cut
+#define UARTSTDIO_SIM_LINE_MAX          512
+
+static uint32_t g_ui32UARTStdioPort = 0;
+
+void UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud,
+                     uint32_t ui32SrcClock)
+{
+    g_ui32UARTStdioPort = ui32PortNum;
+}
+
+int UARTwrite(const char *pcBuf, uint32_t ui32Len)
+{
+    HalUARTWrite(g_ui32UARTStdioPort, (const uint8_t *)pcBuf, ui32Len);
+
+    return (int)ui32Len;
+}
+
+//*****************************************************************************
+//
+// Waits for a character. The TivaWare version spins on the receive FIFO, so
+// the simulation polls too and keeps the task on the CPU while it waits.
+//
+//*****************************************************************************
+unsigned char UARTgetc(void)
+{
+    struct timespec sPoll = { 0, 1000000 };
+    int32_t i32Char;
+
+    while((i32Char = HalUARTCharGetNonBlocking(g_ui32UARTStdioPort)) < 0)
+    {
+        nanosleep(&sPoll, NULL);
+    }
+
+    return (unsigned char)i32Char;
+}
+
+//*****************************************************************************
+//
+// Reads a line into pcBuf without the line end, returns its length.
+//
+//*****************************************************************************
+int UARTgets(char *pcBuf, uint32_t ui32Len)
+{
+    uint32_t ui32Count = 0;
+    unsigned char ucChar;
+
+    while(1)
+    {
+        ucChar = UARTgetc();
+        if((ucChar == '\r') || (ucChar == '\n') || (ucChar == 0x1b))
+        {
+            break;
+        }
+        if(ucChar == '\b')
+        {
+            if(ui32Count)
+            {
+                ui32Count--;
+            }
+            continue;
+        }
+        if(ui32Count < (ui32Len - 1))
+        {
+            pcBuf[ui32Count++] = (char)ucChar;
+        }
+    }
+
+    pcBuf[ui32Count] = 0;
+
+    return (int)ui32Count;
+}
+
+void UARTvprintf(const char *pcString, va_list vaArgP)
+{
+    char pcLine[UARTSTDIO_SIM_LINE_MAX];
+    int iLen;
+
+    iLen = vsnprintf(pcLine, sizeof(pcLine), pcString, vaArgP);
+    if(iLen > 0)
+    {
+        UARTwrite(pcLine, (iLen < (int)sizeof(pcLine)) ?
+                          (uint32_t)iLen : (uint32_t)sizeof(pcLine) - 1);
+    }
+}
+
+void UARTprintf(const char *pcString, ...)
+{
+    va_list vaArgP;
+
+    va_start(vaArgP, pcString);
+    UARTvprintf(pcString, vaArgP);
+    va_end(vaArgP);
+}
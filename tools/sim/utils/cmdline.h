@@ -0,0 +1,32 @@
+//*****************************************************************************
+//
+// cmdline.h - Stand-in for the TivaWare command line processor of
+// utils/cmdline in the Linux simulation.
+//
+//*****************************************************************************
+
+#ifndef __CMDLINE_H__
+#define __CMDLINE_H__
+
+#define CMDLINE_BAD_CMD                 (-1)
+#define CMDLINE_TOO_MANY_ARGS           (-2)
+#define CMDLINE_TOO_FEW_ARGS            (-3)
+#define CMDLINE_INVALID_ARG             (-4)
+
+#define CMDLINE_MAX_ARGS                8
+
+typedef int (*pfnCmdLine)(int argc, char *argv[]);
+
+typedef struct
+{
+    const char *pcCmd;
+    pfnCmdLine pfnCmd;
+    const char *pcHelp;
+}
+tCmdLineEntry;
+
+extern tCmdLineEntry g_psCmdTable[];
+
+int CmdLineProcess(char *pcCmdLine);
+
+#endif
@@ -0,0 +1,23 @@
+//*****************************************************************************
+//
+// uartstdio.h - Stand-in for the TivaWare UART console of utils/uartstdio in
+// the Linux simulation. Output goes to HalUARTWrite() of UART0, input comes
+// from HalUARTCharGetNonBlocking().
+//
+//*****************************************************************************
+
+#ifndef __UARTSTDIO_H__
+#define __UARTSTDIO_H__
+
+#include <stdarg.h>
+#include <stdint.h>
+
+void UARTStdioConfig(uint32_t ui32PortNum, uint32_t ui32Baud,
+                     uint32_t ui32SrcClock);
+int UARTgets(char *pcBuf, uint32_t ui32Len);
+unsigned char UARTgetc(void);
+void UARTprintf(const char *pcString, ...);
+void UARTvprintf(const char *pcString, va_list vaArgP);
+int UARTwrite(const char *pcBuf, uint32_t ui32Len);
+
+#endif
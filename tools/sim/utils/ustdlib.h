@@ -0,0 +1,27 @@
+//*****************************************************************************
+//
+// ustdlib.h - Stand-in for the TivaWare utils/ustdlib in the Linux
+// simulation, the calls map onto the C library.
+//
+//*****************************************************************************
+
+#ifndef __USTDLIB_H__
+#define __USTDLIB_H__
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define usprintf                        sprintf
+#define usnprintf                       snprintf
+#define uvsnprintf                      vsnprintf
+#define ustrtoul                        strtoul
+#define ustrtof                         strtof
+#define ustrlen                         strlen
+#define ustrncpy                        strncpy
+#define ustrcmp                         strcmp
+#define ustrncmp                        strncmp
+#define ustrstr                         strstr
+
+#endif
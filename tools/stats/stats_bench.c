@@ -0,0 +1,243 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Accuracy and speed benchmark of the streaming statistics in stats.c
+//
+// Usage: stats_bench [seconds]
+// Runs synthetic 8kHz frames of four channels through StatsProcessFrames()
+// in blocks, as the ADC interrupt does, and compares the window and total
+// results with a two pass computation in double over the same samples. Then
+// times the block kernel against per sample Welford updates in float and
+// double.
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "stats.h"
+
+#define BENCH_DEFAULT_SECONDS   20
+#define BENCH_TIMING_SAMPLES    (1 << 22)
+#define BENCH_TIMING_RUNS       20
+
+static volatile double g_dSink;
+
+static double BenchNow(void)
+{
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return sTime.tv_sec + (sTime.tv_nsec * 1e-9);
+}
+
+//*****************************************************************************
+//
+// A sensor around a large offset with slow movement and noise, the case in
+// which a naive sum of squares in float loses the variance.
+//
+//*****************************************************************************
+static uint16_t BenchSample(uint32_t ui32Ch, uint32_t ui32Frame)
+{
+    double dValue = 3000 + (100 * ui32Ch) +
+                    (40 * sin((ui32Frame * 2 * M_PI) / (1000.0 * (ui32Ch + 1))));
+
+    dValue += ((rand() % 2001) - 1000) * (1.0 + ui32Ch) / 500.0;
+
+    return (uint16_t)lrint(dValue);
+}
+
+//*****************************************************************************
+//
+// Two pass reference over frames [ui32First, ui32Last) of a channel.
+//
+//*****************************************************************************
+static void BenchReference(const tADCFrame *psFrames, uint32_t ui32Ch,
+                           uint32_t ui32First, uint32_t ui32Last,
+                           double *pdMean, double *pdVar)
+{
+    double dSum = 0, dM2 = 0, dDiff;
+    uint32_t ui32Idx, ui32N = ui32Last - ui32First;
+
+    for(ui32Idx = ui32First; ui32Idx < ui32Last; ui32Idx++)
+    {
+        dSum += psFrames[ui32Idx].pui16Data[ui32Ch];
+    }
+    *pdMean = dSum / ui32N;
+    for(ui32Idx = ui32First; ui32Idx < ui32Last; ui32Idx++)
+    {
+        dDiff = psFrames[ui32Idx].pui16Data[ui32Ch] - *pdMean;
+        dM2 += dDiff * dDiff;
+    }
+    *pdVar = dM2 / (ui32N - 1);
+}
+
+static bool BenchCompare(const char *pcName, uint32_t ui32Ch,
+                         const tStatsResult *psResult, double dMean,
+                         double dVar)
+{
+    double dMeanErr = fabs((psResult->i32MeanQ8 / 256.0) - dMean);
+    double dVarErr = fabs((psResult->ui32VarQ8 / 256.0) - dVar);
+
+    printf("  ch%u %-6s n %8u mean %9.3f (err %.4f) var %9.3f (err %.4f)\n",
+           ui32Ch, pcName, psResult->ui32Count, psResult->i32MeanQ8 / 256.0,
+           dMeanErr, psResult->ui32VarQ8 / 256.0, dVarErr);
+
+    // results carry 8 fraction bits, truncated
+    return (dMeanErr <= (1.0 / 256)) && (dVarErr <= (1.0 / 256) + 1e-9);
+}
+
+//*****************************************************************************
+//
+// Feeds the frames and checks both results of every channel.
+//
+//*****************************************************************************
+static bool BenchAccuracy(uint32_t ui32Seconds)
+{
+    uint32_t ui32Frames = ui32Seconds * ADC_SAMPLE_RATE_HZ, ui32Idx, ui32Ch;
+    uint32_t ui32SlotFrames, ui32WindowFirst, ui32Filled;
+    tADCFrame *psFrames = malloc(ui32Frames * sizeof(tADCFrame));
+    tStatsResult sResult;
+    double dMean, dVar;
+    bool bPass = true;
+
+    srand(1);
+    for(ui32Idx = 0; ui32Idx < ui32Frames; ui32Idx++)
+    {
+        psFrames[ui32Idx].ui32Seq = ui32Idx;
+        for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+        {
+            psFrames[ui32Idx].pui16Data[ui32Ch] = BenchSample(ui32Ch, ui32Idx);
+        }
+    }
+
+    StatsInit();
+    for(ui32Idx = 0; ui32Idx + STATS_BLOCK_FRAMES <= ui32Frames;
+        ui32Idx += STATS_BLOCK_FRAMES)
+    {
+        StatsProcessFrames(&psFrames[ui32Idx], STATS_BLOCK_FRAMES);
+    }
+
+    //
+    // The window holds the full slots before the one being filled.
+    //
+    ui32SlotFrames = (STATS_DEFAULT_WINDOW_MS * (ADC_SAMPLE_RATE_HZ / 1000)) /
+                     STATS_SLOTS;
+    ui32Filled = ui32Idx % ui32SlotFrames;
+    ui32WindowFirst = ui32Idx - ui32Filled -
+                      ((STATS_SLOTS - 1) * ui32SlotFrames);
+
+    printf("%u s of frames, window %u ms in %u slots\n", ui32Seconds,
+           STATS_DEFAULT_WINDOW_MS, STATS_SLOTS);
+    for(ui32Ch = 0; ui32Ch < ADC_NUM_CHANNELS; ui32Ch++)
+    {
+        StatsGet(ui32Ch, true, &sResult);
+        BenchReference(psFrames, ui32Ch, ui32WindowFirst, ui32Idx, &dMean,
+                       &dVar);
+        bPass &= BenchCompare("window", ui32Ch, &sResult, dMean, dVar);
+
+        StatsGet(ui32Ch, false, &sResult);
+        BenchReference(psFrames, ui32Ch, 0, ui32Idx, &dMean, &dVar);
+        bPass &= BenchCompare("total", ui32Ch, &sResult, dMean, dVar);
+    }
+
+    free(psFrames);
+
+    return bPass;
+}
+
+//*****************************************************************************
+//
+// Per sample cost of the block kernel and of Welford's update.
+//
+//*****************************************************************************
+static void BenchTiming(void)
+{
+    uint16_t *pui16Samples = malloc(BENCH_TIMING_SAMPLES * sizeof(uint16_t));
+    tStatsAccum sAccum;
+    tStatsResult sResult;
+    uint32_t ui32Idx, ui32Run, ui32Block;
+    double dStart, dTime, dMean, dM2, dDelta;
+    float fMean, fM2, fDelta;
+
+    for(ui32Idx = 0; ui32Idx < BENCH_TIMING_SAMPLES; ui32Idx++)
+    {
+        pui16Samples[ui32Idx] = BenchSample(0, ui32Idx);
+    }
+
+    printf("\nper sample cost, %u samples\n", BENCH_TIMING_SAMPLES);
+    for(ui32Block = STATS_BLOCK_FRAMES; ui32Block <= 1024; ui32Block *= 8)
+    {
+        dStart = BenchNow();
+        for(ui32Run = 0; ui32Run < BENCH_TIMING_RUNS; ui32Run++)
+        {
+            StatsAccumReset(&sAccum);
+            for(ui32Idx = 0; ui32Idx < BENCH_TIMING_SAMPLES;
+                ui32Idx += ui32Block)
+            {
+                StatsBlockUpdate(&sAccum, pui16Samples + ui32Idx, 1,
+                                 ui32Block);
+            }
+        }
+        dTime = BenchNow() - dStart;
+        StatsAccumResult(&sAccum, &sResult);
+        printf("  block kernel, %4u samples  %6.2f ns   var %.3f\n", ui32Block,
+               (dTime * 1e9) / ((double)BENCH_TIMING_RUNS * BENCH_TIMING_SAMPLES),
+               sResult.ui32VarQ8 / 256.0);
+    }
+
+    dStart = BenchNow();
+    for(ui32Run = 0; ui32Run < BENCH_TIMING_RUNS; ui32Run++)
+    {
+        fMean = 0;
+        fM2 = 0;
+        for(ui32Idx = 0; ui32Idx < BENCH_TIMING_SAMPLES; ui32Idx++)
+        {
+            fDelta = pui16Samples[ui32Idx] - fMean;
+            fMean += fDelta / (float)(ui32Idx + 1);
+            fM2 += fDelta * (pui16Samples[ui32Idx] - fMean);
+        }
+    }
+    dTime = BenchNow() - dStart;
+    g_dSink = fM2;
+    printf("  Welford float                %6.2f ns   var %.3f\n",
+           (dTime * 1e9) / ((double)BENCH_TIMING_RUNS * BENCH_TIMING_SAMPLES),
+           fM2 / (BENCH_TIMING_SAMPLES - 1));
+
+    dStart = BenchNow();
+    for(ui32Run = 0; ui32Run < BENCH_TIMING_RUNS; ui32Run++)
+    {
+        dMean = 0;
+        dM2 = 0;
+        for(ui32Idx = 0; ui32Idx < BENCH_TIMING_SAMPLES; ui32Idx++)
+        {
+            dDelta = pui16Samples[ui32Idx] - dMean;
+            dMean += dDelta / (ui32Idx + 1);
+            dM2 += dDelta * (pui16Samples[ui32Idx] - dMean);
+        }
+    }
+    dTime = BenchNow() - dStart;
+    g_dSink = dM2;
+    printf("  Welford double               %6.2f ns   var %.3f\n",
+           (dTime * 1e9) / ((double)BENCH_TIMING_RUNS * BENCH_TIMING_SAMPLES),
+           dM2 / (BENCH_TIMING_SAMPLES - 1));
+
+    free(pui16Samples);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t ui32Seconds = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+                           BENCH_DEFAULT_SECONDS;
+    bool bPass;
+
+    bPass = BenchAccuracy(ui32Seconds);
+    BenchTiming();
+
+    printf("\n%s\n", bPass ? "results match the two pass reference" :
+                             "MISMATCH");
+
+    return !bPass;
+}
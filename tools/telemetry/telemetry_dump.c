@@ -0,0 +1,127 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Converts a raw telemetry capture into CSV
+//
+// Usage: telemetry_dump [-s] [capture.bin] > frames.csv
+// Reads standard input when no file is given, so it can sit behind a serial
+// port reader, e.g. "stty -F /dev/ttyUSB0 raw 2000000; telemetry_dump
+// /dev/ttyUSB0". With -s the channel statistics packets are printed to
+// standard error.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "telemetry_parser.h"
+
+typedef struct
+{
+    int bHeader;
+    uint64_t ui64Time;
+    uint32_t ui32LastStamp;
+    int bHaveStamp;
+}
+tDumpState;
+
+static void DumpFrame(const tTelemetryFrame *psFrame, void *pvContext)
+{
+    tDumpState *psState = pvContext;
+    uint32_t ui32Ch;
+
+    if(!psState->bHeader)
+    {
+        printf("seq,time_us");
+        for(ui32Ch = 0; ui32Ch < psFrame->ui32NumChannels; ui32Ch++)
+        {
+            printf(",ch%u", ui32Ch);
+        }
+        printf("\n");
+        psState->bHeader = 1;
+    }
+
+    //
+    // Extend the 32-bit cycle counter so long captures stay monotonic.
+    //
+    if(psState->bHaveStamp)
+    {
+        psState->ui64Time += (uint32_t)(psFrame->ui32Time -
+                                        psState->ui32LastStamp);
+    }
+    psState->ui32LastStamp = psFrame->ui32Time;
+    psState->bHaveStamp = 1;
+
+    printf("%u,%.3f", psFrame->ui32Seq,
+           (double)psState->ui64Time * 1e6 / TELEMETRY_TIMESTAMP_HZ);
+    for(ui32Ch = 0; ui32Ch < psFrame->ui32NumChannels; ui32Ch++)
+    {
+        printf(",%u", psFrame->pui16Data[ui32Ch]);
+    }
+    printf("\n");
+}
+
+static void DumpStatsLine(uint32_t ui32Ch, const char *pcName,
+                          const tTelemetryChannelStats *psStats)
+{
+    fprintf(stderr, "  ch%u %s n %u min %u max %u mean %.2f std %.2f\n",
+            ui32Ch, pcName, psStats->ui32Count, psStats->ui32Min,
+            psStats->ui32Max, psStats->dMean, sqrt(psStats->dVariance));
+}
+
+static void DumpStats(const tTelemetryStats *psStats, void *pvContext)
+{
+    uint32_t ui32Ch;
+
+    fprintf(stderr, "stats, window %ums\n", psStats->ui32WindowMs);
+    for(ui32Ch = 0; ui32Ch < psStats->ui32NumChannels; ui32Ch++)
+    {
+        DumpStatsLine(ui32Ch, "window", &psStats->psWindow[ui32Ch]);
+        DumpStatsLine(ui32Ch, "total ", &psStats->psTotal[ui32Ch]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    tTelemetryParser sParser;
+    tDumpState sState = { 0 };
+    uint8_t pui8Buf[4096];
+    size_t ui32Len;
+    FILE *psIn = stdin;
+    int iArg = 1, bStats = 0;
+
+    if((argc > iArg) && (strcmp(argv[iArg], "-s") == 0))
+    {
+        bStats = 1;
+        iArg++;
+    }
+
+    if(argc > iArg)
+    {
+        psIn = fopen(argv[iArg], "rb");
+        if(psIn == NULL)
+        {
+            perror(argv[iArg]);
+            return 1;
+        }
+    }
+
+    TelemetryParserInit(&sParser, DumpFrame, &sState);
+    if(bStats)
+    {
+        TelemetryParserStatsCallback(&sParser, DumpStats);
+    }
+
+    while((ui32Len = fread(pui8Buf, 1, sizeof(pui8Buf), psIn)) != 0)
+    {
+        TelemetryParserFeed(&sParser, pui8Buf, ui32Len);
+    }
+
+    fprintf(stderr, "packets %u frames %u statistics %u lost %u "
+            "cobs errors %u crc errors %u version errors %u "
+            "format errors %u\n",
+            sParser.ui32Packets, sParser.ui32Frames, sParser.ui32StatsPackets,
+            sParser.ui32LostPackets,
+            sParser.ui32CobsErrors, sParser.ui32CrcErrors,
+            sParser.ui32VersionErrors, sParser.ui32FormatErrors);
+
+    return 0;
+}
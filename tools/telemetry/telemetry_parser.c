@@ -0,0 +1,298 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Host side parser for the ECU telemetry stream
+
+#include <stdint.h>
+#include <string.h>
+#include "cobs.h"
+#include "crc16.h"
+#include "compress.h"
+#include "telemetry_parser.h"
+
+//*****************************************************************************
+//
+// Initializes a parser.
+//
+//*****************************************************************************
+void TelemetryParserInit(tTelemetryParser *psParser,
+                         tTelemetryFrameCallback pfnFrame, void *pvContext)
+{
+    memset(psParser, 0, sizeof(*psParser));
+    psParser->pfnFrame = pfnFrame;
+    psParser->pvContext = pvContext;
+}
+
+//*****************************************************************************
+//
+// Sets the callback for TELEMETRY_TYPE_ADC_STATS packets, which are skipped
+// without one.
+//
+//*****************************************************************************
+void TelemetryParserStatsCallback(tTelemetryParser *psParser,
+                                  tTelemetryStatsCallback pfnStats)
+{
+    psParser->pfnStats = pfnStats;
+}
+
+//*****************************************************************************
+//
+// Checks and unpacks a TELEMETRY_TYPE_ADC_FRAMES payload.
+//
+//*****************************************************************************
+static void TelemetryParseADCFrames(tTelemetryParser *psParser,
+                                    const uint8_t *pui8Payload,
+                                    uint32_t ui32Len)
+{
+    tTelemetryFrame sFrame;
+    uint32_t ui32Count, ui32FrameSize, ui32Idx, ui32Ch;
+    const uint8_t *pui8Frame;
+
+    if(ui32Len < TELEMETRY_ADC_FRAMES)
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    sFrame.ui32NumChannels = pui8Payload[TELEMETRY_ADC_CHANNELS];
+    sFrame.ui32Decimation = TelemetryGet16(pui8Payload +
+                                           TELEMETRY_ADC_DECIMATION);
+    ui32Count = pui8Payload[TELEMETRY_ADC_COUNT];
+    ui32FrameSize = TELEMETRY_ADC_FRAME_SIZE(sFrame.ui32NumChannels);
+
+    if((sFrame.ui32NumChannels > TELEMETRY_PARSER_MAX_CHANNELS) ||
+       (ui32Len != (TELEMETRY_ADC_FRAMES + (ui32Count * ui32FrameSize))))
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        pui8Frame = pui8Payload + TELEMETRY_ADC_FRAMES +
+                    (ui32Idx * ui32FrameSize);
+        sFrame.ui32Seq = TelemetryGet32(pui8Frame);
+        sFrame.ui32Time = TelemetryGet32(pui8Frame + 4);
+        for(ui32Ch = 0; ui32Ch < sFrame.ui32NumChannels; ui32Ch++)
+        {
+            sFrame.pui16Data[ui32Ch] = TelemetryGet16(pui8Frame + 8 +
+                                                      (2 * ui32Ch));
+        }
+
+        psParser->ui32Frames++;
+        if(psParser->pfnFrame)
+        {
+            psParser->pfnFrame(&sFrame, psParser->pvContext);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Unpacks a TELEMETRY_TYPE_ADC_COMPRESSED payload.
+//
+//*****************************************************************************
+static void TelemetryParseADCCompressed(tTelemetryParser *psParser,
+                                        const uint8_t *pui8Payload,
+                                        uint32_t ui32Len)
+{
+    tTelemetryFrame sFrame;
+    tCompressHeader sHeader;
+    uint32_t pui32Time[COMPRESS_MAX_FRAMES];
+    uint16_t pui16Data[COMPRESS_MAX_FRAMES * COMPRESS_MAX_CHANNELS];
+    uint32_t ui32Idx, ui32Ch;
+
+    if(CompressBlockDecode(pui8Payload, ui32Len, &sHeader, pui32Time,
+                           pui16Data) != (int32_t)ui32Len)
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    sFrame.ui32NumChannels = sHeader.ui32Channels;
+    sFrame.ui32Decimation = sHeader.ui32Step ? sHeader.ui32Step : 1;
+
+    for(ui32Idx = 0; ui32Idx < sHeader.ui32Count; ui32Idx++)
+    {
+        sFrame.ui32Seq = sHeader.ui32Seq + (ui32Idx * sHeader.ui32Step);
+        sFrame.ui32Time = pui32Time[ui32Idx];
+        for(ui32Ch = 0; ui32Ch < sHeader.ui32Channels; ui32Ch++)
+        {
+            sFrame.pui16Data[ui32Ch] =
+                pui16Data[(ui32Idx * sHeader.ui32Channels) + ui32Ch];
+        }
+
+        psParser->ui32Frames++;
+        if(psParser->pfnFrame)
+        {
+            psParser->pfnFrame(&sFrame, psParser->pvContext);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Checks and unpacks a TELEMETRY_TYPE_ADC_STATS payload.
+//
+//*****************************************************************************
+static void TelemetryParseStatsEntry(const uint8_t *pui8Entry,
+                                     tTelemetryChannelStats *psStats)
+{
+    psStats->ui32Count = TelemetryGet32(pui8Entry);
+    psStats->ui32Min = TelemetryGet16(pui8Entry + 4);
+    psStats->ui32Max = TelemetryGet16(pui8Entry + 6);
+    psStats->dMean = (int32_t)TelemetryGet32(pui8Entry + 8) / 256.0;
+    psStats->dVariance = TelemetryGet32(pui8Entry + 12) / 256.0;
+}
+
+static void TelemetryParseADCStats(tTelemetryParser *psParser,
+                                   const uint8_t *pui8Payload,
+                                   uint32_t ui32Len)
+{
+    tTelemetryStats sStats;
+    const uint8_t *pui8Entry;
+    uint32_t ui32Ch;
+
+    if(ui32Len < TELEMETRY_STATS_DATA)
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    sStats.ui32NumChannels = pui8Payload[TELEMETRY_STATS_CHANNELS];
+    sStats.ui32WindowMs = TelemetryGet16(pui8Payload + TELEMETRY_STATS_WINDOW);
+    if((sStats.ui32NumChannels > TELEMETRY_PARSER_MAX_CHANNELS) ||
+       (ui32Len != TELEMETRY_STATS_LEN(sStats.ui32NumChannels)))
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    pui8Entry = pui8Payload + TELEMETRY_STATS_DATA;
+    for(ui32Ch = 0; ui32Ch < sStats.ui32NumChannels; ui32Ch++)
+    {
+        TelemetryParseStatsEntry(pui8Entry, &sStats.psWindow[ui32Ch]);
+        TelemetryParseStatsEntry(pui8Entry + TELEMETRY_STATS_SIZE,
+                                 &sStats.psTotal[ui32Ch]);
+        pui8Entry += 2 * TELEMETRY_STATS_SIZE;
+    }
+
+    psParser->ui32StatsPackets++;
+    if(psParser->pfnStats)
+    {
+        psParser->pfnStats(&sStats, psParser->pvContext);
+    }
+}
+
+//*****************************************************************************
+//
+// Decodes and dispatches one delimited block.
+//
+//*****************************************************************************
+static void TelemetryParsePacket(tTelemetryParser *psParser)
+{
+    uint8_t *pui8Packet = psParser->pui8Buf;
+    int32_t i32Len;
+    uint32_t ui32Payload;
+    uint16_t ui16Counter;
+
+    i32Len = CobsDecode(psParser->pui8Buf, (uint32_t)psParser->ui32Len,
+                        pui8Packet);
+    if(i32Len < (TELEMETRY_HDR_SIZE + TELEMETRY_CRC_SIZE))
+    {
+        psParser->ui32CobsErrors++;
+        return;
+    }
+
+    ui32Payload = TelemetryGet16(pui8Packet + TELEMETRY_HDR_LENGTH);
+    if((uint32_t)i32Len != (TELEMETRY_HDR_SIZE + ui32Payload +
+                            TELEMETRY_CRC_SIZE))
+    {
+        psParser->ui32FormatErrors++;
+        return;
+    }
+
+    if(Crc16Ccitt(CRC16_CCITT_INIT, pui8Packet,
+                  TELEMETRY_HDR_SIZE + ui32Payload) !=
+       TelemetryGet16(pui8Packet + TELEMETRY_HDR_SIZE + ui32Payload))
+    {
+        psParser->ui32CrcErrors++;
+        return;
+    }
+
+    // older streams only lack the newer packet types
+    if((pui8Packet[TELEMETRY_HDR_VERSION] == 0) ||
+       (pui8Packet[TELEMETRY_HDR_VERSION] > TELEMETRY_SCHEMA_VERSION))
+    {
+        psParser->ui32VersionErrors++;
+        return;
+    }
+
+    ui16Counter = TelemetryGet16(pui8Packet + TELEMETRY_HDR_COUNTER);
+    if(psParser->bHaveCounter)
+    {
+        psParser->ui32LostPackets +=
+            (uint16_t)(ui16Counter - psParser->ui16Counter - 1);
+    }
+    psParser->bHaveCounter = 1;
+    psParser->ui16Counter = ui16Counter;
+    psParser->ui32Packets++;
+
+    switch(pui8Packet[TELEMETRY_HDR_TYPE])
+    {
+        case TELEMETRY_TYPE_ADC_FRAMES:
+            TelemetryParseADCFrames(psParser, pui8Packet + TELEMETRY_HDR_SIZE,
+                                    ui32Payload);
+            break;
+
+        case TELEMETRY_TYPE_ADC_COMPRESSED:
+            TelemetryParseADCCompressed(psParser,
+                                        pui8Packet + TELEMETRY_HDR_SIZE,
+                                        ui32Payload);
+            break;
+
+        case TELEMETRY_TYPE_ADC_STATS:
+            TelemetryParseADCStats(psParser, pui8Packet + TELEMETRY_HDR_SIZE,
+                                   ui32Payload);
+            break;
+
+        default:
+            // unknown packet types of the same schema are skipped
+            break;
+    }
+}
+
+//*****************************************************************************
+//
+// Feeds raw bytes into the parser.
+//
+//*****************************************************************************
+void TelemetryParserFeed(tTelemetryParser *psParser, const uint8_t *pui8Data,
+                         size_t ui32Len)
+{
+    while(ui32Len--)
+    {
+        if(*pui8Data == TELEMETRY_DELIMITER)
+        {
+            if(psParser->bOverflow)
+            {
+                psParser->ui32FormatErrors++;
+            }
+            else if(psParser->ui32Len != 0)
+            {
+                TelemetryParsePacket(psParser);
+            }
+            psParser->ui32Len = 0;
+            psParser->bOverflow = 0;
+        }
+        else if(psParser->ui32Len < sizeof(psParser->pui8Buf))
+        {
+            psParser->pui8Buf[psParser->ui32Len++] = *pui8Data;
+        }
+        else
+        {
+            psParser->bOverflow = 1;
+        }
+
+        pui8Data++;
+    }
+}
@@ -0,0 +1,88 @@
+//*****************************************************************************
+//
+// telemetry_parser.h - Host side parser for the ECU telemetry stream.
+//
+// Feed raw UART bytes in any chunk size. Every valid ADC frame found in the
+// stream is passed to the frame callback, channel statistics packets to the
+// optional statistics callback. Bytes that are not part of a valid
+// packet (console text, corrupted packets) are counted and skipped.
+//
+//*****************************************************************************
+
+#ifndef TELEMETRY_PARSER_H
+#define TELEMETRY_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_schema.h"
+
+#define TELEMETRY_PARSER_MAX_CHANNELS   16
+
+typedef struct
+{
+    uint32_t ui32Seq;
+    uint32_t ui32Time;
+    uint32_t ui32Decimation;
+    uint32_t ui32NumChannels;
+    uint16_t pui16Data[TELEMETRY_PARSER_MAX_CHANNELS];
+}
+tTelemetryFrame;
+
+typedef void (*tTelemetryFrameCallback)(const tTelemetryFrame *psFrame,
+                                        void *pvContext);
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+    double dMean;
+    double dVariance;
+}
+tTelemetryChannelStats;
+
+typedef struct
+{
+    uint32_t ui32WindowMs;
+    uint32_t ui32NumChannels;
+    tTelemetryChannelStats psWindow[TELEMETRY_PARSER_MAX_CHANNELS];
+    tTelemetryChannelStats psTotal[TELEMETRY_PARSER_MAX_CHANNELS];
+}
+tTelemetryStats;
+
+typedef void (*tTelemetryStatsCallback)(const tTelemetryStats *psStats,
+                                        void *pvContext);
+
+typedef struct
+{
+    tTelemetryFrameCallback pfnFrame;
+    tTelemetryStatsCallback pfnStats;
+    void *pvContext;
+
+    uint8_t pui8Buf[TELEMETRY_COBS_MAX(TELEMETRY_MAX_PACKET)];
+    size_t ui32Len;
+    int bOverflow;
+
+    int bHaveCounter;
+    uint16_t ui16Counter;
+
+    // statistics
+    uint32_t ui32Packets;
+    uint32_t ui32Frames;
+    uint32_t ui32StatsPackets;
+    uint32_t ui32LostPackets;
+    uint32_t ui32CobsErrors;
+    uint32_t ui32CrcErrors;
+    uint32_t ui32VersionErrors;
+    uint32_t ui32FormatErrors;
+}
+tTelemetryParser;
+
+void TelemetryParserInit(tTelemetryParser *psParser,
+                         tTelemetryFrameCallback pfnFrame, void *pvContext);
+void TelemetryParserStatsCallback(tTelemetryParser *psParser,
+                                  tTelemetryStatsCallback pfnStats);
+void TelemetryParserFeed(tTelemetryParser *psParser, const uint8_t *pui8Data,
+                         size_t ui32Len);
+
+#endif
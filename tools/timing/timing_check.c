@@ -0,0 +1,342 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Timing checks of the drivers on the simulated board in virtual time
+//
+// Usage: timing_check [-t seconds]
+// Runs the timer triggered ADC, the PWM triggered dampers and the 5ms rate
+// group with the throttle request for the given simulated time (10s by
+// default), then brings up the LCD and times delay_us() and delay_ms().
+// Virtual time makes every run give the same times, so the limits are exact:
+// the ADC converts every 125us, the dampers every 500us, the throttle
+// request is released every 5ms, a delay ends within the last microsecond of its time and the
+// LCD sees no HD44780 timing violation. Prints one line per check and a
+// digest of all measured times, exits with 1 if a check fails.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "hal.h"
+#include "hal_sim.h"
+#include "lcd_sim.h"
+#include "lcd_i2c.h"
+#include "delay.h"
+#include "adc_api.h"
+#include "ADC_task.h"
+#include "wheel_speed.h"
+#include "rate_group.h"
+#include "sensor_bus.h"
+#include "calib.h"
+#include "can_driver.h"
+
+#define TIMING_LCD_I2C_PORT             1
+#define TIMING_LCD_I2C_ADDR             0x3F
+
+// 80MHz cycles between conversions
+#define TIMING_ADC_PERIOD_CYCLES        (HAL_SYS_CLOCK_HZ / ADC_SAMPLE_RATE_HZ)
+// the PWM trigger counts the system clock / 8
+#define TIMING_SUSPENSION_CYCLES        (((HAL_SYS_CLOCK_HZ / 8) /            \
+                                          ADC_SUSPENSION_RATE_HZ) * 8)
+#define TIMING_TASK_PERIOD_CYCLES       ((HAL_SYS_CLOCK_HZ / 1000) *          \
+                                         ADC_TASK_PERIOD_MS)
+
+// created by main() on the board
+xSemaphoreHandle g_pUARTSemaphore;
+xSemaphoreHandle g_pLCDSemaphore;
+xSemaphoreHandle g_pADCSemaphore;
+
+static uint32_t g_ui32TimingSeconds = 10;
+static uint32_t g_ui32TimingFailed = 0;
+static uint64_t g_ui64TimingDigest = 0xCBF29CE484222325ULL;
+
+//*****************************************************************************
+//
+// Adds a measured value to the FNV-1a digest of the run.
+//
+//*****************************************************************************
+static void TimingDigest(uint64_t ui64Value)
+{
+    uint32_t ui32Byte;
+
+    for(ui32Byte = 0; ui32Byte < 8; ui32Byte++)
+    {
+        g_ui64TimingDigest ^= (ui64Value >> (ui32Byte * 8)) & 0xFF;
+        g_ui64TimingDigest *= 0x100000001B3ULL;
+    }
+}
+
+static void TimingCheck(const char *pcName, bool bPass, const char *pcMeasured,
+                        const char *pcLimit)
+{
+    printf("%s %-24s %-28s %s\n", bPass ? "PASS" : "FAIL", pcName,
+           pcMeasured, pcLimit);
+    if(!bPass)
+    {
+        g_ui32TimingFailed++;
+    }
+}
+
+static uint64_t TimingHostNs(void)
+{
+    struct timespec sNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &sNow);
+
+    return ((uint64_t)sNow.tv_sec * 1000000000ULL) + (uint64_t)sNow.tv_nsec;
+}
+
+//*****************************************************************************
+//
+// Follows the ADC frames, the damper frames and the throttle requests on the
+// sensor bus, every millisecond, by their timestamps.
+//
+//*****************************************************************************
+static void TimingPeriods(void)
+{
+    uint64_t ui64End, ui64Host;
+    uint32_t ui32MinADC = UINT32_MAX, ui32MaxADC = 0, ui32Seq, ui32Last = 0;
+    uint32_t ui32MinTask = UINT32_MAX, ui32MaxTask = 0, ui32LastTask = 0;
+    uint32_t ui32MinSusp = UINT32_MAX, ui32MaxSusp = 0, ui32LastSusp = 0;
+    uint32_t ui32Frames = 0, ui32Releases = 0, ui32SuspFrames = 0, ui32Period;
+    tSensorBusSub sRequests, sSuspension;
+    tThrottleRequest sRequest;
+    tADCSuspensionFrame sSuspFrame;
+    tADCFrame sFrame;
+    char pcMeasured[64], pcLimit[64];
+
+    ADCTaskInit();
+    WheelSpeedInit();
+    ADCExtendedInit();
+    RateGroupInit();
+    ui32Seq = ADCFrameSeqGet();
+    SensorBusSubscribe(&sRequests, &g_sThrottleTopic, "timing");
+    SensorBusSubscribe(&sSuspension, &g_sADCSuspensionTopic, "timing");
+
+    ui64Host = TimingHostNs();
+    ui64End = HalSimTimeNs() + (g_ui32TimingSeconds * 1000000000ULL);
+    while(HalSimTimeNs() < ui64End)
+    {
+        vTaskDelay(1);
+
+        while(SensorBusRead(&sRequests, &sRequest))
+        {
+            if(ui32Releases++)
+            {
+                ui32MinTask = (sRequest.ui32Time - ui32LastTask) < ui32MinTask ?
+                              (sRequest.ui32Time - ui32LastTask) : ui32MinTask;
+                ui32MaxTask = (sRequest.ui32Time - ui32LastTask) > ui32MaxTask ?
+                              (sRequest.ui32Time - ui32LastTask) : ui32MaxTask;
+                TimingDigest(sRequest.ui32Time - ui32LastTask);
+            }
+            ui32LastTask = sRequest.ui32Time;
+        }
+
+        while(ADCFrameRead(&ui32Seq, &sFrame))
+        {
+            if(ui32Frames++)
+            {
+                ui32MinADC = (sFrame.ui32Time - ui32Last) < ui32MinADC ?
+                             (sFrame.ui32Time - ui32Last) : ui32MinADC;
+                ui32MaxADC = (sFrame.ui32Time - ui32Last) > ui32MaxADC ?
+                             (sFrame.ui32Time - ui32Last) : ui32MaxADC;
+                TimingDigest(sFrame.ui32Time - ui32Last);
+            }
+            ui32Last = sFrame.ui32Time;
+        }
+
+        while(SensorBusRead(&sSuspension, &sSuspFrame))
+        {
+            if(ui32SuspFrames++)
+            {
+                ui32Period = sSuspFrame.ui32Time - ui32LastSusp;
+                ui32MinSusp = (ui32Period < ui32MinSusp) ? ui32Period :
+                                                           ui32MinSusp;
+                ui32MaxSusp = (ui32Period > ui32MaxSusp) ? ui32Period :
+                                                           ui32MaxSusp;
+                TimingDigest(ui32Period);
+            }
+            ui32LastSusp = sSuspFrame.ui32Time;
+        }
+    }
+    ui64Host = TimingHostNs() - ui64Host;
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%u..%u cycles, %u frames",
+             ui32MinADC, ui32MaxADC, ui32Frames);
+    snprintf(pcLimit, sizeof(pcLimit), "== %u", TIMING_ADC_PERIOD_CYCLES);
+    TimingCheck("adc_period", (ui32Frames > 1) &&
+                (ui32MinADC == TIMING_ADC_PERIOD_CYCLES) &&
+                (ui32MaxADC == TIMING_ADC_PERIOD_CYCLES), pcMeasured, pcLimit);
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%u..%u cycles, %u frames",
+             ui32MinSusp, ui32MaxSusp, ui32SuspFrames);
+    snprintf(pcLimit, sizeof(pcLimit), "== %u", TIMING_SUSPENSION_CYCLES);
+    TimingCheck("suspension_period", (ui32SuspFrames > 1) &&
+                (ui32MinSusp == TIMING_SUSPENSION_CYCLES) &&
+                (ui32MaxSusp == TIMING_SUSPENSION_CYCLES) &&
+                (sSuspension.ui32Lost == 0), pcMeasured, pcLimit);
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%u..%u cycles, %u releases",
+             ui32MinTask, ui32MaxTask, ui32Releases);
+    snprintf(pcLimit, sizeof(pcLimit), "== %u", TIMING_TASK_PERIOD_CYCLES);
+    TimingCheck("adc_task_period", (ui32Releases > 1) &&
+                (ui32MinTask == TIMING_TASK_PERIOD_CYCLES) &&
+                (ui32MaxTask == TIMING_TASK_PERIOD_CYCLES) &&
+                (sRequests.ui32Lost == 0), pcMeasured, pcLimit);
+
+    printf("     %u s simulated in %.3f s, %.0f times real time\n",
+           g_ui32TimingSeconds, (double)ui64Host / 1e9,
+           (g_ui32TimingSeconds * 1e9) / (double)(ui64Host ? ui64Host : 1));
+}
+
+//*****************************************************************************
+//
+// A delay of n microseconds counts n interrupts of the 1MHz timer, so it
+// ends within (n - 1, n] microseconds of the call.
+//
+//*****************************************************************************
+static void TimingDelays(void)
+{
+    static const uint32_t pui32Delays[] = { 1, 2, 50, 150, 2000, 4500 };
+    uint64_t ui64Start, ui64Ns;
+    uint32_t ui32Idx;
+    char pcName[32], pcMeasured[64], pcLimit[64];
+
+    for(ui32Idx = 0; ui32Idx < (sizeof(pui32Delays) / sizeof(uint32_t));
+        ui32Idx++)
+    {
+        ui64Start = HalSimTimeNs();
+        delay_us(pui32Delays[ui32Idx]);
+        ui64Ns = HalSimTimeNs() - ui64Start;
+        TimingDigest(ui64Ns);
+
+        snprintf(pcName, sizeof(pcName), "delay_us(%u)",
+                 pui32Delays[ui32Idx]);
+        snprintf(pcMeasured, sizeof(pcMeasured), "%llu ns",
+                 (unsigned long long)ui64Ns);
+        snprintf(pcLimit, sizeof(pcLimit), "> %u ns, <= %u ns",
+                 (pui32Delays[ui32Idx] - 1) * 1000,
+                 pui32Delays[ui32Idx] * 1000);
+        TimingCheck(pcName,
+                    (ui64Ns > ((pui32Delays[ui32Idx] - 1) * 1000ULL)) &&
+                    (ui64Ns <= (pui32Delays[ui32Idx] * 1000ULL)),
+                    pcMeasured, pcLimit);
+    }
+
+    ui64Start = HalSimTimeNs();
+    delay_ms(5);
+    ui64Ns = HalSimTimeNs() - ui64Start;
+    TimingDigest(ui64Ns);
+    snprintf(pcMeasured, sizeof(pcMeasured), "%llu ns",
+             (unsigned long long)ui64Ns);
+    TimingCheck("delay_ms(5)", (ui64Ns > 4999000) && (ui64Ns <= 5000000),
+                pcMeasured, "> 4999000 ns, <= 5000000 ns");
+}
+
+//*****************************************************************************
+//
+// The reset sequence of lcdI2cInit() and a few commands and characters,
+// checked by the virtual HD44780.
+//
+//*****************************************************************************
+static void TimingLCD(void)
+{
+    tLCDSimTiming sTiming;
+    char pcMeasured[64], pcLimit[64];
+
+    lcdI2cInit(TIMING_LCD_I2C_ADDR, 16, 2, 0);
+    lcdI2cClear();
+    lcdI2cSetCursor(0, 0);
+    lcdI2cPrint("UNB SAE EV");
+    lcdI2cHome();
+    lcdI2cSetCursor(0, 1);
+    lcdI2cPrint("timing");
+
+    LCDSimTimingGet(&sTiming);
+    TimingDigest(sTiming.ui64MinPulseNs);
+    TimingDigest(sTiming.ui64MinCycleNs);
+    TimingDigest((uint64_t)sTiming.i64MinSlackNs);
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%llu ns, %u pulses",
+             (unsigned long long)sTiming.ui64MinPulseNs, sTiming.ui32Pulses);
+    TimingCheck("lcd_enable_pulse", sTiming.ui64MinPulseNs >= 450,
+                pcMeasured, ">= 450 ns");
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%llu ns",
+             (unsigned long long)sTiming.ui64MinCycleNs);
+    TimingCheck("lcd_enable_cycle", sTiming.ui64MinCycleNs >= 1000,
+                pcMeasured, ">= 1000 ns");
+
+    snprintf(pcMeasured, sizeof(pcMeasured), "%lld ns",
+             (long long)sTiming.i64MinSlackNs);
+    snprintf(pcLimit, sizeof(pcLimit), ">= 0 ns, %u violations",
+             sTiming.ui32Violations);
+    TimingCheck("lcd_busy_slack", (sTiming.i64MinSlackNs >= 0) &&
+                (sTiming.ui32Violations == 0), pcMeasured, pcLimit);
+}
+
+static void TimingTask(void *pvParameters)
+{
+    TimingPeriods();
+    TimingLCD();
+    TimingDelays();
+
+    printf("     digest %016llx\n", (unsigned long long)g_ui64TimingDigest);
+    fflush(stdout);
+
+    vTaskEndScheduler();
+    while(1)
+    {
+        vTaskDelay(1000);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int iOpt;
+
+    while((iOpt = getopt(argc, argv, "t:")) != -1)
+    {
+        if(iOpt == 't')
+        {
+            g_ui32TimingSeconds = (uint32_t)strtoul(optarg, NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-t seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    //
+    // Virtual time from the start, before any timer runs. The console of the
+    // firmware goes to stderr.
+    //
+    HalSimVirtualTimeEnable();
+    HalSimUARTFdSet(0, STDIN_FILENO, STDERR_FILENO);
+    HalSysClockInit();
+    HalUARTInit(0, 115200);
+    g_pUARTSemaphore = xSemaphoreCreateMutex();
+    g_pLCDSemaphore = xSemaphoreCreateMutex();
+    g_pADCSemaphore = xSemaphoreCreateMutex();
+    CalibInit();
+    CANDriverInit();
+    LCDSimAttach(TIMING_LCD_I2C_PORT, TIMING_LCD_I2C_ADDR);
+
+    if(xTaskCreate(TimingTask, (const portCHAR *)"TIM", 512, NULL,
+                   configMAX_PRIORITIES - 1, NULL) != pdTRUE)
+    {
+        return 1;
+    }
+
+    vTaskStartScheduler();
+
+    return (g_ui32TimingFailed != 0);
+}
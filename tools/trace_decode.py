@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decode a trace dump captured from the ECU console into a Chrome trace.
+
+Capture the output of the `trace dump` console command (for example with
+`screen -L` or `picocom --logfile`) and run:
+
+    tools/trace_decode.py capture.log -o trace.json [--stats]
+
+Open trace.json in chrome://tracing or https://ui.perfetto.dev. The dump
+format is described in trace_recorder.c.
+"""
+
+import argparse
+import json
+import sys
+
+EVT_TASK_SWITCH = 1
+EVT_ISR_ENTER = 2
+EVT_ISR_EXIT = 3
+EVT_QUEUE_SEND = 4
+EVT_QUEUE_RECEIVE = 5
+EVT_QUEUE_BLOCK = 6
+EVT_QUEUE_SEND_FAILED = 7
+EVT_MARKER = 8
+EVT_QUEUE_RECEIVE_FAILED = 9
+
+QUEUE_EVENT_NAMES = {
+    EVT_QUEUE_SEND: "send",
+    EVT_QUEUE_RECEIVE: "receive",
+    EVT_QUEUE_BLOCK: "block",
+    EVT_QUEUE_SEND_FAILED: "send failed",
+    EVT_QUEUE_RECEIVE_FAILED: "receive failed",
+}
+
+PID_TASKS = 1
+PID_ISR = 2
+PID_QUEUES = 3
+
+
+class Dump:
+    def __init__(self):
+        self.version = 0
+        self.hz = 80000000
+        self.tasks = {}
+        self.queues = {}
+        self.isrs = {}
+        self.events = []
+
+
+def parse(lines):
+    """Returns the last complete dump found in the capture."""
+    dump = None
+    result = None
+    for line in lines:
+        fields = line.strip().split()
+        if not fields:
+            continue
+        if fields[0] == "TRACE" and len(fields) >= 2:
+            if fields[1] == "BEGIN" and len(fields) >= 5:
+                dump = Dump()
+                dump.version = int(fields[2])
+                dump.hz = int(fields[3])
+            elif fields[1] == "END" and dump is not None:
+                result = dump
+                dump = None
+            continue
+        if dump is None or len(fields) < 3:
+            continue
+        try:
+            if fields[0] == "T":
+                dump.tasks[int(fields[1])] = " ".join(fields[2:])
+            elif fields[0] == "Q":
+                dump.queues[int(fields[1])] = " ".join(fields[2:])
+            elif fields[0] == "I":
+                dump.isrs[int(fields[1])] = " ".join(fields[2:])
+            elif fields[0] == "E":
+                dump.events.append((int(fields[1], 16), int(fields[2], 16)))
+        except ValueError:
+            # line garbled by interleaved console output
+            continue
+    return result
+
+
+def unwrap(events, hz):
+    """Converts 32-bit cycle stamps into monotonically increasing microseconds."""
+    out = []
+    base = 0
+    last = None
+    for stamp, info in events:
+        if last is not None and stamp < last:
+            base += 1 << 32
+        last = stamp
+        cycles = base + stamp
+        out.append((cycles * 1e6 / hz, info >> 24, (info >> 16) & 0xFF,
+                    info & 0xFFFF))
+    if out:
+        start = out[0][0]
+        out = [(t - start, typ, ident, data) for t, typ, ident, data in out]
+    return out
+
+
+def to_chrome(dump):
+    events = unwrap(dump.events, dump.hz)
+    trace = []
+
+    def meta(pid, tid, name):
+        trace.append({"ph": "M", "pid": pid, "tid": tid,
+                      "name": "thread_name", "args": {"name": name}})
+
+    trace.append({"ph": "M", "pid": PID_TASKS, "name": "process_name",
+                  "args": {"name": "Tasks"}})
+    trace.append({"ph": "M", "pid": PID_ISR, "name": "process_name",
+                  "args": {"name": "Interrupts"}})
+    trace.append({"ph": "M", "pid": PID_QUEUES, "name": "process_name",
+                  "args": {"name": "Queues"}})
+    for num, name in dump.tasks.items():
+        meta(PID_TASKS, num, name)
+    for num, name in dump.isrs.items():
+        meta(PID_ISR, num, name)
+    for num, name in dump.queues.items():
+        meta(PID_QUEUES, num, name)
+
+    running = None
+    for ts, typ, ident, data in events:
+        if typ == EVT_TASK_SWITCH:
+            if running is not None:
+                trace.append({"ph": "E", "pid": PID_TASKS, "tid": running,
+                              "ts": ts})
+            running = ident
+            trace.append({"ph": "B", "pid": PID_TASKS, "tid": ident, "ts": ts,
+                          "name": dump.tasks.get(ident, "task %d" % ident),
+                          "args": {"priority": data}})
+        elif typ == EVT_ISR_ENTER:
+            trace.append({"ph": "B", "pid": PID_ISR, "tid": ident, "ts": ts,
+                          "name": dump.isrs.get(ident, "isr %d" % ident)})
+        elif typ == EVT_ISR_EXIT:
+            trace.append({"ph": "E", "pid": PID_ISR, "tid": ident, "ts": ts})
+        elif typ in QUEUE_EVENT_NAMES:
+            name = QUEUE_EVENT_NAMES[typ]
+            if typ == EVT_QUEUE_SEND_FAILED and dump.version < 2:
+                # version 1 recorded failed sends and receives alike
+                name = "failed"
+            trace.append({"ph": "i", "s": "t", "pid": PID_QUEUES, "tid": ident,
+                          "ts": ts, "name": name,
+                          "args": {"queue": dump.queues.get(ident, ident),
+                                   "type": data,
+                                   "task": dump.tasks.get(running, running)}})
+        elif typ == EVT_MARKER:
+            trace.append({"ph": "i", "s": "g", "pid": PID_TASKS,
+                          "tid": running if running is not None else 0,
+                          "ts": ts, "name": "marker %d" % ident,
+                          "args": {"value": data}})
+    if running is not None and events:
+        trace.append({"ph": "E", "pid": PID_TASKS, "tid": running,
+                      "ts": events[-1][0]})
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+
+def stats(dump, out):
+    """Prints ISR durations and task run slices, the usual latency suspects."""
+    events = unwrap(dump.events, dump.hz)
+    isr_start = {}
+    durations = {}
+    running = None
+    slice_start = None
+    for ts, typ, ident, _ in events:
+        if typ == EVT_ISR_ENTER:
+            isr_start[ident] = ts
+        elif typ == EVT_ISR_EXIT and ident in isr_start:
+            name = "isr " + dump.isrs.get(ident, str(ident))
+            durations.setdefault(name, []).append(ts - isr_start.pop(ident))
+        elif typ == EVT_TASK_SWITCH:
+            if running is not None:
+                name = "task " + dump.tasks.get(running, str(running))
+                durations.setdefault(name, []).append(ts - slice_start)
+            running = ident
+            slice_start = ts
+    span = events[-1][0] if events else 0
+    out.write("%d events over %.1f us\n" % (len(events), span))
+    out.write("%-20s %8s %10s %10s %10s\n" % ("slice", "count", "min us",
+                                               "avg us", "max us"))
+    for name in sorted(durations):
+        d = durations[name]
+        out.write("%-20s %8d %10.2f %10.2f %10.2f\n" %
+                  (name, len(d), min(d), sum(d) / len(d), max(d)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", help="console capture containing a dump")
+    parser.add_argument("-o", "--output", default="trace.json",
+                        help="Chrome trace JSON output file")
+    parser.add_argument("--stats", action="store_true",
+                        help="print ISR and task slice statistics")
+    args = parser.parse_args()
+
+    with open(args.capture, errors="replace") as f:
+        dump = parse(f)
+    if dump is None:
+        sys.exit("no complete TRACE BEGIN/END block found")
+
+    with open(args.output, "w") as f:
+        json.dump(to_chrome(dump), f)
+
+    if args.stats:
+        stats(dump, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Binary RAM trace recorder for scheduler, queue and interrupt events
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "ram_budget.h"
+#include "trace_recorder.h"
+
+/******************************************************************************
+Description: the recorder is fed by the FreeRTOS trace macros defined in
+trace_recorder.h, by TRACE_ISR_ENTER()/TRACE_ISR_EXIT() in the interrupt
+handlers and by TRACE_MARKER() for user events. The ring buffer always holds
+the most recent TRACE_BUFFER_EVENTS events.
+
+TraceRecorderDump() prints the buffer as text so it can share the console
+UART with UARTprintf:
+
+    TRACE BEGIN <version> <cpu hz> <event count>
+    T <task number> <task name>
+    Q <queue number> <queue name>
+    I <isr id> <isr name>
+    E <timestamp> <info>            (oldest first, both 8 hex digits)
+    TRACE END
+
+tools/trace_decode.py turns a capture of this output into a Chrome trace.
+******************************************************************************/
+
+#define TRACE_FORMAT_VERSION            2
+#define TRACE_MAX_QUEUES                8
+
+volatile uint32_t g_ui32TraceMask = TRACE_MASK_ALL;
+volatile uint32_t g_ui32TraceHead = 0;
+tTraceEvent g_psTraceBuffer[TRACE_BUFFER_EVENTS];
+
+typedef char tTraceBudget[(sizeof(g_psTraceBuffer) <= RAM_BUDGET_TRACE) ?
+                          1 : -1];
+
+static const char *g_ppcTraceQueueNames[TRACE_MAX_QUEUES];
+static uint32_t g_ui32TraceNumQueues = 0;
+
+//*****************************************************************************
+//
+// Names of the interrupt ids, indexed by TRACE_ISR_xxx.
+//
+//*****************************************************************************
+static const char * const g_ppcTraceISRNames[] =
+{
+    "none",
+    "ADC0",
+    "CAN0",
+    "TIMER2A",
+    "TIMER3A",
+    "ADC0SS0",
+};
+
+static uint32_t g_ui32TraceSavedMask = TRACE_MASK_ALL;
+
+//*****************************************************************************
+//
+// Resumes recording with the event mask in use before TraceRecorderStop().
+//
+//*****************************************************************************
+void TraceRecorderStart(void)
+{
+    g_ui32TraceMask = g_ui32TraceSavedMask;
+}
+
+//*****************************************************************************
+//
+// Stops recording. The buffer content is kept.
+//
+//*****************************************************************************
+void TraceRecorderStop(void)
+{
+    if(g_ui32TraceMask != 0)
+    {
+        g_ui32TraceSavedMask = g_ui32TraceMask;
+    }
+    g_ui32TraceMask = 0;
+}
+
+//*****************************************************************************
+//
+// Discards all recorded events.
+//
+//*****************************************************************************
+void TraceRecorderClear(void)
+{
+    uint32_t ui32Masked = HalIntMasterDisable();
+
+    g_ui32TraceHead = 0;
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Assigns a trace number to a queue or semaphore so its events can be told
+// apart in the decoded trace. Unnamed queues are reported as number 0.
+//
+//*****************************************************************************
+void TraceRecorderSetQueueName(void *pvQueue, const char *pcName)
+{
+    if((pvQueue == NULL) || (g_ui32TraceNumQueues >= TRACE_MAX_QUEUES))
+    {
+        return;
+    }
+
+    g_ppcTraceQueueNames[g_ui32TraceNumQueues++] = pcName;
+    vQueueSetQueueNumber((xQueueHandle)pvQueue, g_ui32TraceNumQueues);
+}
+
+//*****************************************************************************
+//
+// Prints the recorded events, oldest first. Recording is paused while the
+// buffer is printed. The task names are taken from a copy of the task list
+// on the heap, sized by the number of tasks; without them the trace cannot
+// be decoded, so nothing is printed when the copy fails. The caller must own
+// the UART.
+//
+//*****************************************************************************
+void TraceRecorderDump(void)
+{
+    TaskStatus_t *psTasks;
+    uint32_t ui32Head, ui32Count, ui32Idx, ui32NumTasks;
+    tTraceEvent *psEvent;
+
+    TraceRecorderStop();
+
+    ui32NumTasks = uxTaskGetNumberOfTasks();
+    psTasks = pvPortMalloc(ui32NumTasks * sizeof(TaskStatus_t));
+    if(psTasks != NULL)
+    {
+        ui32NumTasks = uxTaskGetSystemState(psTasks, ui32NumTasks, NULL);
+    }
+    if((psTasks == NULL) || (ui32NumTasks == 0))
+    {
+        UARTprintf("\ntrace: cannot list the tasks, no dump\n");
+        vPortFree(psTasks);
+        TraceRecorderStart();
+        return;
+    }
+
+    ui32Head = g_ui32TraceHead;
+    ui32Count = (ui32Head < TRACE_BUFFER_EVENTS) ? ui32Head :
+                                                   TRACE_BUFFER_EVENTS;
+
+    UARTprintf("\nTRACE BEGIN %u %u %u\n", TRACE_FORMAT_VERSION,
+               configCPU_CLOCK_HZ, ui32Count);
+
+    for(ui32Idx = 0; ui32Idx < ui32NumTasks; ui32Idx++)
+    {
+        UARTprintf("T %u %s\n", psTasks[ui32Idx].xTaskNumber,
+                   psTasks[ui32Idx].pcTaskName);
+    }
+    vPortFree(psTasks);
+
+    for(ui32Idx = 0; ui32Idx < g_ui32TraceNumQueues; ui32Idx++)
+    {
+        UARTprintf("Q %u %s\n", ui32Idx + 1, g_ppcTraceQueueNames[ui32Idx]);
+    }
+
+    for(ui32Idx = 1; ui32Idx < (sizeof(g_ppcTraceISRNames) /
+                                sizeof(g_ppcTraceISRNames[0])); ui32Idx++)
+    {
+        UARTprintf("I %u %s\n", ui32Idx, g_ppcTraceISRNames[ui32Idx]);
+    }
+
+    for(ui32Idx = ui32Head - ui32Count; ui32Idx != ui32Head; ui32Idx++)
+    {
+        psEvent = &g_psTraceBuffer[ui32Idx & (TRACE_BUFFER_EVENTS - 1)];
+        UARTprintf("E %08x %08x\n", psEvent->ui32Time, psEvent->ui32Info);
+    }
+
+    UARTprintf("TRACE END\n");
+
+    TraceRecorderStart();
+}
@@ -0,0 +1,139 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hal.h"
+#include "timestamp.h"
+
+//*****************************************************************************
+//
+// Binary trace recorder. Events are kept in a RAM ring buffer of two words
+// each: a DWT timestamp and an info word holding the event type (bits 31:24),
+// an object id (bits 23:16) and 16 bits of event data. Recording an event
+// costs a mask test, a short interrupt lock and two stores.
+//
+// This header is included from FreeRTOSConfig.h so it must only depend on
+// the C standard, TivaWare and HAL headers.
+//
+//*****************************************************************************
+
+// must be a power of two
+#define TRACE_BUFFER_EVENTS             128
+
+//*****************************************************************************
+//
+// Event types. The id field holds the task number, queue number, interrupt id
+// or marker id depending on the type.
+//
+//*****************************************************************************
+#define TRACE_EVT_TASK_SWITCH           1       // id = task number
+#define TRACE_EVT_ISR_ENTER             2       // id = TRACE_ISR_xxx
+#define TRACE_EVT_ISR_EXIT              3       // id = TRACE_ISR_xxx
+#define TRACE_EVT_QUEUE_SEND            4       // id = queue number
+#define TRACE_EVT_QUEUE_RECEIVE         5       // id = queue number
+#define TRACE_EVT_QUEUE_BLOCK           6       // id = queue number
+#define TRACE_EVT_QUEUE_SEND_FAILED     7       // id = queue number
+#define TRACE_EVT_MARKER                8       // id = marker, data = value
+#define TRACE_EVT_QUEUE_RECEIVE_FAILED  9       // id = queue number
+
+#define TRACE_MASK_ALL                  0xFFFFFFFF
+
+//*****************************************************************************
+//
+// Interrupt ids used with TRACE_ISR_ENTER()/TRACE_ISR_EXIT().
+//
+//*****************************************************************************
+#define TRACE_ISR_ADC0                  1
+#define TRACE_ISR_CAN0                  2
+#define TRACE_ISR_TIMER2A               3
+#define TRACE_ISR_TIMER3A               4
+#define TRACE_ISR_ADC0SS0               5
+
+typedef struct
+{
+    uint32_t ui32Time;
+    uint32_t ui32Info;
+}
+tTraceEvent;
+
+extern volatile uint32_t g_ui32TraceMask;
+extern volatile uint32_t g_ui32TraceHead;
+extern tTraceEvent g_psTraceBuffer[TRACE_BUFFER_EVENTS];
+
+//*****************************************************************************
+//
+// Records one event. Safe to call from tasks, the kernel and any interrupt.
+//
+//*****************************************************************************
+static inline void TraceRecorderEvent(uint32_t ui32Type, uint32_t ui32Id,
+                                      uint32_t ui32Data)
+{
+    uint32_t ui32Masked;
+    tTraceEvent *psEvent;
+
+    if(g_ui32TraceMask & (1UL << ui32Type))
+    {
+        ui32Masked = HalIntMasterDisable();
+        psEvent = &g_psTraceBuffer[g_ui32TraceHead++ &
+                                   (TRACE_BUFFER_EVENTS - 1)];
+        psEvent->ui32Time = TimestampGet();
+        psEvent->ui32Info = (ui32Type << 24) | ((ui32Id & 0xFF) << 16) |
+                            (ui32Data & 0xFFFF);
+        if(!ui32Masked)
+        {
+            HalIntMasterEnable();
+        }
+    }
+}
+
+#define TRACE_ISR_ENTER(id)     TraceRecorderEvent(TRACE_EVT_ISR_ENTER, (id), 0)
+#define TRACE_ISR_EXIT(id)      TraceRecorderEvent(TRACE_EVT_ISR_EXIT, (id), 0)
+#define TRACE_MARKER(id, value) TraceRecorderEvent(TRACE_EVT_MARKER, (id), \
+                                                   (value))
+
+void TraceRecorderStart(void);
+void TraceRecorderStop(void);
+void TraceRecorderClear(void);
+void TraceRecorderSetQueueName(void *pvQueue, const char *pcName);
+void TraceRecorderDump(void);
+
+//*****************************************************************************
+//
+// FreeRTOS kernel hooks. These expand inside tasks.c and queue.c where
+// pxCurrentTCB and the queue structure members are visible. The task and
+// queue numbers exist because configUSE_TRACE_FACILITY is set.
+//
+//*****************************************************************************
+#define traceTASK_SWITCHED_IN()                                               \
+    TraceRecorderEvent(TRACE_EVT_TASK_SWITCH, pxCurrentTCB->uxTCBNumber,      \
+                       pxCurrentTCB->uxPriority)
+
+#define traceQUEUE_SEND(pxQueue)                                              \
+    TraceRecorderEvent(TRACE_EVT_QUEUE_SEND, (pxQueue)->uxQueueNumber,        \
+                       (pxQueue)->ucQueueType)
+
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)   traceQUEUE_SEND(pxQueue)
+
+#define traceQUEUE_SEND_FAILED(pxQueue)                                       \
+    TraceRecorderEvent(TRACE_EVT_QUEUE_SEND_FAILED,                           \
+                       (pxQueue)->uxQueueNumber, (pxQueue)->ucQueueType)
+
+#define traceQUEUE_RECEIVE(pxQueue)                                           \
+    TraceRecorderEvent(TRACE_EVT_QUEUE_RECEIVE, (pxQueue)->uxQueueNumber,     \
+                       (pxQueue)->ucQueueType)
+
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)    traceQUEUE_RECEIVE(pxQueue)
+
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)                                    \
+    TraceRecorderEvent(TRACE_EVT_QUEUE_RECEIVE_FAILED,                        \
+                       (pxQueue)->uxQueueNumber, (pxQueue)->ucQueueType)
+
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)                               \
+    TraceRecorderEvent(TRACE_EVT_QUEUE_BLOCK, (pxQueue)->uxQueueNumber,       \
+                       (pxQueue)->ucQueueType)
+
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue)                                  \
+    traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue)
+
+#endif
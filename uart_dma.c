@@ -0,0 +1,131 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// UART0 transmit through the uDMA controller
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_uart.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "udma_api.h"
+#include "uart_dma.h"
+
+/******************************************************************************
+Description: moves a buffer into the UART0 transmit FIFO with the uDMA
+controller so the CPU is free while the bytes go out. The caller must own the
+UART (g_pUARTSemaphore) from UARTDMASend() until UARTDMAWait() returns,
+otherwise UARTprintf() output gets mixed into the transfer.
+
+The buffer passed to UARTDMASend() must stay untouched until the next
+UARTDMASend() or UARTDMAWait() call returns.
+******************************************************************************/
+
+// lowest priority, the handler calls into FreeRTOS
+#define UART_DMA_INT_PRIORITY           0xE0
+
+static xSemaphoreHandle g_pUARTDMADone;
+static volatile bool g_bUARTDMABusy = false;
+
+//*****************************************************************************
+//
+// Sets up the UART0 transmit uDMA channel. ConfigureUART() must have been
+// called first.
+//
+//*****************************************************************************
+void UARTDMAInit(void)
+{
+    UDMAInit();
+
+    g_pUARTDMADone = xSemaphoreCreateBinary();
+
+    MAP_uDMAChannelAssign(UDMA_CH9_UART0TX);
+    MAP_uDMAChannelAttributeDisable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_ALL);
+    MAP_uDMAChannelControlSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                              UDMA_DST_INC_NONE | UDMA_ARB_8);
+
+    //
+    // Request a transfer whenever the transmit FIFO is half empty.
+    //
+    MAP_UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    MAP_UARTDMAEnable(UART0_BASE, UART_DMA_TX);
+
+    //
+    // The uDMA done signal of a peripheral channel is raised on the
+    // peripheral interrupt, no UART interrupt source needs to be enabled.
+    //
+    UARTIntRegister(UART0_BASE, UART0IntHandler);
+    MAP_IntPrioritySet(INT_UART0, UART_DMA_INT_PRIORITY);
+    MAP_IntEnable(INT_UART0);
+}
+
+//*****************************************************************************
+//
+// Starts transmitting a buffer. Waits for the previous transfer first, so two
+// buffers can be used in ping-pong fashion.
+//
+//*****************************************************************************
+void UARTDMASend(const void *pvData, uint32_t ui32Len)
+{
+    UARTDMAWait();
+
+    if(ui32Len == 0)
+    {
+        return;
+    }
+
+    if(ui32Len > UART_DMA_MAX_TRANSFER)
+    {
+        ui32Len = UART_DMA_MAX_TRANSFER;
+    }
+
+    g_bUARTDMABusy = true;
+    MAP_uDMAChannelTransferSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT,
+                               UDMA_MODE_BASIC, (void *)pvData,
+                               (void *)(UART0_BASE + UART_O_DR), ui32Len);
+    MAP_uDMAChannelEnable(UDMA_CHANNEL_UART0TX);
+}
+
+//*****************************************************************************
+//
+// Blocks the calling task until the current transfer has been handed to the
+// UART.
+//
+//*****************************************************************************
+void UARTDMAWait(void)
+{
+    if(g_bUARTDMABusy)
+    {
+        xSemaphoreTake(g_pUARTDMADone, portMAX_DELAY);
+        g_bUARTDMABusy = false;
+    }
+}
+
+//*****************************************************************************
+//
+// UART0 interrupt handler. Signals the end of a uDMA transfer.
+//
+//*****************************************************************************
+void UART0IntHandler(void)
+{
+    BaseType_t xWoken = pdFALSE;
+    uint32_t ui32Status;
+
+    ui32Status = MAP_UARTIntStatus(UART0_BASE, true);
+    MAP_UARTIntClear(UART0_BASE, ui32Status);
+
+    if(g_bUARTDMABusy && !MAP_uDMAChannelIsEnabled(UDMA_CHANNEL_UART0TX))
+    {
+        xSemaphoreGiveFromISR(g_pUARTDMADone, &xWoken);
+    }
+
+    portYIELD_FROM_ISR(xWoken);
+}
@@ -0,0 +1,12 @@
+#ifndef UART_DMA_H
+#define UART_DMA_H
+
+// largest single uDMA basic mode transfer
+#define UART_DMA_MAX_TRANSFER           1024
+
+void UARTDMAInit(void);
+void UARTDMASend(const void *pvData, uint32_t ui32Len);
+void UARTDMAWait(void);
+void UART0IntHandler(void);
+
+#endif
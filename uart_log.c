@@ -0,0 +1,339 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Deferred formatting UART logger
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hal.h"
+#include "utils/uartstdio.h"
+#include "utils/ustdlib.h"
+#include "priorities.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "ram_budget.h"
+#include "timestamp.h"
+#include "uart_dma.h"
+#include "uart_log.h"
+
+/******************************************************************************
+Description: LOGn() calls store a record of 32-bit words into a RAM ring:
+
+    word 0      message id (bits 31:16), number of arguments (bits 3:0)
+    word 1      DWT timestamp
+    word 2..    raw arguments
+
+Nothing is formatted in the caller. The ring is only locked (PRIMASK) for the
+few stores of one record, there is no mutex so interrupt handlers can log.
+When the ring is full the record is dropped and counted.
+
+The low priority logger task drains the ring every LOG_FLUSH_MS and sends the
+records with UART0 uDMA, either formatted as text or, in binary mode, as
+frames for tools/log_decode.py:
+
+    0xA5, word count, words (little endian), 8-bit sum of count and words
+******************************************************************************/
+
+//*****************************************************************************
+//
+// The stack size of the logger task, the ring size and the flush period.
+//
+//*****************************************************************************
+#define LOGTASKSTACKSIZE                192             // Stack size in words
+#define LOG_RING_WORDS                  256             // must be power of two
+#define LOG_FLUSH_MS                    10
+#define LOG_TX_BUFFER_SIZE              256
+#define LOG_RECORD_MAX_WORDS            (2 + LOG_MAX_ARGS)
+#define LOG_FRAME_SYNC                  0xA5
+
+extern xSemaphoreHandle g_pUARTSemaphore;
+
+//*****************************************************************************
+//
+// Format strings, generated from log_ids.h.
+//
+//*****************************************************************************
+#define LOG_MSG(id, fmt)    fmt,
+static const char * const g_ppcLogFormats[LOG_NUM_IDS] =
+{
+#include "log_ids.h"
+};
+#undef LOG_MSG
+
+static uint32_t g_pui32LogRing[LOG_RING_WORDS];
+static volatile uint32_t g_ui32LogHead = 0;
+static volatile uint32_t g_ui32LogTail = 0;
+static volatile uint32_t g_ui32LogDropped = 0;
+static uint32_t g_ui32LogDroppedReported = 0;
+static uint32_t g_ui32LogWritten = 0;
+static volatile uint32_t g_ui32LogMode = LOG_MODE_TEXT;
+
+static uint8_t g_ppui8LogTxBuffer[2][LOG_TX_BUFFER_SIZE];
+
+typedef char tLogBudget[(sizeof(g_pui32LogRing) + sizeof(g_ppui8LogTxBuffer) <=
+                         RAM_BUDGET_LOG) ? 1 : -1];
+
+//*****************************************************************************
+//
+// Stores one record. Costs a handful of stores with interrupts masked.
+//
+//*****************************************************************************
+void UARTLogWrite(uint32_t ui32Id, uint32_t ui32NumArgs, uint32_t ui32Arg0,
+                  uint32_t ui32Arg1, uint32_t ui32Arg2, uint32_t ui32Arg3)
+{
+    uint32_t ui32Masked, ui32Head;
+
+    ui32Masked = HalIntMasterDisable();
+
+    ui32Head = g_ui32LogHead;
+    if((ui32Head - g_ui32LogTail + 2 + ui32NumArgs) > LOG_RING_WORDS)
+    {
+        g_ui32LogDropped++;
+    }
+    else
+    {
+        g_pui32LogRing[ui32Head++ & (LOG_RING_WORDS - 1)] =
+            (ui32Id << 16) | ui32NumArgs;
+        g_pui32LogRing[ui32Head++ & (LOG_RING_WORDS - 1)] = TimestampGet();
+        switch(ui32NumArgs)
+        {
+            case 4:
+                g_pui32LogRing[(ui32Head + 3) & (LOG_RING_WORDS - 1)] =
+                    ui32Arg3;
+                // fall through
+            case 3:
+                g_pui32LogRing[(ui32Head + 2) & (LOG_RING_WORDS - 1)] =
+                    ui32Arg2;
+                // fall through
+            case 2:
+                g_pui32LogRing[(ui32Head + 1) & (LOG_RING_WORDS - 1)] =
+                    ui32Arg1;
+                // fall through
+            case 1:
+                g_pui32LogRing[ui32Head & (LOG_RING_WORDS - 1)] = ui32Arg0;
+                // fall through
+            default:
+                break;
+        }
+        g_ui32LogHead = ui32Head + ui32NumArgs;
+    }
+
+    if(!ui32Masked)
+    {
+        HalIntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Selects text or binary output.
+//
+//*****************************************************************************
+void UARTLogModeSet(uint32_t ui32Mode)
+{
+    g_ui32LogMode = ui32Mode;
+}
+
+//*****************************************************************************
+//
+// Prints the logger counters. The caller must own the UART.
+//
+//*****************************************************************************
+void UARTLogReport(void)
+{
+    UARTprintf("log: mode %s written %u dropped %u pending %u words\n",
+               (g_ui32LogMode == LOG_MODE_TEXT) ? "text" : "binary",
+               g_ui32LogWritten, g_ui32LogDropped,
+               g_ui32LogHead - g_ui32LogTail);
+}
+
+//*****************************************************************************
+//
+// Encodes one record into the transmit buffer. Returns the number of bytes
+// used or zero if the record does not fit.
+//
+//*****************************************************************************
+static uint32_t UARTLogEncode(const uint32_t *pui32Record, uint8_t *pui8Buf,
+                              uint32_t ui32Size)
+{
+    uint32_t ui32Id = pui32Record[0] >> 16;
+    uint32_t ui32Words = 2 + (pui32Record[0] & 0xF);
+    uint32_t ui32Len, ui32Idx;
+    uint8_t ui8Sum;
+    int32_t i32Len;
+
+    if(g_ui32LogMode == LOG_MODE_BINARY)
+    {
+        ui32Len = 3 + (ui32Words * 4);
+        if(ui32Len > ui32Size)
+        {
+            return(0);
+        }
+
+        pui8Buf[0] = LOG_FRAME_SYNC;
+        pui8Buf[1] = (uint8_t)ui32Words;
+        ui8Sum = (uint8_t)ui32Words;
+        for(ui32Idx = 0; ui32Idx < (ui32Words * 4); ui32Idx++)
+        {
+            pui8Buf[2 + ui32Idx] =
+                (uint8_t)(pui32Record[ui32Idx / 4] >> (8 * (ui32Idx % 4)));
+            ui8Sum += pui8Buf[2 + ui32Idx];
+        }
+        pui8Buf[ui32Len - 1] = ui8Sum;
+
+        return(ui32Len);
+    }
+
+    if(ui32Id >= LOG_NUM_IDS)
+    {
+        return(0);
+    }
+
+    //
+    // usnprintf() returns the length the text would have had, so a result
+    // that does not fit means the buffer has to be flushed first.
+    //
+    i32Len = usnprintf((char *)pui8Buf, ui32Size, "[%u] ",
+                       TimestampCyclesToUs(pui32Record[1]));
+    if((i32Len < 0) || ((uint32_t)i32Len >= ui32Size))
+    {
+        return(0);
+    }
+    ui32Len = (uint32_t)i32Len;
+
+    i32Len = usnprintf((char *)pui8Buf + ui32Len, ui32Size - ui32Len,
+                       g_ppcLogFormats[ui32Id],
+                       (ui32Words > 2) ? pui32Record[2] : 0,
+                       (ui32Words > 3) ? pui32Record[3] : 0,
+                       (ui32Words > 4) ? pui32Record[4] : 0,
+                       (ui32Words > 5) ? pui32Record[5] : 0);
+    if((i32Len < 0) || ((ui32Len + (uint32_t)i32Len) >= ui32Size))
+    {
+        return(0);
+    }
+
+    return(ui32Len + (uint32_t)i32Len);
+}
+
+//*****************************************************************************
+//
+// Encodes as many pending records as fit into a transmit buffer and removes
+// them from the ring. Returns the number of bytes in the buffer.
+//
+//*****************************************************************************
+static uint32_t UARTLogFill(uint8_t *pui8Buf)
+{
+    uint32_t pui32Record[LOG_RECORD_MAX_WORDS];
+    uint32_t ui32Len = 0, ui32Used, ui32Tail, ui32Words, ui32Idx;
+
+    while(1)
+    {
+        ui32Tail = g_ui32LogTail;
+
+        if(ui32Tail != g_ui32LogHead)
+        {
+            pui32Record[0] = g_pui32LogRing[ui32Tail & (LOG_RING_WORDS - 1)];
+            ui32Words = 2 + (pui32Record[0] & 0xF);
+            for(ui32Idx = 1; ui32Idx < ui32Words; ui32Idx++)
+            {
+                pui32Record[ui32Idx] =
+                    g_pui32LogRing[(ui32Tail + ui32Idx) &
+                                   (LOG_RING_WORDS - 1)];
+            }
+        }
+        else if(g_ui32LogDropped != g_ui32LogDroppedReported)
+        {
+            //
+            // The ring is drained, report the records lost while it was full.
+            //
+            ui32Words = 3;
+            pui32Record[0] = (LOG_DROPPED << 16) | 1;
+            pui32Record[1] = TimestampGet();
+            pui32Record[2] = g_ui32LogDropped - g_ui32LogDroppedReported;
+        }
+        else
+        {
+            break;
+        }
+
+        ui32Used = UARTLogEncode(pui32Record, pui8Buf + ui32Len,
+                                 LOG_TX_BUFFER_SIZE - ui32Len);
+        if(ui32Used == 0)
+        {
+            if(ui32Len != 0)
+            {
+                break;
+            }
+
+            //
+            // A record that does not even fit an empty buffer can never be
+            // sent, skip it.
+            //
+        }
+        ui32Len += ui32Used;
+
+        if(ui32Tail != g_ui32LogHead)
+        {
+            g_ui32LogTail = ui32Tail + ui32Words;
+            g_ui32LogWritten++;
+        }
+        else
+        {
+            g_ui32LogDroppedReported += pui32Record[2];
+        }
+    }
+
+    return(ui32Len);
+}
+
+//*****************************************************************************
+//
+// This task drains the log ring. While one buffer is transmitted by the uDMA
+// the next one is filled.
+//
+//*****************************************************************************
+static void LogTask(void *pvParameters)
+{
+    uint32_t ui32Buf = 0, ui32Len;
+
+    while(1)
+    {
+        vTaskDelay(LOG_FLUSH_MS);
+
+        ui32Len = UARTLogFill(g_ppui8LogTxBuffer[ui32Buf]);
+        if(ui32Len == 0)
+        {
+            continue;
+        }
+
+        xSemaphoreTake(g_pUARTSemaphore, portMAX_DELAY);
+
+        while(ui32Len != 0)
+        {
+            UARTDMASend(g_ppui8LogTxBuffer[ui32Buf], ui32Len);
+            ui32Buf ^= 1;
+            ui32Len = UARTLogFill(g_ppui8LogTxBuffer[ui32Buf]);
+        }
+        UARTDMAWait();
+
+        xSemaphoreGive(g_pUARTSemaphore);
+    }
+}
+
+//*****************************************************************************
+//
+// Initializes the logger task and the UART uDMA channel.
+//
+//*****************************************************************************
+uint32_t UARTLogTaskInit(void)
+{
+    UARTDMAInit();
+
+    if(xTaskCreate(LogTask, (const portCHAR *)"LOG", LOGTASKSTACKSIZE, NULL,
+                   tskIDLE_PRIORITY + PRIORITY_LOG_TASK, NULL) != pdTRUE)
+    {
+        return(1);
+    }
+
+    return(0);
+}
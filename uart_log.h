@@ -0,0 +1,45 @@
+#ifndef UART_LOG_H
+#define UART_LOG_H
+
+//*****************************************************************************
+//
+// Message ids, generated from log_ids.h.
+//
+//*****************************************************************************
+#define LOG_MSG(id, fmt)    id,
+enum
+{
+#include "log_ids.h"
+    LOG_NUM_IDS
+};
+#undef LOG_MSG
+
+#define LOG_MAX_ARGS                    4
+
+//*****************************************************************************
+//
+// Output modes of the logger task.
+//
+//*****************************************************************************
+#define LOG_MODE_TEXT                   0
+#define LOG_MODE_BINARY                 1
+
+//*****************************************************************************
+//
+// Logging calls only store the message id, a timestamp and the raw arguments.
+// They are safe from tasks and interrupt handlers and never block.
+//
+//*****************************************************************************
+#define LOG0(id)                UARTLogWrite((id), 0, 0, 0, 0, 0)
+#define LOG1(id, a)             UARTLogWrite((id), 1, (a), 0, 0, 0)
+#define LOG2(id, a, b)          UARTLogWrite((id), 2, (a), (b), 0, 0)
+#define LOG3(id, a, b, c)       UARTLogWrite((id), 3, (a), (b), (c), 0)
+#define LOG4(id, a, b, c, d)    UARTLogWrite((id), 4, (a), (b), (c), (d))
+
+void UARTLogWrite(uint32_t ui32Id, uint32_t ui32NumArgs, uint32_t ui32Arg0,
+                  uint32_t ui32Arg1, uint32_t ui32Arg2, uint32_t ui32Arg3);
+void UARTLogModeSet(uint32_t ui32Mode);
+void UARTLogReport(void);
+uint32_t UARTLogTaskInit(void);
+
+#endif
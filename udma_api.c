@@ -0,0 +1,55 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// uDMA controller setup shared by the DMA driven peripherals
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "ram_budget.h"
+#include "udma_api.h"
+
+//*****************************************************************************
+//
+// The control table used by the uDMA controller. This table must be aligned
+// to a 1024 byte boundary and holds the primary and alternate control
+// structures of all 32 channels.
+//
+//*****************************************************************************
+#if defined(ewarm)
+#pragma data_alignment=1024
+uint8_t g_pui8DMAControlTable[1024];
+#elif defined(ccs)
+#pragma DATA_ALIGN(g_pui8DMAControlTable, 1024)
+uint8_t g_pui8DMAControlTable[1024];
+#else
+uint8_t g_pui8DMAControlTable[1024] __attribute__ ((aligned(1024)));
+#endif
+
+typedef char tUDMABudget[(sizeof(g_pui8DMAControlTable) <= RAM_BUDGET_UDMA) ?
+                         1 : -1];
+
+static bool g_bUDMAReady = false;
+
+//*****************************************************************************
+//
+// Enables the uDMA controller. Safe to call from every driver init.
+//
+//*****************************************************************************
+void UDMAInit(void)
+{
+    if(g_bUDMAReady)
+    {
+        return;
+    }
+
+    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    MAP_uDMAEnable();
+    MAP_uDMAControlBaseSet(g_pui8DMAControlTable);
+
+    g_bUDMAReady = true;
+}
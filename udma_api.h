@@ -0,0 +1,12 @@
+#ifndef UDMA_API_H
+#define UDMA_API_H
+
+//*****************************************************************************
+//
+// The uDMA controller is shared by several drivers. UDMAInit() enables it
+// once and installs the channel control table.
+//
+//*****************************************************************************
+void UDMAInit(void);
+
+#endif
@@ -0,0 +1,214 @@
+// Author: Ahmed Sobhy
+// Project: UNB SAE EV
+// Front wheel speeds from hardware timed tone wheel edges
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/uartstdio.h"
+#include "hal.h"
+#include "timestamp.h"
+#include "sensor_bus.h"
+#include "wheel_speed.h"
+
+/******************************************************************************
+Description: the wide timer of a wheel counts the tone wheel edges and takes
+the time of the last one in hardware, no code runs per edge. Every 5ms the
+runnable reads both and measures the speed over the edges since the last
+edge it measured, from that edge to the newest one: a whole number of
+teeth over their exact time. Fast, many edges go into one reading and the
+count sets the speed, as a count over a fixed window would but without its
+error of up to one edge. Slow, a reading waits for the next edge and the
+speed comes from a single period. Either way the error is the timer
+resolution over the time measured, 12.5ns in at least 5ms or one period.
+
+Between edges a slowing wheel still shows the speed of the last period, so
+the age of the last edge bounds the speed from above: had the next edge
+been now, the period would have been that long. A wheel that sees no edge
+for WHEEL_SPEED_TIMEOUT_MS reads zero and needs two new edges to roll
+again.
+******************************************************************************/
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Edges;                 // count at the last edge measured
+    uint32_t ui32EdgeTime;              // and its time
+    bool bEdge;                         // ui32EdgeTime is that of an edge
+    uint32_t ui32Speed;                 // 0.01km/h
+    uint32_t ui32StartEdges;            // count at init, for the report
+    uint32_t ui32Measured;              // readings with new edges
+    uint32_t ui32Bounded;               // readings bounded by the edge age
+    uint32_t ui32Stops;
+}
+tWheelSpeedWheel;
+
+static tWheelSpeedWheel g_psWheels[WHEEL_SPEED_NUM_WHEELS];
+
+static const char * const g_ppcWheelSpeedNames[WHEEL_SPEED_NUM_WHEELS] =
+{
+    "left", "right"
+};
+
+static tWheelSpeedFrame g_psWheelSpeedFrames[WHEEL_SPEED_TOPIC_SLOTS];
+tSensorBusTopic g_sWheelSpeedTopic;
+
+//*****************************************************************************
+//
+// Speed in 0.01km/h of ui32Edges tone wheel teeth passing in ui32Cycles.
+//
+//*****************************************************************************
+static uint32_t WheelSpeedFromEdges(uint32_t ui32Edges, uint32_t ui32Cycles)
+{
+    uint64_t ui64Speed;
+
+    if(ui32Cycles == 0)
+    {
+        return 0xFFFF;
+    }
+
+    // teeth/s / teeth * mm / 1000 * 3.6 * 100
+    ui64Speed = ((uint64_t)ui32Edges * HAL_SYS_CLOCK_HZ *
+                 WHEEL_SPEED_CIRCUMFERENCE_MM * 36) /
+                ((uint64_t)ui32Cycles * WHEEL_SPEED_TEETH * 100);
+
+    return (ui64Speed > 0xFFFF) ? 0xFFFF : (uint32_t)ui64Speed;
+}
+
+//*****************************************************************************
+//
+// Updates the speed of a wheel from its capture input.
+//
+//*****************************************************************************
+static void WheelSpeedUpdate(uint32_t ui32Wheel)
+{
+    tWheelSpeedWheel *psWheel = &g_psWheels[ui32Wheel];
+    uint32_t ui32Edges, ui32Time, ui32New, ui32Age, ui32Bound;
+
+    HalCaptureRead(ui32Wheel, &ui32Edges, &ui32Time);
+
+    ui32New = ui32Edges - psWheel->ui32Edges;
+    if(ui32New)
+    {
+        if(psWheel->bEdge)
+        {
+            psWheel->ui32Speed =
+                WheelSpeedFromEdges(ui32New, ui32Time - psWheel->ui32EdgeTime);
+            psWheel->ui32Measured++;
+        }
+        psWheel->ui32Edges = ui32Edges;
+        psWheel->ui32EdgeTime = ui32Time;
+        psWheel->bEdge = true;
+    }
+    else if(psWheel->bEdge)
+    {
+        ui32Age = TimestampGet() - psWheel->ui32EdgeTime;
+        if(ui32Age > TimestampUsToCycles(WHEEL_SPEED_TIMEOUT_MS * 1000))
+        {
+            psWheel->ui32Speed = 0;
+            psWheel->bEdge = false;
+            psWheel->ui32Stops++;
+        }
+        else
+        {
+            ui32Bound = WheelSpeedFromEdges(1, ui32Age);
+            if(ui32Bound < psWheel->ui32Speed)
+            {
+                psWheel->ui32Speed = ui32Bound;
+                psWheel->ui32Bounded++;
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Reads both wheels and publishes their speeds. Runs in the 5ms rate group.
+//
+//*****************************************************************************
+void WheelSpeedRun(void)
+{
+    tWheelSpeedFrame *psFrame;
+    uint32_t ui32Wheel;
+
+    psFrame = (tWheelSpeedFrame *)SensorBusPublishBegin(&g_sWheelSpeedTopic);
+    psFrame->ui32Seq = SensorBusSeqGet(&g_sWheelSpeedTopic);
+    for(ui32Wheel = 0; ui32Wheel < WHEEL_SPEED_NUM_WHEELS; ui32Wheel++)
+    {
+        WheelSpeedUpdate(ui32Wheel);
+        psFrame->pui16Data[ui32Wheel] =
+            (uint16_t)g_psWheels[ui32Wheel].ui32Speed;
+    }
+    psFrame->ui32Time = TimestampGet();
+    SensorBusPublishEnd(&g_sWheelSpeedTopic);
+}
+
+//*****************************************************************************
+//
+// Starts the capture inputs and registers the topic, the 5ms rate group
+// runs WheelSpeedRun().
+//
+//*****************************************************************************
+uint32_t WheelSpeedInit(void)
+{
+    tWheelSpeedWheel *psWheel;
+    uint32_t ui32Wheel;
+
+    SensorBusTopicRegister(&g_sWheelSpeedTopic, "wheels",
+                           g_psWheelSpeedFrames, sizeof(tWheelSpeedFrame),
+                           WHEEL_SPEED_TOPIC_SLOTS);
+
+    for(ui32Wheel = 0; ui32Wheel < WHEEL_SPEED_NUM_WHEELS; ui32Wheel++)
+    {
+        psWheel = &g_psWheels[ui32Wheel];
+        psWheel->pcName = g_ppcWheelSpeedNames[ui32Wheel];
+
+        HalCaptureInit(ui32Wheel);
+        HalCaptureRead(ui32Wheel, &psWheel->ui32Edges, &psWheel->ui32EdgeTime);
+        psWheel->ui32StartEdges = psWheel->ui32Edges;
+        psWheel->bEdge = false;
+        psWheel->ui32Speed = 0;
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Copies the newest frame. Returns false before the first.
+//
+//*****************************************************************************
+bool WheelSpeedLatest(tWheelSpeedFrame *psFrame)
+{
+    return SensorBusLatestRead(&g_sWheelSpeedTopic, psFrame);
+}
+
+//*****************************************************************************
+//
+// Prints the speed and the edge counts of every wheel. The caller must own
+// the UART.
+//
+//*****************************************************************************
+void WheelSpeedReport(void)
+{
+    tWheelSpeedFrame sFrame;
+    tWheelSpeedWheel *psWheel;
+    uint32_t ui32Wheel, ui32Speed;
+
+    if(!WheelSpeedLatest(&sFrame))
+    {
+        UARTprintf("wheels: no readings\n");
+        return;
+    }
+
+    UARTprintf("\nwheel  km/h     edges  measured  bounded  stops\n");
+    for(ui32Wheel = 0; ui32Wheel < WHEEL_SPEED_NUM_WHEELS; ui32Wheel++)
+    {
+        psWheel = &g_psWheels[ui32Wheel];
+        ui32Speed = sFrame.pui16Data[ui32Wheel];
+        UARTprintf("%-5s  %3u.%02u  %8u  %8u  %7u  %5u\n", psWheel->pcName,
+                   ui32Speed / 100, ui32Speed % 100,
+                   psWheel->ui32Edges - psWheel->ui32StartEdges,
+                   psWheel->ui32Measured, psWheel->ui32Bounded,
+                   psWheel->ui32Stops);
+    }
+}
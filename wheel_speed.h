@@ -0,0 +1,46 @@
+#ifndef WHEEL_SPEED_H
+#define WHEEL_SPEED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rate_group.h"
+#include "sensor_bus.h"
+
+//*****************************************************************************
+//
+// Front wheel speeds from the tone wheel sensors on the capture inputs of
+// hal.h, front left on input 0 and front right on input 1. The 5ms rate
+// group publishes both as a frame on the "wheels" topic of the sensor bus,
+// numbered and timestamped like the ADC frames, in 0.01km/h.
+//
+//*****************************************************************************
+#define WHEEL_SPEED_NUM_WHEELS          2
+#define WHEEL_SPEED_FRONT_LEFT          0
+#define WHEEL_SPEED_FRONT_RIGHT         1
+
+#define WHEEL_SPEED_PERIOD_MS           RATE_GROUP_PERIOD_MS(RATE_GROUP_5MS)
+#define WHEEL_SPEED_TOPIC_SLOTS         8       // must be power of two
+
+// tone wheel teeth and rolling circumference of the front tyres
+#define WHEEL_SPEED_TEETH               24
+#define WHEEL_SPEED_CIRCUMFERENCE_MM    1600
+
+// a wheel without an edge for this long stands, below 0.5km/h
+#define WHEEL_SPEED_TIMEOUT_MS          500
+
+typedef struct
+{
+    uint32_t ui32Seq;                   // frame sequence number
+    uint32_t ui32Time;                  // DWT timestamp of the reading
+    uint16_t pui16Data[WHEEL_SPEED_NUM_WHEELS];     // 0.01km/h
+}
+tWheelSpeedFrame;
+
+extern tSensorBusTopic g_sWheelSpeedTopic;
+
+uint32_t WheelSpeedInit(void);
+void WheelSpeedRun(void);
+bool WheelSpeedLatest(tWheelSpeedFrame *psFrame);
+void WheelSpeedReport(void);
+
+#endif